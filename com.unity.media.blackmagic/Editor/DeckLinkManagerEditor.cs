@@ -30,6 +30,16 @@ namespace Unity.Media.Blackmagic.Editor
             public static readonly GUIContent PropertiesNoDeviceSelectedLabel = EditorGUIUtility.TrTextContent("No device selected", "Select an input or output device to view or edit its properties.");
             public static readonly GUIContent InputDeviceListIsEmptyLabel = EditorGUIUtility.TrTextContent("List Is Empty", "The list of input devices is empty.");
             public static readonly GUIContent OutputDeviceListIsEmptyLabel = EditorGUIUtility.TrTextContent("List Is Empty", "The list of output devices is empty.");
+            public static readonly GUIContent DiagnosticsLabel = EditorGUIUtility.TrTextContent("Diagnostics", "The timings and counters recorded by the plugin for the live devices.");
+            public static readonly GUIContent DeviceMetricsLabel = EditorGUIUtility.TrTextContent("Device Metrics", "The timings and counters of each live device. The durations are in nanoseconds.");
+            public static readonly GUIContent CopyMetricsLabel = EditorGUIUtility.TrTextContent("Copy", "Copy the device metrics to the clipboard.");
+            public static readonly GUIContent ResetMetricsLabel = EditorGUIUtility.TrTextContent("Reset", "Clear the device metrics.");
+            public static readonly GUIContent LogSeverityLabel = EditorGUIUtility.TrTextContent("Log Level", "The minimum severity of the messages written to the native log file.");
+            public static readonly GUIContent LogPathLabel = EditorGUIUtility.TrTextContent("Log File", "The path of the native log file. Leave empty to use the default file of the plugin.");
+            public static readonly GUIContent DroppedLogMessagesLabel = EditorGUIUtility.TrTextContent("Dropped Messages", "The number of log messages dropped because the log writer couldn't keep up.");
+            public static readonly GUIContent RecordDriverEventsLabel = EditorGUIUtility.TrTextContent("Record Driver Callbacks", "Record the timing of the frame arrivals, format changes and frame completions, to replay them offline.");
+            public static readonly GUIContent SaveRecordingLabel = EditorGUIUtility.TrTextContent("Save Recording...", "Write the driver callbacks recorded so far to a file.");
+            public static readonly GUIContent NoMetricsLabel = EditorGUIUtility.TrTextContent("No metrics recorded.");
             public static readonly GUIContent ConnectorMappingSupportWarningLabel = EditorGUIUtility.TrTextContent("* Connector Mapping profiles are not available on this device.");
 
             public static readonly GUIContent DeviceOkIcon = EditorGUIUtility.TrIconContent("winbtn_mac_max");
@@ -86,6 +96,10 @@ namespace Unity.Media.Blackmagic.Editor
 
         bool m_HasChanged;
         SerializedProperty m_PropertiesFoldout;
+        SerializedProperty m_DiagnosticsFoldout;
+        SerializedProperty m_LogSeverity;
+        SerializedProperty m_LogPath;
+        SerializedProperty m_RecordDriverEvents;
 
         public bool HasChanged => m_HasChanged;
 
@@ -101,6 +115,10 @@ namespace Unity.Media.Blackmagic.Editor
             m_InputDevicesList = serializedObject.FindProperty("m_InputDevices");
             m_OutputDevicesList = serializedObject.FindProperty("m_OutputDevices");
             m_PropertiesFoldout = serializedObject.FindProperty("m_PropertiesFoldout");
+            m_DiagnosticsFoldout = serializedObject.FindProperty("m_DiagnosticsFoldout");
+            m_LogSeverity = serializedObject.FindProperty("m_LogSeverity");
+            m_LogPath = serializedObject.FindProperty("m_LogPath");
+            m_RecordDriverEvents = serializedObject.FindProperty("m_RecordDriverEvents");
 
             m_VideoIOManager.OnMappingProfilesChanged += OnMappingProfilesChanged;
 
@@ -204,9 +222,86 @@ namespace Unity.Media.Blackmagic.Editor
                 }
             }
 
+            EditorGUILayout.Space(4);
+            VirtualProductionEditorUtilities.DrawSplitter();
+
+            EditorGUILayout.Space(2);
+
+            m_DiagnosticsFoldout.boolValue = EditorGUILayout.Foldout(m_DiagnosticsFoldout.boolValue, Contents.DiagnosticsLabel, headerStyle);
+            if (m_DiagnosticsFoldout.boolValue)
+            {
+                using (new EditorGUI.IndentLevelScope())
+                {
+                    DrawDiagnostics();
+                }
+            }
+
             serializedObject.ApplyModifiedProperties();
         }
 
+        void DrawDiagnostics()
+        {
+            EditorGUILayout.PropertyField(m_LogSeverity, Contents.LogSeverityLabel);
+            EditorGUI.BeginDisabledGroup(m_LogSeverity.intValue == (int)LogSeverity.Off);
+            EditorGUILayout.PropertyField(m_LogPath, Contents.LogPathLabel);
+            EditorGUILayout.LabelField(Contents.DroppedLogMessagesLabel, new GUIContent(m_VideoIOManager.DroppedLogMessages.ToString()));
+            EditorGUI.EndDisabledGroup();
+
+            using (new EditorGUILayout.HorizontalScope())
+            {
+                EditorGUILayout.PropertyField(m_RecordDriverEvents, Contents.RecordDriverEventsLabel);
+
+                EditorGUI.BeginDisabledGroup(!m_RecordDriverEvents.boolValue);
+                if (GUILayout.Button(Contents.SaveRecordingLabel, EditorStyles.miniButton, GUILayout.ExpandWidth(false)))
+                {
+                    SaveDriverEventRecording();
+                }
+                EditorGUI.EndDisabledGroup();
+            }
+
+            EditorGUILayout.Space(4);
+
+            var report = m_VideoIOManager.GetDeviceMetricsReport();
+
+            using (new EditorGUILayout.HorizontalScope())
+            {
+                EditorGUILayout.LabelField(Contents.DeviceMetricsLabel);
+
+                EditorGUI.BeginDisabledGroup(string.IsNullOrEmpty(report));
+                if (GUILayout.Button(Contents.CopyMetricsLabel, EditorStyles.miniButtonLeft))
+                {
+                    EditorGUIUtility.systemCopyBuffer = report;
+                }
+                if (GUILayout.Button(Contents.ResetMetricsLabel, EditorStyles.miniButtonRight))
+                {
+                    m_VideoIOManager.ResetDeviceMetrics();
+                }
+                EditorGUI.EndDisabledGroup();
+            }
+
+            if (string.IsNullOrEmpty(report))
+            {
+                EditorGUILayout.LabelField(Contents.NoMetricsLabel, EditorStyles.miniLabel);
+            }
+            else
+            {
+                EditorGUILayout.SelectableLabel(report, EditorStyles.textArea,
+                    GUILayout.Height(EditorStyles.textArea.lineHeight * (report.Split('\n').Length + 1)));
+            }
+        }
+
+        void SaveDriverEventRecording()
+        {
+            var path = EditorUtility.SaveFilePanel(Contents.SaveRecordingLabel.text, string.Empty, "DeckLinkEvents", "dler");
+            if (string.IsNullOrEmpty(path))
+                return;
+
+            if (m_VideoIOManager.WriteDriverEventRecording(path) < 0)
+            {
+                Debug.LogError($"Failed to write the driver callbacks to {path}.");
+            }
+        }
+
         void CacheDeckLinkCardsInstalled()
         {
             var cards = m_VideoIOManager.m_DeckLinkCards.Select((x) => x.Value.name).ToArray();
@@ -18,6 +18,7 @@ namespace Unity.Media.Blackmagic.Editor
             public static GUIContent VideoModeFoldoutLabel = new GUIContent("Video Mode Configuration", "Configure video media format options.");
             public static GUIContent DeviceSettingsFoldoutLabel = new GUIContent("Device Settings", "Configure Output Device settings regarding timing and latency.");
             public static GUIContent AudioConfigFoldoutLabel = new GUIContent("Audio Configurations", "Configure audio output.");
+            public static GUIContent PassthroughFoldoutLabel = new GUIContent("Passthrough", "Route the frames of an input device to this output without going through Unity.");
             public static GUIContent MediaModeLabel = new GUIContent("Media Mode", "The current source of video mode.");
             public static GUIContent CustomConfigLabel = new GUIContent("Custom", "Set Resolution, Frame Rate, and Scanning Mode explicitly.");
             public static GUIContent SameConfigAsInputLabel = new GUIContent("Same as Input", "Match the video mode of an input device.");
@@ -60,6 +61,11 @@ namespace Unity.Media.Blackmagic.Editor
             public static GUIContent RequestedPixelFormatLabel = new GUIContent("Requested Format", "Request a specific output pixel format.");
             public static GUIContent RequestedColorSpaceLabel = new GUIContent("Color Space", "Request a specific output color space.");
             public static GUIContent RequestedTransferFunctionLabel = new GUIContent("Transfer Function", "BT2020 transfer function to apply.");
+            public static GUIContent PassthroughInputDeviceLabel = new GUIContent("Input Device", "The input device whose frames are played out by this device.");
+            public static GUIContent PassthroughDelayLabel = new GUIContent("Delay", "The number of frames between capture and play out.");
+            public static GUIContent PassthroughCompositingLabel = new GUIContent("Compositing", "\"Fill\" plays out the input frames, \"Key\" uses them as the background of internal keying.");
+            public static GUIContent PassthroughSynchronizeLabel = new GUIContent("Synchronize", "Follow the output clock through a frame synchronizer, for inputs which are not locked to the output reference. Requires the async sync mode.");
+            public static GUIContent PassthroughStatusLabel = new GUIContent("Routed Frames", "The number of input frames played out and skipped by the route.");
             public static GUIContent WorkingSpaceConversionLabel = new GUIContent("Convert Color Space", "Convert the Camera Colors assuming Unity working space (709).");
 
             public static GUIContent ResolutionSupportWarningLabel = new GUIContent("* This resolution is not available on this device.");
@@ -117,6 +123,10 @@ namespace Unity.Media.Blackmagic.Editor
         SerializedProperty m_RequestedPixelFormat;
         SerializedProperty m_RequestedColorSpace;
         SerializedProperty m_RequestedTransferFunction;
+        SerializedProperty m_PassthroughInputDevice;
+        SerializedProperty m_PassthroughDelay;
+        SerializedProperty m_PassthroughCompositing;
+        SerializedProperty m_PassthroughSynchronize;
 
         string m_DeviceName;
         int m_DeviceSelectionCached;
@@ -130,6 +140,7 @@ namespace Unity.Media.Blackmagic.Editor
         SerializedProperty m_VideoModeFoldout;
         SerializedProperty m_DeviceSettingsFoldout;
         SerializedProperty m_AudioConfigFoldout;
+        SerializedProperty m_PassthroughFoldout;
 
         GUIContent m_VideoModeName = new GUIContent();
         GUIContent[] m_AllResolutionLabels;
@@ -188,6 +199,7 @@ namespace Unity.Media.Blackmagic.Editor
             m_VideoModeFoldout = serializedObject.FindProperty("m_VideoModeFoldout");
             m_DeviceSettingsFoldout = serializedObject.FindProperty("m_DeviceSettingsFoldout");
             m_AudioConfigFoldout = serializedObject.FindProperty("m_AudioConfigFoldout");
+            m_PassthroughFoldout = serializedObject.FindProperty("m_PassthroughFoldout");
 
             m_CameraSelection = serializedObject.FindProperty("m_TargetCamera");
             m_SDKDisplayMode = serializedObject.FindProperty("m_SDKDisplayMode");
@@ -213,6 +225,10 @@ namespace Unity.Media.Blackmagic.Editor
             m_RequestedPixelFormat = serializedObject.FindProperty("m_RequestedPixelFormat");
             m_RequestedColorSpace = serializedObject.FindProperty("m_RequestedColorSpace");
             m_RequestedTransferFunction = serializedObject.FindProperty("m_RequestedTransferFunction");
+            m_PassthroughInputDevice = serializedObject.FindProperty("m_PassthroughInputDevice");
+            m_PassthroughDelay = serializedObject.FindProperty("m_PassthroughDelay");
+            m_PassthroughCompositing = serializedObject.FindProperty("m_PassthroughCompositing");
+            m_PassthroughSynchronize = serializedObject.FindProperty("m_PassthroughSynchronize");
 
             m_DeviceName = Contents.DeviceNamePrefix + " " + m_Target.name;
             m_ActualSDKDisplayMode = m_SDKDisplayMode.intValue;
@@ -382,6 +398,7 @@ namespace Unity.Media.Blackmagic.Editor
             DisplayVideoModeFoldout();
             DisplayDeviceSettings();
             DisplayAudioOptions();
+            DisplayPassthroughOptions();
 
             serializedObject.ApplyModifiedProperties();
         }
@@ -470,6 +487,31 @@ namespace Unity.Media.Blackmagic.Editor
             }
         }
 
+        void DisplayPassthroughOptions()
+        {
+            m_PassthroughFoldout.boolValue = EditorGUILayout.Foldout(m_PassthroughFoldout.boolValue, Contents.PassthroughFoldoutLabel, true, m_InlineFoldoutStyle);
+            if (m_PassthroughFoldout.boolValue)
+            {
+                using (new EditorGUI.IndentLevelScope())
+                {
+                    EditorGUILayout.PropertyField(m_PassthroughInputDevice, Contents.PassthroughInputDeviceLabel);
+                    EditorGUILayout.PropertyField(m_PassthroughDelay, Contents.PassthroughDelayLabel);
+                    EditorGUILayout.PropertyField(m_PassthroughCompositing, Contents.PassthroughCompositingLabel);
+                    EditorGUILayout.PropertyField(m_PassthroughSynchronize, Contents.PassthroughSynchronizeLabel);
+
+                    if (m_Target.IsPassthroughRouted)
+                    {
+                        EditorGUILayout.LabelField(Contents.PassthroughStatusLabel,
+                            new GUIContent($"{m_Target.RoutedPassthroughFrameCount} ({m_Target.SkippedPassthroughFrameCount} skipped)"));
+                    }
+                    else if (m_Target.PassthroughError != null && m_PassthroughInputDevice.objectReferenceValue != null)
+                    {
+                        EditorGUILayout.HelpBox(m_Target.PassthroughError, MessageType.Warning, true);
+                    }
+                }
+            }
+        }
+
         void DisplayGenericTrench(
             GUIContent label,
             ref int currentSelectedGUID,
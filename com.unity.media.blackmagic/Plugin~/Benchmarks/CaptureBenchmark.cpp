@@ -0,0 +1,343 @@
+// Capture benchmark: runs DeckLinkInputDevice against virtual cards, for every display mode and
+// pixel format, and measures the frame rate it sustains, the CPU time of its capture callback,
+// the callback durations and the allocations per frame. The results are written as JSON.
+//
+//   CaptureBenchmark [--modes 1080p5994,...] [--formats 8BitYUV,...] [--streams 1]
+//                    [--duration 2] [--warmup 60] [--paced] [--copy] [--output results.json]
+//
+// By default the virtual cards deliver the frames as fast as the plugin takes them; --paced keeps
+// the cadence of the display mode instead. --copy copies every frame in the frame arrived
+// callback, as the managed side does when it reads the frame.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "Common/BenchmarkUtilities.h"
+#include "Common/VirtualDeckLink.h"
+#include "../Includes/DeckLinkInputDevice.h"
+
+using namespace MediaBlackmagic;
+using namespace MediaBlackmagic::Benchmark;
+
+namespace
+{
+    const std::vector<std::string> k_DefaultModes = { "1080p5994", "2160p5994", "4KDCI5994", "4320p5994", "8KDCI5994" };
+    const std::vector<std::string> k_DefaultFormats = { "8BitYUV", "10BitYUV", "8BitBGRA", "10BitRGB", "12BitRGB" };
+    const std::vector<std::string> k_Options = { "modes", "formats", "streams", "duration", "warmup", "paced", "copy", "output" };
+
+    struct Settings
+    {
+        int         streams;
+        double      duration;       // Measured time of each case, in seconds.
+        int         warmupFrames;   // Frames delivered before the measurements start, per stream.
+        bool        paced;
+        bool        copy;
+    };
+
+    struct Stream
+    {
+        DeckLinkInputDevice*        device = nullptr;
+        VirtualDeckLink*            card = nullptr;
+        MeasuringProbe              probe;
+        std::vector<std::uint8_t>   copyBuffer;
+        std::atomic<std::uint64_t>  frameErrors{0};
+    };
+
+    // Indexed by the device index given to the plugin.
+    std::vector<std::unique_ptr<Stream>> s_Streams;
+    bool s_Copy = false;
+
+    void UNITY_INTERFACE_API OnFrameArrived(int32_t deviceIndex, uint8_t* videoData, int64_t videoDataSize,
+                                            int32_t, int32_t, int32_t, int32_t, int64_t, int64_t, int64_t,
+                                            uint32_t, uint8_t*, int32_t, int32_t, int32_t, int64_t)
+    {
+        if (!s_Copy || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Streams.size()))
+            return;
+
+        auto& buffer = s_Streams[deviceIndex]->copyBuffer;
+        std::memcpy(buffer.data(), videoData, std::min(static_cast<std::size_t>(videoDataSize), buffer.size()));
+    }
+
+    void UNITY_INTERFACE_API OnFrameError(int32_t deviceIndex, EDeviceStatus status, InputError, const char*)
+    {
+        if (status == EDeviceStatus::Ok || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Streams.size()))
+            return;
+
+        s_Streams[deviceIndex]->frameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool StartStreams(const VirtualMode& mode, const BMDPixelFormat pixelFormat, const Settings& settings, std::string& error)
+    {
+        for (auto i = 0; i < settings.streams; ++i)
+        {
+            auto stream = s_Streams[i].get();
+            stream->card = VirtualDeckLinkDriver::GetDevice(i);
+            stream->device = new DeckLinkInputDevice();
+
+            if (!StartVirtualCapture(stream->device, stream->card, i, i, mode, pixelFormat, error))
+                return false;
+
+            if (settings.copy)
+                stream->copyBuffer.resize(GetFrameBytes(mode, pixelFormat));
+        }
+        return true;
+    }
+
+    void StopStreams()
+    {
+        for (auto& stream : s_Streams)
+        {
+            if (stream->device != nullptr)
+            {
+                stream->device->Stop();
+                stream->device->Release();
+                stream->device = nullptr;
+            }
+
+            stream->card = nullptr;
+            std::vector<std::uint8_t>().swap(stream->copyBuffer);
+        }
+    }
+
+    void RunCase(const VirtualMode& mode, const BMDPixelFormat pixelFormat, const Settings& settings, JsonWriter& json)
+    {
+        const auto nominalRate = static_cast<double>(mode.timeScale) / static_cast<double>(mode.frameDuration);
+        const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / nominalRate));
+
+        json.BeginObject();
+        json.Member("mode", mode.name);
+        json.Member("width", mode.width);
+        json.Member("height", mode.height);
+        json.Member("quadLink", mode.quadLink);
+        json.Member("pixelFormat", GetPixelFormatName(pixelFormat));
+        json.Member("frameBytes", static_cast<std::uint64_t>(GetFrameBytes(mode, pixelFormat)));
+        json.Member("streams", settings.streams);
+        json.Member("nominalFramesPerSecond", nominalRate);
+
+        std::vector<VirtualDeviceDescription> cards;
+        for (auto i = 0; i < settings.streams; ++i)
+        {
+            cards.push_back({ "Virtual Input " + std::to_string(i + 1), 0x1000 + i, true, false });
+        }
+        VirtualDeckLinkDriver::Install(cards);
+
+        s_Streams.clear();
+        for (auto i = 0; i < settings.streams; ++i)
+        {
+            s_Streams.emplace_back(new Stream());
+        }
+
+        std::string error;
+        if (!StartStreams(mode, pixelFormat, settings, error))
+        {
+            std::fprintf(stderr, "%s %s: %s\n", mode.name, GetPixelFormatName(pixelFormat), error.c_str());
+            json.Member("error", error);
+            json.EndObject();
+
+            StopStreams();
+            VirtualDeckLinkDriver::Uninstall();
+            return;
+        }
+
+        // Each card delivers on its own thread, as the driver does. The measurements start once
+        // every stream is warm.
+        std::atomic<int> warmStreams(0);
+        std::atomic<bool> measuring(false);
+        std::atomic<bool> stopping(false);
+        std::vector<std::thread> threads;
+
+        for (auto& stream : s_Streams)
+        {
+            threads.emplace_back([&, stream = stream.get()]()
+            {
+                auto nextTime = std::chrono::steady_clock::now();
+                auto delivered = 0;
+                auto warm = false;
+
+                while (!stopping.load(std::memory_order_relaxed))
+                {
+                    if (settings.paced)
+                    {
+                        WaitUntil(nextTime);
+                        nextTime += frameDuration;
+                    }
+
+                    if (!warm && ++delivered > settings.warmupFrames)
+                    {
+                        warm = true;
+                        warmStreams.fetch_add(1);
+                        while (!measuring.load() && !stopping.load())
+                        {
+                            std::this_thread::yield();
+                        }
+                        stream->probe.Reset();
+                        nextTime = std::chrono::steady_clock::now();
+                        continue;
+                    }
+
+                    stream->card->DeliverInputFrame(bmdFrameFlagDefault, &stream->probe);
+                }
+            });
+        }
+
+        while (warmStreams.load() < settings.streams)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        const auto startCpuTime = GetProcessCpuTime();
+        const auto startAllocations = AllocationCounter::CountProcess();
+        const auto startContextSwitches = CountContextSwitches();
+        const auto startTime = std::chrono::steady_clock::now();
+        measuring = true;
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(settings.duration));
+        stopping = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        const auto cpuTime = GetProcessCpuTime() - startCpuTime;
+        const auto allocations = AllocationCounter::CountProcess() - startAllocations;
+        const auto contextSwitches = CountContextSwitches() - startContextSwitches;
+
+        std::uint64_t frames = 0;
+        for (const auto& stream : s_Streams)
+        {
+            frames += stream->probe.GetCalls();
+        }
+
+        json.Member("elapsedSeconds", elapsed);
+        json.Member("framesPerSecond", frames / elapsed);
+        json.Member("processCpuPercent", 100.0 * cpuTime / (elapsed * 1e9));
+        json.Member("processAllocationsPerFrame", frames > 0 ? static_cast<double>(allocations) / frames : 0.0);
+        json.Member("contextSwitchesPerSecond", contextSwitches / elapsed);
+        json.Member("residentBytes", GetResidentBytes());
+
+        json.Key("perStream");
+        json.BeginArray();
+        for (const auto& stream : s_Streams)
+        {
+            const auto& probe = stream->probe;
+            const auto calls = std::max<std::uint64_t>(probe.GetCalls(), 1);
+            const auto cpuPerFrame = static_cast<double>(probe.GetCpuTime()) / calls;
+
+            InputFormatChangeStatistics statistics = {};
+            stream->device->GetFormatChangeStatistics(&statistics);
+
+            json.BeginObject();
+            json.Member("frames", probe.GetCalls());
+            json.Member("framesPerSecond", probe.GetCalls() / elapsed);
+            json.Member("callbackCpuNsPerFrame", cpuPerFrame);
+            // The share of a core the stream needs at the rate of the display mode.
+            json.Member("cpuPercentAtNominalRate", 100.0 * cpuPerFrame * nominalRate / 1e9);
+            json.Member("callbackAllocationsPerFrame", static_cast<double>(probe.GetAllocations()) / calls);
+            json.Member("frameErrors", stream->frameErrors.load());
+            json.Member("framePoolMisses", static_cast<std::uint64_t>(statistics.poolMisses));
+            json.Member("framePoolBytes", statistics.pooledBytes);
+            json.Key("callback");
+            json.Durations(probe.GetDurations());
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+
+        MetricSummary callback = {};
+        s_Streams[0]->probe.GetDurations().Summarize(callback);
+        std::fprintf(stderr, "%-10s %-9s %2d stream(s): %8.1f fps, callback p50 %7.1f us p99 %7.1f us, %.2f alloc/frame\n",
+                     mode.name, GetPixelFormatName(pixelFormat), settings.streams, frames / elapsed,
+                     callback.p50 / 1000.0, callback.p99 / 1000.0, frames > 0 ? static_cast<double>(allocations) / frames : 0.0);
+
+        StopStreams();
+        s_Streams.clear();
+        VirtualDeckLinkDriver::Uninstall();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchmarkOptions options(argc, argv);
+
+    for (const auto& unknown : options.GetUnknown(k_Options))
+    {
+        std::fprintf(stderr, "Unknown option --%s.\n", unknown.c_str());
+        return 1;
+    }
+
+    Settings settings;
+    settings.streams = static_cast<int>(std::max<std::int64_t>(options.GetInt("streams", 1), 1));
+    settings.duration = options.GetDouble("duration", 2.0);
+    settings.warmupFrames = static_cast<int>(options.GetInt("warmup", 60));
+    settings.paced = options.Has("paced");
+    settings.copy = options.Has("copy");
+    s_Copy = settings.copy;
+
+    std::vector<const VirtualMode*> modes;
+    for (const auto& name : options.GetList("modes", k_DefaultModes))
+    {
+        const auto mode = FindVirtualMode(name);
+        if (mode == nullptr)
+        {
+            std::fprintf(stderr, "Unknown mode %s.\n", name.c_str());
+            return 1;
+        }
+        modes.push_back(mode);
+    }
+
+    std::vector<BMDPixelFormat> pixelFormats;
+    for (const auto& name : options.GetList("formats", k_DefaultFormats))
+    {
+        BMDPixelFormat pixelFormat;
+        if (!FindPixelFormat(name, pixelFormat))
+        {
+            std::fprintf(stderr, "Unknown pixel format %s.\n", name.c_str());
+            return 1;
+        }
+        pixelFormats.push_back(pixelFormat);
+    }
+
+    DeckLinkInputDevice::SetFrameArrivedCallback(OnFrameArrived);
+    DeckLinkInputDevice::SetFameErrorCallback(OnFrameError);
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Member("benchmark", "capture");
+    json.Member("hardwareThreads", static_cast<int>(std::thread::hardware_concurrency()));
+    json.Key("settings");
+    json.BeginObject();
+    json.Member("streams", settings.streams);
+    json.Member("durationSeconds", settings.duration);
+    json.Member("warmupFrames", settings.warmupFrames);
+    json.Member("paced", settings.paced);
+    json.Member("copy", settings.copy);
+    json.EndObject();
+
+    json.Key("cases");
+    json.BeginArray();
+    for (const auto mode : modes)
+    {
+        for (const auto pixelFormat : pixelFormats)
+        {
+            RunCase(*mode, pixelFormat, settings, json);
+        }
+    }
+    json.EndArray();
+    json.EndObject();
+
+    DeckLinkInputDevice::SetFrameArrivedCallback(nullptr);
+    DeckLinkInputDevice::SetFameErrorCallback(nullptr);
+
+    const auto output = options.GetString("output", "CaptureBenchmark.json");
+    if (!json.Save(output))
+    {
+        std::fprintf(stderr, "Can't write %s.\n", output.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,656 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <dirent.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BenchmarkUtilities.h"
+#include "../../Includes/DeckLinkInputDevice.h"
+
+namespace MediaBlackmagic
+{
+namespace Benchmark
+{
+    namespace
+    {
+        std::atomic<std::uint64_t> s_ProcessAllocations(0);
+        thread_local std::uint64_t t_ThreadAllocations = 0;
+        thread_local int t_UncountedDepth = 0;
+
+        const struct
+        {
+            BMDPixelFormat  pixelFormat;
+            const char*     name;
+        } k_PixelFormatNames[] =
+        {
+            { bmdFormat8BitYUV, "8BitYUV" },
+            { bmdFormat10BitYUV, "10BitYUV" },
+            { bmdFormat8BitARGB, "8BitARGB" },
+            { bmdFormat8BitBGRA, "8BitBGRA" },
+            { bmdFormat10BitRGB, "10BitRGB" },
+            { bmdFormat10BitRGBXLE, "10BitRGBXLE" },
+            { bmdFormat10BitRGBX, "10BitRGBX" },
+            { bmdFormat12BitRGB, "12BitRGB" },
+            { bmdFormat12BitRGBLE, "12BitRGBLE" },
+        };
+
+        // Beyond this, the wait sleeps rather than spins.
+        const auto k_SpinDuration = std::chrono::microseconds(500);
+
+        std::int64_t ToNanoseconds(const timeval& time)
+        {
+            return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + static_cast<std::int64_t>(time.tv_usec) * 1000;
+        }
+
+        int CountDirectoryEntries(const char* path)
+        {
+            auto directory = opendir(path);
+            if (directory == nullptr)
+                return 0;
+
+            auto count = 0;
+            while (auto entry = readdir(directory))
+            {
+                if (entry->d_name[0] != '.')
+                    ++count;
+            }
+
+            closedir(directory);
+            return count;
+        }
+
+        // The signal a card detects when the source sends frames in the pixel format.
+        BMDDetectedVideoInputFormatFlags GetDetectedFlags(const BMDPixelFormat pixelFormat)
+        {
+            switch (pixelFormat)
+            {
+            case bmdFormat8BitYUV:
+                return bmdDetectedVideoInputYCbCr422 | bmdDetectedVideoInput8BitDepth;
+            case bmdFormat10BitYUV:
+                return bmdDetectedVideoInputYCbCr422 | bmdDetectedVideoInput10BitDepth;
+            case bmdFormat8BitARGB:
+            case bmdFormat8BitBGRA:
+                return bmdDetectedVideoInputRGB444 | bmdDetectedVideoInput8BitDepth;
+            case bmdFormat12BitRGB:
+            case bmdFormat12BitRGBLE:
+                return bmdDetectedVideoInputRGB444 | bmdDetectedVideoInput12BitDepth;
+            default:
+                return bmdDetectedVideoInputRGB444 | bmdDetectedVideoInput10BitDepth;
+            }
+        }
+    }
+
+    std::uint64_t AllocationCounter::CountThread()
+    {
+        return t_ThreadAllocations;
+    }
+
+    std::uint64_t AllocationCounter::CountProcess()
+    {
+        return s_ProcessAllocations.load(std::memory_order_relaxed);
+    }
+
+    void AllocationCounter::Count(std::size_t)
+    {
+        if (t_UncountedDepth > 0)
+            return;
+
+        ++t_ThreadAllocations;
+        s_ProcessAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    UncountedAllocationScope::UncountedAllocationScope()
+    {
+        ++t_UncountedDepth;
+    }
+
+    UncountedAllocationScope::~UncountedAllocationScope()
+    {
+        --t_UncountedDepth;
+    }
+
+    bool UncountedAllocationScope::IsActive()
+    {
+        return t_UncountedDepth > 0;
+    }
+
+    std::int64_t GetThreadCpuTime()
+    {
+        timespec time;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+            return 0;
+        return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    std::int64_t GetProcessCpuTime()
+    {
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+        return ToNanoseconds(usage.ru_utime) + ToNanoseconds(usage.ru_stime);
+    }
+
+    std::int64_t CountContextSwitches()
+    {
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+        return static_cast<std::int64_t>(usage.ru_nvcsw) + static_cast<std::int64_t>(usage.ru_nivcsw);
+    }
+
+    std::int64_t GetResidentBytes()
+    {
+        auto file = std::fopen("/proc/self/statm", "r");
+        if (file == nullptr)
+            return 0;
+
+        long long size = 0;
+        long long resident = 0;
+        const auto read = std::fscanf(file, "%lld %lld", &size, &resident);
+        std::fclose(file);
+
+        return read == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+    }
+
+    std::int64_t GetHeapBytes()
+    {
+#if __GLIBC_PREREQ(2, 33)
+        const auto info = mallinfo2();
+#else
+        const auto info = mallinfo();
+#endif
+        return static_cast<std::int64_t>(info.uordblks) + static_cast<std::int64_t>(info.hblkhd);
+    }
+
+    int CountThreads()
+    {
+        return CountDirectoryEntries("/proc/self/task");
+    }
+
+    int CountFileDescriptors()
+    {
+        // Less the descriptor of the directory read.
+        return std::max(CountDirectoryEntries("/proc/self/fd") - 1, 0);
+    }
+
+    MeasuringProbe::MeasuringProbe() :
+        m_Calls(0),
+        m_CpuTime(0),
+        m_Allocations(0),
+        m_EnterCpuTime(0),
+        m_EnterAllocations(0)
+    {
+    }
+
+    void MeasuringProbe::Enter()
+    {
+        m_EnterAllocations = AllocationCounter::CountThread();
+        m_EnterCpuTime = GetThreadCpuTime();
+        m_EnterTime = std::chrono::steady_clock::now();
+    }
+
+    void MeasuringProbe::Leave()
+    {
+        const auto leaveTime = std::chrono::steady_clock::now();
+        m_CpuTime += GetThreadCpuTime() - m_EnterCpuTime;
+        m_Allocations += AllocationCounter::CountThread() - m_EnterAllocations;
+        m_Durations.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(leaveTime - m_EnterTime).count());
+        ++m_Calls;
+    }
+
+    void MeasuringProbe::Reset()
+    {
+        m_Durations.Reset();
+        m_Calls = 0;
+        m_CpuTime = 0;
+        m_Allocations = 0;
+    }
+
+    void WaitUntil(const std::chrono::steady_clock::time_point time)
+    {
+        const auto sleepTime = time - k_SpinDuration;
+        if (std::chrono::steady_clock::now() < sleepTime)
+            std::this_thread::sleep_until(sleepTime);
+
+        while (std::chrono::steady_clock::now() < time)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    BenchmarkOptions::BenchmarkOptions(const int argc, char** argv)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            if (std::strncmp(argv[i], "--", 2) != 0)
+                continue;
+
+            const std::string name(argv[i] + 2);
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+            {
+                m_Values[name] = argv[++i];
+            }
+            else
+            {
+                m_Values[name] = "";
+            }
+        }
+    }
+
+    bool BenchmarkOptions::Has(const std::string& name) const
+    {
+        return m_Values.find(name) != m_Values.end();
+    }
+
+    std::string BenchmarkOptions::GetString(const std::string& name, const std::string& fallback) const
+    {
+        const auto it = m_Values.find(name);
+        return it != m_Values.end() && !it->second.empty() ? it->second : fallback;
+    }
+
+    std::int64_t BenchmarkOptions::GetInt(const std::string& name, const std::int64_t fallback) const
+    {
+        const auto value = GetString(name, "");
+        return value.empty() ? fallback : std::strtoll(value.c_str(), nullptr, 10);
+    }
+
+    double BenchmarkOptions::GetDouble(const std::string& name, const double fallback) const
+    {
+        const auto value = GetString(name, "");
+        return value.empty() ? fallback : std::strtod(value.c_str(), nullptr);
+    }
+
+    std::vector<std::string> BenchmarkOptions::GetList(const std::string& name, const std::vector<std::string>& fallback) const
+    {
+        const auto value = GetString(name, "");
+        if (value.empty())
+            return fallback;
+
+        std::vector<std::string> list;
+        std::size_t start = 0;
+        while (start <= value.size())
+        {
+            auto end = value.find(',', start);
+            if (end == std::string::npos)
+                end = value.size();
+
+            if (end > start)
+                list.push_back(value.substr(start, end - start));
+            start = end + 1;
+        }
+        return list;
+    }
+
+    std::vector<std::string> BenchmarkOptions::GetUnknown(const std::vector<std::string>& known) const
+    {
+        std::vector<std::string> unknown;
+        for (const auto& value : m_Values)
+        {
+            if (std::find(known.begin(), known.end(), value.first) == known.end())
+                unknown.push_back(value.first);
+        }
+        return unknown;
+    }
+
+    bool StartVirtualCapture(DeckLinkInputDevice* device, VirtualDeckLink* card, const int deviceIndex, const int deviceSelected,
+                             const VirtualMode& mode, const BMDPixelFormat pixelFormat, std::string& error)
+    {
+        const auto& modes = GetVirtualModes();
+        const auto startFormatIndex = modes[0].displayMode != mode.displayMode ? 0 : 1;
+
+        if (!device->Start(deviceIndex, deviceSelected, startFormatIndex, pixelFormat, false, kUnityGfxRendererNull, nullptr))
+        {
+            error = device->GetErrorString();
+            return false;
+        }
+
+        if (!card->ChangeInputFormat(mode.displayMode, GetDetectedFlags(pixelFormat)))
+        {
+            error = "The input didn't accept the format change.";
+            return false;
+        }
+
+        DeckLinkInputDevice::InputVideoFormatData format;
+        device->GetSelectedFormat(&format);
+        if (format.mode != static_cast<int32_t>(mode.displayMode) || format.formatCode != static_cast<int32_t>(pixelFormat))
+        {
+            error = "The input didn't switch to the format.";
+            return false;
+        }
+        return true;
+    }
+
+    const char* GetPixelFormatName(const BMDPixelFormat pixelFormat)
+    {
+        for (const auto& entry : k_PixelFormatNames)
+        {
+            if (entry.pixelFormat == pixelFormat)
+                return entry.name;
+        }
+        return "Unknown";
+    }
+
+    bool FindPixelFormat(const std::string& name, BMDPixelFormat& pixelFormat)
+    {
+        for (const auto& entry : k_PixelFormatNames)
+        {
+            if (name == entry.name)
+            {
+                pixelFormat = entry.pixelFormat;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    JsonWriter::JsonWriter() :
+        m_AfterKey(false)
+    {
+    }
+
+    void JsonWriter::BeginObject()
+    {
+        BeginValue();
+        m_Text += '{';
+        m_HasMembers.push_back(false);
+    }
+
+    void JsonWriter::EndObject()
+    {
+        const auto hasMembers = m_HasMembers.back();
+        m_HasMembers.pop_back();
+        if (hasMembers)
+            Indent();
+        m_Text += '}';
+    }
+
+    void JsonWriter::BeginArray()
+    {
+        BeginValue();
+        m_Text += '[';
+        m_HasMembers.push_back(false);
+    }
+
+    void JsonWriter::EndArray()
+    {
+        EndObject();
+        m_Text.back() = ']';
+    }
+
+    void JsonWriter::Key(const char* key)
+    {
+        BeginValue();
+        WriteString(key);
+        m_Text += ": ";
+        m_AfterKey = true;
+    }
+
+    void JsonWriter::Value(const std::string& value)
+    {
+        Value(value.c_str());
+    }
+
+    void JsonWriter::Value(const char* value)
+    {
+        BeginValue();
+        WriteString(value);
+    }
+
+    void JsonWriter::Value(const std::int64_t value)
+    {
+        BeginValue();
+        m_Text += std::to_string(value);
+    }
+
+    void JsonWriter::Value(const std::uint64_t value)
+    {
+        BeginValue();
+        m_Text += std::to_string(value);
+    }
+
+    void JsonWriter::Value(const int value)
+    {
+        Value(static_cast<std::int64_t>(value));
+    }
+
+    void JsonWriter::Value(const double value)
+    {
+        BeginValue();
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", value);
+        m_Text += text;
+    }
+
+    void JsonWriter::Value(const bool value)
+    {
+        BeginValue();
+        m_Text += value ? "true" : "false";
+    }
+
+    void JsonWriter::Durations(const LatencyHistogram& histogram)
+    {
+        MetricSummary summary = {};
+        histogram.Summarize(summary);
+
+        BeginObject();
+        Member("count", summary.count);
+        Member("minUs", summary.min / 1000.0);
+        Member("meanUs", summary.mean / 1000.0);
+        Member("p50Us", summary.p50 / 1000.0);
+        Member("p90Us", summary.p90 / 1000.0);
+        Member("p99Us", summary.p99 / 1000.0);
+        Member("p999Us", summary.p999 / 1000.0);
+        Member("maxUs", summary.max / 1000.0);
+        EndObject();
+    }
+
+    bool JsonWriter::Save(const std::string& path) const
+    {
+        if (path == "-")
+        {
+            std::fwrite(m_Text.data(), 1, m_Text.size(), stdout);
+            std::fputc('\n', stdout);
+            return true;
+        }
+
+        auto file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        const auto written = std::fwrite(m_Text.data(), 1, m_Text.size(), file) == m_Text.size();
+        std::fputc('\n', file);
+        return std::fclose(file) == 0 && written;
+    }
+
+    void JsonWriter::BeginValue()
+    {
+        // A value after a key continues the member.
+        if (m_AfterKey)
+        {
+            m_AfterKey = false;
+            return;
+        }
+
+        if (m_HasMembers.empty())
+            return;
+
+        if (m_HasMembers.back())
+            m_Text += ',';
+        m_HasMembers.back() = true;
+        Indent();
+    }
+
+    void JsonWriter::WriteString(const char* value)
+    {
+        m_Text += '"';
+        for (auto c = value; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                m_Text += '\\';
+                m_Text += *c;
+            }
+            else if (static_cast<unsigned char>(*c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                m_Text += escaped;
+            }
+            else
+            {
+                m_Text += *c;
+            }
+        }
+        m_Text += '"';
+    }
+
+    void JsonWriter::Indent()
+    {
+        m_Text += '\n';
+        m_Text.append(m_HasMembers.size() * 2, ' ');
+    }
+}
+}
+
+// The global allocation functions, replaced to count the allocations. Every form of operator new
+// is replaced along with its operator delete, so each pointer goes back to the allocator it came
+// from: std::malloc or posix_memalign, then std::free.
+
+namespace
+{
+    void* Allocate(const std::size_t size, const std::size_t alignment)
+    {
+        MediaBlackmagic::Benchmark::AllocationCounter::Count(size);
+        if (alignment <= alignof(std::max_align_t))
+            return std::malloc(size != 0 ? size : 1);
+
+        void* pointer = nullptr;
+        return posix_memalign(&pointer, alignment, size != 0 ? size : 1) == 0 ? pointer : nullptr;
+    }
+}
+
+void* operator new(const std::size_t size)
+{
+    if (auto pointer = Allocate(size, 0))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size, 0);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size, 0);
+}
+
+// GCC can't tell the replaced operator new allocates with std::malloc, and reports the std::free
+// of its pointers as mismatched once a delete expression is inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    if (auto pointer = Allocate(size, static_cast<std::size_t>(alignment)))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
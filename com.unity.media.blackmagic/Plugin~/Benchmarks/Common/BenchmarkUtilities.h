@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "VirtualDeckLink.h"
+#include "../../Includes/DeckLinkDeviceMetrics.h"
+
+namespace MediaBlackmagic
+{
+    class DeckLinkInputDevice;
+
+namespace Benchmark
+{
+    // Counts the calls to the global operator new, which the benchmarks replace. The counts of the
+    // calling thread and of the whole process are kept apart, so the plugin callbacks can be
+    // measured alone while the other threads keep allocating.
+    class AllocationCounter final
+    {
+    public:
+        static std::uint64_t CountThread();
+        static std::uint64_t CountProcess();
+
+        static void Count(std::size_t size);
+    };
+
+    // Allocations of the virtual driver itself, which the benchmarks leave out of their counts.
+    class UncountedAllocationScope final
+    {
+    public:
+        UncountedAllocationScope();
+        ~UncountedAllocationScope();
+
+        UncountedAllocationScope(const UncountedAllocationScope&) = delete;
+        UncountedAllocationScope& operator=(const UncountedAllocationScope&) = delete;
+
+        static bool IsActive();
+    };
+
+    // CPU time and system counters, from the kernel.
+    std::int64_t GetThreadCpuTime();        // CPU time of the calling thread, in nanoseconds.
+    std::int64_t GetProcessCpuTime();       // User and system time of every thread, in nanoseconds.
+    std::int64_t CountContextSwitches();    // Voluntary and involuntary, for the whole process.
+    std::int64_t GetResidentBytes();
+    std::int64_t GetHeapBytes();            // In use in the malloc heap, including the mapped blocks.
+    int CountThreads();
+    int CountFileDescriptors();
+
+    // Measures the plugin code run by the virtual driver on one thread: its duration, its CPU time
+    // and the allocations it makes. Not thread-safe, except for the histogram.
+    class MeasuringProbe final : public VirtualCallProbe
+    {
+    public:
+        MeasuringProbe();
+
+        void Enter() override;
+        void Leave() override;
+
+        // Forgets the calls so far, after the warm-up.
+        void Reset();
+
+        inline std::uint64_t GetCalls() const { return m_Calls; }
+        inline std::int64_t GetCpuTime() const { return m_CpuTime; }
+        inline std::uint64_t GetAllocations() const { return m_Allocations; }
+        inline const LatencyHistogram& GetDurations() const { return m_Durations; }
+
+    private:
+        LatencyHistogram                        m_Durations;
+        std::uint64_t                           m_Calls;
+        std::int64_t                            m_CpuTime;
+        std::uint64_t                           m_Allocations;
+
+        std::chrono::steady_clock::time_point   m_EnterTime;
+        std::int64_t                            m_EnterCpuTime;
+        std::uint64_t                           m_EnterAllocations;
+    };
+
+    // Sleeps until the given time, then spins for the last part, so paced deliveries keep the
+    // cadence of the card without a core spinning all the time.
+    void WaitUntil(std::chrono::steady_clock::time_point time);
+
+    // Options given as '--name value' or '--flag'. Lists are comma-separated.
+    class BenchmarkOptions final
+    {
+    public:
+        BenchmarkOptions(int argc, char** argv);
+
+        bool Has(const std::string& name) const;
+        std::string GetString(const std::string& name, const std::string& fallback) const;
+        std::int64_t GetInt(const std::string& name, std::int64_t fallback) const;
+        double GetDouble(const std::string& name, double fallback) const;
+        std::vector<std::string> GetList(const std::string& name, const std::vector<std::string>& fallback) const;
+
+        // The options which aren't among the given ones, so a typo doesn't go unnoticed.
+        std::vector<std::string> GetUnknown(const std::vector<std::string>& known) const;
+
+    private:
+        std::map<std::string, std::string> m_Values;
+    };
+
+    // Starts the input device on the card in the mode and pixel format. The plugin opens the input
+    // in 8-bit YUV and applies the pixel format on a format change, so the input starts in another
+    // mode and the card then detects the tested one.
+    bool StartVirtualCapture(DeckLinkInputDevice* device, VirtualDeckLink* card, int deviceIndex, int deviceSelected,
+                             const VirtualMode& mode, BMDPixelFormat pixelFormat, std::string& error);
+
+    // Short names of the pixel formats on the command lines and in the results.
+    const char* GetPixelFormatName(BMDPixelFormat pixelFormat);
+    bool FindPixelFormat(const std::string& name, BMDPixelFormat& pixelFormat);
+
+    // Streaming JSON writer. Commas and indentation follow the nesting.
+    class JsonWriter final
+    {
+    public:
+        JsonWriter();
+
+        void BeginObject();
+        void EndObject();
+        void BeginArray();
+        void EndArray();
+
+        void Key(const char* key);
+        void Value(const std::string& value);
+        void Value(const char* value);
+        void Value(std::int64_t value);
+        void Value(std::uint64_t value);
+        void Value(int value);
+        void Value(double value);
+        void Value(bool value);
+
+        // The percentiles of a histogram, scaled from nanoseconds to microseconds.
+        void Durations(const LatencyHistogram& histogram);
+
+        template <typename T>
+        void Member(const char* key, const T& value)
+        {
+            Key(key);
+            Value(value);
+        }
+
+        inline const std::string& GetText() const { return m_Text; }
+
+        // Writes the text to the file, or to the standard output for "-".
+        bool Save(const std::string& path) const;
+
+    private:
+        void BeginValue();
+        void WriteString(const char* value);
+        void Indent();
+
+        std::string         m_Text;
+        std::vector<bool>   m_HasMembers;   // One level per open object or array.
+        bool                m_AfterKey;
+    };
+}
+}
@@ -0,0 +1,1783 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "VirtualDeckLink.h"
+#include "BenchmarkUtilities.h"
+#include "../../Includes/DeckLinkCapabilitySnapshot.h"
+#include "../../Includes/DeckLinkDeviceUtilities.h"
+#include "../../Includes/DeckLinkInputFramePool.h"
+
+namespace MediaBlackmagic
+{
+namespace Benchmark
+{
+    namespace
+    {
+        const std::vector<VirtualMode> k_VirtualModes =
+        {
+            { bmdModeHD1080p5994, "1080p5994", 1920, 1080, 1001, 60000, false },
+            { bmdMode4K2160p5994, "2160p5994", 3840, 2160, 1001, 60000, false },
+            { bmdMode4kDCI5994, "4KDCI5994", 4096, 2160, 1001, 60000, false },
+            { bmdMode8K4320p5994, "4320p5994", 7680, 4320, 1001, 60000, true },
+            { bmdMode8kDCI5994, "8KDCI5994", 8192, 4320, 1001, 60000, true },
+        };
+
+        const std::int64_t k_AudioSampleRate = 48000;
+        const std::int32_t k_AudioChannelCount = 2;
+        const std::int32_t k_AudioSampleBytes = 2;
+        const auto k_StopGracePeriod = std::chrono::milliseconds(50);
+
+        bool IsSupportedPixelFormat(const BMDPixelFormat pixelFormat)
+        {
+            return pixelFormat != bmdFormatH265 && DeckLinkCapabilitySnapshot::GetPixelFormatBit(pixelFormat) >= 0;
+        }
+
+        BMDTimeValue GetTime(const std::chrono::steady_clock::duration duration, const BMDTimeScale timeScale)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() * timeScale / 1000000000;
+        }
+
+        // The interfaces whose objects are counted, in the order of the counts. The last entry
+        // stands for the interfaces missing from the list.
+        const struct
+        {
+            REFIID          iid;
+            const char*     name;
+        } k_CountedInterfaces[] =
+        {
+            { IID_IDeckLink, "IDeckLink" },
+            { IID_IDeckLinkIterator, "IDeckLinkIterator" },
+            { IID_IDeckLinkDiscovery, "IDeckLinkDiscovery" },
+            { IID_IDeckLinkProfileAttributes, "IDeckLinkProfileAttributes" },
+            { IID_IDeckLinkConfiguration, "IDeckLinkConfiguration" },
+            { IID_IDeckLinkStatus, "IDeckLinkStatus" },
+            { IID_IDeckLinkInput, "IDeckLinkInput" },
+            { IID_IDeckLinkOutput, "IDeckLinkOutput" },
+            { IID_IDeckLinkDisplayModeIterator, "IDeckLinkDisplayModeIterator" },
+            { IID_IDeckLinkDisplayMode, "IDeckLinkDisplayMode" },
+            { IID_IDeckLinkVideoInputFrame, "IDeckLinkVideoInputFrame" },
+            { IID_IDeckLinkAudioInputPacket, "IDeckLinkAudioInputPacket" },
+            { IID_IDeckLinkMutableVideoFrame, "IDeckLinkMutableVideoFrame" },
+            { IID_IUnknown, "Other" },
+        };
+
+        const int k_CountedInterfaceCount = sizeof(k_CountedInterfaces) / sizeof(k_CountedInterfaces[0]);
+        const int k_DeckLinkCountIndex = 0;     // The cards, which don't derive from VirtualUnknown.
+
+        // Live objects and references per interface, updated by every virtual object.
+        std::atomic<std::int64_t> s_LiveObjects[k_CountedInterfaceCount];
+        std::atomic<std::int64_t> s_LiveReferences[k_CountedInterfaceCount];
+
+        int FindCountedInterface(const REFIID& iid)
+        {
+            for (auto i = 0; i < k_CountedInterfaceCount - 1; ++i)
+            {
+                if (k_CountedInterfaces[i].iid == iid)
+                    return i;
+            }
+            return k_CountedInterfaceCount - 1;
+        }
+
+        // Counts an object from its creation to its destruction, and the references held to it.
+        class ObjectCount final
+        {
+        public:
+            explicit ObjectCount(const REFIID& iid) :
+                m_Index(FindCountedInterface(iid))
+            {
+                s_LiveObjects[m_Index].fetch_add(1, std::memory_order_relaxed);
+                s_LiveReferences[m_Index].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            ~ObjectCount()
+            {
+                s_LiveObjects[m_Index].fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            ObjectCount(const ObjectCount&) = delete;
+            ObjectCount& operator=(const ObjectCount&) = delete;
+
+            inline void AddRef() { s_LiveReferences[m_Index].fetch_add(1, std::memory_order_relaxed); }
+            inline void Release() { s_LiveReferences[m_Index].fetch_sub(1, std::memory_order_relaxed); }
+
+        private:
+            const int   m_Index;
+        };
+
+        // Reference counting of the virtual objects, which implement a single interface.
+        template <typename Interface>
+        class VirtualUnknown : public Interface
+        {
+        public:
+            explicit VirtualUnknown(const REFIID& iid) :
+                m_Iid(iid),
+                m_ObjectCount(iid),
+                m_RefCount(1)
+            {
+            }
+
+            HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override
+            {
+                if (iid == IID_IUnknown || iid == m_Iid)
+                {
+                    *ppv = static_cast<Interface*>(this);
+                    AddRef();
+                    return S_OK;
+                }
+
+                *ppv = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            ULONG STDMETHODCALLTYPE AddRef() override
+            {
+                m_ObjectCount.AddRef();
+                return m_RefCount.fetch_add(1) + 1;
+            }
+
+            ULONG STDMETHODCALLTYPE Release() override
+            {
+                m_ObjectCount.Release();
+                const auto count = m_RefCount.fetch_sub(1) - 1;
+                if (count == 0)
+                    delete this;
+                return count;
+            }
+
+        protected:
+            virtual ~VirtualUnknown() = default;
+
+        private:
+            const REFIID        m_Iid;
+            ObjectCount         m_ObjectCount;
+            std::atomic<ULONG>  m_RefCount;
+        };
+
+        class VirtualDisplayMode final : public VirtualUnknown<IDeckLinkDisplayMode>
+        {
+        public:
+            explicit VirtualDisplayMode(const VirtualMode& mode) :
+                VirtualUnknown(IID_IDeckLinkDisplayMode),
+                m_Mode(mode)
+            {
+            }
+
+            HRESULT STDMETHODCALLTYPE GetName(const char** name) override
+            {
+                *name = StdToDlString(m_Mode.name);
+                return S_OK;
+            }
+
+            BMDDisplayMode STDMETHODCALLTYPE GetDisplayMode() override { return m_Mode.displayMode; }
+            long STDMETHODCALLTYPE GetWidth() override { return m_Mode.width; }
+            long STDMETHODCALLTYPE GetHeight() override { return m_Mode.height; }
+
+            HRESULT STDMETHODCALLTYPE GetFrameRate(BMDTimeValue* frameDuration, BMDTimeScale* timeScale) override
+            {
+                *frameDuration = m_Mode.frameDuration;
+                *timeScale = m_Mode.timeScale;
+                return S_OK;
+            }
+
+            BMDFieldDominance STDMETHODCALLTYPE GetFieldDominance() override { return bmdProgressiveFrame; }
+
+            BMDDisplayModeFlags STDMETHODCALLTYPE GetFlags() override
+            {
+                return m_Mode.height > 1080 ? bmdDisplayModeColorspaceRec2020 : bmdDisplayModeColorspaceRec709;
+            }
+
+        private:
+            const VirtualMode m_Mode;
+        };
+
+        class VirtualDisplayModeIterator final : public VirtualUnknown<IDeckLinkDisplayModeIterator>
+        {
+        public:
+            VirtualDisplayModeIterator() :
+                VirtualUnknown(IID_IDeckLinkDisplayModeIterator),
+                m_Next(0)
+            {
+            }
+
+            HRESULT STDMETHODCALLTYPE Next(IDeckLinkDisplayMode** mode) override
+            {
+                const auto& modes = GetVirtualModes();
+                if (m_Next >= modes.size())
+                {
+                    *mode = nullptr;
+                    return S_FALSE;
+                }
+
+                *mode = new VirtualDisplayMode(modes[m_Next++]);
+                return S_OK;
+            }
+
+        private:
+            std::size_t m_Next;
+        };
+
+        HRESULT CreateDisplayMode(const BMDDisplayMode displayMode, IDeckLinkDisplayMode** result)
+        {
+            const auto mode = FindVirtualMode(displayMode);
+            if (mode == nullptr)
+            {
+                *result = nullptr;
+                return E_INVALIDARG;
+            }
+
+            *result = new VirtualDisplayMode(*mode);
+            return S_OK;
+        }
+
+        HRESULT DoesSupportMode(const BMDDisplayMode requestedMode, const BMDPixelFormat pixelFormat, BMDDisplayMode* actualMode, dlbool_t* supported)
+        {
+            *supported = FindVirtualMode(requestedMode) != nullptr && IsSupportedPixelFormat(pixelFormat);
+            if (actualMode != nullptr)
+            {
+                *actualMode = *supported ? requestedMode : static_cast<BMDDisplayMode>(bmdModeUnknown);
+            }
+            return S_OK;
+        }
+
+        // Frames and packets hold their own reference to the card, so they may outlive the input.
+        class VirtualVideoInputFrame final : public VirtualUnknown<IDeckLinkVideoInputFrame>
+        {
+        public:
+            VirtualVideoInputFrame(const VirtualMode& mode, const BMDPixelFormat pixelFormat, const BMDFrameFlags flags,
+                                   const BMDTimeValue streamTime, const BMDTimeValue hardwareTime) :
+                VirtualUnknown(IID_IDeckLinkVideoInputFrame),
+                m_Mode(mode),
+                m_PixelFormat(pixelFormat),
+                m_Flags(flags),
+                m_RowBytes(DeckLinkInputFramePool::GetRowBytes(pixelFormat, mode.width)),
+                m_StreamTime(streamTime),
+                m_HardwareTime(hardwareTime),
+                m_Allocator(nullptr),
+                m_Buffer(nullptr)
+            {
+            }
+
+            // Takes the frame buffer from the allocator, or from the heap without one.
+            bool AllocateBuffer(IDeckLinkMemoryAllocator* allocator)
+            {
+                const auto size = m_RowBytes * static_cast<std::uint32_t>(m_Mode.height);
+                if (allocator != nullptr)
+                {
+                    if (allocator->AllocateBuffer(size, &m_Buffer) != S_OK)
+                        return false;
+
+                    m_Allocator = allocator;
+                    m_Allocator->AddRef();
+                    return true;
+                }
+
+                m_Buffer = AllocatePageAlignedBuffer(size);
+                return m_Buffer != nullptr;
+            }
+
+            long STDMETHODCALLTYPE GetWidth() override { return m_Mode.width; }
+            long STDMETHODCALLTYPE GetHeight() override { return m_Mode.height; }
+            long STDMETHODCALLTYPE GetRowBytes() override { return m_RowBytes; }
+            BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat() override { return m_PixelFormat; }
+            BMDFrameFlags STDMETHODCALLTYPE GetFlags() override { return m_Flags; }
+
+            HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) override
+            {
+                *buffer = m_Buffer;
+                return m_Buffer != nullptr ? S_OK : E_FAIL;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetTimecode(BMDTimecodeFormat, IDeckLinkTimecode** timecode) override
+            {
+                *timecode = nullptr;
+                return S_FALSE;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) override
+            {
+                *ancillary = nullptr;
+                return S_FALSE;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetStreamTime(BMDTimeValue* frameTime, BMDTimeValue* frameDuration, const BMDTimeScale timeScale) override
+            {
+                *frameTime = m_StreamTime * timeScale / m_Mode.timeScale;
+                *frameDuration = m_Mode.frameDuration * timeScale / m_Mode.timeScale;
+                return S_OK;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetHardwareReferenceTimestamp(const BMDTimeScale timeScale, BMDTimeValue* frameTime, BMDTimeValue* frameDuration) override
+            {
+                *frameTime = m_HardwareTime * timeScale / m_Mode.timeScale;
+                *frameDuration = m_Mode.frameDuration * timeScale / m_Mode.timeScale;
+                return S_OK;
+            }
+
+        private:
+            ~VirtualVideoInputFrame() override
+            {
+                if (m_Allocator != nullptr)
+                {
+                    m_Allocator->ReleaseBuffer(m_Buffer);
+                    m_Allocator->Release();
+                }
+                else if (m_Buffer != nullptr)
+                {
+                    FreePageAlignedBuffer(m_Buffer);
+                }
+            }
+
+            const VirtualMode           m_Mode;
+            const BMDPixelFormat        m_PixelFormat;
+            const BMDFrameFlags         m_Flags;
+            const std::uint32_t         m_RowBytes;
+            const BMDTimeValue          m_StreamTime;
+            const BMDTimeValue          m_HardwareTime;
+            IDeckLinkMemoryAllocator*   m_Allocator;
+            void*                       m_Buffer;
+        };
+
+        class VirtualAudioInputPacket final : public VirtualUnknown<IDeckLinkAudioInputPacket>
+        {
+        public:
+            VirtualAudioInputPacket(void* buffer, const long sampleFrameCount, const BMDTimeValue packetTime) :
+                VirtualUnknown(IID_IDeckLinkAudioInputPacket),
+                m_Buffer(buffer),
+                m_SampleFrameCount(sampleFrameCount),
+                m_PacketTime(packetTime)
+            {
+            }
+
+            long STDMETHODCALLTYPE GetSampleFrameCount() override { return m_SampleFrameCount; }
+
+            HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) override
+            {
+                *buffer = m_Buffer;
+                return S_OK;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetPacketTime(BMDTimeValue* packetTime, const BMDTimeScale timeScale) override
+            {
+                *packetTime = m_PacketTime * timeScale / k_AudioSampleRate;
+                return S_OK;
+            }
+
+        private:
+            void* const         m_Buffer;
+            const long          m_SampleFrameCount;
+            const BMDTimeValue  m_PacketTime;       // In samples.
+        };
+
+        // The frames created for the output. The buffer is page-aligned, as the one of the driver.
+        class VirtualMutableVideoFrame final : public VirtualUnknown<IDeckLinkMutableVideoFrame>
+        {
+        public:
+            VirtualMutableVideoFrame(const std::int32_t width, const std::int32_t height, const std::int32_t rowBytes,
+                                     const BMDPixelFormat pixelFormat, const BMDFrameFlags flags) :
+                VirtualUnknown(IID_IDeckLinkMutableVideoFrame),
+                m_Width(width),
+                m_Height(height),
+                m_RowBytes(rowBytes),
+                m_PixelFormat(pixelFormat),
+                m_Flags(flags),
+                m_Buffer(AllocatePageAlignedBuffer(static_cast<std::size_t>(rowBytes) * static_cast<std::size_t>(height)))
+            {
+            }
+
+            inline bool IsAllocated() const { return m_Buffer != nullptr; }
+
+            HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override
+            {
+                if (iid == IID_IDeckLinkVideoFrame)
+                {
+                    *ppv = static_cast<IDeckLinkVideoFrame*>(this);
+                    AddRef();
+                    return S_OK;
+                }
+                return VirtualUnknown::QueryInterface(iid, ppv);
+            }
+
+            long STDMETHODCALLTYPE GetWidth() override { return m_Width; }
+            long STDMETHODCALLTYPE GetHeight() override { return m_Height; }
+            long STDMETHODCALLTYPE GetRowBytes() override { return m_RowBytes; }
+            BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat() override { return m_PixelFormat; }
+            BMDFrameFlags STDMETHODCALLTYPE GetFlags() override { return m_Flags; }
+
+            HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) override
+            {
+                *buffer = m_Buffer;
+                return m_Buffer != nullptr ? S_OK : E_FAIL;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetTimecode(BMDTimecodeFormat, IDeckLinkTimecode** timecode) override
+            {
+                *timecode = nullptr;
+                return S_FALSE;
+            }
+
+            HRESULT STDMETHODCALLTYPE GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) override
+            {
+                *ancillary = nullptr;
+                return S_FALSE;
+            }
+
+            HRESULT STDMETHODCALLTYPE SetFlags(const BMDFrameFlags flags) override
+            {
+                m_Flags = flags;
+                return S_OK;
+            }
+
+            // The timecodes and the ancillary data aren't played out: they are only accepted.
+            HRESULT STDMETHODCALLTYPE SetTimecode(BMDTimecodeFormat, IDeckLinkTimecode*) override { return S_OK; }
+            HRESULT STDMETHODCALLTYPE SetTimecodeFromComponents(BMDTimecodeFormat, uint8_t, uint8_t, uint8_t, uint8_t, BMDTimecodeFlags) override { return S_OK; }
+            HRESULT STDMETHODCALLTYPE SetAncillaryData(IDeckLinkVideoFrameAncillary*) override { return S_OK; }
+            HRESULT STDMETHODCALLTYPE SetTimecodeUserBits(BMDTimecodeFormat, BMDTimecodeUserBits) override { return S_OK; }
+
+        private:
+            ~VirtualMutableVideoFrame() override
+            {
+                if (m_Buffer != nullptr)
+                    FreePageAlignedBuffer(m_Buffer);
+            }
+
+            const std::int32_t      m_Width;
+            const std::int32_t      m_Height;
+            const std::int32_t      m_RowBytes;
+            const BMDPixelFormat    m_PixelFormat;
+            BMDFrameFlags           m_Flags;
+            void* const             m_Buffer;
+        };
+
+        class VirtualAttributes final : public VirtualUnknown<IDeckLinkProfileAttributes>
+        {
+        public:
+            explicit VirtualAttributes(const VirtualDeviceDescription& description) :
+                VirtualUnknown(IID_IDeckLinkProfileAttributes),
+                m_Description(description)
+            {
+            }
+
+            HRESULT STDMETHODCALLTYPE GetFlag(const BMDDeckLinkAttributeID id, dlbool_t* value) override
+            {
+                switch (id)
+                {
+                case BMDDeckLinkSupportsInputFormatDetection:
+                case BMDDeckLinkSupportsDualLinkSDI:
+                case BMDDeckLinkSupportsQuadLinkSDI:
+                    *value = true;
+                    return S_OK;
+                case BMDDeckLinkSupportsInternalKeying:
+                case BMDDeckLinkSupportsExternalKeying:
+                    *value = false;
+                    return S_OK;
+                default:
+                    return E_INVALIDARG;
+                }
+            }
+
+            HRESULT STDMETHODCALLTYPE GetInt(const BMDDeckLinkAttributeID id, dllonglong* value) override
+            {
+                switch (id)
+                {
+                case BMDDeckLinkPersistentID:
+                    *value = m_Description.persistentId;
+                    return S_OK;
+                case BMDDeckLinkDuplex:
+                    *value = bmdDuplexFull;
+                    return S_OK;
+                case BMDDeckLinkVideoIOSupport:
+                    *value = (m_Description.capture ? bmdDeviceSupportsCapture : 0) |
+                             (m_Description.playback ? bmdDeviceSupportsPlayback : 0);
+                    return S_OK;
+                case BMDDeckLinkMaximumAudioChannels:
+                    *value = 16;
+                    return S_OK;
+                default:
+                    return E_INVALIDARG;
+                }
+            }
+
+            HRESULT STDMETHODCALLTYPE GetFloat(BMDDeckLinkAttributeID, double*) override { return E_INVALIDARG; }
+            HRESULT STDMETHODCALLTYPE GetString(BMDDeckLinkAttributeID, const char**) override { return E_INVALIDARG; }
+
+        private:
+            const VirtualDeviceDescription m_Description;
+        };
+    }
+
+    // The interfaces below share the state of their card, and keep it alive.
+
+    class VirtualConfiguration final : public VirtualUnknown<IDeckLinkConfiguration>
+    {
+    public:
+        explicit VirtualConfiguration(VirtualDeckLink* device) :
+            VirtualUnknown(IID_IDeckLinkConfiguration),
+            m_Device(device)
+        {
+            m_Device->AddRef();
+        }
+
+        HRESULT STDMETHODCALLTYPE SetFlag(const BMDDeckLinkConfigurationID id, const dlbool_t value) override { return Set(id, value ? 1 : 0); }
+
+        HRESULT STDMETHODCALLTYPE GetFlag(const BMDDeckLinkConfigurationID id, dlbool_t* value) override
+        {
+            *value = Get(id) != 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetInt(const BMDDeckLinkConfigurationID id, const dllonglong value) override { return Set(id, value); }
+
+        HRESULT STDMETHODCALLTYPE GetInt(const BMDDeckLinkConfigurationID id, dllonglong* value) override
+        {
+            *value = Get(id);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetFloat(BMDDeckLinkConfigurationID, double) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE GetFloat(BMDDeckLinkConfigurationID, double*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE SetString(BMDDeckLinkConfigurationID, const char*) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE GetString(BMDDeckLinkConfigurationID, const char**) override { return E_NOTIMPL; }
+        HRESULT STDMETHODCALLTYPE WriteConfigurationToPreferences() override { return S_OK; }
+
+    private:
+        ~VirtualConfiguration() override
+        {
+            m_Device->Release();
+        }
+
+        HRESULT Set(const BMDDeckLinkConfigurationID id, const std::int64_t value)
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_ConfigurationMutex);
+            m_Device->m_Configuration[id] = value;
+            return S_OK;
+        }
+
+        std::int64_t Get(const BMDDeckLinkConfigurationID id)
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_ConfigurationMutex);
+            const auto it = m_Device->m_Configuration.find(id);
+            return it != m_Device->m_Configuration.end() ? it->second : 0;
+        }
+
+        VirtualDeckLink* const m_Device;
+    };
+
+    namespace
+    {
+        class VirtualStatus final : public VirtualUnknown<IDeckLinkStatus>
+        {
+        public:
+            explicit VirtualStatus(VirtualDeckLink* device) :
+                VirtualUnknown(IID_IDeckLinkStatus),
+                m_Device(device)
+            {
+                m_Device->AddRef();
+            }
+
+            HRESULT STDMETHODCALLTYPE GetFlag(const BMDDeckLinkStatusID id, dlbool_t* value) override
+            {
+                switch (id)
+                {
+                case bmdDeckLinkStatusVideoInputSignalLocked:
+                    *value = m_Device->IsInputStreaming();
+                    return S_OK;
+                case bmdDeckLinkStatusReferenceSignalLocked:
+                    *value = false;
+                    return S_OK;
+                default:
+                    return E_INVALIDARG;
+                }
+            }
+
+            HRESULT STDMETHODCALLTYPE GetInt(const BMDDeckLinkStatusID id, dllonglong* value) override
+            {
+                switch (id)
+                {
+                case bmdDeckLinkStatusCurrentVideoInputPixelFormat:
+                    *value = m_Device->GetInputPixelFormat();
+                    return S_OK;
+                case bmdDeckLinkStatusCurrentVideoInputMode:
+                    *value = m_Device->GetInputMode();
+                    return S_OK;
+                case bmdDeckLinkStatusDeviceTemperature:
+                    *value = 45;
+                    return S_OK;
+                default:
+                    return E_INVALIDARG;
+                }
+            }
+
+            HRESULT STDMETHODCALLTYPE GetFloat(BMDDeckLinkStatusID, double*) override { return E_INVALIDARG; }
+            HRESULT STDMETHODCALLTYPE GetString(BMDDeckLinkStatusID, const char**) override { return E_INVALIDARG; }
+            HRESULT STDMETHODCALLTYPE GetBytes(BMDDeckLinkStatusID, void*, uint32_t*) override { return E_INVALIDARG; }
+
+        private:
+            ~VirtualStatus() override
+            {
+                m_Device->Release();
+            }
+
+            VirtualDeckLink* const m_Device;
+        };
+    }
+
+    class VirtualInput final : public VirtualUnknown<IDeckLinkInput>
+    {
+    public:
+        explicit VirtualInput(VirtualDeckLink* device) :
+            VirtualUnknown(IID_IDeckLinkInput),
+            m_Device(device)
+        {
+            m_Device->AddRef();
+
+            std::lock_guard<std::mutex> lock(m_Device->m_InputMutex);
+            m_Device->m_InputInterfaces++;
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override
+        {
+            // The plugin reaches the configuration from the input as well.
+            if (iid == IID_IDeckLinkConfiguration)
+            {
+                *ppv = static_cast<IDeckLinkConfiguration*>(new VirtualConfiguration(m_Device));
+                return S_OK;
+            }
+            return VirtualUnknown::QueryInterface(iid, ppv);
+        }
+
+        HRESULT STDMETHODCALLTYPE DoesSupportVideoMode(BMDVideoConnection, const BMDDisplayMode requestedMode, const BMDPixelFormat pixelFormat,
+                                                       BMDVideoInputConversionMode, BMDSupportedVideoModeFlags,
+                                                       BMDDisplayMode* actualMode, dlbool_t* supported) override
+        {
+            return DoesSupportMode(requestedMode, pixelFormat, actualMode, supported);
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDisplayMode(const BMDDisplayMode displayMode, IDeckLinkDisplayMode** result) override
+        {
+            return CreateDisplayMode(displayMode, result);
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDisplayModeIterator(IDeckLinkDisplayModeIterator** iterator) override
+        {
+            *iterator = new VirtualDisplayModeIterator();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetScreenPreviewCallback(IDeckLinkScreenPreviewCallback*) override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE EnableVideoInput(const BMDDisplayMode displayMode, const BMDPixelFormat pixelFormat, BMDVideoInputFlags) override
+        {
+            if (FindVirtualMode(displayMode) == nullptr || !IsSupportedPixelFormat(pixelFormat))
+                return E_INVALIDARG;
+
+            m_Device->m_InputMode = displayMode;
+            m_Device->m_InputPixelFormat = pixelFormat;
+            m_Device->m_InputEnabled = true;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE DisableVideoInput() override
+        {
+            m_Device->m_InputEnabled = false;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetAvailableVideoFrameCount(uint32_t* availableFrameCount) override
+        {
+            *availableFrameCount = 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetVideoInputFrameMemoryAllocator(IDeckLinkMemoryAllocator* allocator) override
+        {
+            if (allocator != nullptr)
+                allocator->AddRef();
+
+            std::lock_guard<std::mutex> lock(m_Device->m_InputMutex);
+            if (m_Device->m_InputAllocator != nullptr)
+                m_Device->m_InputAllocator->Release();
+            m_Device->m_InputAllocator = allocator;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE EnableAudioInput(BMDAudioSampleRate, BMDAudioSampleType, uint32_t) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE DisableAudioInput() override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE GetAvailableAudioSampleFrameCount(uint32_t* availableSampleFrameCount) override
+        {
+            *availableSampleFrameCount = 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE StartStreams() override
+        {
+            if (!m_Device->m_InputEnabled)
+                return E_ACCESSDENIED;
+
+            m_Device->m_InputStreaming = true;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE StopStreams() override
+        {
+            // As with the driver, no callback runs once the streams are stopped.
+            m_Device->m_InputStreaming = false;
+            std::lock_guard<std::mutex> lock(m_Device->m_InputMutex);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE PauseStreams() override
+        {
+            m_Device->m_InputStreaming = false;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE FlushStreams() override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE SetCallback(IDeckLinkInputCallback* callback) override
+        {
+            if (callback != nullptr)
+                callback->AddRef();
+
+            IDeckLinkInputCallback* previous;
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_CallbackMutex);
+                previous = m_Device->m_InputCallback;
+                m_Device->m_InputCallback = callback;
+            }
+
+            if (previous != nullptr)
+                previous->Release();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetHardwareReferenceClock(const BMDTimeScale timeScale, BMDTimeValue* hardwareTime,
+                                                            BMDTimeValue* timeInFrame, BMDTimeValue* ticksPerFrame) override
+        {
+            const auto mode = FindVirtualMode(m_Device->GetInputMode());
+            *hardwareTime = GetTime(std::chrono::steady_clock::now() - m_Device->m_Epoch, timeScale);
+            *ticksPerFrame = mode != nullptr ? mode->frameDuration * timeScale / mode->timeScale : 0;
+            *timeInFrame = *ticksPerFrame > 0 ? *hardwareTime % *ticksPerFrame : 0;
+            return S_OK;
+        }
+
+    private:
+        ~VirtualInput() override
+        {
+            // The driver lets go of the memory allocator with the last reference to the input.
+            IDeckLinkMemoryAllocator* allocator = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_InputMutex);
+                if (--m_Device->m_InputInterfaces == 0)
+                    std::swap(allocator, m_Device->m_InputAllocator);
+            }
+
+            if (allocator != nullptr)
+                allocator->Release();
+            m_Device->Release();
+        }
+
+        VirtualDeckLink* const m_Device;
+    };
+
+    class VirtualOutput final : public VirtualUnknown<IDeckLinkOutput>
+    {
+    public:
+        explicit VirtualOutput(VirtualDeckLink* device) :
+            VirtualUnknown(IID_IDeckLinkOutput),
+            m_Device(device)
+        {
+            m_Device->AddRef();
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override
+        {
+            // The plugin reaches the configuration from the output as well. There is no keyer.
+            if (iid == IID_IDeckLinkConfiguration)
+            {
+                *ppv = static_cast<IDeckLinkConfiguration*>(new VirtualConfiguration(m_Device));
+                return S_OK;
+            }
+            return VirtualUnknown::QueryInterface(iid, ppv);
+        }
+
+        HRESULT STDMETHODCALLTYPE DoesSupportVideoMode(BMDVideoConnection, const BMDDisplayMode requestedMode, const BMDPixelFormat pixelFormat,
+                                                       BMDVideoOutputConversionMode, const BMDSupportedVideoModeFlags flags,
+                                                       BMDDisplayMode* actualMode, dlbool_t* supported) override
+        {
+            if ((flags & bmdSupportedVideoModeKeying) != 0)
+            {
+                *supported = false;
+                return S_OK;
+            }
+            return DoesSupportMode(requestedMode, pixelFormat, actualMode, supported);
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDisplayMode(const BMDDisplayMode displayMode, IDeckLinkDisplayMode** result) override
+        {
+            return CreateDisplayMode(displayMode, result);
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDisplayModeIterator(IDeckLinkDisplayModeIterator** iterator) override
+        {
+            *iterator = new VirtualDisplayModeIterator();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetScreenPreviewCallback(IDeckLinkScreenPreviewCallback*) override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE EnableVideoOutput(const BMDDisplayMode displayMode, BMDVideoOutputFlags) override
+        {
+            if (FindVirtualMode(displayMode) == nullptr)
+                return E_INVALIDARG;
+
+            // A playback being stopped is given the time to end, as the driver ends it within a frame
+            // period, but the wait is bounded: the plugin may hold the lock its stop callback needs.
+            std::unique_lock<std::mutex> lock(m_Device->m_OutputMutex);
+            m_Device->m_OutputCondition.wait_for(lock, k_StopGracePeriod, [this]
+            {
+                return !m_Device->m_PlaybackRunning || !m_Device->m_StopRequested;
+            });
+            if (m_Device->m_PlaybackRunning)
+                return E_ACCESSDENIED;
+
+            m_Device->m_OutputMode = displayMode;
+            m_Device->m_OutputEnabled = true;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE DisableVideoOutput() override
+        {
+            // The frames still scheduled are released without completion, as with the driver.
+            std::deque<VirtualDeckLink::ScheduledFrame> frames;
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+                m_Device->m_OutputEnabled = false;
+                if (!m_Device->m_PlaybackRunning)
+                    frames.swap(m_Device->m_ScheduledFrames);
+            }
+
+            for (const auto& scheduled : frames)
+                scheduled.frame->Release();
+            return S_OK;
+        }
+
+        // The plugin allocates its own output frames on Windows only.
+        HRESULT STDMETHODCALLTYPE SetVideoOutputFrameMemoryAllocator(IDeckLinkMemoryAllocator*) override { return E_NOTIMPL; }
+
+        HRESULT STDMETHODCALLTYPE CreateVideoFrame(const int32_t width, const int32_t height, const int32_t rowBytes,
+                                                   const BMDPixelFormat pixelFormat, const BMDFrameFlags flags,
+                                                   IDeckLinkMutableVideoFrame** frame) override
+        {
+            if (width <= 0 || height <= 0 || rowBytes <= 0 || !IsSupportedPixelFormat(pixelFormat))
+            {
+                *frame = nullptr;
+                return E_INVALIDARG;
+            }
+
+            UncountedAllocationScope uncounted;
+
+            auto created = new VirtualMutableVideoFrame(width, height, rowBytes, pixelFormat, flags);
+            if (!created->IsAllocated())
+            {
+                created->Release();
+                *frame = nullptr;
+                return E_OUTOFMEMORY;
+            }
+
+            *frame = created;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE CreateAncillaryData(BMDPixelFormat, IDeckLinkVideoFrameAncillary** ancillary) override
+        {
+            *ancillary = nullptr;
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE DisplayVideoFrameSync(IDeckLinkVideoFrame*) override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            return m_Device->m_OutputEnabled && !m_Device->m_PlaybackRunning ? S_OK : E_ACCESSDENIED;
+        }
+
+        HRESULT STDMETHODCALLTYPE ScheduleVideoFrame(IDeckLinkVideoFrame* frame, const BMDTimeValue displayTime,
+                                                     BMDTimeValue, const BMDTimeScale timeScale) override
+        {
+            if (frame == nullptr || timeScale <= 0)
+                return E_INVALIDARG;
+
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+
+            const auto mode = FindVirtualMode(m_Device->m_OutputMode);
+            if (!m_Device->m_OutputEnabled || m_Device->m_StopRequested || mode == nullptr)
+                return E_ACCESSDENIED;
+
+            VirtualDeckLink::ScheduledFrame scheduled;
+            scheduled.frame = frame;
+            scheduled.displayTime = displayTime * mode->timeScale / timeScale;
+            scheduled.late = m_Device->m_PlaybackRunning && scheduled.displayTime < m_Device->GetOutputStreamTime(mode->timeScale);
+
+            auto& frames = m_Device->m_ScheduledFrames;
+            const auto position = std::upper_bound(frames.begin(), frames.end(), scheduled.displayTime,
+                [](const BMDTimeValue time, const VirtualDeckLink::ScheduledFrame& other) { return time < other.displayTime; });
+            {
+                UncountedAllocationScope uncounted;
+                frames.insert(position, scheduled);
+            }
+
+            frame->AddRef();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetScheduledFrameCompletionCallback(IDeckLinkVideoOutputCallback* callback) override
+        {
+            if (callback != nullptr)
+                callback->AddRef();
+
+            IDeckLinkVideoOutputCallback* previous;
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+                previous = m_Device->m_OutputCallback;
+                m_Device->m_OutputCallback = callback;
+            }
+
+            if (previous != nullptr)
+                previous->Release();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetBufferedVideoFrameCount(uint32_t* bufferedFrameCount) override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            *bufferedFrameCount = static_cast<uint32_t>(m_Device->m_ScheduledFrames.size());
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE EnableAudioOutput(const BMDAudioSampleRate sampleRate, BMDAudioSampleType, uint32_t, BMDAudioOutputStreamType) override
+        {
+            if (sampleRate != bmdAudioSampleRate48kHz)
+                return E_INVALIDARG;
+
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            m_Device->m_AudioEnabled = true;
+            m_Device->m_BufferedAudio = 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE DisableAudioOutput() override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            m_Device->m_AudioEnabled = false;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE WriteAudioSamplesSync(void*, const uint32_t sampleFrameCount, uint32_t* sampleFramesWritten) override
+        {
+            if (sampleFramesWritten != nullptr)
+                *sampleFramesWritten = sampleFrameCount;
+            return S_OK;
+        }
+
+        // The preroll is played with the video: the audio callback is only called by the output clock.
+        HRESULT STDMETHODCALLTYPE BeginAudioPreroll() override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE EndAudioPreroll() override { return S_OK; }
+
+        HRESULT STDMETHODCALLTYPE ScheduleAudioSamples(void*, const uint32_t sampleFrameCount, BMDTimeValue, BMDTimeScale,
+                                                       uint32_t* sampleFramesWritten) override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            if (!m_Device->m_AudioEnabled)
+                return E_ACCESSDENIED;
+
+            m_Device->m_BufferedAudio += sampleFrameCount;
+            if (sampleFramesWritten != nullptr)
+                *sampleFramesWritten = sampleFrameCount;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetBufferedAudioSampleFrameCount(uint32_t* bufferedSampleFrameCount) override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            *bufferedSampleFrameCount = static_cast<uint32_t>(m_Device->m_BufferedAudio);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE FlushBufferedAudioSamples() override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            m_Device->m_BufferedAudio = 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetAudioCallback(IDeckLinkAudioOutputCallback* callback) override
+        {
+            if (callback != nullptr)
+                callback->AddRef();
+
+            IDeckLinkAudioOutputCallback* previous;
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+                previous = m_Device->m_AudioCallback;
+                m_Device->m_AudioCallback = callback;
+            }
+
+            if (previous != nullptr)
+                previous->Release();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE StartScheduledPlayback(const BMDTimeValue playbackStartTime, const BMDTimeScale timeScale, double) override
+        {
+            if (timeScale <= 0)
+                return E_INVALIDARG;
+
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+                if (m_Device->m_PlaybackRunning || !m_Device->m_OutputEnabled)
+                    return E_ACCESSDENIED;
+            }
+
+            // The clock of the previous playback is past its last callback.
+            m_Device->JoinOutputClock();
+
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+
+            const auto mode = FindVirtualMode(m_Device->m_OutputMode);
+            if (m_Device->m_PlaybackRunning || !m_Device->m_OutputEnabled || mode == nullptr)
+                return E_ACCESSDENIED;
+
+            m_Device->m_PlaybackRunning = true;
+            m_Device->m_StopRequested = false;
+            m_Device->m_StopStreamTime = 0;
+            m_Device->m_Displayed = false;
+            m_Device->m_PlaybackStartTime = std::chrono::steady_clock::now();
+            m_Device->m_PlaybackStartStreamTime = playbackStartTime * mode->timeScale / timeScale;
+            m_Device->m_OutputStatistics = VirtualOutputStatistics();
+            m_Device->m_OutputClock = std::thread(&VirtualDeckLink::RunOutputClock, m_Device, *mode);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE StopScheduledPlayback(const BMDTimeValue stopPlaybackAtTime, BMDTimeValue* actualStopTime, const BMDTimeScale timeScale) override
+        {
+            // Doesn't wait for the clock, which calls the plugin back: the plugin holds its lock here.
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+
+                const auto mode = FindVirtualMode(m_Device->m_OutputMode);
+                if (!m_Device->m_PlaybackRunning || m_Device->m_StopRequested || mode == nullptr)
+                    return E_ACCESSDENIED;
+
+                m_Device->m_StopRequested = true;
+                m_Device->m_StopStreamTime = stopPlaybackAtTime > 0 && timeScale > 0 ? stopPlaybackAtTime * mode->timeScale / timeScale : 0;
+
+                if (actualStopTime != nullptr)
+                {
+                    *actualStopTime = m_Device->m_StopStreamTime > 0 ? stopPlaybackAtTime : m_Device->GetOutputStreamTime(timeScale);
+                }
+            }
+
+            m_Device->m_OutputCondition.notify_all();
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE IsScheduledPlaybackRunning(dlbool_t* active) override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+            *active = m_Device->m_PlaybackRunning && !m_Device->m_StopRequested;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetScheduledStreamTime(const BMDTimeScale timeScale, BMDTimeValue* streamTime, double* playbackSpeed) override
+        {
+            std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+
+            const auto running = m_Device->m_PlaybackRunning && !m_Device->m_StopRequested;
+            *streamTime = running ? m_Device->GetOutputStreamTime(timeScale) : 0;
+            *playbackSpeed = running ? 1.0 : 0.0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetReferenceStatus(BMDReferenceStatus* referenceStatus) override
+        {
+            *referenceStatus = 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetHardwareReferenceClock(const BMDTimeScale timeScale, BMDTimeValue* hardwareTime,
+                                                            BMDTimeValue* timeInFrame, BMDTimeValue* ticksPerFrame) override
+        {
+            BMDDisplayMode displayMode;
+            {
+                std::lock_guard<std::mutex> lock(m_Device->m_OutputMutex);
+                displayMode = m_Device->m_OutputMode;
+            }
+
+            const auto mode = FindVirtualMode(displayMode);
+            *hardwareTime = GetTime(std::chrono::steady_clock::now() - m_Device->m_Epoch, timeScale);
+            *ticksPerFrame = mode != nullptr ? mode->frameDuration * timeScale / mode->timeScale : 0;
+            *timeInFrame = *ticksPerFrame > 0 ? *hardwareTime % *ticksPerFrame : 0;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetFrameCompletionReferenceTimestamp(IDeckLinkVideoFrame*, BMDTimeScale, BMDTimeValue*) override { return E_NOTIMPL; }
+
+    private:
+        ~VirtualOutput() override
+        {
+            m_Device->Release();
+        }
+
+        VirtualDeckLink* const m_Device;
+    };
+
+    namespace
+    {
+        class VirtualIterator final : public VirtualUnknown<IDeckLinkIterator>
+        {
+        public:
+            VirtualIterator() :
+                VirtualUnknown(IID_IDeckLinkIterator),
+                m_Devices(VirtualDeckLinkDriver::AcquireDevices()),
+                m_Next(0)
+            {
+            }
+
+            HRESULT STDMETHODCALLTYPE Next(IDeckLink** device) override
+            {
+                if (m_Next >= m_Devices.size())
+                {
+                    *device = nullptr;
+                    return S_FALSE;
+                }
+
+                *device = m_Devices[m_Next++];
+                return S_OK;
+            }
+
+        private:
+            ~VirtualIterator() override
+            {
+                while (m_Next < m_Devices.size())
+                    m_Devices[m_Next++]->Release();
+            }
+
+            std::vector<VirtualDeckLink*>   m_Devices;
+            std::size_t                     m_Next;
+        };
+
+        class VirtualDiscovery final : public VirtualUnknown<IDeckLinkDiscovery>
+        {
+        public:
+            VirtualDiscovery() :
+                VirtualUnknown(IID_IDeckLinkDiscovery)
+            {
+            }
+
+            // The cards are all present from the start.
+            HRESULT STDMETHODCALLTYPE InstallDeviceNotifications(IDeckLinkDeviceNotificationCallback* callback) override
+            {
+                for (auto device : VirtualDeckLinkDriver::AcquireDevices())
+                {
+                    callback->DeckLinkDeviceArrived(device);
+                    device->Release();
+                }
+                return S_OK;
+            }
+
+            HRESULT STDMETHODCALLTYPE UninstallDeviceNotifications() override { return S_OK; }
+        };
+    }
+
+    const std::vector<VirtualMode>& GetVirtualModes()
+    {
+        return k_VirtualModes;
+    }
+
+    const VirtualMode* FindVirtualMode(const BMDDisplayMode displayMode)
+    {
+        for (const auto& mode : k_VirtualModes)
+        {
+            if (mode.displayMode == displayMode)
+                return &mode;
+        }
+        return nullptr;
+    }
+
+    const VirtualMode* FindVirtualMode(const std::string& name)
+    {
+        for (const auto& mode : k_VirtualModes)
+        {
+            if (name == mode.name)
+                return &mode;
+        }
+        return nullptr;
+    }
+
+    std::vector<VirtualObjectCount> CountVirtualObjects()
+    {
+        std::vector<VirtualObjectCount> counts;
+        counts.reserve(k_CountedInterfaceCount);
+        for (auto i = 0; i < k_CountedInterfaceCount; ++i)
+        {
+            counts.push_back({
+                k_CountedInterfaces[i].name,
+                s_LiveObjects[i].load(std::memory_order_relaxed),
+                s_LiveReferences[i].load(std::memory_order_relaxed) });
+        }
+        return counts;
+    }
+
+    std::uint32_t GetFrameBytes(const VirtualMode& mode, const BMDPixelFormat pixelFormat)
+    {
+        return DeckLinkInputFramePool::GetRowBytes(pixelFormat, mode.width) * static_cast<std::uint32_t>(mode.height);
+    }
+
+    std::mutex VirtualDeckLinkDriver::s_Mutex;
+    std::vector<VirtualDeckLink*> VirtualDeckLinkDriver::s_Devices;
+
+    void VirtualDeckLinkDriver::Install(const std::vector<VirtualDeviceDescription>& devices)
+    {
+        Uninstall();
+
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            for (const auto& description : devices)
+                s_Devices.push_back(new VirtualDeckLink(description));
+        }
+
+        DeckLinkCapabilitySnapshot::Invalidate();
+    }
+
+    void VirtualDeckLinkDriver::Uninstall()
+    {
+        std::vector<VirtualDeckLink*> devices;
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            devices.swap(s_Devices);
+        }
+
+        for (auto device : devices)
+            device->Release();
+
+        DeckLinkCapabilitySnapshot::Invalidate();
+    }
+
+    VirtualDeckLink* VirtualDeckLinkDriver::GetDevice(const int deviceSelected)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        return deviceSelected >= 0 && deviceSelected < static_cast<int>(s_Devices.size()) ? s_Devices[deviceSelected] : nullptr;
+    }
+
+    int VirtualDeckLinkDriver::CountDevices()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        return static_cast<int>(s_Devices.size());
+    }
+
+    std::vector<VirtualDeckLink*> VirtualDeckLinkDriver::AcquireDevices()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        for (auto device : s_Devices)
+            device->AddRef();
+        return s_Devices;
+    }
+
+    VirtualDeckLink::VirtualDeckLink(const VirtualDeviceDescription& description) :
+        m_Description(description),
+        m_RefCount(1),
+        m_InputCallback(nullptr),
+        m_InputAllocator(nullptr),
+        m_InputInterfaces(0),
+        m_InputMode(bmdModeUnknown),
+        m_InputPixelFormat(bmdFormat8BitYUV),
+        m_InputEnabled(false),
+        m_InputStreaming(false),
+        m_InputFrameCount(0),
+        m_Epoch(std::chrono::steady_clock::now()),
+        m_OutputCallback(nullptr),
+        m_AudioCallback(nullptr),
+        m_OutputMode(bmdModeUnknown),
+        m_OutputEnabled(false),
+        m_AudioEnabled(false),
+        m_BufferedAudio(0),
+        m_PlaybackRunning(false),
+        m_StopRequested(false),
+        m_StopStreamTime(0),
+        m_Displayed(false),
+        m_PlaybackStartStreamTime(0),
+        m_Faults(),
+        m_RandomState(0x9E3779B97F4A7C15ull ^ static_cast<std::uint64_t>(description.persistentId)),
+        m_OutputStatistics(),
+        m_CompletionProbe(nullptr),
+        m_AudioProbe(nullptr),
+        m_CompletionsReplayed(false)
+    {
+        if (m_RandomState == 0)
+            m_RandomState = 1;
+
+        s_LiveObjects[k_DeckLinkCountIndex].fetch_add(1, std::memory_order_relaxed);
+        s_LiveReferences[k_DeckLinkCountIndex].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    VirtualDeckLink::~VirtualDeckLink()
+    {
+        s_LiveObjects[k_DeckLinkCountIndex].fetch_sub(1, std::memory_order_relaxed);
+
+        // A playback left running is flushed, as when the driver closes the card.
+        {
+            std::lock_guard<std::mutex> lock(m_OutputMutex);
+            m_StopRequested = true;
+            m_StopStreamTime = 0;
+        }
+        m_OutputCondition.notify_all();
+        JoinOutputClock();
+
+        for (const auto& scheduled : m_ScheduledFrames)
+            scheduled.frame->Release();
+
+        if (m_OutputCallback != nullptr)
+            m_OutputCallback->Release();
+        if (m_AudioCallback != nullptr)
+            m_AudioCallback->Release();
+        if (m_InputCallback != nullptr)
+            m_InputCallback->Release();
+        if (m_InputAllocator != nullptr)
+            m_InputAllocator->Release();
+    }
+
+    bool VirtualDeckLink::DeliverInputFrame(const BMDFrameFlags flags, VirtualCallProbe* probe)
+    {
+        // Held for the whole delivery: StopStreams waits for it, as it waits for the driver thread.
+        std::lock_guard<std::mutex> lock(m_InputMutex);
+
+        const auto mode = FindVirtualMode(m_InputMode);
+        if (!m_InputStreaming || mode == nullptr)
+            return false;
+
+        IDeckLinkInputCallback* callback;
+        {
+            std::lock_guard<std::mutex> callbackLock(m_CallbackMutex);
+            callback = m_InputCallback;
+        }
+        if (callback == nullptr)
+            return false;
+
+        // The samples of the frame, so the audio follows the video over time.
+        const auto sampleTime = m_InputFrameCount * mode->frameDuration * k_AudioSampleRate / mode->timeScale;
+        const auto nextSampleTime = (m_InputFrameCount + 1) * mode->frameDuration * k_AudioSampleRate / mode->timeScale;
+        const auto sampleFrameCount = static_cast<long>(nextSampleTime - sampleTime);
+        const auto audioBytes = static_cast<std::size_t>(sampleFrameCount * k_AudioChannelCount * k_AudioSampleBytes);
+
+        const auto streamTime = m_InputFrameCount * mode->frameDuration;
+        const auto hardwareTime = GetTime(std::chrono::steady_clock::now() - m_Epoch, mode->timeScale);
+        ++m_InputFrameCount;
+
+        VirtualVideoInputFrame* frame;
+        VirtualAudioInputPacket* packet;
+        {
+            // The driver owns these: only the allocations of the plugin are counted.
+            UncountedAllocationScope uncounted;
+
+            if (m_AudioBuffer.size() < audioBytes)
+                m_AudioBuffer.resize(audioBytes);
+
+            frame = new VirtualVideoInputFrame(*mode, m_InputPixelFormat, flags, streamTime, hardwareTime);
+            packet = new VirtualAudioInputPacket(m_AudioBuffer.data(), sampleFrameCount, sampleTime);
+        }
+
+        if (probe != nullptr)
+            probe->Enter();
+
+        auto delivered = frame->AllocateBuffer(m_InputAllocator);
+        if (delivered)
+        {
+            callback->VideoInputFrameArrived(frame, packet);
+        }
+
+        // The buffer returns to the allocator with the last reference to the frame.
+        frame->Release();
+
+        if (probe != nullptr)
+            probe->Leave();
+
+        packet->Release();
+        return delivered;
+    }
+
+    bool VirtualDeckLink::ChangeInputFormat(const BMDDisplayMode displayMode, const BMDDetectedVideoInputFormatFlags flags)
+    {
+        std::lock_guard<std::mutex> lock(m_InputMutex);
+
+        IDeckLinkInputCallback* callback;
+        {
+            std::lock_guard<std::mutex> callbackLock(m_CallbackMutex);
+            callback = m_InputCallback;
+        }
+
+        IDeckLinkDisplayMode* mode;
+        if (callback == nullptr || CreateDisplayMode(displayMode, &mode) != S_OK)
+            return false;
+
+        const auto events = displayMode != m_InputMode ? bmdVideoInputDisplayModeChanged : bmdVideoInputColorspaceChanged;
+        const auto result = callback->VideoInputFormatChanged(events, mode, flags);
+        mode->Release();
+
+        m_InputFrameCount = 0;
+        return result == S_OK;
+    }
+
+    void VirtualDeckLink::SetOutputFaults(const VirtualOutputFaults& faults)
+    {
+        std::lock_guard<std::mutex> lock(m_OutputMutex);
+        m_Faults = faults;
+    }
+
+    VirtualOutputStatistics VirtualDeckLink::GetOutputStatistics()
+    {
+        std::lock_guard<std::mutex> lock(m_OutputMutex);
+        return m_OutputStatistics;
+    }
+
+    void VirtualDeckLink::SetOutputProbes(VirtualCallProbe* completionProbe, VirtualCallProbe* audioProbe)
+    {
+        std::lock_guard<std::mutex> lock(m_OutputMutex);
+        m_CompletionProbe = completionProbe;
+        m_AudioProbe = audioProbe;
+    }
+
+    void VirtualDeckLink::SetOutputCompletionsReplayed(const bool replayed)
+    {
+        std::lock_guard<std::mutex> lock(m_OutputMutex);
+        m_CompletionsReplayed = replayed;
+    }
+
+    bool VirtualDeckLink::CompleteOutputFrame(const BMDOutputFrameCompletionResult result, VirtualCallProbe* probe)
+    {
+        IDeckLinkVideoOutputCallback* callback;
+        IDeckLinkVideoFrame* frame;
+        {
+            std::lock_guard<std::mutex> lock(m_OutputMutex);
+            if (!m_PlaybackRunning || m_StopRequested || m_ScheduledFrames.empty())
+                return false;
+
+            frame = m_ScheduledFrames.front().frame;
+            m_ScheduledFrames.pop_front();
+            CountCompletion(result);
+
+            callback = m_OutputCallback;
+            if (callback != nullptr)
+                callback->AddRef();
+        }
+
+        if (probe != nullptr)
+            probe->Enter();
+
+        if (callback != nullptr)
+            callback->ScheduledFrameCompleted(frame, result);
+        frame->Release();
+
+        if (probe != nullptr)
+            probe->Leave();
+
+        if (callback != nullptr)
+            callback->Release();
+        return true;
+    }
+
+    void VirtualDeckLink::RunOutputClock(const VirtualMode mode)
+    {
+        {
+            UncountedAllocationScope uncounted;
+            m_CompletedFrames.reserve(16);
+        }
+
+        std::unique_lock<std::mutex> lock(m_OutputMutex);
+        const auto startTime = m_PlaybackStartTime;
+
+        for (std::int64_t period = 1;; period++)
+        {
+            // A stop without a stream time ends the playback at once; the others at the end of a period.
+            const auto periodEnd = startTime + std::chrono::nanoseconds(period * mode.frameDuration * 1000000000 / mode.timeScale);
+            if (m_OutputCondition.wait_until(lock, periodEnd, [this] { return m_StopRequested && m_StopStreamTime == 0; }))
+                break;
+
+            const auto streamTime = m_PlaybackStartStreamTime + period * mode.frameDuration;
+            if (!m_CompletionsReplayed)
+                CompleteFrames(mode, streamTime);
+
+            // The card plays the samples of the period, so the plugin is asked for more.
+            const auto playedSamples = period * mode.frameDuration * k_AudioSampleRate / mode.timeScale -
+                                       (period - 1) * mode.frameDuration * k_AudioSampleRate / mode.timeScale;
+            m_BufferedAudio = std::max<std::int64_t>(0, m_BufferedAudio - playedSamples);
+
+            const auto stop = m_StopRequested && streamTime >= m_StopStreamTime;
+            const auto videoCallback = m_OutputCallback;
+            const auto audioCallback = m_AudioEnabled && !stop ? m_AudioCallback : nullptr;
+            const auto completionProbe = m_CompletionProbe;
+            const auto audioProbe = m_AudioProbe;
+            if (videoCallback != nullptr)
+                videoCallback->AddRef();
+            if (audioCallback != nullptr)
+                audioCallback->AddRef();
+
+            lock.unlock();
+
+            DispatchCompletedFrames(videoCallback, completionProbe);
+
+            if (audioCallback != nullptr)
+            {
+                if (audioProbe != nullptr)
+                    audioProbe->Enter();
+
+                audioCallback->RenderAudioSamples(false);
+
+                if (audioProbe != nullptr)
+                    audioProbe->Leave();
+
+                audioCallback->Release();
+            }
+            if (videoCallback != nullptr)
+                videoCallback->Release();
+
+            lock.lock();
+            if (stop)
+                break;
+        }
+
+        FlushFrames();
+        const auto callback = m_OutputCallback;
+        const auto completionProbe = m_CompletionProbe;
+        if (callback != nullptr)
+            callback->AddRef();
+        lock.unlock();
+
+        DispatchCompletedFrames(callback, completionProbe);
+        if (callback != nullptr)
+        {
+            callback->ScheduledPlaybackHasStopped();
+            callback->Release();
+        }
+
+        lock.lock();
+        m_PlaybackRunning = false;
+        m_StopRequested = false;
+        m_OutputCondition.notify_all();
+    }
+
+    void VirtualDeckLink::CompleteFrames(const VirtualMode& mode, const BMDTimeValue streamTime)
+    {
+        // The frames whose period ended: the last one was displayed, the ones before it were skipped.
+        std::size_t due = 0;
+        while (due < m_ScheduledFrames.size() && m_ScheduledFrames[due].displayTime < streamTime)
+            due++;
+
+        if (due == 0)
+        {
+            if (m_Displayed)
+                m_OutputStatistics.underruns++;
+            return;
+        }
+
+        for (std::size_t i = 0; i < due; i++)
+        {
+            const auto scheduled = m_ScheduledFrames.front();
+            m_ScheduledFrames.pop_front();
+
+            BMDOutputFrameCompletionResult result;
+            if (i + 1 < due)
+                result = bmdOutputFrameDropped;
+            else if (scheduled.late || scheduled.displayTime < streamTime - mode.frameDuration)
+                result = bmdOutputFrameDisplayedLate;
+            else
+                result = InjectFault();
+
+            CountCompletion(result);
+
+            UncountedAllocationScope uncounted;
+            m_CompletedFrames.push_back({ scheduled.frame, result });
+        }
+
+        m_Displayed = true;
+    }
+
+    void VirtualDeckLink::CountCompletion(const BMDOutputFrameCompletionResult result)
+    {
+        switch (result)
+        {
+        case bmdOutputFrameCompleted: m_OutputStatistics.completed++; break;
+        case bmdOutputFrameDisplayedLate: m_OutputStatistics.late++; break;
+        case bmdOutputFrameDropped: m_OutputStatistics.dropped++; break;
+        case bmdOutputFrameFlushed: m_OutputStatistics.flushed++; break;
+        }
+    }
+
+    void VirtualDeckLink::FlushFrames()
+    {
+        UncountedAllocationScope uncounted;
+
+        for (const auto& scheduled : m_ScheduledFrames)
+        {
+            m_CompletedFrames.push_back({ scheduled.frame, bmdOutputFrameFlushed });
+            m_OutputStatistics.flushed++;
+        }
+        m_ScheduledFrames.clear();
+    }
+
+    void VirtualDeckLink::DispatchCompletedFrames(IDeckLinkVideoOutputCallback* callback, VirtualCallProbe* probe)
+    {
+        for (const auto& completed : m_CompletedFrames)
+        {
+            if (probe != nullptr)
+                probe->Enter();
+
+            if (callback != nullptr)
+                callback->ScheduledFrameCompleted(completed.frame, completed.result);
+
+            // The driver releases its reference once the plugin was told.
+            completed.frame->Release();
+
+            if (probe != nullptr)
+                probe->Leave();
+        }
+        m_CompletedFrames.clear();
+    }
+
+    BMDOutputFrameCompletionResult VirtualDeckLink::InjectFault()
+    {
+        // xorshift64: deterministic for a card, so the runs can be compared.
+        m_RandomState ^= m_RandomState << 13;
+        m_RandomState ^= m_RandomState >> 7;
+        m_RandomState ^= m_RandomState << 17;
+        const auto draw = static_cast<double>(m_RandomState >> 11) / static_cast<double>(1ull << 53);
+
+        auto result = bmdOutputFrameCompleted;
+        if (draw < m_Faults.lateRate)
+            result = bmdOutputFrameDisplayedLate;
+        else if (draw < m_Faults.lateRate + m_Faults.dropRate)
+            result = bmdOutputFrameDropped;
+        else if (draw < m_Faults.lateRate + m_Faults.dropRate + m_Faults.flushRate)
+            result = bmdOutputFrameFlushed;
+
+        if (result != bmdOutputFrameCompleted)
+            m_OutputStatistics.injected++;
+        return result;
+    }
+
+    BMDTimeValue VirtualDeckLink::GetOutputStreamTime(const BMDTimeScale timeScale)
+    {
+        const auto mode = FindVirtualMode(m_OutputMode);
+        const auto startStreamTime = mode != nullptr ? m_PlaybackStartStreamTime * timeScale / mode->timeScale : 0;
+        return startStreamTime + GetTime(std::chrono::steady_clock::now() - m_PlaybackStartTime, timeScale);
+    }
+
+    void VirtualDeckLink::JoinOutputClock()
+    {
+        if (m_OutputClock.joinable() && m_OutputClock.get_id() != std::this_thread::get_id())
+            m_OutputClock.join();
+    }
+
+    HRESULT STDMETHODCALLTYPE VirtualDeckLink::QueryInterface(REFIID iid, LPVOID* ppv)
+    {
+        if (iid == IID_IUnknown || iid == IID_IDeckLink)
+        {
+            *ppv = static_cast<IDeckLink*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        if (iid == IID_IDeckLinkInput && m_Description.capture)
+        {
+            *ppv = static_cast<IDeckLinkInput*>(new VirtualInput(this));
+            return S_OK;
+        }
+
+        if (iid == IID_IDeckLinkOutput && m_Description.playback)
+        {
+            *ppv = static_cast<IDeckLinkOutput*>(new VirtualOutput(this));
+            return S_OK;
+        }
+
+        if (iid == IID_IDeckLinkProfileAttributes)
+        {
+            *ppv = static_cast<IDeckLinkProfileAttributes*>(new VirtualAttributes(m_Description));
+            return S_OK;
+        }
+
+        if (iid == IID_IDeckLinkConfiguration)
+        {
+            *ppv = static_cast<IDeckLinkConfiguration*>(new VirtualConfiguration(this));
+            return S_OK;
+        }
+
+        if (iid == IID_IDeckLinkStatus)
+        {
+            *ppv = static_cast<IDeckLinkStatus*>(new VirtualStatus(this));
+            return S_OK;
+        }
+
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE VirtualDeckLink::AddRef()
+    {
+        s_LiveReferences[k_DeckLinkCountIndex].fetch_add(1, std::memory_order_relaxed);
+        return m_RefCount.fetch_add(1) + 1;
+    }
+
+    ULONG STDMETHODCALLTYPE VirtualDeckLink::Release()
+    {
+        s_LiveReferences[k_DeckLinkCountIndex].fetch_sub(1, std::memory_order_relaxed);
+        const auto count = m_RefCount.fetch_sub(1) - 1;
+        if (count == 0)
+            delete this;
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE VirtualDeckLink::GetModelName(const char** modelName)
+    {
+        *modelName = StdToDlString("Virtual DeckLink");
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE VirtualDeckLink::GetDisplayName(const char** displayName)
+    {
+        *displayName = StdToDlString(m_Description.name);
+        return S_OK;
+    }
+}
+}
+
+// Entry points of the DeckLink API, normally loaded from the driver by DeckLinkAPIDispatch.cpp.
+
+IDeckLinkIterator* CreateDeckLinkIteratorInstance(void)
+{
+    return new MediaBlackmagic::Benchmark::VirtualIterator();
+}
+
+IDeckLinkDiscovery* CreateDeckLinkDiscoveryInstance(void)
+{
+    return new MediaBlackmagic::Benchmark::VirtualDiscovery();
+}
+
+IDeckLinkAPIInformation* CreateDeckLinkAPIInformationInstance(void)
+{
+    return nullptr;
+}
+
+IDeckLinkGLScreenPreviewHelper* CreateOpenGLScreenPreviewHelper(void)
+{
+    return nullptr;
+}
+
+IDeckLinkVideoConversion* CreateVideoConversionInstance(void)
+{
+    return nullptr;
+}
+
+IDeckLinkVideoFrameAncillaryPackets* CreateVideoFrameAncillaryPacketsInstance(void)
+{
+    return nullptr;
+}
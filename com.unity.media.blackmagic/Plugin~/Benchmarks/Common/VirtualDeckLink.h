@@ -0,0 +1,241 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../Common.h"
+
+namespace MediaBlackmagic
+{
+namespace Benchmark
+{
+    // A display mode offered by a virtual card.
+    struct VirtualMode
+    {
+        BMDDisplayMode  displayMode;
+        const char*     name;               // Also the name used on the command lines.
+        std::int32_t    width;
+        std::int32_t    height;
+        BMDTimeValue    frameDuration;
+        BMDTimeScale    timeScale;
+        bool            quadLink;           // Needs the four links of the card, as 8K does.
+    };
+
+    // The modes of the virtual cards: the usual sizes from HD to 8K DCI, at 59.94 Hz.
+    const std::vector<VirtualMode>& GetVirtualModes();
+    const VirtualMode* FindVirtualMode(BMDDisplayMode displayMode);
+    const VirtualMode* FindVirtualMode(const std::string& name);
+
+    // Size of a frame of the mode in the pixel format, as laid out by the driver.
+    std::uint32_t GetFrameBytes(const VirtualMode& mode, BMDPixelFormat pixelFormat);
+
+    struct VirtualDeviceDescription
+    {
+        std::string     name;
+        std::int64_t    persistentId;
+        bool            capture;
+        bool            playback;
+    };
+
+    // Brackets the plugin code run by the virtual driver, so the benchmarks measure it alone.
+    class VirtualCallProbe
+    {
+    public:
+        virtual ~VirtualCallProbe() = default;
+
+        virtual void Enter() = 0;
+        virtual void Leave() = 0;
+    };
+
+    // Results the virtual output clock gives to the frames which are on time, instead of
+    // bmdOutputFrameCompleted, with the given probabilities.
+    struct VirtualOutputFaults
+    {
+        double  lateRate;
+        double  dropRate;
+        double  flushRate;
+    };
+
+    // What the virtual output clock did since the playback started.
+    struct VirtualOutputStatistics
+    {
+        std::uint64_t   completed;
+        std::uint64_t   late;
+        std::uint64_t   dropped;
+        std::uint64_t   flushed;
+        std::uint64_t   injected;       // Late, dropped or flushed results given to frames on time.
+        std::uint64_t   underruns;      // Frame periods without a frame to display, after the first one.
+    };
+
+    // The virtual objects of an interface which are alive, and the references held to them by the
+    // plugin and the virtual driver. Both go back to their level once the devices are destroyed.
+    struct VirtualObjectCount
+    {
+        const char*     interfaceName;
+        std::int64_t    objects;
+        std::int64_t    references;
+    };
+
+    // Counts of every virtual interface, the objects of other interfaces last.
+    std::vector<VirtualObjectCount> CountVirtualObjects();
+
+    class VirtualDeckLink;
+
+    // Stand-in for the DeckLink driver. The benchmarks are linked with this file instead of
+    // DeckLinkAPIDispatch.cpp, so the plugin enumerates the virtual cards through the regular API
+    // and the virtual cards call the plugin back like the driver threads do.
+    class VirtualDeckLinkDriver final
+    {
+    public:
+        // Replaces the cards seen by the plugin. The capability snapshot is invalidated.
+        static void Install(const std::vector<VirtualDeviceDescription>& devices);
+        static void Uninstall();
+
+        // Borrowed pointer to an installed card, or null.
+        static VirtualDeckLink* GetDevice(int deviceSelected);
+        static int CountDevices();
+
+        // New references to the installed cards, for the iterator and the discovery.
+        static std::vector<VirtualDeckLink*> AcquireDevices();
+
+    private:
+        static std::mutex                       s_Mutex;
+        static std::vector<VirtualDeckLink*>    s_Devices;
+    };
+
+    // A virtual card. Its interfaces are created on demand and share the state of the card.
+    class VirtualDeckLink final : public IDeckLink
+    {
+    public:
+        explicit VirtualDeckLink(const VirtualDeviceDescription& description);
+
+        inline const VirtualDeviceDescription& GetDescription() const { return m_Description; }
+
+        // Delivers the next captured frame to the input callback, as the capture thread of the
+        // driver does: the buffer comes from the memory allocator set by the plugin and the frame
+        // is released after the callback. Returns false if the input isn't streaming.
+        bool DeliverInputFrame(BMDFrameFlags flags, VirtualCallProbe* probe);
+
+        // Reports a detected signal, as the format detection of the driver does.
+        bool ChangeInputFormat(BMDDisplayMode displayMode, BMDDetectedVideoInputFormatFlags flags);
+
+        // Faults injected by the output clock. Applied from the next frame period.
+        void SetOutputFaults(const VirtualOutputFaults& faults);
+        VirtualOutputStatistics GetOutputStatistics();
+
+        // Probes around the completion and audio callbacks, called on the output clock thread.
+        // Applied from the next frame period.
+        void SetOutputProbes(VirtualCallProbe* completionProbe, VirtualCallProbe* audioProbe);
+
+        // Replayed completions: the output clock keeps the time and requests the audio, but the
+        // frames are only completed by CompleteOutputFrame, as a recording dictates.
+        void SetOutputCompletionsReplayed(bool replayed);
+
+        // Completes the scheduled frame due first with the given result, on the calling thread.
+        // Returns false if the playback isn't running or no frame is scheduled.
+        bool CompleteOutputFrame(BMDOutputFrameCompletionResult result, VirtualCallProbe* probe);
+
+        inline BMDDisplayMode GetInputMode() const { return m_InputMode.load(std::memory_order_relaxed); }
+        inline BMDPixelFormat GetInputPixelFormat() const { return m_InputPixelFormat.load(std::memory_order_relaxed); }
+        inline bool IsInputStreaming() const { return m_InputStreaming.load(std::memory_order_relaxed); }
+
+        // IUnknown
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override;
+        ULONG STDMETHODCALLTYPE AddRef() override;
+        ULONG STDMETHODCALLTYPE Release() override;
+
+        // IDeckLink
+        HRESULT STDMETHODCALLTYPE GetModelName(const char** modelName) override;
+        HRESULT STDMETHODCALLTYPE GetDisplayName(const char** displayName) override;
+
+    private:
+        friend class VirtualInput;
+        friend class VirtualOutput;
+        friend class VirtualConfiguration;
+
+        struct ScheduledFrame
+        {
+            IDeckLinkVideoFrame*    frame;
+            BMDTimeValue            displayTime;    // In the time scale of the output mode.
+            bool                    late;           // Scheduled after the start of its frame period.
+        };
+
+        struct CompletedFrame
+        {
+            IDeckLinkVideoFrame*            frame;
+            BMDOutputFrameCompletionResult  result;
+        };
+
+        ~VirtualDeckLink();
+
+        // The output clock: at the end of every frame period, the frames due are completed and
+        // more audio is requested, on a thread of its own as with the driver.
+        void RunOutputClock(VirtualMode mode);
+        void CompleteFrames(const VirtualMode& mode, BMDTimeValue streamTime);
+        void CountCompletion(BMDOutputFrameCompletionResult result);
+        void FlushFrames();
+        void DispatchCompletedFrames(IDeckLinkVideoOutputCallback* callback, VirtualCallProbe* probe);
+        BMDOutputFrameCompletionResult InjectFault();
+        BMDTimeValue GetOutputStreamTime(BMDTimeScale timeScale);
+        void JoinOutputClock();
+
+        const VirtualDeviceDescription  m_Description;
+        std::atomic<ULONG>              m_RefCount;
+
+        // Configuration set through IDeckLinkConfiguration.
+        std::mutex                                  m_ConfigurationMutex;
+        std::map<BMDDeckLinkConfigurationID, std::int64_t> m_Configuration;
+
+        // Input state. A delivery holds m_InputMutex throughout, so StopStreams waits for it; the
+        // callback has its own lock, as the plugin sets it from the callback thread on a format change.
+        std::mutex                          m_InputMutex;
+        std::mutex                          m_CallbackMutex;
+        IDeckLinkInputCallback*             m_InputCallback;
+        IDeckLinkMemoryAllocator*           m_InputAllocator;       // Released with the last input interface.
+        int                                 m_InputInterfaces;
+        std::atomic<BMDDisplayMode>         m_InputMode;
+        std::atomic<BMDPixelFormat>         m_InputPixelFormat;
+        std::atomic<bool>                   m_InputEnabled;
+        std::atomic<bool>                   m_InputStreaming;
+        std::int64_t                        m_InputFrameCount;
+        std::vector<std::uint8_t>           m_AudioBuffer;
+        std::chrono::steady_clock::time_point m_Epoch;
+
+        // Output state, guarded by m_OutputMutex. The callbacks are called without the lock, so the
+        // plugin may schedule frames from them, as it does in async mode.
+        std::mutex                          m_OutputMutex;
+        std::condition_variable             m_OutputCondition;
+        IDeckLinkVideoOutputCallback*       m_OutputCallback;
+        IDeckLinkAudioOutputCallback*       m_AudioCallback;
+        BMDDisplayMode                      m_OutputMode;
+        bool                                m_OutputEnabled;
+        bool                                m_AudioEnabled;
+        std::int64_t                        m_BufferedAudio;        // Sample frames.
+        std::deque<ScheduledFrame>          m_ScheduledFrames;      // In the order of their display time.
+        bool                                m_PlaybackRunning;      // Until ScheduledPlaybackHasStopped returns.
+        bool                                m_StopRequested;
+        BMDTimeValue                        m_StopStreamTime;       // 0 to stop at once.
+        bool                                m_Displayed;            // A frame was displayed since the start.
+        std::chrono::steady_clock::time_point m_PlaybackStartTime;
+        BMDTimeValue                        m_PlaybackStartStreamTime;
+        VirtualOutputFaults                 m_Faults;
+        std::uint64_t                       m_RandomState;
+        VirtualOutputStatistics             m_OutputStatistics;
+        VirtualCallProbe*                   m_CompletionProbe;
+        VirtualCallProbe*                   m_AudioProbe;
+        bool                                m_CompletionsReplayed;
+
+        // The clock thread is joined by the next start of the playback, or with the card.
+        std::thread                         m_OutputClock;
+        std::vector<CompletedFrame>         m_CompletedFrames;      // Of the current period, for the clock thread only.
+    };
+}
+}
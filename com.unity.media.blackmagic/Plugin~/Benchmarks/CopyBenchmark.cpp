@@ -0,0 +1,297 @@
+// Copy benchmark: compares the frame copy engine of the output devices with std::memcpy, for the
+// frame sizes of the display modes and pixel formats: the copy duration and bandwidth of memcpy,
+// of every copy kernel the CPU supports on one thread, and of the engine with the thread count and
+// chunk size it tuned, and how much each copy slows down the next pass of the render thread over
+// its working set, which the copy evicts from the cache. The results are written as JSON.
+//
+//   CopyBenchmark [--modes 1080p5994,...] [--formats 8BitYUV,...] [--copies 100]
+//                 [--working-set 16] [--output results.json]
+//
+// The copies rotate through several destination frames, as the driver frames do, and each one is
+// checked against its source, also from unaligned addresses.
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include "Common/BenchmarkUtilities.h"
+#include "Common/VirtualDeckLink.h"
+#include "../Includes/FrameCopyEngine.h"
+
+using namespace MediaBlackmagic;
+using namespace MediaBlackmagic::Benchmark;
+
+namespace
+{
+    const std::vector<std::string> k_DefaultModes = { "1080p5994", "2160p5994", "4320p5994" };
+    const std::vector<std::string> k_DefaultFormats = { "8BitYUV", "10BitYUV", "8BitBGRA" };
+    const std::vector<std::string> k_Options = { "modes", "formats", "copies", "working-set", "output" };
+
+    const int k_DestinationFrames = 4;
+
+    // Copies of a size the engine may run while it tunes the size in the background, beyond which
+    // it is measured as it is.
+    const int k_MaxTuningCopies = 1000;
+
+    struct Settings
+    {
+        int             copies;             // Measured copies of each method.
+        std::size_t     workingSetBytes;
+    };
+
+    // Page-aligned, as the frames of the driver and the textures read back by Unity are.
+    class FrameBuffer final
+    {
+    public:
+        explicit FrameBuffer(const std::size_t bytes) :
+            m_Data(static_cast<std::uint8_t*>(AllocatePageAlignedBuffer(bytes))),
+            m_Bytes(bytes)
+        {
+        }
+
+        ~FrameBuffer() { FreePageAlignedBuffer(m_Data); }
+
+        FrameBuffer(const FrameBuffer&) = delete;
+        FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+        inline std::uint8_t* GetData() const { return m_Data; }
+        inline std::size_t GetBytes() const { return m_Bytes; }
+
+    private:
+        std::uint8_t*   m_Data;
+        std::size_t     m_Bytes;
+    };
+
+    // Reads a byte of every cache line, as the render thread goes over its working set.
+    std::uint64_t TouchWorkingSet(const FrameBuffer& workingSet)
+    {
+        std::uint64_t sum = 0;
+        const auto data = workingSet.GetData();
+        for (std::size_t i = 0; i < workingSet.GetBytes(); i += 64)
+        {
+            sum += data[i];
+        }
+        return sum;
+    }
+
+    typedef std::function<void(void* destination, const void* source, std::size_t bytes)> CopyFunction;
+
+    // Copies from unaligned addresses, and the whole frame, and compares the result with the source.
+    bool VerifyCopy(const CopyFunction& copy, const FrameBuffer& source, const FrameBuffer& destination)
+    {
+        const auto bytes = source.GetBytes();
+
+        std::memset(destination.GetData(), 0, bytes);
+        copy(destination.GetData() + 5, source.GetData() + 3, bytes - 13);
+        if (std::memcmp(destination.GetData() + 5, source.GetData() + 3, bytes - 13) != 0 ||
+            destination.GetData()[4] != 0 || destination.GetData()[bytes - 8] != 0)
+            return false;
+
+        copy(destination.GetData(), source.GetData(), bytes);
+        return std::memcmp(destination.GetData(), source.GetData(), bytes) == 0;
+    }
+
+    void RunMethod(const char* method, const CopyFunction& copy, const FrameBuffer& source,
+                   const std::vector<std::unique_ptr<FrameBuffer>>& destinations, const FrameBuffer& workingSet,
+                   const Settings& settings, JsonWriter& json, bool& verified)
+    {
+        const auto bytes = source.GetBytes();
+        const auto valid = !copy || VerifyCopy(copy, source, *destinations[0]);
+        verified = verified && valid;
+
+        LatencyHistogram durations;
+        LatencyHistogram reloads;
+        std::int64_t totalDuration = 0;
+        volatile std::uint64_t sink = 0;
+
+        for (auto i = 0; i < settings.copies; ++i)
+        {
+            sink = sink + TouchWorkingSet(workingSet);
+
+            const auto start = std::chrono::steady_clock::now();
+            if (copy)
+                copy(destinations[i % destinations.size()]->GetData(), source.GetData(), bytes);
+            const auto copied = std::chrono::steady_clock::now();
+            sink = sink + TouchWorkingSet(workingSet);
+            const auto reloaded = std::chrono::steady_clock::now();
+
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(copied - start).count();
+            durations.Record(duration);
+            reloads.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(reloaded - copied).count());
+            totalDuration += duration;
+        }
+
+        MetricSummary duration = {};
+        MetricSummary reload = {};
+        durations.Summarize(duration);
+        reloads.Summarize(reload);
+
+        json.Key(method);
+        json.BeginObject();
+        if (copy)
+        {
+            json.Member("verified", valid);
+            json.Member("gigabytesPerSecond", totalDuration > 0 ? static_cast<double>(bytes) * settings.copies / totalDuration : 0.0);
+            json.Key("copy");
+            json.Durations(durations);
+        }
+        // The pass over the working set after the copy, slower as the copy evicted more of it.
+        json.Key("workingSetPass");
+        json.Durations(reloads);
+        json.EndObject();
+
+        if (copy)
+            std::fprintf(stderr, "    %-8s p50 %8.1f us p99 %8.1f us, %6.2f GB/s, working set pass p50 %7.1f us%s\n", method,
+                         duration.p50 / 1000.0, duration.p99 / 1000.0,
+                         totalDuration > 0 ? static_cast<double>(bytes) * settings.copies / totalDuration : 0.0,
+                         reload.p50 / 1000.0, valid ? "" : ", WRONG RESULT");
+        else
+            std::fprintf(stderr, "    %-8s working set pass p50 %7.1f us\n", method, reload.p50 / 1000.0);
+    }
+
+    bool RunCase(const VirtualMode& mode, const BMDPixelFormat pixelFormat, const Settings& settings, JsonWriter& json)
+    {
+        const auto bytes = static_cast<std::size_t>(GetFrameBytes(mode, pixelFormat));
+
+        json.BeginObject();
+        json.Member("mode", mode.name);
+        json.Member("pixelFormat", GetPixelFormatName(pixelFormat));
+        json.Member("frameBytes", static_cast<std::uint64_t>(bytes));
+
+        std::fprintf(stderr, "%s %s, %.1f MiB:\n", mode.name, GetPixelFormatName(pixelFormat), bytes / 1048576.0);
+
+        FrameBuffer source(bytes);
+        FrameBuffer workingSet(settings.workingSetBytes);
+        std::vector<std::unique_ptr<FrameBuffer>> destinations;
+        for (auto i = 0; i < k_DestinationFrames; ++i)
+        {
+            destinations.emplace_back(new FrameBuffer(bytes));
+            std::memset(destinations.back()->GetData(), 0, bytes);
+        }
+        for (std::size_t i = 0; i < bytes; ++i)
+        {
+            source.GetData()[i] = static_cast<std::uint8_t>(i * 131 + (i >> 12));
+        }
+        std::memset(workingSet.GetData(), 1, settings.workingSetBytes);
+
+        auto verified = true;
+        json.Key("methods");
+        json.BeginObject();
+
+        // The working set pass without a copy in between, for reference.
+        RunMethod("none", CopyFunction(), source, destinations, workingSet, settings, json, verified);
+
+        RunMethod("memcpy", [](void* destination, const void* source, std::size_t bytes) { std::memcpy(destination, source, bytes); },
+                  source, destinations, workingSet, settings, json, verified);
+
+        for (auto kernel = static_cast<int>(ECopyKernel::SSE2); kernel < static_cast<int>(ECopyKernel::Count); ++kernel)
+        {
+            const auto copyKernel = static_cast<ECopyKernel>(kernel);
+            if (!FrameCopyEngine::IsKernelSupported(copyKernel))
+                continue;
+
+            RunMethod(FrameCopyEngine::GetKernelName(copyKernel), [copyKernel](void* destination, const void* source, std::size_t bytes)
+            {
+                FrameCopyEngine::CopyWithKernel(copyKernel, destination, source, bytes);
+            }, source, destinations, workingSet, settings, json, verified);
+        }
+
+        // The engine is measured once it tuned the size, as it runs for the most part.
+        FrameCopyEngine engine;
+        int threadCount = 1;
+        std::size_t chunkBytes = bytes;
+        for (auto i = 0; i < k_MaxTuningCopies && !engine.GetTuning(bytes, threadCount, chunkBytes); ++i)
+        {
+            engine.Copy(destinations[i % destinations.size()]->GetData(), source.GetData(), bytes);
+        }
+
+        RunMethod("engine", [&engine](void* destination, const void* source, std::size_t bytes) { engine.Copy(destination, source, bytes); },
+                  source, destinations, workingSet, settings, json, verified);
+        json.EndObject();
+
+        json.Member("kernel", FrameCopyEngine::GetKernelName(FrameCopyEngine::GetKernel()));
+        json.Member("tunedThreads", threadCount);
+        json.Member("tunedChunkBytes", static_cast<std::uint64_t>(chunkBytes));
+        json.Member("verified", verified);
+        json.EndObject();
+
+        std::fprintf(stderr, "    engine tuned to %d thread(s), %llu KiB chunks\n", threadCount,
+                     static_cast<unsigned long long>(chunkBytes / 1024));
+        return verified;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchmarkOptions options(argc, argv);
+
+    for (const auto& unknown : options.GetUnknown(k_Options))
+    {
+        std::fprintf(stderr, "Unknown option --%s.\n", unknown.c_str());
+        return 1;
+    }
+
+    Settings settings;
+    settings.copies = static_cast<int>(std::max<std::int64_t>(options.GetInt("copies", 100), 1));
+    settings.workingSetBytes = static_cast<std::size_t>(std::max<std::int64_t>(options.GetInt("working-set", 16), 1)) << 20;
+
+    std::vector<const VirtualMode*> modes;
+    for (const auto& name : options.GetList("modes", k_DefaultModes))
+    {
+        const auto mode = FindVirtualMode(name);
+        if (mode == nullptr)
+        {
+            std::fprintf(stderr, "Unknown mode %s.\n", name.c_str());
+            return 1;
+        }
+        modes.push_back(mode);
+    }
+
+    std::vector<BMDPixelFormat> pixelFormats;
+    for (const auto& name : options.GetList("formats", k_DefaultFormats))
+    {
+        BMDPixelFormat pixelFormat;
+        if (!FindPixelFormat(name, pixelFormat))
+        {
+            std::fprintf(stderr, "Unknown pixel format %s.\n", name.c_str());
+            return 1;
+        }
+        pixelFormats.push_back(pixelFormat);
+    }
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Member("benchmark", "copy");
+    json.Member("hardwareThreads", static_cast<int>(std::thread::hardware_concurrency()));
+    json.Member("kernel", FrameCopyEngine::GetKernelName(FrameCopyEngine::GetKernel()));
+    json.Key("settings");
+    json.BeginObject();
+    json.Member("copies", settings.copies);
+    json.Member("workingSetBytes", static_cast<std::uint64_t>(settings.workingSetBytes));
+    json.Member("destinationFrames", k_DestinationFrames);
+    json.EndObject();
+
+    auto verified = true;
+    json.Key("cases");
+    json.BeginArray();
+    for (const auto mode : modes)
+    {
+        for (const auto pixelFormat : pixelFormats)
+        {
+            verified = RunCase(*mode, pixelFormat, settings, json) && verified;
+        }
+    }
+    json.EndArray();
+    json.EndObject();
+
+    const auto output = options.GetString("output", "CopyBenchmark.json");
+    if (!json.Save(output))
+    {
+        std::fprintf(stderr, "Can't write %s.\n", output.c_str());
+        return 1;
+    }
+
+    // A copy which doesn't reproduce its source fails the run.
+    return verified ? 0 : 1;
+}
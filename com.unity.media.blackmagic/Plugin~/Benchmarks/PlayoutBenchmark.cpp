@@ -0,0 +1,504 @@
+// Playout benchmark: runs DeckLinkOutputDevice against virtual cards, whose clock completes the
+// scheduled frames at the cadence of the display mode, and measures the frame rate it sustains,
+// the FeedFrame durations, the late and dropped frames and the allocations per frame, for both
+// submission modes, SDR and HDR feeds, with and without audio. The results are written as JSON.
+//
+//   PlayoutBenchmark [--modes 1080p5994,...] [--formats 8BitYUV,...] [--submission async,manual]
+//                    [--dynamic sdr,hdr] [--audio off,on] [--outputs 1,4,16] [--duration 2]
+//                    [--warmup 60] [--preroll 3] [--late-rate 0] [--drop-rate 0] [--flush-rate 0]
+//                    [--output results.json]
+//
+// Every output is fed by a thread of its own at the cadence of the display mode, as by the frame
+// loop of Unity. The rates inject late, dropped and flushed results into the frames displayed on
+// time, so the error paths of the completion callback are measured as well.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "Common/BenchmarkUtilities.h"
+#include "Common/VirtualDeckLink.h"
+#include "../Includes/DeckLinkOutputDevice.h"
+
+using namespace MediaBlackmagic;
+using namespace MediaBlackmagic::Benchmark;
+
+namespace
+{
+    const std::vector<std::string> k_DefaultModes = { "1080p5994", "2160p5994" };
+    const std::vector<std::string> k_DefaultFormats = { "8BitYUV", "10BitYUV" };
+    const std::vector<std::string> k_DefaultSubmissions = { "async", "manual" };
+    const std::vector<std::string> k_DefaultDynamics = { "sdr", "hdr" };
+    const std::vector<std::string> k_DefaultAudio = { "off", "on" };
+    const std::vector<std::string> k_DefaultOutputs = { "1", "4", "16" };
+    const std::vector<std::string> k_Options = { "modes", "formats", "submission", "dynamic", "audio", "outputs", "duration",
+                                                 "warmup", "preroll", "late-rate", "drop-rate", "flush-rate", "output" };
+
+    const int k_AudioChannelCount = 2;
+    const int k_AudioSampleRate = 48000;
+    const int k_HlgTransferFunction = 3;    // EOTF of the HDR metadata, as in CTA-861.
+
+    struct Settings
+    {
+        double              duration;       // Measured time of each case, in seconds.
+        int                 warmupFrames;   // Frames fed before the measurements start, per output.
+        int                 preroll;
+        VirtualOutputFaults faults;
+    };
+
+    struct Case
+    {
+        const VirtualMode*  mode;
+        BMDPixelFormat      pixelFormat;
+        bool                async;
+        bool                hdr;
+        bool                audio;
+        int                 outputs;
+    };
+
+    struct Output
+    {
+        DeckLinkOutputDevice*       device = nullptr;
+        VirtualDeckLink*            card = nullptr;
+        MeasuringProbe              feedProbe;          // FeedFrame, on the feeding thread.
+        MeasuringProbe              audioFeedProbe;     // FeedAudioSampleFrames, on the feeding thread.
+        MeasuringProbe              completionProbe;    // ScheduledFrameCompleted, on the clock thread.
+        MeasuringProbe              renderProbe;        // RenderAudioSamples, on the clock thread.
+        std::vector<std::uint8_t>   source;
+        std::vector<float>          samples;
+        std::atomic<std::uint64_t>  frameErrors{0};
+    };
+
+    // Indexed by the device index given to the plugin.
+    std::vector<std::unique_ptr<Output>> s_Outputs;
+
+    void UNITY_INTERFACE_API OnFrameError(int deviceIndex, const char*, EDeviceStatus status)
+    {
+        if (status == EDeviceStatus::Ok || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Outputs.size()))
+            return;
+
+        s_Outputs[deviceIndex]->frameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::string GetCaseName(const Case& test)
+    {
+        return std::string(test.mode->name) + " " + GetPixelFormatName(test.pixelFormat) + " " +
+               (test.async ? "async" : "manual") + " " + (test.hdr ? "hdr" : "sdr") + " " +
+               (test.audio ? "audio" : "no-audio");
+    }
+
+    bool StartOutputs(const Case& test, const Settings& settings, std::string& error)
+    {
+        const auto colorSpace = test.hdr ? bmdDisplayModeColorspaceRec2020 : bmdDisplayModeColorspaceRec709;
+        const auto transferFunction = test.hdr ? k_HlgTransferFunction : 0;
+
+        for (auto i = 0; i < test.outputs; ++i)
+        {
+            auto output = s_Outputs[i].get();
+            output->card = VirtualDeckLinkDriver::GetDevice(i);
+            output->card->SetOutputFaults(settings.faults);
+            output->device = new DeckLinkOutputDevice();
+            output->device->SetFameErrorCallback(OnFrameError);
+
+            const auto started = test.async ?
+                output->device->StartAsyncMode(i, i, test.mode->displayMode, test.pixelFormat, colorSpace, transferFunction,
+                                               settings.preroll, test.audio, k_AudioChannelCount, k_AudioSampleRate, false) :
+                output->device->StartManualMode(i, i, test.mode->displayMode, test.pixelFormat, colorSpace, transferFunction,
+                                                settings.preroll, test.audio, k_AudioChannelCount, k_AudioSampleRate, false);
+            if (!started)
+            {
+                error = output->device->GetErrorString();
+                return false;
+            }
+
+            // Sized as the managed side sizes the frames it feeds.
+            output->source.assign(static_cast<std::size_t>(output->device->GetBackingFrameByteWidth()) *
+                                  output->device->GetBackingFrameByteHeight(), 0x40);
+        }
+        return true;
+    }
+
+    void StopOutputs()
+    {
+        for (auto& output : s_Outputs)
+        {
+            if (output->card != nullptr)
+                output->card->SetOutputProbes(nullptr, nullptr);
+
+            if (output->device != nullptr)
+            {
+                output->device->Stop();
+                output->device->Release();
+                output->device = nullptr;
+            }
+
+            output->card = nullptr;
+        }
+    }
+
+    struct OutputCounters
+    {
+        VirtualOutputStatistics virtualStatistics;
+        unsigned int            lateFrames;
+        unsigned int            droppedFrames;
+    };
+
+    OutputCounters ReadCounters(const Output& output)
+    {
+        OutputCounters counters;
+        counters.virtualStatistics = output.card->GetOutputStatistics();
+        counters.lateFrames = output.device->CountLateFrames();
+        counters.droppedFrames = output.device->CountDroppedFrames();
+        return counters;
+    }
+
+    void RunCase(const Case& test, const Settings& settings, JsonWriter& json)
+    {
+        const auto& mode = *test.mode;
+        const auto nominalRate = static_cast<double>(mode.timeScale) / static_cast<double>(mode.frameDuration);
+        const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / nominalRate));
+        const auto name = GetCaseName(test);
+
+        json.BeginObject();
+        json.Member("mode", mode.name);
+        json.Member("width", mode.width);
+        json.Member("height", mode.height);
+        json.Member("pixelFormat", GetPixelFormatName(test.pixelFormat));
+        json.Member("submission", test.async ? "async" : "manual");
+        json.Member("dynamicRange", test.hdr ? "hdr" : "sdr");
+        json.Member("audio", test.audio);
+        json.Member("outputs", test.outputs);
+        json.Member("nominalFramesPerSecond", nominalRate);
+
+        std::vector<VirtualDeviceDescription> cards;
+        for (auto i = 0; i < test.outputs; ++i)
+        {
+            cards.push_back({ "Virtual Output " + std::to_string(i + 1), 0x2000 + i, false, true });
+        }
+        VirtualDeckLinkDriver::Install(cards);
+
+        s_Outputs.clear();
+        for (auto i = 0; i < test.outputs; ++i)
+        {
+            s_Outputs.emplace_back(new Output());
+        }
+
+        std::string error;
+        if (!StartOutputs(test, settings, error))
+        {
+            std::fprintf(stderr, "%s: %s\n", name.c_str(), error.c_str());
+            json.Member("error", error);
+            json.EndObject();
+
+            StopOutputs();
+            s_Outputs.clear();
+            VirtualDeckLinkDriver::Uninstall();
+            return;
+        }
+
+        // Each output is fed on its own thread. The measurements start once every output is warm.
+        std::atomic<int> warmOutputs(0);
+        std::atomic<bool> measuring(false);
+        std::atomic<bool> stopping(false);
+        std::vector<std::thread> threads;
+
+        for (auto& output : s_Outputs)
+        {
+            threads.emplace_back([&, output = output.get()]()
+            {
+                auto nextTime = std::chrono::steady_clock::now();
+                std::int64_t fed = 0;
+                auto warm = false;
+
+                while (!stopping.load(std::memory_order_relaxed))
+                {
+                    WaitUntil(nextTime);
+                    nextTime += frameDuration;
+
+                    if (!warm && fed >= settings.warmupFrames)
+                    {
+                        warm = true;
+                        warmOutputs.fetch_add(1);
+                        while (!measuring.load() && !stopping.load())
+                        {
+                            std::this_thread::yield();
+                        }
+                        output->feedProbe.Reset();
+                        output->audioFeedProbe.Reset();
+                        nextTime = std::chrono::steady_clock::now();
+                        continue;
+                    }
+
+                    output->feedProbe.Enter();
+                    output->device->FeedFrame(output->source.data(), static_cast<unsigned int>(fed));
+                    output->feedProbe.Leave();
+
+                    if (test.audio)
+                    {
+                        // The samples of the frame, so the audio follows the video over time.
+                        const auto sampleFrames = (fed + 1) * mode.frameDuration * k_AudioSampleRate / mode.timeScale -
+                                                  fed * mode.frameDuration * k_AudioSampleRate / mode.timeScale;
+                        const auto sampleCount = static_cast<int>(sampleFrames) * k_AudioChannelCount;
+                        if (output->samples.size() < static_cast<std::size_t>(sampleCount))
+                            output->samples.resize(sampleCount);
+
+                        output->audioFeedProbe.Enter();
+                        output->device->FeedAudioSampleFrames(output->samples.data(), sampleCount);
+                        output->audioFeedProbe.Leave();
+                    }
+                    fed++;
+                }
+            });
+        }
+
+        while (warmOutputs.load() < test.outputs)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // The clock threads take the probes from their next frame period.
+        std::vector<OutputCounters> startCounters;
+        for (auto& output : s_Outputs)
+        {
+            output->card->SetOutputProbes(&output->completionProbe, &output->renderProbe);
+            startCounters.push_back(ReadCounters(*output));
+        }
+
+        const auto startCpuTime = GetProcessCpuTime();
+        const auto startAllocations = AllocationCounter::CountProcess();
+        const auto startContextSwitches = CountContextSwitches();
+        const auto startTime = std::chrono::steady_clock::now();
+        measuring = true;
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(settings.duration));
+
+        // Read before the feeding stops, which would underrun the outputs.
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        const auto cpuTime = GetProcessCpuTime() - startCpuTime;
+        const auto allocations = AllocationCounter::CountProcess() - startAllocations;
+        const auto contextSwitches = CountContextSwitches() - startContextSwitches;
+        std::vector<OutputCounters> endCounters;
+        for (auto& output : s_Outputs)
+        {
+            output->card->SetOutputProbes(nullptr, nullptr);
+            endCounters.push_back(ReadCounters(*output));
+        }
+
+        stopping = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::uint64_t displayed = 0;
+        std::uint64_t late = 0;
+        std::uint64_t dropped = 0;
+        for (std::size_t i = 0; i < s_Outputs.size(); ++i)
+        {
+            const auto& start = startCounters[i].virtualStatistics;
+            const auto& end = endCounters[i].virtualStatistics;
+            displayed += (end.completed - start.completed) + (end.late - start.late);
+            late += endCounters[i].lateFrames - startCounters[i].lateFrames;
+            dropped += endCounters[i].droppedFrames - startCounters[i].droppedFrames;
+        }
+
+        json.Member("elapsedSeconds", elapsed);
+        json.Member("displayedFramesPerSecond", displayed / elapsed);
+        json.Member("lateFrames", late);
+        json.Member("droppedFrames", dropped);
+        json.Member("processCpuPercent", 100.0 * cpuTime / (elapsed * 1e9));
+        json.Member("processAllocationsPerFrame", displayed > 0 ? static_cast<double>(allocations) / displayed : 0.0);
+        json.Member("contextSwitchesPerSecond", contextSwitches / elapsed);
+        json.Member("residentBytes", GetResidentBytes());
+
+        json.Key("perOutput");
+        json.BeginArray();
+        for (std::size_t i = 0; i < s_Outputs.size(); ++i)
+        {
+            const auto& output = *s_Outputs[i];
+            const auto& start = startCounters[i].virtualStatistics;
+            const auto& end = endCounters[i].virtualStatistics;
+            const auto feeds = std::max<std::uint64_t>(output.feedProbe.GetCalls(), 1);
+            const auto completions = std::max<std::uint64_t>(output.completionProbe.GetCalls(), 1);
+
+            json.BeginObject();
+            json.Member("framesFed", output.feedProbe.GetCalls());
+            json.Member("framesPerSecond", ((end.completed - start.completed) + (end.late - start.late)) / elapsed);
+            json.Member("completed", end.completed - start.completed);
+            json.Member("displayedLate", end.late - start.late);
+            json.Member("dropped", end.dropped - start.dropped);
+            json.Member("flushed", end.flushed - start.flushed);
+            json.Member("injectedFaults", end.injected - start.injected);
+            json.Member("underruns", end.underruns - start.underruns);
+            json.Member("pluginLateFrames", static_cast<std::uint64_t>(endCounters[i].lateFrames - startCounters[i].lateFrames));
+            json.Member("pluginDroppedFrames", static_cast<std::uint64_t>(endCounters[i].droppedFrames - startCounters[i].droppedFrames));
+            json.Member("frameErrors", output.frameErrors.load());
+            json.Member("feedCpuNsPerFrame", static_cast<double>(output.feedProbe.GetCpuTime()) / feeds);
+            json.Member("feedAllocationsPerFrame", static_cast<double>(output.feedProbe.GetAllocations()) / feeds);
+            json.Member("completionCpuNsPerFrame", static_cast<double>(output.completionProbe.GetCpuTime()) / completions);
+            json.Member("completionAllocationsPerFrame", static_cast<double>(output.completionProbe.GetAllocations()) / completions);
+            json.Key("feedFrame");
+            json.Durations(output.feedProbe.GetDurations());
+            json.Key("completion");
+            json.Durations(output.completionProbe.GetDurations());
+            if (test.audio)
+            {
+                json.Member("audioFeedAllocationsPerFrame",
+                            static_cast<double>(output.audioFeedProbe.GetAllocations()) / std::max<std::uint64_t>(output.audioFeedProbe.GetCalls(), 1));
+                json.Member("renderAllocationsPerCall",
+                            static_cast<double>(output.renderProbe.GetAllocations()) / std::max<std::uint64_t>(output.renderProbe.GetCalls(), 1));
+                json.Key("audioFeed");
+                json.Durations(output.audioFeedProbe.GetDurations());
+                json.Key("renderAudio");
+                json.Durations(output.renderProbe.GetDurations());
+            }
+            json.EndObject();
+        }
+        json.EndArray();
+        json.EndObject();
+
+        const auto& first = *s_Outputs[0];
+        MetricSummary feed = {};
+        first.feedProbe.GetDurations().Summarize(feed);
+        std::fprintf(stderr, "%-42s %2d output(s): %7.1f fps, FeedFrame p50 %7.1f us p99 %7.1f us, %llu late %llu dropped, %.2f alloc/frame\n",
+                     name.c_str(), test.outputs, displayed / elapsed, feed.p50 / 1000.0, feed.p99 / 1000.0,
+                     static_cast<unsigned long long>(late), static_cast<unsigned long long>(dropped),
+                     static_cast<double>(first.feedProbe.GetAllocations() + first.completionProbe.GetAllocations()) /
+                         std::max<std::uint64_t>(first.feedProbe.GetCalls(), 1));
+
+        StopOutputs();
+        VirtualDeckLinkDriver::Uninstall();
+        s_Outputs.clear();
+    }
+
+    template <typename T>
+    bool ParseChoices(const BenchmarkOptions& options, const char* name, const std::vector<std::string>& fallback,
+                      const std::string& first, const std::string& second, T firstValue, T secondValue, std::vector<T>& values)
+    {
+        for (const auto& choice : options.GetList(name, fallback))
+        {
+            if (choice == first)
+                values.push_back(firstValue);
+            else if (choice == second)
+                values.push_back(secondValue);
+            else
+            {
+                std::fprintf(stderr, "Unknown --%s value %s.\n", name, choice.c_str());
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchmarkOptions options(argc, argv);
+
+    for (const auto& unknown : options.GetUnknown(k_Options))
+    {
+        std::fprintf(stderr, "Unknown option --%s.\n", unknown.c_str());
+        return 1;
+    }
+
+    Settings settings;
+    settings.duration = options.GetDouble("duration", 2.0);
+    settings.warmupFrames = static_cast<int>(options.GetInt("warmup", 60));
+    settings.preroll = static_cast<int>(std::max<std::int64_t>(options.GetInt("preroll", 3), 1));
+    settings.faults.lateRate = options.GetDouble("late-rate", 0.0);
+    settings.faults.dropRate = options.GetDouble("drop-rate", 0.0);
+    settings.faults.flushRate = options.GetDouble("flush-rate", 0.0);
+
+    std::vector<const VirtualMode*> modes;
+    for (const auto& name : options.GetList("modes", k_DefaultModes))
+    {
+        const auto mode = FindVirtualMode(name);
+        if (mode == nullptr)
+        {
+            std::fprintf(stderr, "Unknown mode %s.\n", name.c_str());
+            return 1;
+        }
+        modes.push_back(mode);
+    }
+
+    std::vector<BMDPixelFormat> pixelFormats;
+    for (const auto& name : options.GetList("formats", k_DefaultFormats))
+    {
+        BMDPixelFormat pixelFormat;
+        if (!FindPixelFormat(name, pixelFormat))
+        {
+            std::fprintf(stderr, "Unknown pixel format %s.\n", name.c_str());
+            return 1;
+        }
+        pixelFormats.push_back(pixelFormat);
+    }
+
+    std::vector<bool> submissions;
+    std::vector<bool> dynamics;
+    std::vector<bool> audio;
+    if (!ParseChoices(options, "submission", k_DefaultSubmissions, "async", "manual", true, false, submissions) ||
+        !ParseChoices(options, "dynamic", k_DefaultDynamics, "hdr", "sdr", true, false, dynamics) ||
+        !ParseChoices(options, "audio", k_DefaultAudio, "on", "off", true, false, audio))
+        return 1;
+
+    std::vector<int> outputCounts;
+    for (const auto& count : options.GetList("outputs", k_DefaultOutputs))
+    {
+        const auto outputs = std::atoi(count.c_str());
+        if (outputs < 1 || outputs > 16)
+        {
+            std::fprintf(stderr, "The output count must be between 1 and 16, not %s.\n", count.c_str());
+            return 1;
+        }
+        outputCounts.push_back(outputs);
+    }
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Member("benchmark", "playout");
+    json.Member("hardwareThreads", static_cast<int>(std::thread::hardware_concurrency()));
+    json.Key("settings");
+    json.BeginObject();
+    json.Member("durationSeconds", settings.duration);
+    json.Member("warmupFrames", settings.warmupFrames);
+    json.Member("preroll", settings.preroll);
+    json.Member("lateRate", settings.faults.lateRate);
+    json.Member("dropRate", settings.faults.dropRate);
+    json.Member("flushRate", settings.faults.flushRate);
+    json.EndObject();
+
+    json.Key("cases");
+    json.BeginArray();
+    for (const auto mode : modes)
+    {
+        for (const auto pixelFormat : pixelFormats)
+        {
+            for (const auto async : submissions)
+            {
+                for (const auto hdr : dynamics)
+                {
+                    for (const auto withAudio : audio)
+                    {
+                        for (const auto outputs : outputCounts)
+                        {
+                            RunCase({ mode, pixelFormat, async, hdr, withAudio, outputs }, settings, json);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    json.EndArray();
+    json.EndObject();
+
+    const auto output = options.GetString("output", "PlayoutBenchmark.json");
+    if (!json.Save(output))
+    {
+        std::fprintf(stderr, "Can't write %s.\n", output.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,481 @@
+// Replay benchmark: feeds a recording of the event recorder back into the plugin through virtual
+// cards, with the timing of the recording, so a production incident can be reproduced offline and
+// a change of the plugin compared against the same sequence of driver callbacks. It measures the
+// callback durations and allocations per event, how closely the replay kept the recorded timing,
+// and the late and dropped frames the plugin counted. The results are written as JSON.
+//
+//   ReplayBenchmark --trace recording.dler [--mode 1080p5994] [--format 8BitYUV] [--speed 1]
+//                   [--preroll 3] [--record replayed.dler] [--output results.json]
+//
+// Every device index of the recording gets a virtual card: an input device when the recording has
+// arrived frames or format changes for it, an output device when it has completed frames. The
+// inputs start in the first mode the recording detected, or in --mode, and the outputs in --mode;
+// the outputs are fed at the cadence of the mode as by the frame loop of Unity, while their frames
+// are only completed by the replay, with the recorded results. --speed scales the recorded time,
+// and --record records the replayed callbacks, to compare them with the recording.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "Common/BenchmarkUtilities.h"
+#include "Common/VirtualDeckLink.h"
+#include "../Includes/DeckLinkEventRecorder.h"
+#include "../Includes/DeckLinkInputDevice.h"
+#include "../Includes/DeckLinkOutputDevice.h"
+
+using namespace MediaBlackmagic;
+using namespace MediaBlackmagic::Benchmark;
+
+namespace
+{
+    const std::vector<std::string> k_Options = { "trace", "mode", "format", "speed", "preroll", "record", "output" };
+
+    const int k_MaxDevices = 64;
+
+    // Lets the outputs preroll and the inputs settle before the first event is replayed.
+    const std::chrono::milliseconds k_StartDelay(250);
+
+    struct Settings
+    {
+        const VirtualMode*  mode;
+        BMDPixelFormat      pixelFormat;
+        double              speed;
+        int                 preroll;
+    };
+
+    // The events of a type replayed on a card.
+    struct ReplayedEvents
+    {
+        MeasuringProbe  probe;          // The plugin callback, on the replay thread.
+        std::uint64_t   recorded = 0;
+        std::uint64_t   missed = 0;     // Not replayed: the device wasn't streaming or had no frame scheduled.
+    };
+
+    struct Device
+    {
+        int                             index = 0;
+        VirtualDeckLink*                card = nullptr;
+        DeckLinkInputDevice*            input = nullptr;
+        DeckLinkOutputDevice*           output = nullptr;
+        const VirtualMode*              inputMode = nullptr;
+        std::vector<const RecordedEvent*> events;
+        ReplayedEvents                  replayed[static_cast<int>(ERecordedEvent::Count)];
+        LatencyHistogram                lateness;       // Behind the recorded time, in nanoseconds.
+        std::vector<std::uint8_t>       source;
+        std::atomic<std::uint64_t>      frameErrors{0};
+    };
+
+    // Indexed by the device index of the recording, which is the one given to the plugin.
+    std::vector<std::unique_ptr<Device>> s_Devices;
+
+    bool HasEvents(const Device& device, const ERecordedEvent type)
+    {
+        return device.replayed[static_cast<int>(type)].recorded > 0;
+    }
+
+    void UNITY_INTERFACE_API OnInputFrameError(int32_t deviceIndex, EDeviceStatus status, InputError, const char*)
+    {
+        if (status == EDeviceStatus::Ok || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Devices.size()))
+            return;
+
+        s_Devices[deviceIndex]->frameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void UNITY_INTERFACE_API OnOutputFrameError(int deviceIndex, const char*, EDeviceStatus status)
+    {
+        if (status == EDeviceStatus::Ok || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Devices.size()))
+            return;
+
+        s_Devices[deviceIndex]->frameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool LoadDevices(const std::vector<RecordedEvent>& events, const Settings& settings, std::string& error)
+    {
+        for (const auto& event : events)
+        {
+            if (event.deviceIndex < 0 || event.deviceIndex >= k_MaxDevices)
+            {
+                error = "The recording has events of device " + std::to_string(event.deviceIndex) + ".";
+                return false;
+            }
+
+            while (static_cast<int>(s_Devices.size()) <= event.deviceIndex)
+            {
+                s_Devices.emplace_back(new Device());
+                s_Devices.back()->index = static_cast<int>(s_Devices.size()) - 1;
+            }
+
+            auto& device = *s_Devices[event.deviceIndex];
+            device.events.push_back(&event);
+            device.replayed[event.type].recorded++;
+
+            // The inputs start in the signal detected first, if the virtual cards offer it.
+            if (device.inputMode == nullptr && event.type == static_cast<std::uint8_t>(ERecordedEvent::FormatChanged))
+                device.inputMode = FindVirtualMode(static_cast<BMDDisplayMode>(event.code));
+        }
+
+        for (auto& device : s_Devices)
+        {
+            if (device->inputMode == nullptr)
+                device->inputMode = settings.mode;
+        }
+        return true;
+    }
+
+    bool StartDevices(const Settings& settings, std::string& error)
+    {
+        for (auto& device : s_Devices)
+        {
+            const auto i = device->index;
+            device->card = VirtualDeckLinkDriver::GetDevice(i);
+
+            if (HasEvents(*device, ERecordedEvent::FrameArrived) || HasEvents(*device, ERecordedEvent::FormatChanged))
+            {
+                device->input = new DeckLinkInputDevice();
+                if (!StartVirtualCapture(device->input, device->card, i, i, *device->inputMode, settings.pixelFormat, error))
+                    return false;
+            }
+
+            if (HasEvents(*device, ERecordedEvent::FrameCompleted))
+            {
+                device->card->SetOutputCompletionsReplayed(true);
+                device->output = new DeckLinkOutputDevice();
+                device->output->SetFameErrorCallback(OnOutputFrameError);
+
+                if (!device->output->StartAsyncMode(i, i, settings.mode->displayMode, settings.pixelFormat,
+                                                    bmdDisplayModeColorspaceRec709, 0, settings.preroll, false, 2, 48000, false))
+                {
+                    error = device->output->GetErrorString();
+                    return false;
+                }
+
+                device->source.assign(static_cast<std::size_t>(device->output->GetBackingFrameByteWidth()) *
+                                      device->output->GetBackingFrameByteHeight(), 0x40);
+            }
+        }
+        return true;
+    }
+
+    void StopDevices()
+    {
+        for (auto& device : s_Devices)
+        {
+            if (device->input != nullptr)
+            {
+                device->input->Stop();
+                device->input->Release();
+                device->input = nullptr;
+            }
+
+            if (device->output != nullptr)
+            {
+                device->output->Stop();
+                device->output->Release();
+                device->output = nullptr;
+            }
+
+            device->card = nullptr;
+        }
+    }
+
+    // Replays the events of a card, each at its recorded time relative to the first event of the
+    // recording, so the cards keep their recorded order with each other.
+    void ReplayEvents(Device& device, const std::chrono::steady_clock::time_point startTime, const std::int64_t firstTime,
+                      const double speed)
+    {
+        for (const auto event : device.events)
+        {
+            const auto offset = std::chrono::nanoseconds(static_cast<std::int64_t>((event->time - firstTime) / speed));
+            const auto dueTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset);
+            WaitUntil(dueTime);
+            device.lateness.Record(std::max<std::int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - dueTime).count()));
+
+            auto& replayed = device.replayed[event->type];
+            auto done = false;
+            switch (static_cast<ERecordedEvent>(event->type))
+            {
+            case ERecordedEvent::FrameArrived:
+                // The audio-only callbacks have no frame for the card to deliver.
+                if (event->frameNumber >= 0)
+                    done = device.card->DeliverInputFrame(static_cast<BMDFrameFlags>(event->code), &replayed.probe);
+                break;
+            case ERecordedEvent::FormatChanged:
+                replayed.probe.Enter();
+                done = device.card->ChangeInputFormat(static_cast<BMDDisplayMode>(event->code),
+                                                      static_cast<BMDDetectedVideoInputFormatFlags>(event->detail));
+                replayed.probe.Leave();
+                break;
+            case ERecordedEvent::FrameCompleted:
+                done = device.card->CompleteOutputFrame(static_cast<BMDOutputFrameCompletionResult>(event->code), &replayed.probe);
+                break;
+            default:
+                break;
+            }
+
+            if (!done)
+                replayed.missed++;
+        }
+    }
+
+    const char* GetEventName(const ERecordedEvent type)
+    {
+        switch (type)
+        {
+        case ERecordedEvent::FrameArrived: return "frameArrived";
+        case ERecordedEvent::FormatChanged: return "formatChanged";
+        case ERecordedEvent::FrameCompleted: return "frameCompleted";
+        default: return "unknown";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchmarkOptions options(argc, argv);
+
+    for (const auto& unknown : options.GetUnknown(k_Options))
+    {
+        std::fprintf(stderr, "Unknown option --%s.\n", unknown.c_str());
+        return 1;
+    }
+
+    const auto trace = options.GetString("trace", "");
+    if (trace.empty())
+    {
+        std::fprintf(stderr, "A recording is needed: --trace recording.dler.\n");
+        return 1;
+    }
+
+    Settings settings;
+    settings.speed = options.GetDouble("speed", 1.0);
+    settings.preroll = static_cast<int>(std::max<std::int64_t>(options.GetInt("preroll", 3), 1));
+
+    const auto modeName = options.GetString("mode", "1080p5994");
+    settings.mode = FindVirtualMode(modeName);
+    if (settings.mode == nullptr)
+    {
+        std::fprintf(stderr, "Unknown mode %s.\n", modeName.c_str());
+        return 1;
+    }
+
+    const auto formatName = options.GetString("format", "8BitYUV");
+    if (!FindPixelFormat(formatName, settings.pixelFormat))
+    {
+        std::fprintf(stderr, "Unknown pixel format %s.\n", formatName.c_str());
+        return 1;
+    }
+
+    if (settings.speed <= 0.0)
+    {
+        std::fprintf(stderr, "The speed must be positive.\n");
+        return 1;
+    }
+
+    std::vector<RecordedEvent> events;
+    if (!DeckLinkEventRecorder::Read(trace.c_str(), events))
+    {
+        std::fprintf(stderr, "%s isn't a recording of the event recorder.\n", trace.c_str());
+        return 1;
+    }
+    if (events.empty())
+    {
+        std::fprintf(stderr, "%s has no events.\n", trace.c_str());
+        return 1;
+    }
+
+    std::string error;
+    if (!LoadDevices(events, settings, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    std::vector<VirtualDeviceDescription> cards;
+    for (const auto& device : s_Devices)
+    {
+        const auto capture = HasEvents(*device, ERecordedEvent::FrameArrived) || HasEvents(*device, ERecordedEvent::FormatChanged);
+        const auto playback = HasEvents(*device, ERecordedEvent::FrameCompleted);
+        cards.push_back({ "Virtual Replay " + std::to_string(device->index + 1), 0x5000 + device->index, capture, playback });
+    }
+    VirtualDeckLinkDriver::Install(cards);
+
+    DeckLinkInputDevice::SetFameErrorCallback(OnInputFrameError);
+
+    if (!StartDevices(settings, error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+
+        StopDevices();
+        DeckLinkInputDevice::SetFameErrorCallback(nullptr);
+        VirtualDeckLinkDriver::Uninstall();
+        return 1;
+    }
+
+    const auto record = options.GetString("record", "");
+    if (!record.empty())
+        DeckLinkEventRecorder::Enable(static_cast<int>(events.size()) + 1024);
+
+    // The outputs are fed for the whole replay, as the frame loop of Unity feeds them.
+    const auto& mode = *settings.mode;
+    const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(mode.frameDuration) / static_cast<double>(mode.timeScale)));
+    std::atomic<bool> stopping(false);
+    std::vector<std::thread> feeders;
+
+    for (auto& device : s_Devices)
+    {
+        if (device->output == nullptr)
+            continue;
+
+        feeders.emplace_back([&, device = device.get()]()
+        {
+            auto nextTime = std::chrono::steady_clock::now();
+            std::uint32_t fed = 0;
+
+            while (!stopping.load(std::memory_order_relaxed))
+            {
+                WaitUntil(nextTime);
+                nextTime += frameDuration;
+
+                device->output->FeedFrame(device->source.data(), fed++);
+            }
+        });
+    }
+
+    const auto firstTime = events.front().time;
+    const auto lastTime = events.back().time;
+    const auto startTime = std::chrono::steady_clock::now() + k_StartDelay;
+
+    const auto startCpuTime = GetProcessCpuTime();
+    const auto startAllocations = AllocationCounter::CountProcess();
+
+    // Each card replays on its own thread, as the driver calls back on a thread per card.
+    std::vector<std::thread> replays;
+    for (auto& device : s_Devices)
+    {
+        if (device->events.empty())
+            continue;
+
+        replays.emplace_back([&, device = device.get()]()
+        {
+            ReplayEvents(*device, startTime, firstTime, settings.speed);
+        });
+    }
+
+    for (auto& thread : replays)
+    {
+        thread.join();
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const auto cpuTime = GetProcessCpuTime() - startCpuTime;
+    const auto allocations = AllocationCounter::CountProcess() - startAllocations;
+
+    stopping = true;
+    for (auto& thread : feeders)
+    {
+        thread.join();
+    }
+
+    auto recorded = -1;
+    if (!record.empty())
+    {
+        DeckLinkEventRecorder::Disable();
+        recorded = DeckLinkEventRecorder::Write(record.c_str());
+        if (recorded < 0)
+            std::fprintf(stderr, "Can't write %s.\n", record.c_str());
+    }
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Member("benchmark", "replay");
+    json.Member("hardwareThreads", static_cast<int>(std::thread::hardware_concurrency()));
+    json.Key("settings");
+    json.BeginObject();
+    json.Member("trace", trace);
+    json.Member("mode", mode.name);
+    json.Member("pixelFormat", GetPixelFormatName(settings.pixelFormat));
+    json.Member("speed", settings.speed);
+    json.Member("preroll", settings.preroll);
+    json.EndObject();
+
+    json.Member("events", static_cast<std::uint64_t>(events.size()));
+    json.Member("recordedSeconds", (lastTime - firstTime) / 1e9);
+    json.Member("elapsedSeconds", elapsed);
+    json.Member("processCpuPercent", elapsed > 0.0 ? 100.0 * cpuTime / (elapsed * 1e9) : 0.0);
+    json.Member("processAllocationsPerEvent", static_cast<double>(allocations) / events.size());
+    if (recorded >= 0)
+        json.Member("replayedEventsRecorded", recorded);
+
+    json.Key("devices");
+    json.BeginArray();
+    for (const auto& device : s_Devices)
+    {
+        if (device->events.empty())
+            continue;
+
+        std::uint64_t missed = 0;
+
+        json.BeginObject();
+        json.Member("deviceIndex", device->index);
+        if (device->input != nullptr)
+            json.Member("inputMode", device->inputMode->name);
+        json.Member("frameErrors", device->frameErrors.load());
+        if (device->output != nullptr)
+        {
+            json.Member("pluginLateFrames", static_cast<std::uint64_t>(device->output->CountLateFrames()));
+            json.Member("pluginDroppedFrames", static_cast<std::uint64_t>(device->output->CountDroppedFrames()));
+        }
+        json.Key("lateness");
+        json.Durations(device->lateness);
+
+        for (auto type = 0; type < static_cast<int>(ERecordedEvent::Count); ++type)
+        {
+            const auto& replayed = device->replayed[type];
+            if (replayed.recorded == 0)
+                continue;
+
+            const auto calls = std::max<std::uint64_t>(replayed.probe.GetCalls(), 1);
+            missed += replayed.missed;
+
+            json.Key(GetEventName(static_cast<ERecordedEvent>(type)));
+            json.BeginObject();
+            json.Member("recorded", replayed.recorded);
+            json.Member("replayed", replayed.recorded - replayed.missed);
+            json.Member("missed", replayed.missed);
+            json.Member("callbackCpuNsPerEvent", static_cast<double>(replayed.probe.GetCpuTime()) / calls);
+            json.Member("callbackAllocationsPerEvent", static_cast<double>(replayed.probe.GetAllocations()) / calls);
+            json.Key("callback");
+            json.Durations(replayed.probe.GetDurations());
+            json.EndObject();
+        }
+        json.EndObject();
+
+        MetricSummary lateness = {};
+        device->lateness.Summarize(lateness);
+        std::fprintf(stderr, "Device %2d: %6llu event(s), %llu missed, lateness p50 %7.1f us p99 %7.1f us\n",
+                     device->index, static_cast<unsigned long long>(device->events.size()),
+                     static_cast<unsigned long long>(missed),
+                     lateness.p50 / 1000.0, lateness.p99 / 1000.0);
+    }
+    json.EndArray();
+    json.EndObject();
+
+    StopDevices();
+    DeckLinkInputDevice::SetFameErrorCallback(nullptr);
+    VirtualDeckLinkDriver::Uninstall();
+    s_Devices.clear();
+
+    const auto output = options.GetString("output", "ReplayBenchmark.json");
+    if (!json.Save(output))
+    {
+        std::fprintf(stderr, "Can't write %s.\n", output.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,486 @@
+// Scaling benchmark: runs N input and M output devices at once against virtual cards, for every
+// combination of the given counts, and measures how the cost of the plugin grows with them: the
+// CPU time, the context switches, the threads, the memory and the tail latency of every stream.
+// The results are written as JSON.
+//
+//   ScalingBenchmark [--inputs 0,1,4,16] [--outputs 0,1,4,16] [--mode 1080p5994] [--format 8BitYUV]
+//                    [--duration 2] [--warmup 60] [--copy] [--output results.json]
+//
+// Every card runs at the cadence of the display mode: the inputs deliver from a thread of their
+// own, as the driver does, and the outputs are fed from a thread of their own, as by the frame
+// loop of Unity. --copy copies every captured frame in the frame arrived callback. The CPU time
+// per stream frame stays flat while the plugin scales linearly.
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "Common/BenchmarkUtilities.h"
+#include "Common/VirtualDeckLink.h"
+#include "../Includes/DeckLinkInputDevice.h"
+#include "../Includes/DeckLinkOutputDevice.h"
+
+using namespace MediaBlackmagic;
+using namespace MediaBlackmagic::Benchmark;
+
+namespace
+{
+    const std::vector<std::string> k_DefaultCounts = { "0", "1", "4", "16" };
+    const std::vector<std::string> k_Options = { "inputs", "outputs", "mode", "format", "duration", "warmup", "copy", "output" };
+
+    const int k_MaxStreams = 16;
+
+    struct Settings
+    {
+        const VirtualMode*  mode;
+        BMDPixelFormat      pixelFormat;
+        double              duration;       // Measured time of each case, in seconds.
+        int                 warmupFrames;   // Frames before the measurements start, per stream.
+        bool                copy;
+    };
+
+    struct InputStream
+    {
+        DeckLinkInputDevice*        device = nullptr;
+        VirtualDeckLink*            card = nullptr;
+        MeasuringProbe              probe;              // The capture callback, on the delivery thread.
+        std::vector<std::uint8_t>   copyBuffer;
+        std::atomic<std::uint64_t>  frameErrors{0};
+    };
+
+    struct OutputStream
+    {
+        DeckLinkOutputDevice*       device = nullptr;
+        VirtualDeckLink*            card = nullptr;
+        MeasuringProbe              feedProbe;          // FeedFrame, on the feeding thread.
+        MeasuringProbe              completionProbe;    // ScheduledFrameCompleted, on the clock thread.
+        std::vector<std::uint8_t>   source;
+        std::atomic<std::uint64_t>  frameErrors{0};
+    };
+
+    // Indexed by the device indices given to the plugin, which are apart for inputs and outputs.
+    std::vector<std::unique_ptr<InputStream>> s_Inputs;
+    std::vector<std::unique_ptr<OutputStream>> s_Outputs;
+    bool s_Copy = false;
+
+    void UNITY_INTERFACE_API OnFrameArrived(int32_t deviceIndex, uint8_t* videoData, int64_t videoDataSize,
+                                            int32_t, int32_t, int32_t, int32_t, int64_t, int64_t, int64_t,
+                                            uint32_t, uint8_t*, int32_t, int32_t, int32_t, int64_t)
+    {
+        if (!s_Copy || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Inputs.size()))
+            return;
+
+        auto& buffer = s_Inputs[deviceIndex]->copyBuffer;
+        std::memcpy(buffer.data(), videoData, std::min(static_cast<std::size_t>(videoDataSize), buffer.size()));
+    }
+
+    void UNITY_INTERFACE_API OnInputError(int32_t deviceIndex, EDeviceStatus status, InputError, const char*)
+    {
+        if (status == EDeviceStatus::Ok || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Inputs.size()))
+            return;
+
+        s_Inputs[deviceIndex]->frameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void UNITY_INTERFACE_API OnOutputError(int deviceIndex, const char*, EDeviceStatus status)
+    {
+        if (status == EDeviceStatus::Ok || deviceIndex < 0 || deviceIndex >= static_cast<int>(s_Outputs.size()))
+            return;
+
+        s_Outputs[deviceIndex]->frameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The input cards come first, then the output cards.
+    bool StartStreams(const Settings& settings, std::string& error)
+    {
+        const auto& mode = *settings.mode;
+        const auto inputCount = static_cast<int>(s_Inputs.size());
+
+        for (auto i = 0; i < inputCount; ++i)
+        {
+            auto input = s_Inputs[i].get();
+            input->card = VirtualDeckLinkDriver::GetDevice(i);
+            input->device = new DeckLinkInputDevice();
+
+            if (!StartVirtualCapture(input->device, input->card, i, i, mode, settings.pixelFormat, error))
+                return false;
+
+            if (settings.copy)
+                input->copyBuffer.resize(GetFrameBytes(mode, settings.pixelFormat));
+        }
+
+        for (auto i = 0; i < static_cast<int>(s_Outputs.size()); ++i)
+        {
+            auto output = s_Outputs[i].get();
+            output->card = VirtualDeckLinkDriver::GetDevice(inputCount + i);
+            output->device = new DeckLinkOutputDevice();
+            output->device->SetFameErrorCallback(OnOutputError);
+
+            if (!output->device->StartAsyncMode(i, inputCount + i, mode.displayMode, settings.pixelFormat,
+                                                bmdDisplayModeColorspaceRec709, 0, 3, false, 0, 48000, false))
+            {
+                error = output->device->GetErrorString();
+                return false;
+            }
+
+            output->source.assign(static_cast<std::size_t>(output->device->GetBackingFrameByteWidth()) *
+                                  output->device->GetBackingFrameByteHeight(), 0x40);
+        }
+        return true;
+    }
+
+    void StopStreams()
+    {
+        for (auto& input : s_Inputs)
+        {
+            if (input->device != nullptr)
+            {
+                input->device->Stop();
+                input->device->Release();
+                input->device = nullptr;
+            }
+            input->card = nullptr;
+        }
+
+        for (auto& output : s_Outputs)
+        {
+            if (output->card != nullptr)
+                output->card->SetOutputProbes(nullptr, nullptr);
+
+            if (output->device != nullptr)
+            {
+                output->device->Stop();
+                output->device->Release();
+                output->device = nullptr;
+            }
+            output->card = nullptr;
+        }
+    }
+
+    void WriteStreamLatency(JsonWriter& json, const char* kind, const int index, const MeasuringProbe& probe,
+                            const std::uint64_t frameErrors, const double elapsed)
+    {
+        json.BeginObject();
+        json.Member("kind", kind);
+        json.Member("index", index);
+        json.Member("frames", probe.GetCalls());
+        json.Member("framesPerSecond", probe.GetCalls() / elapsed);
+        json.Member("frameErrors", frameErrors);
+        json.Key("latency");
+        json.Durations(probe.GetDurations());
+        json.EndObject();
+    }
+
+    void RunCase(const int inputCount, const int outputCount, const Settings& settings, JsonWriter& json)
+    {
+        const auto& mode = *settings.mode;
+        const auto nominalRate = static_cast<double>(mode.timeScale) / static_cast<double>(mode.frameDuration);
+        const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / nominalRate));
+        const auto streamCount = inputCount + outputCount;
+
+        json.BeginObject();
+        json.Member("inputs", inputCount);
+        json.Member("outputs", outputCount);
+
+        // The footprint of the streams is the growth from here.
+        const auto baseThreads = CountThreads();
+        const auto baseResidentBytes = GetResidentBytes();
+
+        std::vector<VirtualDeviceDescription> cards;
+        for (auto i = 0; i < inputCount; ++i)
+        {
+            cards.push_back({ "Virtual Input " + std::to_string(i + 1), 0x1000 + i, true, false });
+        }
+        for (auto i = 0; i < outputCount; ++i)
+        {
+            cards.push_back({ "Virtual Output " + std::to_string(i + 1), 0x2000 + i, false, true });
+        }
+        VirtualDeckLinkDriver::Install(cards);
+
+        s_Inputs.clear();
+        s_Outputs.clear();
+        for (auto i = 0; i < inputCount; ++i)
+        {
+            s_Inputs.emplace_back(new InputStream());
+        }
+        for (auto i = 0; i < outputCount; ++i)
+        {
+            s_Outputs.emplace_back(new OutputStream());
+        }
+
+        std::string error;
+        if (!StartStreams(settings, error))
+        {
+            std::fprintf(stderr, "%2d input(s) %2d output(s): %s\n", inputCount, outputCount, error.c_str());
+            json.Member("error", error);
+            json.EndObject();
+
+            StopStreams();
+            VirtualDeckLinkDriver::Uninstall();
+            s_Inputs.clear();
+            s_Outputs.clear();
+            return;
+        }
+
+        // Each stream runs on its own thread. The measurements start once every stream is warm.
+        std::atomic<int> warmStreams(0);
+        std::atomic<bool> measuring(false);
+        std::atomic<bool> stopping(false);
+        std::vector<std::thread> threads;
+
+        const auto warmUp = [&](MeasuringProbe& probe, std::chrono::steady_clock::time_point& nextTime)
+        {
+            warmStreams.fetch_add(1);
+            while (!measuring.load() && !stopping.load())
+            {
+                std::this_thread::yield();
+            }
+            probe.Reset();
+            nextTime = std::chrono::steady_clock::now();
+        };
+
+        for (auto& input : s_Inputs)
+        {
+            threads.emplace_back([&, input = input.get()]()
+            {
+                auto nextTime = std::chrono::steady_clock::now();
+                auto delivered = 0;
+
+                while (!stopping.load(std::memory_order_relaxed))
+                {
+                    WaitUntil(nextTime);
+                    nextTime += frameDuration;
+
+                    if (delivered++ == settings.warmupFrames)
+                    {
+                        warmUp(input->probe, nextTime);
+                        continue;
+                    }
+
+                    input->card->DeliverInputFrame(bmdFrameFlagDefault, &input->probe);
+                }
+            });
+        }
+
+        for (auto& output : s_Outputs)
+        {
+            threads.emplace_back([&, output = output.get()]()
+            {
+                auto nextTime = std::chrono::steady_clock::now();
+                auto fed = 0;
+
+                while (!stopping.load(std::memory_order_relaxed))
+                {
+                    WaitUntil(nextTime);
+                    nextTime += frameDuration;
+
+                    if (fed++ == settings.warmupFrames)
+                    {
+                        warmUp(output->feedProbe, nextTime);
+                        continue;
+                    }
+
+                    output->feedProbe.Enter();
+                    output->device->FeedFrame(output->source.data(), static_cast<unsigned int>(fed));
+                    output->feedProbe.Leave();
+                }
+            });
+        }
+
+        while (warmStreams.load() < streamCount)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // The clock threads take the probes from their next frame period.
+        for (auto& output : s_Outputs)
+        {
+            output->card->SetOutputProbes(&output->completionProbe, nullptr);
+        }
+
+        const auto startCpuTime = GetProcessCpuTime();
+        const auto startAllocations = AllocationCounter::CountProcess();
+        const auto startContextSwitches = CountContextSwitches();
+        const auto startTime = std::chrono::steady_clock::now();
+        measuring = true;
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(settings.duration));
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        const auto cpuTime = GetProcessCpuTime() - startCpuTime;
+        const auto allocations = AllocationCounter::CountProcess() - startAllocations;
+        const auto contextSwitches = CountContextSwitches() - startContextSwitches;
+        const auto threadCount = CountThreads();
+        const auto residentBytes = GetResidentBytes();
+
+        for (auto& output : s_Outputs)
+        {
+            output->card->SetOutputProbes(nullptr, nullptr);
+        }
+
+        stopping = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::uint64_t frames = 0;
+        LatencyHistogram inputLatency;
+        LatencyHistogram feedLatency;
+        for (const auto& input : s_Inputs)
+        {
+            frames += input->probe.GetCalls();
+            inputLatency.Merge(input->probe.GetDurations());
+        }
+        for (const auto& output : s_Outputs)
+        {
+            frames += output->feedProbe.GetCalls();
+            feedLatency.Merge(output->feedProbe.GetDurations());
+        }
+
+        // Neither the threads of the benchmark, one per stream, nor the clocks of the virtual
+        // outputs are the ones of the plugin.
+        const auto pluginThreads = threadCount - baseThreads - streamCount - outputCount;
+        const auto cpuNsPerFrame = frames > 0 ? static_cast<double>(cpuTime) / frames : 0.0;
+
+        json.Member("elapsedSeconds", elapsed);
+        json.Member("framesPerSecond", frames / elapsed);
+        json.Member("processCpuPercent", 100.0 * cpuTime / (elapsed * 1e9));
+        json.Member("cpuPercentPerStream", streamCount > 0 ? 100.0 * cpuTime / (elapsed * 1e9) / streamCount : 0.0);
+        json.Member("cpuNsPerStreamFrame", cpuNsPerFrame);
+        json.Member("contextSwitchesPerSecond", contextSwitches / elapsed);
+        json.Member("contextSwitchesPerStreamFrame", frames > 0 ? static_cast<double>(contextSwitches) / frames : 0.0);
+        json.Member("allocationsPerStreamFrame", frames > 0 ? static_cast<double>(allocations) / frames : 0.0);
+        json.Member("pluginThreads", pluginThreads);
+        json.Member("residentBytes", residentBytes);
+        json.Member("residentBytesPerStream", streamCount > 0 ? (residentBytes - baseResidentBytes) / streamCount : 0);
+        json.Key("inputLatency");
+        json.Durations(inputLatency);
+        json.Key("feedLatency");
+        json.Durations(feedLatency);
+
+        json.Key("perStream");
+        json.BeginArray();
+        for (auto i = 0; i < inputCount; ++i)
+        {
+            WriteStreamLatency(json, "input", i, s_Inputs[i]->probe, s_Inputs[i]->frameErrors.load(), elapsed);
+        }
+        for (auto i = 0; i < outputCount; ++i)
+        {
+            WriteStreamLatency(json, "output", i, s_Outputs[i]->feedProbe, s_Outputs[i]->frameErrors.load(), elapsed);
+        }
+        json.EndArray();
+        json.EndObject();
+
+        MetricSummary input = {};
+        MetricSummary feed = {};
+        inputLatency.Summarize(input);
+        feedLatency.Summarize(feed);
+        std::fprintf(stderr, "%2d input(s) %2d output(s): %6.1f%% CPU, %8.0f ns/frame, %6.0f switches/s, %3d threads, "
+                             "input p99 %7.1f us, feed p99 %7.1f us\n",
+                     inputCount, outputCount, 100.0 * cpuTime / (elapsed * 1e9), cpuNsPerFrame, contextSwitches / elapsed,
+                     pluginThreads, input.p99 / 1000.0, feed.p99 / 1000.0);
+
+        StopStreams();
+        VirtualDeckLinkDriver::Uninstall();
+        s_Inputs.clear();
+        s_Outputs.clear();
+    }
+
+    bool ParseCounts(const BenchmarkOptions& options, const char* name, std::vector<int>& counts)
+    {
+        for (const auto& value : options.GetList(name, k_DefaultCounts))
+        {
+            const auto count = std::atoi(value.c_str());
+            if (count < 0 || count > k_MaxStreams)
+            {
+                std::fprintf(stderr, "The --%s counts must be between 0 and %d, not %s.\n", name, k_MaxStreams, value.c_str());
+                return false;
+            }
+            counts.push_back(count);
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchmarkOptions options(argc, argv);
+
+    for (const auto& unknown : options.GetUnknown(k_Options))
+    {
+        std::fprintf(stderr, "Unknown option --%s.\n", unknown.c_str());
+        return 1;
+    }
+
+    Settings settings;
+    settings.mode = FindVirtualMode(options.GetString("mode", "1080p5994"));
+    settings.duration = options.GetDouble("duration", 2.0);
+    settings.warmupFrames = static_cast<int>(options.GetInt("warmup", 60));
+    settings.copy = options.Has("copy");
+    s_Copy = settings.copy;
+
+    if (settings.mode == nullptr)
+    {
+        std::fprintf(stderr, "Unknown mode %s.\n", options.GetString("mode", "").c_str());
+        return 1;
+    }
+
+    const auto format = options.GetString("format", "8BitYUV");
+    if (!FindPixelFormat(format, settings.pixelFormat))
+    {
+        std::fprintf(stderr, "Unknown pixel format %s.\n", format.c_str());
+        return 1;
+    }
+
+    std::vector<int> inputCounts;
+    std::vector<int> outputCounts;
+    if (!ParseCounts(options, "inputs", inputCounts) || !ParseCounts(options, "outputs", outputCounts))
+        return 1;
+
+    DeckLinkInputDevice::SetFrameArrivedCallback(OnFrameArrived);
+    DeckLinkInputDevice::SetFameErrorCallback(OnInputError);
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Member("benchmark", "scaling");
+    json.Member("hardwareThreads", static_cast<int>(std::thread::hardware_concurrency()));
+    json.Key("settings");
+    json.BeginObject();
+    json.Member("mode", settings.mode->name);
+    json.Member("pixelFormat", GetPixelFormatName(settings.pixelFormat));
+    json.Member("nominalFramesPerSecond", static_cast<double>(settings.mode->timeScale) / settings.mode->frameDuration);
+    json.Member("durationSeconds", settings.duration);
+    json.Member("warmupFrames", settings.warmupFrames);
+    json.Member("copy", settings.copy);
+    json.EndObject();
+
+    json.Key("cases");
+    json.BeginArray();
+    for (const auto inputCount : inputCounts)
+    {
+        for (const auto outputCount : outputCounts)
+        {
+            if (inputCount + outputCount > 0)
+            {
+                RunCase(inputCount, outputCount, settings, json);
+            }
+        }
+    }
+    json.EndArray();
+    json.EndObject();
+
+    DeckLinkInputDevice::SetFrameArrivedCallback(nullptr);
+    DeckLinkInputDevice::SetFameErrorCallback(nullptr);
+
+    const auto output = options.GetString("output", "ScalingBenchmark.json");
+    if (!json.Save(output))
+    {
+        std::fprintf(stderr, "Can't write %s.\n", output.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,553 @@
+// Soak benchmark: cycles the devices of the plugin through their life against virtual cards, for
+// as long as asked, and watches the resources left behind by every cycle: the live objects and
+// references of every DeckLink interface, the heap, the resident memory, the threads and the file
+// descriptors. It fails as soon as one of them grows through a whole window of cycles, so a slow
+// leak shows up in minutes instead of after a day on air. The samples are written as JSON.
+//
+//   SoakBenchmark [--inputs 2] [--outputs 2] [--modes 1080p5994,2160p5994] [--cycles 40]
+//                 [--duration 0] [--phase 1] [--warmup 3] [--window 10] [--fault-rate 0.01]
+//                 [--output results.json]
+//
+// A cycle creates the devices, streams for a phase, reconfigures them to the next mode, streams
+// for another phase and destroys them. The inputs are fed at the cadence of the mode by a thread
+// of their own, as by the driver; the outputs alternate between async SDR and manual HDR feeds,
+// with audio, and are fed by a thread of their own, as by the frame loop of Unity. --duration, in
+// seconds, runs cycles until it is over, instead of the count of --cycles. The samples of the
+// warm-up cycles are reported but not judged, as the caches of the plugin fill up.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <malloc.h>
+
+#include "Common/BenchmarkUtilities.h"
+#include "Common/VirtualDeckLink.h"
+#include "../Includes/DeckLinkInputDevice.h"
+#include "../Includes/DeckLinkOutputDevice.h"
+
+using namespace MediaBlackmagic;
+using namespace MediaBlackmagic::Benchmark;
+
+namespace
+{
+    const std::vector<std::string> k_DefaultModes = { "1080p5994", "2160p5994" };
+    const std::vector<std::string> k_Options = { "inputs", "outputs", "modes", "cycles", "duration", "phase", "warmup",
+                                                 "window", "fault-rate", "output" };
+
+    const int k_MaxStreams = 16;
+    const int k_AudioChannelCount = 2;
+    const int k_AudioSampleRate = 48000;
+    const int k_HlgTransferFunction = 3;    // EOTF of the HDR metadata, as in CTA-861.
+    const int k_Preroll = 3;
+
+    // Growth within these bounds over a window is allocator noise rather than a leak.
+    const std::int64_t k_HeapTolerance = 4 * 1024;
+    const std::int64_t k_ResidentTolerance = 1024 * 1024;
+
+    struct Settings
+    {
+        int                             inputs;
+        int                             outputs;
+        std::vector<const VirtualMode*> modes;          // Cycled through, one step per reconfiguration.
+        int                             cycles;
+        double                          duration;       // In seconds; 0 to run the count of cycles.
+        double                          phase;          // Streaming time before and after the reconfiguration.
+        int                             warmupCycles;
+        int                             window;         // Cycles of growth which make a leak.
+        VirtualOutputFaults             faults;
+    };
+
+    struct InputStream
+    {
+        DeckLinkInputDevice*        device = nullptr;
+        VirtualDeckLink*            card = nullptr;
+        std::uint64_t               frames = 0;
+    };
+
+    struct OutputStream
+    {
+        DeckLinkOutputDevice*       device = nullptr;
+        VirtualDeckLink*            card = nullptr;
+        bool                        hdr = false;
+        BMDPixelFormat              pixelFormat = bmdFormat8BitYUV;
+        std::vector<std::uint8_t>   source;
+        std::vector<float>          samples;
+        std::uint64_t               frames = 0;
+    };
+
+    // What the cycles left behind, once their devices are destroyed. The memory is the sum of what
+    // every cycle kept, measured around the cycle so the results of the benchmark are left out.
+    struct Sample
+    {
+        std::vector<VirtualObjectCount>     objects;
+        std::int64_t                        heapBytes;
+        std::int64_t                        residentBytes;
+        int                                 threads;
+        int                                 fileDescriptors;
+        std::uint64_t                       frames;         // Streamed during the cycle.
+        std::uint64_t                       frameErrors;
+    };
+
+    // A resource watched for growth, read from the samples.
+    struct Metric
+    {
+        std::string                         name;
+        std::int64_t                        tolerance;
+        std::int64_t                        (*read)(const Sample& sample, std::size_t index);
+        std::size_t                         index;          // Of the interface, for the object counts.
+    };
+
+    std::vector<InputStream> s_Inputs;
+    std::vector<OutputStream> s_Outputs;
+    std::atomic<std::uint64_t> s_FrameErrors(0);
+    std::int64_t s_RetainedHeapBytes = 0;
+    std::int64_t s_RetainedResidentBytes = 0;
+
+    void UNITY_INTERFACE_API OnInputError(int32_t, EDeviceStatus status, InputError, const char*)
+    {
+        if (status != EDeviceStatus::Ok)
+            s_FrameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void UNITY_INTERFACE_API OnOutputError(int, const char*, EDeviceStatus status)
+    {
+        if (status != EDeviceStatus::Ok)
+            s_FrameErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The backing frames change with the mode, so the source follows them.
+    void ResizeSource(OutputStream& output)
+    {
+        output.source.assign(static_cast<std::size_t>(output.device->GetBackingFrameByteWidth()) *
+                             output.device->GetBackingFrameByteHeight(), 0x40);
+    }
+
+    // The input cards come first, then the output cards. Even outputs start in async SDR and odd
+    // ones in manual HDR, and they swap on every cycle.
+    bool CreateDevices(const Settings& settings, const VirtualMode& mode, const int cycle, std::string& error)
+    {
+        for (auto i = 0; i < settings.inputs; ++i)
+        {
+            auto& input = s_Inputs[i];
+            input.card = VirtualDeckLinkDriver::GetDevice(i);
+            input.device = new DeckLinkInputDevice();
+
+            if (!StartVirtualCapture(input.device, input.card, i, i, mode, bmdFormat8BitYUV, error))
+                return false;
+        }
+
+        for (auto i = 0; i < settings.outputs; ++i)
+        {
+            auto& output = s_Outputs[i];
+            output.card = VirtualDeckLinkDriver::GetDevice(settings.inputs + i);
+            output.card->SetOutputFaults(settings.faults);
+            output.device = new DeckLinkOutputDevice();
+            output.device->SetFameErrorCallback(OnOutputError);
+
+            output.hdr = (i + cycle) % 2 != 0;
+            output.pixelFormat = output.hdr ? bmdFormat10BitYUV : bmdFormat8BitYUV;
+            const auto colorSpace = output.hdr ? bmdDisplayModeColorspaceRec2020 : bmdDisplayModeColorspaceRec709;
+            const auto transferFunction = output.hdr ? k_HlgTransferFunction : 0;
+
+            const auto started = output.hdr ?
+                output.device->StartManualMode(i, settings.inputs + i, mode.displayMode, output.pixelFormat, colorSpace,
+                                               transferFunction, k_Preroll, true, k_AudioChannelCount, k_AudioSampleRate, false) :
+                output.device->StartAsyncMode(i, settings.inputs + i, mode.displayMode, output.pixelFormat, colorSpace,
+                                              transferFunction, k_Preroll, true, k_AudioChannelCount, k_AudioSampleRate, false);
+            if (!started)
+            {
+                error = output.device->GetErrorString();
+                return false;
+            }
+            ResizeSource(output);
+        }
+        return true;
+    }
+
+    // The inputs detect a signal in the mode, and the outputs are switched to it while running.
+    bool ReconfigureDevices(const VirtualMode& mode, std::string& error)
+    {
+        for (auto& input : s_Inputs)
+        {
+            if (!input.card->ChangeInputFormat(mode.displayMode, bmdDetectedVideoInputYCbCr422 | bmdDetectedVideoInput8BitDepth))
+            {
+                error = "The input didn't accept the format change.";
+                return false;
+            }
+        }
+
+        for (auto& output : s_Outputs)
+        {
+            const auto colorSpace = output.hdr ? bmdDisplayModeColorspaceRec2020 : bmdDisplayModeColorspaceRec709;
+            const auto transferFunction = output.hdr ? k_HlgTransferFunction : 0;
+
+            if (!output.device->Reconfigure(mode.displayMode, output.pixelFormat, colorSpace, transferFunction,
+                                            EOutputKeyingMode::None, EOutputLinkMode::Single))
+            {
+                error = output.device->GetErrorString();
+                return false;
+            }
+            ResizeSource(output);
+        }
+        return true;
+    }
+
+    void DestroyDevices()
+    {
+        for (auto& input : s_Inputs)
+        {
+            if (input.device != nullptr)
+            {
+                input.device->Stop();
+                input.device->Release();
+                input.device = nullptr;
+            }
+            input.card = nullptr;
+        }
+
+        for (auto& output : s_Outputs)
+        {
+            if (output.device != nullptr)
+            {
+                output.device->Stop();
+                output.device->Release();
+                output.device = nullptr;
+            }
+            output.card = nullptr;
+
+            // The buffers of the benchmark go as well, so the samples only hold what the plugin kept.
+            std::vector<std::uint8_t>().swap(output.source);
+            std::vector<float>().swap(output.samples);
+        }
+    }
+
+    // Every stream runs on its own thread at the cadence of the mode, for the duration.
+    void Stream(const VirtualMode& mode, const double duration)
+    {
+        const auto frameDuration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(mode.frameDuration) / mode.timeScale));
+        const auto endTime = std::chrono::steady_clock::now() +
+                             std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(duration));
+        std::vector<std::thread> threads;
+
+        for (auto& input : s_Inputs)
+        {
+            threads.emplace_back([&, input = &input]()
+            {
+                for (auto nextTime = std::chrono::steady_clock::now(); nextTime < endTime; nextTime += frameDuration)
+                {
+                    WaitUntil(nextTime);
+                    if (input->card->DeliverInputFrame(bmdFrameFlagDefault, nullptr))
+                        input->frames++;
+                }
+            });
+        }
+
+        for (auto& output : s_Outputs)
+        {
+            threads.emplace_back([&, output = &output]()
+            {
+                for (auto nextTime = std::chrono::steady_clock::now(); nextTime < endTime; nextTime += frameDuration)
+                {
+                    WaitUntil(nextTime);
+
+                    const auto fed = static_cast<std::int64_t>(output->frames++);
+                    output->device->FeedFrame(output->source.data(), static_cast<unsigned int>(fed));
+
+                    // The samples of the frame, so the audio follows the video over time.
+                    const auto sampleFrames = (fed + 1) * mode.frameDuration * k_AudioSampleRate / mode.timeScale -
+                                              fed * mode.frameDuration * k_AudioSampleRate / mode.timeScale;
+                    const auto sampleCount = static_cast<int>(sampleFrames) * k_AudioChannelCount;
+                    if (output->samples.size() < static_cast<std::size_t>(sampleCount))
+                        output->samples.resize(sampleCount);
+                    output->device->FeedAudioSampleFrames(output->samples.data(), sampleCount);
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    bool RunCycle(const Settings& settings, const int cycle, Sample& sample, std::string& error)
+    {
+        const auto& mode = *settings.modes[cycle % settings.modes.size()];
+        const auto& nextMode = *settings.modes[(cycle + 1) % settings.modes.size()];
+
+        for (auto& input : s_Inputs)
+        {
+            input.frames = 0;
+        }
+        for (auto& output : s_Outputs)
+        {
+            output.frames = 0;
+        }
+        s_FrameErrors = 0;
+
+        // The memory freed before goes back to the system first, on both ends of the cycle, so the
+        // resident size only holds what is in use rather than what the allocator keeps at hand.
+        malloc_trim(0);
+        const auto heapBytes = GetHeapBytes();
+        const auto residentBytes = GetResidentBytes();
+
+        auto succeeded = CreateDevices(settings, mode, cycle, error);
+        if (succeeded)
+        {
+            Stream(mode, settings.phase);
+            succeeded = ReconfigureDevices(nextMode, error);
+        }
+        if (succeeded)
+        {
+            Stream(nextMode, settings.phase);
+        }
+        DestroyDevices();
+
+        malloc_trim(0);
+        s_RetainedHeapBytes += GetHeapBytes() - heapBytes;
+        s_RetainedResidentBytes += GetResidentBytes() - residentBytes;
+
+        sample.heapBytes = s_RetainedHeapBytes;
+        sample.residentBytes = s_RetainedResidentBytes;
+        sample.objects = CountVirtualObjects();
+        sample.threads = CountThreads();
+        sample.fileDescriptors = CountFileDescriptors();
+        sample.frames = 0;
+        for (const auto& input : s_Inputs)
+        {
+            sample.frames += input.frames;
+        }
+        for (const auto& output : s_Outputs)
+        {
+            sample.frames += output.frames;
+        }
+        sample.frameErrors = s_FrameErrors.load();
+        return succeeded;
+    }
+
+    std::vector<Metric> GetMetrics(const Sample& sample)
+    {
+        std::vector<Metric> metrics =
+        {
+            { "retainedHeapBytes", k_HeapTolerance, [](const Sample& s, std::size_t) { return s.heapBytes; }, 0 },
+            { "retainedResidentBytes", k_ResidentTolerance, [](const Sample& s, std::size_t) { return s.residentBytes; }, 0 },
+            { "threads", 0, [](const Sample& s, std::size_t) { return static_cast<std::int64_t>(s.threads); }, 0 },
+            { "fileDescriptors", 0, [](const Sample& s, std::size_t) { return static_cast<std::int64_t>(s.fileDescriptors); }, 0 },
+        };
+
+        for (std::size_t i = 0; i < sample.objects.size(); ++i)
+        {
+            const std::string name = sample.objects[i].interfaceName;
+            metrics.push_back({ name + ".objects", 0, [](const Sample& s, std::size_t index) { return s.objects[index].objects; }, i });
+            metrics.push_back({ name + ".references", 0, [](const Sample& s, std::size_t index) { return s.objects[index].references; }, i });
+        }
+        return metrics;
+    }
+
+    // A metric leaks when it never went down over the last window of samples and ended higher than
+    // the tolerance. Returns the growth over the window, or 0.
+    std::int64_t FindGrowth(const Metric& metric, const std::vector<Sample>& samples, const std::size_t first)
+    {
+        const auto values = samples.size() - first;
+        if (values < 2)
+            return 0;
+
+        for (auto i = first + 1; i < samples.size(); ++i)
+        {
+            if (metric.read(samples[i], metric.index) < metric.read(samples[i - 1], metric.index))
+                return 0;
+        }
+
+        const auto growth = metric.read(samples.back(), metric.index) - metric.read(samples[first], metric.index);
+        return growth > metric.tolerance ? growth : 0;
+    }
+
+    void WriteSample(JsonWriter& json, const int cycle, const Sample& sample, const double elapsed)
+    {
+        json.BeginObject();
+        json.Member("cycle", cycle);
+        json.Member("elapsedSeconds", elapsed);
+        json.Member("frames", sample.frames);
+        json.Member("frameErrors", sample.frameErrors);
+        json.Member("retainedHeapBytes", sample.heapBytes);
+        json.Member("retainedResidentBytes", sample.residentBytes);
+        json.Member("threads", sample.threads);
+        json.Member("fileDescriptors", sample.fileDescriptors);
+        json.Key("objects");
+        json.BeginObject();
+        for (const auto& count : sample.objects)
+        {
+            json.Key(count.interfaceName);
+            json.BeginObject();
+            json.Member("objects", count.objects);
+            json.Member("references", count.references);
+            json.EndObject();
+        }
+        json.EndObject();
+        json.EndObject();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const BenchmarkOptions options(argc, argv);
+
+    for (const auto& unknown : options.GetUnknown(k_Options))
+    {
+        std::fprintf(stderr, "Unknown option --%s.\n", unknown.c_str());
+        return 1;
+    }
+
+    Settings settings;
+    settings.inputs = static_cast<int>(options.GetInt("inputs", 2));
+    settings.outputs = static_cast<int>(options.GetInt("outputs", 2));
+    settings.cycles = static_cast<int>(options.GetInt("cycles", 40));
+    settings.duration = options.GetDouble("duration", 0.0);
+    settings.phase = options.GetDouble("phase", 1.0);
+    settings.warmupCycles = static_cast<int>(options.GetInt("warmup", 3));
+    settings.window = static_cast<int>(options.GetInt("window", 10));
+
+    const auto faultRate = options.GetDouble("fault-rate", 0.01);
+    settings.faults = { faultRate, faultRate, 0.0 };
+
+    if (settings.inputs < 0 || settings.inputs > k_MaxStreams || settings.outputs < 0 || settings.outputs > k_MaxStreams ||
+        settings.inputs + settings.outputs == 0)
+    {
+        std::fprintf(stderr, "The --inputs and --outputs counts must be between 0 and %d, and not both 0.\n", k_MaxStreams);
+        return 1;
+    }
+
+    if (settings.window < 2 || settings.warmupCycles < 0 || settings.phase <= 0.0)
+    {
+        std::fprintf(stderr, "The --window must be 2 cycles at least, and the --phase longer than 0.\n");
+        return 1;
+    }
+
+    for (const auto& name : options.GetList("modes", k_DefaultModes))
+    {
+        const auto mode = FindVirtualMode(name);
+        if (mode == nullptr || mode->quadLink)
+        {
+            std::fprintf(stderr, "Unknown or quad-link mode %s.\n", name.c_str());
+            return 1;
+        }
+        settings.modes.push_back(mode);
+    }
+
+    std::vector<VirtualDeviceDescription> cards;
+    for (auto i = 0; i < settings.inputs; ++i)
+    {
+        cards.push_back({ "Virtual Input " + std::to_string(i + 1), 0x1000 + i, true, false });
+    }
+    for (auto i = 0; i < settings.outputs; ++i)
+    {
+        cards.push_back({ "Virtual Output " + std::to_string(i + 1), 0x2000 + i, false, true });
+    }
+    VirtualDeckLinkDriver::Install(cards);
+
+    s_Inputs.resize(settings.inputs);
+    s_Outputs.resize(settings.outputs);
+    DeckLinkInputDevice::SetFameErrorCallback(OnInputError);
+
+    JsonWriter json;
+    json.BeginObject();
+    json.Member("benchmark", "soak");
+    json.Key("settings");
+    json.BeginObject();
+    json.Member("inputs", settings.inputs);
+    json.Member("outputs", settings.outputs);
+    json.Key("modes");
+    json.BeginArray();
+    for (const auto mode : settings.modes)
+    {
+        json.Value(mode->name);
+    }
+    json.EndArray();
+    json.Member("cycles", settings.cycles);
+    json.Member("durationSeconds", settings.duration);
+    json.Member("phaseSeconds", settings.phase);
+    json.Member("warmupCycles", settings.warmupCycles);
+    json.Member("windowCycles", settings.window);
+    json.Member("faultRate", faultRate);
+    json.EndObject();
+
+    std::vector<Sample> samples;
+    std::string error;
+    std::string leak;
+    std::int64_t leakGrowth = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    json.Key("samples");
+    json.BeginArray();
+    for (auto cycle = 0;; ++cycle)
+    {
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (settings.duration > 0.0 ? elapsed >= settings.duration : cycle >= settings.cycles)
+            break;
+
+        Sample sample;
+        const auto succeeded = RunCycle(settings, cycle, sample, error);
+        samples.push_back(sample);
+        WriteSample(json, cycle, sample, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
+        std::fprintf(stderr, "Cycle %4d: %6llu frames, %3llu errors, retained heap %8lld B, resident %9lld B, %3d threads, %3d fds\n",
+                     cycle, static_cast<unsigned long long>(sample.frames), static_cast<unsigned long long>(sample.frameErrors),
+                     static_cast<long long>(sample.heapBytes), static_cast<long long>(sample.residentBytes),
+                     sample.threads, sample.fileDescriptors);
+
+        if (!succeeded)
+        {
+            std::fprintf(stderr, "Cycle %d failed: %s\n", cycle, error.c_str());
+            break;
+        }
+
+        // The window starts after the warm-up, and slides once full.
+        const auto judged = static_cast<int>(samples.size()) - settings.warmupCycles;
+        if (judged < settings.window)
+            continue;
+
+        for (const auto& metric : GetMetrics(sample))
+        {
+            leakGrowth = FindGrowth(metric, samples, samples.size() - settings.window);
+            if (leakGrowth > 0)
+            {
+                leak = metric.name;
+                break;
+            }
+        }
+        if (!leak.empty())
+            break;
+    }
+    json.EndArray();
+
+    json.Member("completedCycles", static_cast<int>(samples.size()));
+    json.Member("error", error);
+    json.Member("leak", leak);
+    json.Member("leakGrowth", leakGrowth);
+    json.Member("passed", error.empty() && leak.empty());
+    json.EndObject();
+
+    DeckLinkInputDevice::SetFameErrorCallback(nullptr);
+    s_Inputs.clear();
+    s_Outputs.clear();
+    VirtualDeckLinkDriver::Uninstall();
+
+    if (!leak.empty())
+    {
+        std::fprintf(stderr, "%s grew by %lld over the last %d cycles.\n", leak.c_str(), static_cast<long long>(leakGrowth),
+                     settings.window);
+    }
+
+    const auto output = options.GetString("output", "SoakBenchmark.json");
+    if (!json.Save(output))
+    {
+        std::fprintf(stderr, "Can't write %s.\n", output.c_str());
+        return 1;
+    }
+    return error.empty() && leak.empty() ? 0 : 1;
+}
@@ -1,7 +1,21 @@
-#include "ObjectIDMap.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ObjectSlotMap.h"
 #include "Includes/BlackmagicPluginEvents.h"
+#include "Includes/DeckLinkEventRecorder.h"
 #include "Includes/DeckLinkInputDevice.h"
+#include "Includes/DeckLinkLogger.h"
 #include "Includes/DeckLinkOutputDevice.h"
+#include "Includes/DeckLinkPassthroughRoute.h"
+#include "Includes/DeckLinkProfiler.h"
+#include "Includes/DeckLinkTracer.h"
 #include "external/Unity/IUnityInterface.h"
 #include "external/Unity/IUnityProfiler.h"
 #include "external/Unity/IUnityRenderingExtensions.h"
@@ -12,8 +26,6 @@
 
 namespace
 {
-    static IUnityProfiler* s_UnityProfiler = NULL;
-    static const UnityProfilerMarkerDesc* s_TextureUpdateLockMarker = NULL;
     static MediaBlackmagic::LicenseSecurity s_LicenseSecurity;
     const std::string k_LicenseInvalid = "Your Unity license is not compatible with the Blackmagic Video package.";
 
@@ -33,8 +45,48 @@ namespace
         s_LicenseSecurity.SetRequirementErrorCallback(callback);
     }
 
-    // ID-DeckLinkInputDevice map
-    MediaBlackmagic::ObjectIDMap<MediaBlackmagic::DeckLinkInputDevice> s_InputDeviceMap;
+    // ID-DeckLinkInputDevice map, read from the render thread.
+    MediaBlackmagic::ObjectSlotMap<MediaBlackmagic::DeckLinkInputDevice> s_InputDeviceMap;
+
+    // Stops run by StopDevices which missed their deadline, by device. They are awaited before
+    // the device is destroyed.
+    std::mutex s_PendingStopsMutex;
+    std::unordered_map<void*, std::shared_future<void>> s_PendingStops;
+
+    // Runs the stop on a detached thread: unlike the future of std::async, the returned one
+    // doesn't wait for the stop when it is dropped.
+    std::shared_future<void> StopInBackground(std::function<void()> stop)
+    {
+        auto done = std::make_shared<std::promise<void>>();
+        auto future = done->get_future().share();
+        std::thread([stop, done]
+        {
+            MediaBlackmagic::ProfilerThreadScope thread("Device Stop");
+            stop();
+            done->set_value();
+        }).detach();
+        return future;
+    }
+
+    void WaitPendingStop(void* device)
+    {
+        std::shared_future<void> pending;
+        {
+            std::lock_guard<std::mutex> lock(s_PendingStopsMutex);
+            auto it = s_PendingStops.find(device);
+            if (it == s_PendingStops.end())
+                return;
+            pending = it->second;
+            s_PendingStops.erase(it);
+        }
+        pending.wait();
+    }
+
+    // Start of the texture update being traced on the render thread, 0 if none.
+    std::int64_t s_TextureUpdateTraceBegin = 0;
+
+    // Whether the profiler sample of the texture update was begun on the render thread.
+    bool s_TextureUpdateSampleBegun = false;
 
     // Callback for texture update events
     static void UNITY_INTERFACE_API TextureUpdateCallback(int eventID, void* data)
@@ -46,8 +98,8 @@ namespace
         if (event == kUnityRenderingExtEventUpdateTextureBeginV2)
         {
             auto params = reinterpret_cast<UnityRenderingExtTextureUpdateParamsV2*>(data);
-            auto inputDevice = s_InputDeviceMap[params->userData];
-            if (inputDevice == nullptr)
+            auto inputDevice = s_InputDeviceMap.Acquire(static_cast<int>(params->userData));
+            if (!inputDevice)
                 return;
 
             params->texData = inputDevice->GetTextureData();
@@ -59,21 +111,31 @@ namespace
                 inputDevice->LockQueue();
             }
 
-            if (s_UnityProfiler != NULL)
-            {
-                s_UnityProfiler->BeginSample(s_TextureUpdateLockMarker);
-            }
+            s_TextureUpdateSampleBegun = MediaBlackmagic::DeckLinkProfiler::BeginSample(MediaBlackmagic::EProfilerMarker::TextureUpdateLock);
+
+            s_TextureUpdateTraceBegin = MediaBlackmagic::DeckLinkTracer::IsEnabled() ? MediaBlackmagic::DeckLinkTracer::Now() : 0;
         }
         else if (event == kUnityRenderingExtEventUpdateTextureEndV2)
         {
             auto params = reinterpret_cast<UnityRenderingExtTextureUpdateParamsV2*>(data);
-            auto inputDevice = s_InputDeviceMap[params->userData];
-            if (inputDevice == nullptr)
+            auto inputDevice = s_InputDeviceMap.Acquire(static_cast<int>(params->userData));
+            if (!inputDevice)
                 return;
 
-            if (s_UnityProfiler != NULL)
+            if (s_TextureUpdateSampleBegun)
             {
-                s_UnityProfiler->EndSample(s_TextureUpdateLockMarker);
+                MediaBlackmagic::DeckLinkProfiler::EndSample(MediaBlackmagic::EProfilerMarker::TextureUpdateLock);
+                s_TextureUpdateSampleBegun = false;
+            }
+
+            // The uploaded frame is the one the output frames rendered next are made of.
+            if (s_TextureUpdateTraceBegin != 0)
+            {
+                const auto flow = inputDevice->GetTraceFlow();
+                MediaBlackmagic::DeckLinkTracer::Record(MediaBlackmagic::ETraceSpan::TextureUpdate, inputDevice->GetIndex(), flow,
+                                                        s_TextureUpdateTraceBegin, MediaBlackmagic::DeckLinkTracer::Now());
+                MediaBlackmagic::DeckLinkTracer::SetCurrentFlow(flow);
+                s_TextureUpdateTraceBegin = 0;
             }
 
             const auto graphicsAPI = inputDevice->GetGraphicsAPI();
@@ -91,14 +153,10 @@ namespace
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
 {
+    MediaBlackmagic::InitLog();
     MediaBlackmagic::WriteFileDebug("Load plugin\n", false);
 
-    s_UnityProfiler = unityInterfaces->Get<IUnityProfiler>();
-
-    if (s_UnityProfiler != NULL)
-    {
-        s_UnityProfiler->CreateMarker(&s_TextureUpdateLockMarker, "TextureUpdateLock", kUnityProfilerCategoryOther, kUnityProfilerMarkerFlagDefault, 0);
-    }
+    MediaBlackmagic::DeckLinkProfiler::Initialize(unityInterfaces->Get<IUnityProfiler>());
 
     MediaBlackmagic::OnPluginLoadGraphics(unityInterfaces);
 }
@@ -107,9 +165,11 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
     MediaBlackmagic::WriteFileDebug("Unload plugin\n");
 
-    s_UnityProfiler = NULL;
+    MediaBlackmagic::DeckLinkProfiler::Shutdown();
 
     MediaBlackmagic::OnPluginUnloadGraphics();
+
+    MediaBlackmagic::DeckLinkLogger::Shutdown();
 }
 
 extern "C" UnityRenderingEventAndData UNITY_INTERFACE_EXPORT GetTextureUpdateCallback()
@@ -117,6 +177,194 @@ extern "C" UnityRenderingEventAndData UNITY_INTERFACE_EXPORT GetTextureUpdateCal
     return TextureUpdateCallback;
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT GetDeviceStatusSnapshot(MediaBlackmagic::DeviceStatus* statuses, int capacity)
+{
+    return MediaBlackmagic::DeckLinkDeviceStatus::Snapshot(statuses, capacity);
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetDeviceMetricsSnapshot(MediaBlackmagic::MetricSummary* summaries, int capacity)
+{
+    return MediaBlackmagic::DeckLinkDeviceMetrics::Snapshot(summaries, capacity);
+}
+
+// Copies the text report of the metrics into 'buffer', truncated and null-terminated, and returns
+// the size the whole report requires, including the null terminator.
+extern "C" int UNITY_INTERFACE_EXPORT GetDeviceMetricsReport(char* buffer, int capacity)
+{
+    const auto report = MediaBlackmagic::DeckLinkDeviceMetrics::Report();
+
+    if (buffer != nullptr && capacity > 0)
+    {
+        const auto length = std::min(static_cast<int>(report.size()), capacity - 1);
+        std::copy_n(report.data(), length, buffer);
+        buffer[length] = '\0';
+    }
+
+    return static_cast<int>(report.size()) + 1;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT ResetDeviceMetrics()
+{
+    MediaBlackmagic::DeckLinkDeviceMetrics::ResetAll();
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT EnableDeckLinkTracing(int capacity)
+{
+    return MediaBlackmagic::DeckLinkTracer::Enable(capacity);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT DisableDeckLinkTracing()
+{
+    MediaBlackmagic::DeckLinkTracer::Disable();
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT IsDeckLinkTracingEnabled()
+{
+    return MediaBlackmagic::DeckLinkTracer::IsEnabled();
+}
+
+// Writes the recorded spans as a Chrome JSON trace. Returns the number of spans written, or -1.
+extern "C" int UNITY_INTERFACE_EXPORT WriteDeckLinkTrace(const char* path)
+{
+    if (path == nullptr)
+        return -1;
+
+    return MediaBlackmagic::DeckLinkTracer::Write(path);
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetDeckLinkTraceTimestamp()
+{
+    return MediaBlackmagic::DeckLinkTracer::Now();
+}
+
+extern "C" std::uint64_t UNITY_INTERFACE_EXPORT GetDeckLinkTraceCurrentFlow()
+{
+    return MediaBlackmagic::DeckLinkTracer::GetCurrentFlow();
+}
+
+// Records a span measured by the managed code, with timestamps from GetDeckLinkTraceTimestamp.
+extern "C" void UNITY_INTERFACE_EXPORT RecordDeckLinkTraceSpan(int span, int deviceIndex, std::uint64_t flow, std::int64_t begin, std::int64_t end)
+{
+    if (span < 0 || span >= static_cast<int>(MediaBlackmagic::ETraceSpan::Count))
+        return;
+
+    MediaBlackmagic::DeckLinkTracer::Record(static_cast<MediaBlackmagic::ETraceSpan>(span), deviceIndex, flow, begin, end);
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT EnableDeckLinkEventRecording(int capacity)
+{
+    return MediaBlackmagic::DeckLinkEventRecorder::Enable(capacity);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT DisableDeckLinkEventRecording()
+{
+    MediaBlackmagic::DeckLinkEventRecorder::Disable();
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT IsDeckLinkEventRecordingEnabled()
+{
+    return MediaBlackmagic::DeckLinkEventRecorder::IsEnabled();
+}
+
+// Writes the recorded driver callbacks as a binary recording. Returns the number of events written, or -1.
+extern "C" int UNITY_INTERFACE_EXPORT WriteDeckLinkEventRecording(const char* path)
+{
+    if (path == nullptr)
+        return -1;
+
+    return MediaBlackmagic::DeckLinkEventRecorder::Write(path);
+}
+
+// Sets the log file, the minimum ELogSeverity and the size after which the file is rotated. A null
+// path keeps the current file.
+extern "C" void UNITY_INTERFACE_EXPORT ConfigureDeckLinkLog(const char* path, int severity, std::int64_t maxFileBytes)
+{
+    if (severity < 0 || severity > static_cast<int>(MediaBlackmagic::ELogSeverity::Off))
+        return;
+
+    MediaBlackmagic::DeckLinkLogger::Configure(path, static_cast<MediaBlackmagic::ELogSeverity>(severity), maxFileBytes);
+}
+
+extern "C" std::uint64_t UNITY_INTERFACE_EXPORT GetDeckLinkLogDroppedMessages()
+{
+    return MediaBlackmagic::DeckLinkLogger::CountDropped();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT SetDeckLinkStatusPollingInterval(int intervalMs)
+{
+    MediaBlackmagic::DeckLinkStatusPoller::SetPollingInterval(intervalMs);
+}
+
+// Stops many devices at once. The output playbacks are stopped together and awaited against a
+// single deadline, then every device releases its resources on its own thread. The stops which
+// miss the deadline are left running; destroying the device waits for them. The devices still
+// have to be destroyed afterwards. Returns the number of devices which missed the deadline;
+// 'missed', if not null, receives one flag per device, the input devices first.
+extern "C" int UNITY_INTERFACE_EXPORT StopDevices(void** inputDevices, int inputCount, void** outputDevices, int outputCount, int timeoutMs, bool* missed)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+
+    inputCount = (inputDevices != nullptr) ? std::max(inputCount, 0) : 0;
+    outputCount = (outputDevices != nullptr) ? std::max(outputCount, 0) : 0;
+
+    std::vector<bool> playbackStopped(outputCount, true);
+    std::vector<std::shared_future<void>> stops(inputCount + outputCount);
+
+    // Request the end of every playback first: the driver stops them concurrently.
+    for (auto i = 0; i < outputCount; ++i)
+    {
+        if (outputDevices[i] != nullptr)
+            reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevices[i])->BeginStop();
+    }
+
+    for (auto i = 0; i < inputCount; ++i)
+    {
+        if (inputDevices[i] == nullptr)
+            continue;
+
+        auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevices[i]);
+        stops[i] = StopInBackground([instance]
+        {
+            instance->GetReadiness().Join();
+            s_InputDeviceMap.Remove(instance);
+            instance->Stop();
+        });
+    }
+
+    for (auto i = 0; i < outputCount; ++i)
+    {
+        if (outputDevices[i] == nullptr)
+            continue;
+
+        auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevices[i]);
+        playbackStopped[i] = instance->WaitStopped(deadline);
+        stops[inputCount + i] = StopInBackground([instance, deadline]
+        {
+            instance->Stop(deadline);
+        });
+    }
+
+    auto missedCount = 0;
+    for (auto i = 0; i < inputCount + outputCount; ++i)
+    {
+        auto late = (i >= inputCount && !playbackStopped[i - inputCount]);
+        if (stops[i].valid() && stops[i].wait_until(deadline) == std::future_status::timeout)
+        {
+            late = true;
+
+            std::lock_guard<std::mutex> lock(s_PendingStopsMutex);
+            s_PendingStops[i < inputCount ? inputDevices[i] : outputDevices[i - inputCount]] = stops[i];
+        }
+
+        if (late)
+            ++missedCount;
+        if (missed != nullptr)
+            missed[i] = late;
+    }
+
+    return missedCount;
+}
+
 #pragma endregion
 
 #pragma region Input Device plugin functions
@@ -136,17 +384,96 @@ extern "C" void UNITY_INTERFACE_EXPORT SetFrameArrivedCallback(MediaBlackmagic::
     MediaBlackmagic::DeckLinkInputDevice::SetFrameArrivedCallback(callback);
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT * CreateInputDevice(int deviceIndex, int deviceSelected, int format, int pixelFormat, bool enablePassThrough, int graphicsAPI, MediaBlackmagic::DeckLinkInputDevice::InputVideoFormatData* selectedFormat)
+// Opens the device through its readiness, on a worker thread if 'inBackground'. The device is
+// only added to the ID map once it started, so the render thread never reaches a device which
+// is still opening.
+static MediaBlackmagic::DeckLinkInputDevice* OpenInputDevice(bool inBackground, int deviceIndex, int deviceSelected, int format, int pixelFormat, bool enablePassThrough, int graphicsAPI, MediaBlackmagic::DeckLinkInputDevice::InputVideoFormatData* selectedFormat)
 {
     const auto instance = new MediaBlackmagic::DeckLinkInputDevice();
-    s_InputDeviceMap.Add(instance);
 
     auto graphicsAPIEnum = static_cast<UnityGfxRenderer>(graphicsAPI);
-    instance->Start(deviceIndex, deviceSelected, format, pixelFormat, enablePassThrough, graphicsAPIEnum, selectedFormat);
+    auto open = [=](std::string& error)
+    {
+        MediaBlackmagic::ProfilerSample sample(MediaBlackmagic::EProfilerMarker::OpenDevice, deviceIndex);
+        if (!instance->Start(deviceIndex, deviceSelected, format, pixelFormat, enablePassThrough, graphicsAPIEnum, selectedFormat))
+        {
+            error = instance->GetErrorString();
+            return false;
+        }
+        if (s_InputDeviceMap.Add(instance) == 0)
+        {
+            error = "Too many input devices.";
+            return false;
+        }
+        return true;
+    };
+
+    if (inBackground)
+        instance->GetReadiness().OpenInBackground(open);
+    else
+        instance->GetReadiness().Open(open);
+
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateInputDevice(int deviceIndex, int deviceSelected, int format, int pixelFormat, bool enablePassThrough, int graphicsAPI, MediaBlackmagic::DeckLinkInputDevice::InputVideoFormatData* selectedFormat)
+{
+    return OpenInputDevice(false, deviceIndex, deviceSelected, format, pixelFormat, enablePassThrough, graphicsAPI, selectedFormat);
+}
+
+// Returns immediately; the selected format is retrieved with GetInputDeviceSelectedFormat once the device is ready.
+extern "C" void UNITY_INTERFACE_EXPORT * CreateInputDeviceDeferred(int deviceIndex, int deviceSelected, int format, int pixelFormat, bool enablePassThrough, int graphicsAPI)
+{
+    return OpenInputDevice(true, deviceIndex, deviceSelected, format, pixelFormat, enablePassThrough, graphicsAPI, nullptr);
+}
 
+// The device, or null while it is still opening or if it failed to open.
+static MediaBlackmagic::DeckLinkInputDevice* GetReadyInputDevice(void* inputDevice)
+{
+    if (inputDevice == nullptr)
+        return nullptr;
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    if (instance->GetReadiness().GetState() != MediaBlackmagic::EDeviceReadiness::Ready)
+        return nullptr;
     return instance;
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT GetInputDeviceReadiness(void* inputDevice)
+{
+    if (inputDevice == nullptr)
+        return static_cast<int>(MediaBlackmagic::EDeviceReadiness::Failed);
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    return static_cast<int>(instance->GetReadiness().GetState());
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT WaitInputDeviceReady(void* inputDevice, int timeoutMs)
+{
+    if (inputDevice == nullptr)
+        return static_cast<int>(MediaBlackmagic::EDeviceReadiness::Failed);
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    return static_cast<int>(instance->GetReadiness().Wait(timeoutMs));
+}
+
+extern "C" const char UNITY_INTERFACE_EXPORT * GetInputDeviceOpenError(void* inputDevice)
+{
+    if (inputDevice == nullptr)
+        return "";
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    return instance->GetReadiness().GetError();
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT GetInputDeviceSelectedFormat(void* inputDevice, MediaBlackmagic::DeckLinkInputDevice::InputVideoFormatData* selectedFormat)
+{
+    if (inputDevice == nullptr || selectedFormat == nullptr)
+        return false;
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    if (instance->GetReadiness().GetState() != MediaBlackmagic::EDeviceReadiness::Ready)
+        return false;
+
+    instance->GetSelectedFormat(selectedFormat);
+    return true;
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT DestroyInputDevice(void* inputDevice)
 {
     if (inputDevice == nullptr)
@@ -155,6 +482,9 @@ extern "C" void UNITY_INTERFACE_EXPORT DestroyInputDevice(void* inputDevice)
     if (instance == nullptr)
         return;
 
+    // Once the opening is over, so the device isn't added to the map after it was removed.
+    WaitPendingStop(inputDevice);
+    instance->GetReadiness().Join();
     s_InputDeviceMap.Remove(instance);
     instance->Stop();
     instance->Release();
@@ -162,9 +492,7 @@ extern "C" void UNITY_INTERFACE_EXPORT DestroyInputDevice(void* inputDevice)
 
 extern "C" bool UNITY_INTERFACE_EXPORT IsInputDeviceInitialized(void* inputDevice)
 {
-    if (inputDevice == nullptr)
-        return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    const auto instance = GetReadyInputDevice(inputDevice);
     if (instance == nullptr)
         return false;
     return instance->IsInitialized();
@@ -172,9 +500,7 @@ extern "C" bool UNITY_INTERFACE_EXPORT IsInputDeviceInitialized(void* inputDevic
 
 extern "C" void UNITY_INTERFACE_EXPORT SetTextureUpdateSource(void* inputDevice, uint8_t* textureData)
 {
-    if (inputDevice == nullptr)
-        return;
-    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    const auto instance = GetReadyInputDevice(inputDevice);
     if (instance == nullptr)
         return;
 
@@ -183,9 +509,7 @@ extern "C" void UNITY_INTERFACE_EXPORT SetTextureUpdateSource(void* inputDevice,
 
 extern "C" void UNITY_INTERFACE_EXPORT LockInputDeviceQueue(void* inputDevice)
 {
-    if (inputDevice == nullptr)
-        return;
-    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    const auto instance = GetReadyInputDevice(inputDevice);
     if (instance == nullptr)
         return;
 
@@ -194,9 +518,7 @@ extern "C" void UNITY_INTERFACE_EXPORT LockInputDeviceQueue(void* inputDevice)
 
 extern "C" void UNITY_INTERFACE_EXPORT UnlockInputDeviceQueue(void* inputDevice)
 {
-    if (inputDevice == nullptr)
-        return;
-    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    const auto instance = GetReadyInputDevice(inputDevice);
     if (instance == nullptr)
         return;
     
@@ -216,20 +538,58 @@ extern "C" unsigned int UNITY_INTERFACE_EXPORT GetInputDeviceID(void* inputDevic
 
 extern "C" bool UNITY_INTERFACE_EXPORT GetHasInputSource(void* inputDevice)
 {
-    if (inputDevice == nullptr)
-        return false;
-    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    const auto instance = GetReadyInputDevice(inputDevice);
     if (instance == nullptr)
         return false;
 
     return instance->GetHasInputSource();
 }
 
+extern "C" const void UNITY_INTERFACE_EXPORT * GetInputDeviceStatusBlock(void* inputDevice)
+{
+    if (inputDevice == nullptr)
+        return nullptr;
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkInputDevice*>(inputDevice);
+    return instance->GetStatus().GetBlock();
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT GetInputDeviceHealth(void* inputDevice, MediaBlackmagic::DeckLinkHealth* health)
+{
+    const auto instance = GetReadyInputDevice(inputDevice);
+    if (instance == nullptr || health == nullptr)
+        return false;
+    const auto poller = instance->GetStatusPoller();
+    if (poller == nullptr)
+        return false;
+    *health = poller->GetHealth();
+    return true;
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetInputDeviceHealthHistory(void* inputDevice, MediaBlackmagic::DeckLinkHealthEvent* events, int capacity)
+{
+    const auto instance = GetReadyInputDevice(inputDevice);
+    if (instance == nullptr || events == nullptr)
+        return 0;
+    const auto poller = instance->GetStatusPoller();
+    return poller != nullptr ? poller->CopyHistory(events, capacity) : 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetInputDeviceFormatChangeStatistics(void* inputDevice, MediaBlackmagic::InputFormatChangeStatistics* statistics)
+{
+    const auto instance = GetReadyInputDevice(inputDevice);
+    if (instance == nullptr || statistics == nullptr)
+        return;
+    instance->GetFormatChangeStatistics(statistics);
+}
+
 #pragma endregion
 
 #pragma region Output Device plugin functions
 
-extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncOutputDevice(int deviceIndex,
+// Opens the device through its readiness, on a worker thread if 'inBackground'.
+static MediaBlackmagic::DeckLinkOutputDevice* CreateOutputDevice(bool asyncMode,
+                                                                 bool inBackground,
+                                                                 int deviceIndex,
                                                                  int deviceSelected,
                                                                  int displayMode,
                                                                  int pixelFormat,
@@ -241,12 +601,42 @@ extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncOutputDevice(int deviceIndex
                                                                  int audioSampleRate,
                                                                  bool useGPUDirect)
 {
-    auto instance = new MediaBlackmagic::DeckLinkOutputDevice();
-    auto mode = static_cast<BMDDisplayMode>(displayMode);
-    instance->StartAsyncMode(deviceIndex, deviceSelected, mode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+    const auto instance = new MediaBlackmagic::DeckLinkOutputDevice();
+    const auto mode = static_cast<BMDDisplayMode>(displayMode);
+    auto open = [=](std::string& error)
+    {
+        MediaBlackmagic::ProfilerSample sample(MediaBlackmagic::EProfilerMarker::OpenDevice, deviceIndex);
+        const auto started = asyncMode
+            ? instance->StartAsyncMode(deviceIndex, deviceSelected, mode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect)
+            : instance->StartManualMode(deviceIndex, deviceSelected, mode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+        if (!started)
+            error = instance->GetErrorString();
+        return started;
+    };
+
+    if (inBackground)
+        instance->GetReadiness().OpenInBackground(open);
+    else
+        instance->GetReadiness().Open(open);
+
     return instance;
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncOutputDevice(int deviceIndex,
+                                                                 int deviceSelected,
+                                                                 int displayMode,
+                                                                 int pixelFormat,
+                                                                 int colorSpace,
+                                                                 int transferFunction,
+                                                                 int preroll,
+                                                                 bool enableAudio,
+                                                                 int audioChannelCount,
+                                                                 int audioSampleRate,
+                                                                 bool useGPUDirect)
+{
+    return CreateOutputDevice(true, false, deviceIndex, deviceSelected, displayMode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT * CreateManualOutputDevice(int deviceIndex,
                                                                   int deviceSelected,
                                                                   int displayMode,
@@ -259,12 +649,74 @@ extern "C" void UNITY_INTERFACE_EXPORT * CreateManualOutputDevice(int deviceInde
                                                                   int audioSampleRate,
                                                                   bool useGPUDirect)
 {
-    auto instance = new MediaBlackmagic::DeckLinkOutputDevice();
-    auto mode = static_cast<BMDDisplayMode>(displayMode);
-    instance->StartManualMode(deviceIndex, deviceSelected, mode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+    return CreateOutputDevice(false, false, deviceIndex, deviceSelected, displayMode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncOutputDeviceDeferred(int deviceIndex,
+                                                                         int deviceSelected,
+                                                                         int displayMode,
+                                                                         int pixelFormat,
+                                                                         int colorSpace,
+                                                                         int transferFunction,
+                                                                         int preroll,
+                                                                         bool enableAudio,
+                                                                         int audioChannelCount,
+                                                                         int audioSampleRate,
+                                                                         bool useGPUDirect)
+{
+    return CreateOutputDevice(true, true, deviceIndex, deviceSelected, displayMode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateManualOutputDeviceDeferred(int deviceIndex,
+                                                                          int deviceSelected,
+                                                                          int displayMode,
+                                                                          int pixelFormat,
+                                                                          int colorSpace,
+                                                                          int transferFunction,
+                                                                          int preroll,
+                                                                          bool enableAudio,
+                                                                          int audioChannelCount,
+                                                                          int audioSampleRate,
+                                                                          bool useGPUDirect)
+{
+    return CreateOutputDevice(false, true, deviceIndex, deviceSelected, displayMode, pixelFormat, colorSpace, transferFunction, preroll, enableAudio, audioChannelCount, audioSampleRate, useGPUDirect);
+}
+
+// The device, or null while it is still opening or if it failed to open.
+static MediaBlackmagic::DeckLinkOutputDevice* GetReadyOutputDevice(void* outputDevice)
+{
+    if (outputDevice == nullptr)
+        return nullptr;
+    const auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    if (instance->GetReadiness().GetState() != MediaBlackmagic::EDeviceReadiness::Ready)
+        return nullptr;
     return instance;
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT GetOutputDeviceReadiness(void* outputDevice)
+{
+    if (outputDevice == nullptr)
+        return static_cast<int>(MediaBlackmagic::EDeviceReadiness::Failed);
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    return static_cast<int>(instance->GetReadiness().GetState());
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT WaitOutputDeviceReady(void* outputDevice, int timeoutMs)
+{
+    if (outputDevice == nullptr)
+        return static_cast<int>(MediaBlackmagic::EDeviceReadiness::Failed);
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    return static_cast<int>(instance->GetReadiness().Wait(timeoutMs));
+}
+
+extern "C" const char UNITY_INTERFACE_EXPORT * GetOutputDeviceOpenError(void* outputDevice)
+{
+    if (outputDevice == nullptr)
+        return "";
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    return instance->GetReadiness().GetError();
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT DestroyOutputDevice(void* outputDevice)
 {
     if (outputDevice == nullptr)
@@ -272,15 +724,14 @@ extern "C" void UNITY_INTERFACE_EXPORT DestroyOutputDevice(void* outputDevice)
     auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     if (instance == nullptr)
         return;
+    WaitPendingStop(outputDevice);
     instance->Stop();
     instance->Release();
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT IsOutputDeviceInitialized(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return false;
     return instance->IsInitialized();
@@ -288,9 +739,7 @@ extern "C" bool UNITY_INTERFACE_EXPORT IsOutputDeviceInitialized(void* outputDev
 
 extern "C" int UNITY_INTERFACE_EXPORT GetOutputDeviceFrameWidth(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return 0;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return std::get<0>(instance->GetFrameDimensions());
@@ -298,9 +747,7 @@ extern "C" int UNITY_INTERFACE_EXPORT GetOutputDeviceFrameWidth(void* outputDevi
 
 extern "C" int UNITY_INTERFACE_EXPORT GetOutputDeviceFrameHeight(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return 0;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return std::get<1>(instance->GetFrameDimensions());
@@ -308,9 +755,7 @@ extern "C" int UNITY_INTERFACE_EXPORT GetOutputDeviceFrameHeight(void* outputDev
 
 extern "C" void UNITY_INTERFACE_EXPORT GetOutputDeviceFrameRate(void* outputDevice, std::int32_t* numerator, std::int32_t* denominator)
 {
-    if (outputDevice == nullptr)
-        return;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return;
     return instance->GetFrameRate(*numerator, *denominator);
@@ -318,20 +763,16 @@ extern "C" void UNITY_INTERFACE_EXPORT GetOutputDeviceFrameRate(void* outputDevi
 
 extern "C" void UNITY_INTERFACE_EXPORT * GetOutputDevicePixelFormat(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return nullptr;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return nullptr;
 
-    return const_cast<char*>(instance->RetrievePixelFormat().c_str());
+    return const_cast<char*>(instance->RetrievePixelFormat());
 }
 
 extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetOutputDeviceFrameDuration(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return 0;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return instance->GetFrameDuration();
@@ -339,9 +780,7 @@ extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetOutputDeviceFrameDuration(void
 
 extern "C" int UNITY_INTERFACE_EXPORT IsOutputDeviceProgressive(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return 0;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return instance->IsProgressive() ? 1 : 0;
@@ -350,9 +789,7 @@ extern "C" int UNITY_INTERFACE_EXPORT IsOutputDeviceProgressive(void* outputDevi
 extern "C" void UNITY_INTERFACE_EXPORT GetOutputDeviceBackingFrameByteDimensions(void* outputDevice, std::uint32_t & w, std::uint32_t & h, std::uint32_t & d)
 {
     w = h = d = 0;
-    if (outputDevice == nullptr)
-        return;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return;
     w = instance->GetBackingFrameByteWidth();
@@ -362,9 +799,7 @@ extern "C" void UNITY_INTERFACE_EXPORT GetOutputDeviceBackingFrameByteDimensions
 
 extern "C" int UNITY_INTERFACE_EXPORT IsOutputDeviceReferenceLocked(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return 0;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return instance->IsReferenceLocked() ? 1 : 0;
@@ -372,9 +807,7 @@ extern "C" int UNITY_INTERFACE_EXPORT IsOutputDeviceReferenceLocked(void* output
 
 extern "C" void UNITY_INTERFACE_EXPORT FeedFrameToOutputDevice(void* outputDevice, void* frameData, unsigned int timecode)
 {
-    if (outputDevice == nullptr)
-        return;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return;
     instance->FeedFrame(frameData, timecode);
@@ -382,19 +815,79 @@ extern "C" void UNITY_INTERFACE_EXPORT FeedFrameToOutputDevice(void* outputDevic
 
 extern "C" void UNITY_INTERFACE_EXPORT WaitOutputDeviceCompletion(void* outputDevice, std::int64_t frameNumber)
 {
-    if (outputDevice == nullptr)
-        return;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return;
     instance->WaitFrameCompletion(frameNumber);
 }
 
-extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountDroppedOutputDeviceFrames(void* outputDevice)
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetOutputDeviceCompletedFrames(void* outputDevice)
 {
     if (outputDevice == nullptr)
         return 0;
     auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    return instance->GetCompletionEvent().GetCompletedFrames();
+}
+
+extern "C" const void UNITY_INTERFACE_EXPORT * GetOutputDeviceStatusBlock(void* outputDevice)
+{
+    if (outputDevice == nullptr)
+        return nullptr;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    return instance->GetStatus().GetBlock();
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT GetOutputDeviceHealth(void* outputDevice, MediaBlackmagic::DeckLinkHealth* health)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr || health == nullptr)
+        return false;
+    const auto poller = instance->GetStatusPoller();
+    if (poller == nullptr)
+        return false;
+    *health = poller->GetHealth();
+    return true;
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetOutputDeviceHealthHistory(void* outputDevice, MediaBlackmagic::DeckLinkHealthEvent* events, int capacity)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr || events == nullptr)
+        return 0;
+    const auto poller = instance->GetStatusPoller();
+    return poller != nullptr ? poller->CopyHistory(events, capacity) : 0;
+}
+
+static std::vector<const MediaBlackmagic::DeckLinkCompletionEvent*> GetCompletionEvents(void** outputDevices, int count)
+{
+    std::vector<const MediaBlackmagic::DeckLinkCompletionEvent*> events(count, nullptr);
+    for (auto i = 0; i < count; ++i)
+    {
+        if (outputDevices[i] != nullptr)
+            events[i] = &reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevices[i])->GetCompletionEvent();
+    }
+    return events;
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT WaitAnyOutputCompletion(void** outputDevices, const std::int64_t* frameNumbers, int count, int timeoutMs)
+{
+    if (outputDevices == nullptr || frameNumbers == nullptr || count <= 0)
+        return -1;
+    const auto events = GetCompletionEvents(outputDevices, count);
+    return MediaBlackmagic::DeckLinkCompletionEvent::WaitAny(events.data(), frameNumbers, count, timeoutMs);
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT WaitAllOutputCompletion(void** outputDevices, const std::int64_t* frameNumbers, int count, int timeoutMs)
+{
+    if (outputDevices == nullptr || frameNumbers == nullptr || count <= 0)
+        return false;
+    const auto events = GetCompletionEvents(outputDevices, count);
+    return MediaBlackmagic::DeckLinkCompletionEvent::WaitAll(events.data(), frameNumbers, count, timeoutMs);
+}
+
+extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountDroppedOutputDeviceFrames(void* outputDevice)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return instance->CountDroppedFrames();
@@ -402,9 +895,7 @@ extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountDroppedOutputDeviceFra
 
 extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountLateOutputDeviceFrames(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return 0;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return 0;
     return instance->CountLateFrames();
@@ -413,23 +904,23 @@ extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountLateOutputDeviceFrames
 extern "C" void UNITY_INTERFACE_EXPORT
 FeedAudioSampleFramesToOutputDevice(MediaBlackmagic::DeckLinkOutputDevice * outputDevice, float* sampleFrames, int sampleCount)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return;
 
-    outputDevice->FeedAudioSampleFrames(sampleFrames, sampleCount);
+    instance->FeedAudioSampleFrames(sampleFrames, sampleCount);
 }
 
 extern "C" const void UNITY_INTERFACE_EXPORT * GetOutputDeviceError(void* outputDevice)
 {
-    if (outputDevice == nullptr)
-        return nullptr;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    const auto instance = GetReadyOutputDevice(outputDevice);
     if (instance == nullptr)
         return nullptr;
     const auto& error = instance->GetErrorString();
     return error.empty() ? nullptr : error.c_str();
 }
 
+// The callbacks may be set while the device opens, so they are called from the start.
 extern "C" void UNITY_INTERFACE_EXPORT SetFrameErrorCallback(void* outputDevice,
     MediaBlackmagic::DeckLinkOutputDevice::FrameError callback)
 {
@@ -450,66 +941,225 @@ extern "C" void UNITY_INTERFACE_EXPORT SetFrameCompletedCallback(void* outputDev
 
 extern "C" bool UNITY_INTERFACE_EXPORT IsValidConfiguration(void* outputDevice)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->IsValidConfiguration();
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT IsOutputKeyingCompatible(void* outputDevice, int keying)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->SupportsKeying(static_cast<MediaBlackmagic::EOutputKeyingMode>(keying));
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT InitializeOutputKeyerParameters(void* outputDevice, int keying)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->InitializeKeyerParameters(static_cast<MediaBlackmagic::EOutputKeyingMode>(keying));
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT ChangeKeyingMode(void* outputDevice, int keying)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->ChangeKeyingMode(static_cast<MediaBlackmagic::EOutputKeyingMode>(keying));
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT DisableKeying(void* outputDevice)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->DisableKeying();
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT SetDefaultScheduleTime(void* outputDevice, float defaultTime)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     instance->SetDefaultScheduleTime(defaultTime);
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT IsOutputLinkCompatible(void* outputDevice, int mode)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->IsSupportedLinkMode(static_cast<MediaBlackmagic::EOutputLinkMode>(mode));
 }
 
 extern "C" bool UNITY_INTERFACE_EXPORT SetOutputLinkMode(void* outputDevice, int mode)
 {
-    if (outputDevice == nullptr)
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
         return false;
-    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
     return instance->SetLinkConfiguration(static_cast<MediaBlackmagic::EOutputLinkMode>(mode));
 }
 
+extern "C" bool UNITY_INTERFACE_EXPORT ReconfigureOutputDevice(void* outputDevice, int mode, int pixelFormat, int colorSpace, int transferFunction, int keying, int linkMode)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
+        return false;
+    return instance->Reconfigure(
+        static_cast<BMDDisplayMode>(mode),
+        pixelFormat,
+        colorSpace,
+        transferFunction,
+        static_cast<MediaBlackmagic::EOutputKeyingMode>(keying),
+        static_cast<MediaBlackmagic::EOutputLinkMode>(linkMode));
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT EnableOutputDeviceAsyncSubmission(void* outputDevice, int capacity, int policy)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
+        return false;
+    return instance->EnableAsyncSubmission(capacity, static_cast<MediaBlackmagic::ESubmissionBackpressure>(policy));
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT DisableOutputDeviceAsyncSubmission(void* outputDevice)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
+        return;
+    instance->DisableAsyncSubmission();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT SetOutputDeviceTraceFlow(void* outputDevice, std::uint64_t flow)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr)
+        return;
+    instance->SetFeedTraceFlow(flow);
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT SubmitFrameToOutputDevice(void* outputDevice, void* frameData, unsigned int timecode)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr || frameData == nullptr)
+        return false;
+    return instance->SubmitFrame(frameData, timecode);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT SetFrameReleasedCallback(void* outputDevice,
+    MediaBlackmagic::DeckLinkOutputSubmissionQueue::FrameReleased callback)
+{
+    if (outputDevice == nullptr || callback == nullptr)
+        return;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkOutputDevice*>(outputDevice);
+    instance->SetFrameReleasedCallback(callback);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetOutputDeviceSubmissionStatistics(void* outputDevice, MediaBlackmagic::OutputSubmissionStatistics* statistics)
+{
+    const auto instance = GetReadyOutputDevice(outputDevice);
+    if (instance == nullptr || statistics == nullptr)
+        return;
+    *statistics = instance->GetSubmissionStatistics();
+}
+
+#pragma endregion
+
+#pragma region Passthrough Route plugin functions
+
+// The route errors are returned by copy, valid until the next route call of the same thread.
+static thread_local std::string t_PassthroughRouteError;
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreatePassthroughRoute(void* inputDevice,
+                                                                void* outputDevice,
+                                                                int delayFrames,
+                                                                int compositing,
+                                                                bool synchronize)
+{
+    t_PassthroughRouteError.clear();
+
+    auto input = GetReadyInputDevice(inputDevice);
+    auto output = GetReadyOutputDevice(outputDevice);
+    if (input == nullptr || output == nullptr)
+    {
+        t_PassthroughRouteError = "The input and output devices are not ready.";
+        return nullptr;
+    }
+
+    auto instance = new MediaBlackmagic::DeckLinkPassthroughRoute(input, output);
+    if (!instance->Start(delayFrames, static_cast<MediaBlackmagic::EPassthroughCompositing>(compositing), synchronize))
+    {
+        t_PassthroughRouteError = instance->GetErrorString();
+        delete instance;
+        return nullptr;
+    }
+    return instance;
+}
+
+// The error of the last CreatePassthroughRoute call of this thread which returned null.
+extern "C" const void UNITY_INTERFACE_EXPORT * GetPassthroughRouteCreateError()
+{
+    return t_PassthroughRouteError.empty() ? nullptr : t_PassthroughRouteError.c_str();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT DestroyPassthroughRoute(void* route)
+{
+    if (route == nullptr)
+        return;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    delete instance;
+}
+
+extern "C" bool UNITY_INTERFACE_EXPORT SetPassthroughRouteDelay(void* route, int delayFrames)
+{
+    if (route == nullptr)
+        return false;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    return instance->SetDelay(delayFrames);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT SetPassthroughRouteCompositing(void* route, int compositing)
+{
+    if (route == nullptr)
+        return;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    instance->SetCompositing(static_cast<MediaBlackmagic::EPassthroughCompositing>(compositing));
+}
+
+extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountRoutedPassthroughFrames(void* route)
+{
+    if (route == nullptr)
+        return 0;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    return instance->CountRoutedFrames();
+}
+
+extern "C" const unsigned int UNITY_INTERFACE_EXPORT CountSkippedPassthroughFrames(void* route)
+{
+    if (route == nullptr)
+        return 0;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    return instance->CountSkippedFrames();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetPassthroughRouteSynchronizerStatistics(void* route, MediaBlackmagic::FrameSynchronizerStatistics* statistics)
+{
+    if (route == nullptr || statistics == nullptr)
+        return;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    *statistics = instance->GetSynchronizerStatistics();
+}
+
+extern "C" const void UNITY_INTERFACE_EXPORT * GetPassthroughRouteError(void* route)
+{
+    if (route == nullptr)
+        return nullptr;
+    auto instance = reinterpret_cast<MediaBlackmagic::DeckLinkPassthroughRoute*>(route);
+    t_PassthroughRouteError = instance->GetErrorString();
+    return t_PassthroughRouteError.empty() ? nullptr : t_PassthroughRouteError.c_str();
+}
+
 #pragma endregion
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Common.h"
+
+namespace MediaBlackmagic
+{
+    enum class ECapabilityKeying
+    {
+        Internal = 1 << 0,
+        External = 1 << 1
+    };
+
+    enum class ECapabilityLink
+    {
+        DualLink = 1 << 0,
+        QuadLink = 1 << 1
+    };
+
+    struct ModeCapabilities
+    {
+        BMDDisplayMode  displayMode;
+        std::int32_t    width;
+        std::int32_t    height;
+        std::int32_t    fieldDominance;         // BMDFieldDominance
+        std::int64_t    frameDuration;
+        std::int64_t    timeScale;
+        std::uint32_t   pixelFormats;           // One bit per entry of kPixelFormatMappings.
+        std::uint32_t   keyingPixelFormats;     // Same, with keying enabled. Outputs only.
+    };
+
+    struct DeviceCapabilities
+    {
+        IDeckLink*                      device;
+        std::string                     name;
+        std::int64_t                    persistentId;
+        std::int64_t                    groupId;            // Shared by the devices of a card.
+        std::int32_t                    duplex;             // BMDDuplexMode
+        std::int32_t                    videoIOSupport;     // BMDVideoIOSupport
+        std::int32_t                    keying;             // ECapabilityKeying flags
+        std::int32_t                    links;              // ECapabilityLink flags
+        std::int32_t                    inputFormatDetection;
+        std::vector<ModeCapabilities>   inputModes;         // In the order of the input display mode iterator.
+        std::vector<ModeCapabilities>   outputModes;        // In the order of the output display mode iterator.
+
+        inline bool IsActive() const { return static_cast<BMDDuplexMode>(duplex) != bmdDuplexInactive; }
+    };
+
+    // Header of the flat capability buffer. The layout is shared with the managed
+    // CapabilitySnapshotHeader struct. Every array starts at its byte offset from the start of
+    // the buffer; the device arrays have 'deviceCount' entries, the mode arrays 'modeCount'.
+    struct CapabilitySnapshotHeader
+    {
+        std::int32_t  totalSize;
+        std::uint32_t generation;
+        std::int32_t  deviceCount;
+        std::int32_t  modeCount;
+        std::int32_t  pixelFormatCount;
+        std::int32_t  pixelFormatsOffset;            // int32[pixelFormatCount], BMDPixelFormat of each bit.
+
+        std::int32_t  persistentIdOffset;            // int64[]
+        std::int32_t  groupIdOffset;                 // int64[]
+        std::int32_t  duplexOffset;                  // int32[]
+        std::int32_t  videoIOSupportOffset;          // int32[]
+        std::int32_t  keyingOffset;                  // int32[]
+        std::int32_t  linksOffset;                   // int32[]
+        std::int32_t  inputFormatDetectionOffset;    // int32[]
+        std::int32_t  nameOffsetOffset;              // int32[], offset of the null-terminated UTF-8 name.
+        std::int32_t  firstInputModeOffset;          // int32[], index in the mode arrays.
+        std::int32_t  inputModeCountOffset;          // int32[]
+        std::int32_t  firstOutputModeOffset;         // int32[]
+        std::int32_t  outputModeCountOffset;         // int32[]
+
+        std::int32_t  frameDurationOffset;           // int64[]
+        std::int32_t  timeScaleOffset;               // int64[]
+        std::int32_t  displayModeOffset;             // int32[]
+        std::int32_t  widthOffset;                   // int32[]
+        std::int32_t  heightOffset;                  // int32[]
+        std::int32_t  fieldDominanceOffset;          // int32[]
+        std::int32_t  pixelFormatMaskOffset;         // uint32[]
+        std::int32_t  keyingPixelFormatMaskOffset;   // uint32[]
+    };
+
+    // Immutable description of every card: profile, IO support, keying, links, display modes
+    // and the support of each pixel format per mode. A snapshot is built once, querying the
+    // cards in parallel, and is only rebuilt after a discovery or profile event invalidated it.
+    // Readers share the current snapshot and never call into the driver.
+    class DeckLinkCapabilitySnapshot final
+    {
+    public:
+        using Pointer = std::shared_ptr<const DeckLinkCapabilitySnapshot>;
+
+        ~DeckLinkCapabilitySnapshot();
+
+        DeckLinkCapabilitySnapshot(const DeckLinkCapabilitySnapshot&) = delete;
+        DeckLinkCapabilitySnapshot& operator=(const DeckLinkCapabilitySnapshot&) = delete;
+
+        // Returns the current snapshot, building it first if it is missing or stale.
+        static Pointer Get();
+
+        // Returns the current snapshot without building it, so it may be stale; null before the
+        // first build. Safe to call from the driver callbacks.
+        static Pointer GetCurrent();
+
+        // Builds the snapshot if it is stale. The status pollers call it, so a snapshot
+        // invalidated while the streams run is rebuilt off the driver callbacks.
+        static void RefreshIfStale();
+
+        // Marks the current snapshot as stale. Safe to call from the driver callbacks.
+        static void Invalidate();
+
+        // Index of the pixel format in kPixelFormatMappings, or -1.
+        static int GetPixelFormatBit(BMDPixelFormat pixelFormat);
+
+        inline std::uint32_t GetGeneration() const { return m_Generation; }
+        inline const std::vector<DeviceCapabilities>& GetDevices() const { return m_Devices; }
+
+        // Devices are indexed in the order of the DeckLink iterator. Null if out of range.
+        const DeviceCapabilities* GetDevice(int deviceSelected) const;
+
+        // Returns false if the mode or the pixel format isn't part of the snapshot.
+        bool TryIsInputPixelFormatSupported(int deviceSelected, BMDDisplayMode displayMode, BMDPixelFormat pixelFormat, bool& supported) const;
+        bool TryIsOutputPixelFormatSupported(int deviceSelected, BMDDisplayMode displayMode, BMDPixelFormat pixelFormat, bool keying, bool& supported) const;
+
+        // Copies the flat buffer if it fits, and returns its size in bytes.
+        int CopyTo(void* buffer, int size) const;
+
+    private:
+        static std::mutex           s_BuildMutex;
+        static std::mutex           s_Mutex;            // Guards s_Current only, never held during a build.
+        static Pointer              s_Current;
+        static std::atomic<bool>    s_Stale;
+        static std::uint32_t        s_Generation;
+
+        DeckLinkCapabilitySnapshot(std::uint32_t generation, std::vector<DeviceCapabilities>&& devices);
+
+        static Pointer Build(std::uint32_t generation);
+        static DeviceCapabilities Query(IDeckLink* device);
+
+        void Flatten();
+
+        std::uint32_t                   m_Generation;
+        std::vector<DeviceCapabilities> m_Devices;
+        std::vector<std::uint8_t>       m_Flat;
+    };
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace MediaBlackmagic
+{
+    // Completion notification of an output device, carrying the number of the latest completed
+    // frame. Every signal bumps a process-wide epoch which waiters block on, so a single wait can
+    // cover any number of devices and wakes up as soon as one of them completes a frame.
+    class DeckLinkCompletionEvent final
+    {
+    public:
+        DeckLinkCompletionEvent();
+
+        void Signal(std::int64_t completedFrames);
+        std::int64_t GetCompletedFrames() const;
+
+        // Waits until at least 'frameNumber' frames have completed. Returns false on timeout.
+        bool Wait(std::int64_t frameNumber, int timeoutMs) const;
+
+        // Returns the index of the first event which reached its frame number, or -1 on timeout.
+        static int WaitAny(const DeckLinkCompletionEvent* const* events,
+                           const std::int64_t* frameNumbers,
+                           int count,
+                           int timeoutMs);
+
+        // Returns true once every event reached its frame number, false on timeout.
+        static bool WaitAll(const DeckLinkCompletionEvent* const* events,
+                            const std::int64_t* frameNumbers,
+                            int count,
+                            int timeoutMs);
+
+    private:
+        static std::atomic<std::uint32_t> s_Epoch;
+
+        std::atomic<std::int64_t> m_CompletedFrames;
+
+        template<typename Predicate>
+        static bool WaitUntil(const Predicate& predicate, int timeoutMs);
+    };
+}
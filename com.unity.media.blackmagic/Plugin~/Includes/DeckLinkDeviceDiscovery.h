@@ -1,12 +1,15 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <atomic>
 #include <functional>
+#include <mutex>
+#include <unordered_map>
 
 #include "com_ptr.h"
 #include "../Common.h"
-#include "../ObjectIDMap.h"
+#include "../ObjectSlotMap.h"
 #include "../external/Unity/IUnityRenderingExtensions.h"
 #include "DeckLinkOutputLinkMode.h"
 #include "DeckLinkOutputKeyingMode.h"
@@ -15,6 +18,16 @@ namespace MediaBlackmagic
 {
     typedef void(UNITY_INTERFACE_API* CallbackDeviceName)(const char*, int);
 
+    enum class EDeviceEvent : int
+    {
+        Arrived = 0,
+        Removed = 1,
+        ProfileChanged = 2      // The device type changed with the profile of its card.
+    };
+
+    // Delta notification of a single device: event, stable device ID, name, device type.
+    typedef void(UNITY_INTERFACE_API* CallbackDeviceEvent)(int, int64_t, const char*, int);
+
     enum class EConnectorMapping
     {
         FourSubDevicesHalfDuplex = 0,
@@ -24,6 +37,25 @@ namespace MediaBlackmagic
         TwoSubDevicesHalfDuplex = 4
     };
 
+    enum class EConnectorMappingResult : int32_t
+    {
+        Unchanged = 0,      // The profile was already active.
+        Activated = 1,
+        Incompatible = 2,   // No card with this group ID, or the card has no such profile.
+        Refused = 3,        // SetActive failed, e.g. while a device of the card is in use.
+        TimedOut = 4        // The profile wasn't activated before the deadline.
+    };
+
+    // Outcome of one card of ChangeConnectorMappings. The layout is shared with the managed
+    // ConnectorMappingResult struct.
+    struct ConnectorMappingResult
+    {
+        int64_t groupID;
+        int64_t elapsed;        // From SetActive to the activation, or to the deadline, in nanoseconds.
+        int32_t result;         // EConnectorMappingResult
+        int32_t rolledBack;     // Non-zero once the previous profile of a failed card is active again.
+    };
+
     struct DeckLinkCardInfo
     {
         int64_t groupID;
@@ -37,9 +69,12 @@ namespace MediaBlackmagic
         std::string name;
         std::list<EConnectorMapping> compatibleProfiles;
         IDeckLinkProfile* deckLinkProfile;
+        int64_t id;             // BMDDeckLinkPersistentID, or BMDDeckLinkTopologicalID as a fallback.
+        int64_t groupID;
+        int deviceType;         // EDeviceDiscoveryType
 
         DeviceInfo(IDeckLink* pDevice, std::string pName)
-            : device(pDevice), hasConnectorMapping(false), name(pName), deckLinkProfile(nullptr)
+            : device(pDevice), hasConnectorMapping(false), name(pName), deckLinkProfile(nullptr), id(0), groupID(0), deviceType(0)
         {
         }
 
@@ -93,10 +128,12 @@ namespace MediaBlackmagic
 
         inline void SetOnDeviceArrival(const CallbackDeviceName& callback) { m_deviceNameArrivedCallback = callback; }
         inline void SetOnDeviceRemoval(const CallbackDeviceName& callback) { m_deviceNameRemovedCallback = callback; }
+        inline void SetOnDeviceEvent(const CallbackDeviceEvent& callback) { m_deviceEventCallback = callback; }
 
         bool EnableDeviceNotifications();
         bool DisableDeviceNotifications();
         bool ChangeAllDevicesConnectorMapping(EConnectorMapping profile, int64_t groupID);
+        int  ChangeConnectorMappings(const int64_t* groupIDs, const EConnectorMapping* profiles, int count, int timeoutMs, ConnectorMappingResult* results);
         bool HasConnectorMappingProfiles();
         bool IsConnectorMappingProfileCompatible(EConnectorMapping profile);
         void ReloadAllDeckLinkDevicesEvent();
@@ -118,7 +155,11 @@ namespace MediaBlackmagic
         ULONG		STDMETHODCALLTYPE Release() override;
 
     private:
-        std::list<DeviceInfo>       m_ActiveDevices;
+        // Guards the devices and the connector mappings, which the notification thread changes.
+        // It isn't held while ChangeConnectorMappings waits for the cards.
+        std::recursive_mutex                    m_DevicesMutex;
+        std::map<int64_t, DeviceInfo>           m_ActiveDevices;    // By stable device ID.
+        std::unordered_map<IDeckLink*, int64_t> m_DeviceIDs;
         com_ptr<IDeckLinkDiscovery> m_deckLinkDiscovery;
 
         CallbackDevice              m_deviceArrivedCallback;
@@ -126,23 +167,31 @@ namespace MediaBlackmagic
 
         CallbackDeviceName			m_deviceNameArrivedCallback;
         CallbackDeviceName          m_deviceNameRemovedCallback;
+        CallbackDeviceEvent         m_deviceEventCallback;
 
         std::atomic<ULONG>          m_refCount;
         std::list<DeckLinkCardInfo> m_ConnectorMappings;
+        int64_t                     m_NextFallbackID;
 
         bool    SetDeviceProfile(IDeckLink* device, DeviceInfo& deviceInfo);
         HRESULT GetDeckLinkProfileID(IDeckLinkProfile* profile, _BMDProfileID* profileID);
         bool    TryGetConnectorMappingProfile(EConnectorMapping profile, _BMDProfileID* bmdProfile);
         bool    TryGetConnectorMappingProfile(_BMDProfileID bmdProfile, EConnectorMapping* profile);
         void    ReloadDeckLinkDevicesEvent(IDeckLink& device);
+        void    SetConnectorMapping(int64_t groupID, EConnectorMapping profile);
+        void    GetDeviceIDs(IDeckLink* device, int64_t* id, int64_t* groupID);
+        bool    IsGroupBusy(int64_t groupID);
+        void    NotifyProfileChanges();
+        void    InvokeDeviceEvent(EDeviceEvent event, const DeviceInfo& deviceInfo);
         int     AddCompatibleConnectorMappingProfiles(DeviceInfo& deviceInfo);
         bool    TryGetConnectorMappingProfileDeckLinkCard(IDeckLink* deckLink, EConnectorMapping& profile);
+        bool    TryGetStoredConnectorMapping(int64_t groupID, EConnectorMapping& profile) const;
     };
 }
 
 namespace
 {
-    MediaBlackmagic::ObjectIDMap<MediaBlackmagic::DeckLinkDeviceDiscovery> s_DeckLinkDeviceDiscovery;
+    MediaBlackmagic::ObjectSlotMap<MediaBlackmagic::DeckLinkDeviceDiscovery> s_DeckLinkDeviceDiscovery;
 
     inline MediaBlackmagic::DeckLinkDeviceDiscovery* GetInstanceDeckLinkDeviceDiscovery(void* deviceDiscovery)
     {
@@ -156,7 +205,11 @@ namespace
 extern "C" void UNITY_INTERFACE_EXPORT * CreateDeckLinkDeviceDiscoveryInstance()
 {
     auto instance = new MediaBlackmagic::DeckLinkDeviceDiscovery();
-    s_DeckLinkDeviceDiscovery.Add(instance);
+    if (s_DeckLinkDeviceDiscovery.Add(instance) == 0)
+    {
+        instance->Release();
+        return nullptr;
+    }
     return instance;
 }
 
@@ -199,6 +252,18 @@ SetDeckLinkOnDeviceRemoved(void* deviceDiscovery, MediaBlackmagic::CallbackDevic
     instance->SetOnDeviceRemoval(callBack);
 }
 
+// Delta notifications with stable device IDs; see MediaBlackmagic::EDeviceEvent. Set before the
+// arrival callback, which enables the notifications.
+extern "C" const void UNITY_INTERFACE_EXPORT
+SetDeckLinkOnDeviceEvent(void* deviceDiscovery, MediaBlackmagic::CallbackDeviceEvent callBack)
+{
+    auto instance = GetInstanceDeckLinkDeviceDiscovery(deviceDiscovery);
+    if (instance == nullptr)
+        return;
+
+    instance->SetOnDeviceEvent(callBack);
+}
+
 extern "C" const bool UNITY_INTERFACE_EXPORT
 ChangeAllDevicesConnectorMapping(void* deviceDiscovery, int profile, int64_t groupID)
 {
@@ -210,6 +275,24 @@ ChangeAllDevicesConnectorMapping(void* deviceDiscovery, int profile, int64_t gro
     return instance->ChangeAllDevicesConnectorMapping(connectorMapping, groupID);
 }
 
+// Activates the profiles of many cards at once, and waits for all of them against a single
+// deadline. The cards which failed are rolled back to their previous profile. Returns the number
+// of failed cards, or -1 if the instance is invalid.
+extern "C" int UNITY_INTERFACE_EXPORT
+ChangeConnectorMappings(void* deviceDiscovery,
+                        int64_t groupIDs[],
+                        MediaBlackmagic::EConnectorMapping profiles[],
+                        int count,
+                        int timeoutMs,
+                        MediaBlackmagic::ConnectorMappingResult results[])
+{
+    auto instance = GetInstanceDeckLinkDeviceDiscovery(deviceDiscovery);
+    if (instance == nullptr || groupIDs == nullptr || profiles == nullptr || results == nullptr)
+        return -1;
+
+    return instance->ChangeConnectorMappings(groupIDs, profiles, count, timeoutMs, results);
+}
+
 extern "C" const unsigned int UNITY_INTERFACE_EXPORT
 DestroyDeckLinkDeviceDiscoveryInstance(void* deviceDiscovery)
 {
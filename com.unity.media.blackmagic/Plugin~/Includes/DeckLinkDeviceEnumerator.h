@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include "../Common.h"
+#include "DeckLinkCapabilitySnapshot.h"
 #include "../external/Unity/IUnityRenderingExtensions.h"
 
 namespace MediaBlackmagic
@@ -73,4 +74,9 @@ extern "C" bool UNITY_INTERFACE_EXPORT SetAllDevicesDuplexMode(bool halfDuplex)
     return enumerator.SetAllDevicesDuplexMode(halfDuplex);
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT GetDeckLinkCapabilities(void* buffer, int size)
+{
+    return MediaBlackmagic::DeckLinkCapabilitySnapshot::Get()->CopyTo(buffer, size);
+}
+
 #pragma endregion
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "DeckLinkDeviceStatus.h"
+
+namespace MediaBlackmagic
+{
+    // Measurements of a device. The histograms come first, the counters last; the values are shared
+    // with the managed DeviceMetric enum.
+    enum class EDeviceMetric
+    {
+        InputCallback = 0,          // Duration of VideoInputFrameArrived, in nanoseconds.
+        InputJitter,                // Deviation of the frame inter-arrival time from the frame duration, in nanoseconds.
+        DeliveryQueueDepth,         // Frames waiting in the submission queue when a frame is submitted.
+        Copy,                       // Copy of a frame into a DeckLink frame, in nanoseconds.
+        Pack,                       // Conversion of a frame to the pixel format of the output, in nanoseconds.
+        ScheduleToCompletion,       // From ScheduleVideoFrame to ScheduledFrameCompleted, in nanoseconds.
+        AudioRingFill,              // Sample frames buffered by the output when more audio is requested.
+
+        LateFrames,
+        DroppedFrames,
+        FlushedFrames,
+
+        Count,
+        FirstCounter = LateFrames
+    };
+
+    // Summary of one metric of one device. The layout is shared with the managed MetricSummary
+    // struct. For a counter, only 'count' is set.
+    struct MetricSummary
+    {
+        std::int32_t  deviceIndex;
+        std::int32_t  direction;    // EDeviceDirection
+        std::int32_t  metric;       // EDeviceMetric
+        std::int32_t  reserved;
+        std::uint64_t count;
+        std::int64_t  min;
+        std::int64_t  max;
+        std::int64_t  mean;
+        std::int64_t  p50;
+        std::int64_t  p90;
+        std::int64_t  p99;
+        std::int64_t  p999;
+    };
+
+    // Log-linear histogram of non-negative values, in the manner of HdrHistogram: every power of
+    // two is split into kSubBuckets linear buckets, so each value is kept within 1/kSubBuckets of
+    // its magnitude. Recording is lock-free and may happen from any thread.
+    class LatencyHistogram final
+    {
+    public:
+        LatencyHistogram();
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        void Record(std::int64_t value);
+        void Reset();
+
+        // Adds the values of another histogram, to summarize several devices together.
+        void Merge(const LatencyHistogram& other);
+
+        // Fills the statistics of 'summary' from a copy of the buckets.
+        void Summarize(MetricSummary& summary) const;
+
+    private:
+        static const int          kSubBucketBits = 5;
+        static const std::int64_t kSubBuckets = 1 << kSubBucketBits;
+        static const int          kMaxValueBits = 40;    // About 18 minutes in nanoseconds.
+        static const int          kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+        static int          GetBucket(std::int64_t value);
+        static std::int64_t GetHighestEquivalentValue(int bucket);
+
+        std::array<std::atomic<std::uint32_t>, kBucketCount> m_Buckets;
+        std::atomic<std::uint64_t>  m_Count;
+        std::atomic<std::int64_t>   m_Sum;
+        std::atomic<std::int64_t>   m_Min;
+        std::atomic<std::int64_t>   m_Max;
+    };
+
+    // The last kCapacity values of a measurement, for statistics which follow the recent behaviour of
+    // a device rather than its whole run. Not thread-safe: owned by the thread recording the values.
+    class RollingWindow final
+    {
+    public:
+        static const int kCapacity = 128;
+
+        RollingWindow();
+
+        void Add(std::int64_t value);
+        void Clear();
+
+        // Minimum, 1st percentile and median of the window; false while it is empty.
+        bool Summarize(std::int64_t& min, std::int64_t& p1, std::int64_t& p50);
+
+    private:
+        std::array<std::int64_t, kCapacity> m_Values;
+        std::array<std::int64_t, kCapacity> m_Sorted;
+        int                                 m_Count;
+        int                                 m_Next;
+    };
+
+    // Histograms and counters of a device, recorded by the plugin threads as the device runs.
+    // Every live set is registered for the aggregated snapshot and the text report.
+    class DeckLinkDeviceMetrics final
+    {
+    public:
+        explicit DeckLinkDeviceMetrics(EDeviceDirection direction);
+        ~DeckLinkDeviceMetrics();
+
+        DeckLinkDeviceMetrics(const DeckLinkDeviceMetrics&) = delete;
+        DeckLinkDeviceMetrics& operator=(const DeckLinkDeviceMetrics&) = delete;
+
+        inline void SetDeviceIndex(int deviceIndex) { m_DeviceIndex.store(deviceIndex, std::memory_order_relaxed); }
+
+        void Record(EDeviceMetric metric, std::int64_t value);
+        void RecordDuration(EDeviceMetric metric, std::chrono::steady_clock::duration duration);
+        void Increment(EDeviceMetric metric);
+        void Reset();
+
+        // Copies up to 'capacity' summaries of the metrics recorded so far, and returns the
+        // number of such metrics over all the live devices.
+        static int Snapshot(MetricSummary* summaries, int capacity);
+
+        // One line per recorded metric, for the logs.
+        static std::string Report();
+
+        static void ResetAll();
+
+    private:
+        static const int kHistogramCount = static_cast<int>(EDeviceMetric::FirstCounter);
+        static const int kCounterCount = static_cast<int>(EDeviceMetric::Count) - kHistogramCount;
+
+        static std::mutex                           s_RegistryMutex;
+        static std::vector<DeckLinkDeviceMetrics*>  s_Registry;
+
+        static std::vector<MetricSummary> Collect();
+
+        const EDeviceDirection      m_Direction;
+        std::atomic<std::int32_t>   m_DeviceIndex;
+
+        std::array<LatencyHistogram, kHistogramCount>               m_Histograms;
+        std::array<std::atomic<std::uint64_t>, kCounterCount>       m_Counters;
+    };
+}
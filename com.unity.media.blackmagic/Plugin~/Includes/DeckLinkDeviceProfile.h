@@ -5,7 +5,7 @@
 
 #include "com_ptr.h"
 #include "../Common.h"
-#include "../ObjectIDMap.h"
+#include "../ObjectSlotMap.h"
 #include "../external/Unity/IUnityRenderingExtensions.h"
 
 namespace MediaBlackmagic
@@ -49,7 +49,7 @@ namespace MediaBlackmagic
 
 namespace
 {
-    MediaBlackmagic::ObjectIDMap<MediaBlackmagic::DeckLinkDeviceProfile> s_DeckLinkDeviceProfile;
+    MediaBlackmagic::ObjectSlotMap<MediaBlackmagic::DeckLinkDeviceProfile> s_DeckLinkDeviceProfile;
 
     inline MediaBlackmagic::DeckLinkDeviceProfile* GetInstanceDeckLinkProfileCallback(void* deviceProfile)
     {
@@ -63,7 +63,11 @@ namespace
 extern "C" void UNITY_INTERFACE_EXPORT * CreateDeckLinkDeviceProfileInstance()
 {
     auto instance = new MediaBlackmagic::DeckLinkDeviceProfile();
-    s_DeckLinkDeviceProfile.Add(instance);
+    if (s_DeckLinkDeviceProfile.Add(instance) == 0)
+    {
+        instance->Release();
+        return nullptr;
+    }
     return instance;
 }
 
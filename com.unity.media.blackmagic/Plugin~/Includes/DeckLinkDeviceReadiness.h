@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace MediaBlackmagic
+{
+    enum class EDeviceReadiness
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    // Readiness of a device opened on a worker thread. The handle of the device is returned to
+    // the caller right away; the caller then polls or waits for the readiness, and reads the
+    // error once the opening failed. Each device has its own worker, so several devices are
+    // opened in parallel.
+    class DeckLinkDeviceReadiness final
+    {
+    public:
+        // Opens the device and reports whether it succeeded; 'error' describes the failure.
+        using OpenFunction = std::function<bool(std::string& error)>;
+
+        DeckLinkDeviceReadiness();
+        ~DeckLinkDeviceReadiness();
+
+        DeckLinkDeviceReadiness(const DeckLinkDeviceReadiness&) = delete;
+        DeckLinkDeviceReadiness& operator=(const DeckLinkDeviceReadiness&) = delete;
+
+        // Runs 'open' on the calling thread, for devices created synchronously.
+        void Open(const OpenFunction& open);
+
+        // Runs 'open' on a new worker thread and returns immediately.
+        void OpenInBackground(OpenFunction open);
+
+        // Waits for the worker, if any. Must be called before the device is stopped.
+        void Join();
+
+        EDeviceReadiness GetState() const;
+
+        // Waits until the device isn't pending anymore, or 'timeoutMs' elapsed (a negative
+        // timeout waits forever). Returns the state at that time.
+        EDeviceReadiness Wait(int timeoutMs) const;
+
+        // Empty unless the state is Failed.
+        const char* GetError() const;
+
+    private:
+        void Complete(bool success, std::string&& error);
+
+        mutable std::atomic<std::uint32_t>  m_State;
+        std::string                         m_Error;    // Written once, before the state.
+        std::thread                         m_Worker;
+    };
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "../Common.h"
+
+namespace MediaBlackmagic
+{
+    enum class EDeviceDirection
+    {
+        Input,
+        Output
+    };
+
+    // Copy of a device status block. The layout is shared with the managed DeviceStatus
+    // struct, so fields may only be appended.
+    struct DeviceStatus
+    {
+        std::int64_t  processedFrames;  // Frames completed by an output, or arrived on an input.
+        std::uint32_t updateCount;      // Odd while the block is written, incremented by two per update.
+        std::int32_t  deviceIndex;
+        std::int32_t  direction;        // EDeviceDirection
+        std::uint32_t droppedFrames;
+        std::uint32_t lateFrames;
+        std::int32_t  bufferedFrames;
+        std::int32_t  referenceLocked;
+        std::int32_t  pixelFormat;      // BMDPixelFormat of the last frame.
+        std::int32_t  signalPresent;    // Input signal detected, or output playback running.
+        std::int32_t  lastStatus;       // EDeviceStatus of the last report.
+        std::int32_t  lastErrorCode;    // InputError for inputs, BMDOutputFrameCompletionResult for outputs.
+        std::int32_t  reserved;
+        std::int64_t  deadlineSlack;    // Time left before the last fed output frame is due, in flicks.
+        std::int64_t  deadlineSlackMin; // Minimum, 1st percentile and median of the slack over the last frames.
+        std::int64_t  deadlineSlackP1;
+        std::int64_t  deadlineSlackP50;
+    };
+
+    // Status of a device, written by the plugin threads as the device runs. Each field is
+    // atomic, so the block can be mapped once by managed code and read without a call into
+    // the plugin; the update count is a sequence lock, so a reader copying the block between two
+    // even and equal counts got the fields of a single update. Every live block is also
+    // registered for the aggregated snapshot.
+    class DeckLinkDeviceStatus final
+    {
+    public:
+        explicit DeckLinkDeviceStatus(EDeviceDirection direction);
+        ~DeckLinkDeviceStatus();
+
+        DeckLinkDeviceStatus(const DeckLinkDeviceStatus&) = delete;
+        DeckLinkDeviceStatus& operator=(const DeckLinkDeviceStatus&) = delete;
+
+        // Address of the block, valid for the lifetime of the device.
+        inline const void* GetBlock() const { return &m_Block; }
+
+        // Retries until it copied the fields of a single update.
+        DeviceStatus Load() const;
+
+        void SetDeviceIndex(int deviceIndex);
+        void SetProcessedFrames(std::int64_t processedFrames);
+        void IncrementProcessedFrames();
+        void IncrementDroppedFrames();
+        void IncrementLateFrames();
+        void SetBufferedFrames(int bufferedFrames);
+        void SetReferenceLocked(bool locked);
+        void SetPixelFormat(int pixelFormat);
+        void SetSignalPresent(bool present);
+        void Report(EDeviceStatus status, int errorCode);
+        void SetDeadlineSlack(std::int64_t slack, std::int64_t min, std::int64_t p1, std::int64_t p50);
+        void Reset();
+
+        // Copies up to 'capacity' statuses and returns the number of live devices.
+        static int Snapshot(DeviceStatus* statuses, int capacity);
+
+    private:
+        struct Block
+        {
+            std::atomic<std::int64_t>   processedFrames;
+            std::atomic<std::uint32_t>  updateCount;
+            std::atomic<std::int32_t>   deviceIndex;
+            std::atomic<std::int32_t>   direction;
+            std::atomic<std::uint32_t>  droppedFrames;
+            std::atomic<std::uint32_t>  lateFrames;
+            std::atomic<std::int32_t>   bufferedFrames;
+            std::atomic<std::int32_t>   referenceLocked;
+            std::atomic<std::int32_t>   pixelFormat;
+            std::atomic<std::int32_t>   signalPresent;
+            std::atomic<std::int32_t>   lastStatus;
+            std::atomic<std::int32_t>   lastErrorCode;
+            std::atomic<std::int32_t>   reserved;
+            std::atomic<std::int64_t>   deadlineSlack;
+            std::atomic<std::int64_t>   deadlineSlackMin;
+            std::atomic<std::int64_t>   deadlineSlackP1;
+            std::atomic<std::int64_t>   deadlineSlackP50;
+        };
+
+        // Makes the update count odd for the time of a write. The writers are the device threads
+        // and the status poller of the card, serialized by the mutex.
+        class WriteScope final
+        {
+        public:
+            explicit WriteScope(DeckLinkDeviceStatus& status);
+            ~WriteScope();
+
+        private:
+            std::lock_guard<std::mutex> m_Lock;
+            Block&                      m_Block;
+        };
+
+        static std::mutex                           s_RegistryMutex;
+        static std::vector<DeckLinkDeviceStatus*>   s_Registry;
+
+        std::mutex  m_WriteMutex;
+        Block       m_Block;
+
+        DeviceStatus LoadFields() const;
+    };
+}
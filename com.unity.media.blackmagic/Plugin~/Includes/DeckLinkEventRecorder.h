@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../Common.h"
+#include "DeckLinkEventRing.h"
+
+namespace MediaBlackmagic
+{
+    // Driver callbacks kept by the event recorder. The values are stored in the recordings.
+    enum class ERecordedEvent : std::uint8_t
+    {
+        FrameArrived = 0,       // VideoInputFrameArrived.
+        FormatChanged,          // VideoInputFormatChanged.
+        FrameCompleted,         // ScheduledFrameCompleted.
+
+        Count
+    };
+
+    // A driver callback as stored in a recording, 32 bytes in the byte order of the host.
+    struct RecordedEvent
+    {
+        std::int64_t    time;           // Steady clock time of the callback, in nanoseconds.
+        std::int64_t    frameNumber;    // FrameArrived: stream time of the frame in frames, -1 without a frame.
+        std::uint32_t   code;           // BMDFrameFlags, BMDDisplayMode or BMDOutputFrameCompletionResult, after the type.
+        std::uint32_t   detail;         // FrameArrived: audio sample frames. FormatChanged: BMDDetectedVideoInputFormatFlags.
+        std::int16_t    deviceIndex;
+        std::uint8_t    type;           // ERecordedEvent.
+        std::uint8_t    events;         // FormatChanged: BMDVideoInputFormatChangedEvents.
+        std::uint32_t   reserved;
+    };
+
+    static_assert(sizeof(RecordedEvent) == 32, "The recorded events are stored as they are laid out.");
+
+    // Optional record of the timing and metadata of the driver callbacks, so the callbacks of a
+    // production incident can be replayed offline against stand-in cards. The events are written
+    // into the same kind of ring as the spans of the tracer; when the recorder is disabled, a
+    // callback costs a relaxed atomic load.
+    //
+    // A recording is a 16-byte header, "DLER", the format version, the size of an event and the
+    // count of events, followed by the events in the order of their time.
+    class DeckLinkEventRecorder final
+    {
+    public:
+        static const std::uint32_t kFormatVersion = 1;
+
+        // Starts recording into a ring of 'capacity' events; the oldest events are overwritten.
+        // The ring is allocated on the first call and kept until the plugin is unloaded.
+        static bool Enable(int capacity);
+        static void Disable();
+        static inline bool IsEnabled() { return s_Events.IsEnabled(); }
+
+        static void RecordFrameArrived(int deviceIndex, IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket);
+        static void RecordFormatChanged(int deviceIndex, BMDVideoInputFormatChangedEvents events, IDeckLinkDisplayMode* mode,
+                                        BMDDetectedVideoInputFormatFlags flags);
+        static void RecordFrameCompleted(int deviceIndex, BMDOutputFrameCompletionResult result);
+
+        // Writes the recorded events. Returns the number of events written, or -1 if the file
+        // can't be written.
+        static int Write(const char* path);
+
+        // Reads a recording written by Write. Returns false if the file isn't one.
+        static bool Read(const char* path, std::vector<RecordedEvent>& events);
+
+    private:
+        struct FileHeader
+        {
+            char            magic[4];
+            std::uint32_t   version;
+            std::uint32_t   eventSize;
+            std::uint32_t   eventCount;
+        };
+
+        static void Record(const RecordedEvent& event);
+
+        static DeckLinkEventRing<RecordedEvent> s_Events;
+    };
+}
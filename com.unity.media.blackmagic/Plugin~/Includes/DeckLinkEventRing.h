@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace MediaBlackmagic
+{
+    // Preallocated ring of events, written without locking by any thread and read by one writer
+    // of a file at a time, as the tracer and the event recorder use it. A slot is guarded by a
+    // sequence, so the events being written, or overwritten while they are read, are skipped.
+    // When the ring is disabled, a record costs a relaxed atomic load.
+    template<typename Event>
+    class DeckLinkEventRing final
+    {
+    public:
+        DeckLinkEventRing() :
+            m_Enabled(false),
+            m_Head(0),
+            m_Capacity(0)
+        {
+        }
+
+        DeckLinkEventRing(const DeckLinkEventRing&) = delete;
+        DeckLinkEventRing& operator=(const DeckLinkEventRing&) = delete;
+
+        // Starts recording into a ring of 'capacity' events; the oldest events are overwritten.
+        // The ring is allocated on the first call and kept until the plugin is unloaded.
+        bool Enable(const int capacity)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            if (m_Slots == nullptr)
+            {
+                if (capacity <= 0)
+                    return false;
+
+                // The writers may still use the ring after a Disable, so it is never reallocated.
+                m_Slots.reset(new Slot[capacity]);
+                m_Capacity = static_cast<std::uint64_t>(capacity);
+            }
+
+            for (std::uint64_t i = 0; i < m_Capacity; ++i)
+            {
+                m_Slots[i].sequence.store(0, std::memory_order_relaxed);
+            }
+            m_Head.store(0, std::memory_order_relaxed);
+
+            m_Enabled.store(true, std::memory_order_release);
+            return true;
+        }
+
+        void Disable()
+        {
+            m_Enabled.store(false, std::memory_order_release);
+        }
+
+        inline bool IsEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+        // Claims the next slot and fills its event with 'write', which is given the event by reference.
+        template<typename Writer>
+        void Record(const Writer& write)
+        {
+            if (!m_Enabled.load(std::memory_order_acquire))
+                return;
+
+            const auto index = m_Head.fetch_add(1, std::memory_order_relaxed);
+            auto& slot = m_Slots[index % m_Capacity];
+
+            // The sequence is odd while the event is written, then 2 * (index + 1).
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            write(slot.event);
+
+            slot.sequence.store(2 * (index + 1), std::memory_order_release);
+        }
+
+        // Copies the events of the ring, from the oldest one.
+        void Read(std::vector<Event>& events) const
+        {
+            events.clear();
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Slots == nullptr)
+                return;
+
+            const auto head = m_Head.load(std::memory_order_acquire);
+            const auto first = head > m_Capacity ? head - m_Capacity : 0;
+            events.reserve(static_cast<size_t>(head - first));
+
+            for (auto index = first; index < head; ++index)
+            {
+                const auto& slot = m_Slots[index % m_Capacity];
+
+                // Skip the events being written, or overwritten in the meantime.
+                const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                const auto event = slot.event;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence == 2 * (index + 1) && slot.sequence.load(std::memory_order_relaxed) == sequence)
+                {
+                    events.push_back(event);
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<std::uint64_t>  sequence;
+            Event                       event;
+        };
+
+        std::atomic<bool>           m_Enabled;
+        std::atomic<std::uint64_t>  m_Head;
+        std::unique_ptr<Slot[]>     m_Slots;
+        std::uint64_t               m_Capacity;
+        mutable std::mutex          m_Mutex;
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace MediaBlackmagic
+{
+    struct FrameSynchronizerStatistics
+    {
+        std::int64_t  phase;            // Position of the last input frame in the output frame, in flicks.
+        std::int64_t  outputFrameDuration;
+        double        driftPpm;         // Positive when the input runs slower than the output.
+        std::int32_t  depth;
+        std::uint32_t droppedFrames;
+        std::uint32_t repeatedFrames;
+        std::int64_t  audioSlip;        // Net number of video frames of audio inserted (> 0) or dropped (< 0).
+    };
+
+    // Time-base corrector between an input clock and an output clock domain.
+    // The input side pushes the frames as they are captured, and the output side pulls one
+    // frame per output frame. The drift between both clocks is measured from the phase of the
+    // input frames within the output frames, and a frame is only dropped or repeated at an output
+    // frame boundary when the measured drift calls for it, so jitter alone never causes a slip.
+    class DeckLinkFrameSynchronizer final
+    {
+    public:
+        enum class EDecision
+        {
+            Present,
+            Drop,
+            Repeat,
+            Starved
+        };
+
+        DeckLinkFrameSynchronizer();
+
+        void Reset(int targetDepth, std::int64_t outputFrameDuration);
+
+        // Input clock domain: 'outputPhase' is the output hardware clock position at arrival.
+        void PushInputFrame(std::uint64_t sequence,
+                            std::int64_t inputTimestamp,
+                            std::int64_t inputFrameDuration,
+                            std::int64_t outputPhase);
+
+        // Output clock domain: called once per output frame.
+        EDecision PullOutputFrame(std::uint64_t& sequence);
+
+        FrameSynchronizerStatistics GetStatistics() const;
+
+    private:
+        // Weight of a new phase measurement in the drift estimate.
+        const double k_DriftSmoothing = 1.0 / 32.0;
+        const double k_DriftDeadBandPpm = 1.0;
+
+        mutable std::mutex          m_Mutex;
+        std::deque<std::uint64_t>   m_Queue;
+        int                         m_TargetDepth;
+        std::int64_t                m_OutputFrameDuration;
+
+        bool                        m_HasInput;
+        std::int64_t                m_LastInputTimestamp;
+        std::int64_t                m_LastPhase;
+        double                      m_PhaseRate;
+
+        bool                        m_HasPresented;
+        std::uint64_t               m_LastPresented;
+
+        std::uint32_t               m_DroppedFrames;
+        std::uint32_t               m_RepeatedFrames;
+        std::int64_t                m_AudioSlip;
+    };
+}
@@ -1,16 +1,26 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <vector>
 
 #include "../Common.h"
+#include "DeckLinkCapabilitySnapshot.h"
 #include "DeckLinkDeviceUtilities.h"
+#include "DeckLinkDeviceReadiness.h"
+#include "DeckLinkInputFramePool.h"
+#include "DeckLinkDeviceStatus.h"
+#include "DeckLinkDeviceMetrics.h"
+#include "DeckLinkLogger.h"
+#include "DeckLinkStatusPoller.h"
 #include "../external/Unity/IUnityRenderingExtensions.h"
 #include "../external/Unity/IUnityGraphics.h"
 
 namespace MediaBlackmagic
 {
+    class DeckLinkPassthroughRoute;
+
     enum class InputError
     {
         NoError,
@@ -20,6 +30,20 @@ namespace MediaBlackmagic
         NoInputSource
     };
 
+    // Timings of the input restarts on format changes, in nanoseconds. The layout is shared with
+    // the managed InputFormatChangeStatistics struct.
+    struct InputFormatChangeStatistics
+    {
+        std::int64_t  lastRestart;          // Duration of the last restart sequence.
+        std::int64_t  maxRestart;
+        std::int64_t  lastRecovery;         // From the last format change to the first frame in the new format.
+        std::int64_t  pooledBytes;
+        std::uint32_t formatChanges;
+        std::uint32_t poolMisses;           // Frame buffers the driver allocated on demand.
+        std::uint32_t lastRecoveryMisses;   // The same, between the last format change and its first frame.
+        std::int32_t  pooledBuffers;
+    };
+
     class DeckLinkInputDevice final : private DeckLinkInputCallback
     {
     public:
@@ -73,8 +97,16 @@ namespace MediaBlackmagic
 
         inline bool IsInitialized() const { return m_Initialized; }
         inline UnityGfxRenderer GetGraphicsAPI() const { return m_GraphicsAPI; }
-
-        void Start(
+        inline int GetAudioChannelCount() const { return m_ChannelCount; }
+        inline _BMDAudioSampleRate GetAudioSampleRate() const { return m_AudioSampleRate; }
+        inline _BMDAudioSampleType GetAudioSampleType() const { return m_AudioSampleType; }
+        inline const DeckLinkDeviceStatus& GetStatus() const { return m_Status; }
+        inline DeckLinkDeviceMetrics& GetMetrics() { return m_Metrics; }
+        inline int GetIndex() const { return m_Index; }
+        inline std::uint64_t GetTraceFlow() const { return m_TraceFlow.load(std::memory_order_relaxed); }
+        inline const DeckLinkStatusPoller* GetStatusPoller() const { return m_StatusPoller; }
+
+        bool Start(
             int deviceIndex,
             int deviceSelected,
             int formatIndex,
@@ -86,11 +118,18 @@ namespace MediaBlackmagic
         void Stop();
         bool GetHasInputSource() const;
 
+        const std::string& GetErrorString() const;
+        void GetSelectedFormat(InputVideoFormatData* format);
+        inline DeckLinkDeviceReadiness& GetReadiness() { return m_Readiness; }
+        void GetFormatChangeStatistics(InputFormatChangeStatistics* statistics) const;
+
         void SetTextureData(uint8_t* textureData);
         uint8_t* GetTextureData();
         void LockQueue();
         void UnlockQueue();
 
+        void SetPassthroughRoute(DeckLinkPassthroughRoute* route);
+
         HRESULT STDMETHODCALLTYPE  QueryInterface(REFIID iid, LPVOID* ppv) override;
         ULONG STDMETHODCALLTYPE    AddRef() override;
         ULONG STDMETHODCALLTYPE    Release() override;
@@ -107,6 +146,11 @@ namespace MediaBlackmagic
         static VideoFormatChangedCallback   s_VideoFormatChangedCallback;
         static FrameArrivedCallback         s_FrameArrivedCallback;
 
+        // Frame buffers kept in advance for the likely next formats, within a budget. Frames
+        // beyond it are allocated on demand.
+        static const int kReservedFrameBuffers = 4;
+        static const std::uint64_t k_MaxReservedBytes = 256ull << 20;
+
         int                     m_Index;
         bool                    m_Initialized;
         std::atomic<ULONG>      m_RefCount;
@@ -122,11 +166,35 @@ namespace MediaBlackmagic
         uint8_t*                m_TextureData;
         mutable std::mutex      m_QueueLock;
         UnityGfxRenderer        m_GraphicsAPI;
+        DeckLinkPassthroughRoute* m_PassthroughRoute;
+        std::mutex              m_PassthroughRouteLock;
+        DeckLinkDeviceStatus    m_Status;
+        DeckLinkDeviceMetrics   m_Metrics;
+        // The frame errors repeat on every frame; each kind is limited on its own, so a frequent
+        // one doesn't hide the others.
+        LogRateLimit            m_ErrorLogLimits[static_cast<int>(InputError::NoInputSource) + 1];
+        std::int64_t            m_LastArrivalTime;      // Steady clock time of the last frame, in nanoseconds; 0 after a restart.
+        std::atomic<std::uint64_t> m_TraceFlow;         // Trace flow of the last frame, 0 when not tracing.
+        DeckLinkStatusPoller*   m_StatusPoller;
+        DeckLinkDeviceReadiness m_Readiness;
+        std::string             m_Error;
+        int                     m_DeviceSelected;
+        DeckLinkCapabilitySnapshot::Pointer m_Capabilities;
+        DeckLinkInputFramePool* m_FramePool;
+
+        std::atomic<std::uint32_t>  m_FormatChanges;
+        std::atomic<std::int64_t>   m_LastRestart;
+        std::atomic<std::int64_t>   m_MaxRestart;
+        std::atomic<std::int64_t>   m_LastRecovery;
+        std::atomic<std::uint32_t>  m_LastRecoveryMisses;
+        std::atomic<std::int64_t>   m_FormatChangeTime;     // Steady clock time of the pending format change, 0 once recovered.
+        std::atomic<std::uint32_t>  m_FormatChangeMisses;
 
         _BMDAudioSampleRate     m_AudioSampleRate = _BMDAudioSampleRate::bmdAudioSampleRate48kHz;
         _BMDAudioSampleType     m_AudioSampleType = _BMDAudioSampleType::bmdAudioSampleType16bitInteger;
         const int               m_ChannelCount = 2;
 
+        void            ReportFrameError(EDeviceStatus status, InputError error, const char* message);
         HRESULT         DetectInputSource(IDeckLinkVideoInputFrame* videoFrame);
         std::uint32_t   GetVideoTimecode(IDeckLinkVideoInputFrame* frame);
         std::int64_t    GetVideoHardwareReferenceTimestamp(IDeckLinkVideoInputFrame* frame);
@@ -154,6 +222,9 @@ namespace MediaBlackmagic
         void            InvokeFormatChangedCallback(std::string changeDescription);
         void            GetVideoFormat(InputVideoFormatData* format);
         void            EnablesVideoFormatFlag();
+        BMDVideoInputFlags GetVideoInputFlags() const;
+        void            ReserveFramePool();
+        void            RecordFormatChange(std::chrono::steady_clock::time_point start);
         bool            IsRGBPixelFormat(BMDPixelFormat pixelFormat) const;
     };
 }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../Common.h"
+
+namespace MediaBlackmagic
+{
+    // Memory allocator of the captured frames. The buffers released by the driver are kept for
+    // reuse, and a background thread allocates the buffers of the next likely formats in
+    // advance, so restarting the input in another format doesn't allocate on the capture path.
+    // A buffer serves any request up to its size.
+    class DeckLinkInputFramePool final : public IDeckLinkMemoryAllocator
+    {
+    public:
+        DeckLinkInputFramePool();
+
+        // Makes sure that 'count' buffers of at least 'bufferSize' bytes exist, in the background.
+        void Reserve(std::uint32_t bufferSize, int count);
+
+        // Row bytes of a captured frame, as laid out by the driver.
+        static std::uint32_t GetRowBytes(BMDPixelFormat pixelFormat, std::int32_t width);
+
+        // Number of buffers the driver requested while none was large enough.
+        inline std::uint32_t CountMisses() const { return m_Misses.load(std::memory_order_relaxed); }
+
+        int CountBuffers() const;
+        std::int64_t CountBytes() const;
+
+        // IUnknown implementation
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override;
+        ULONG STDMETHODCALLTYPE AddRef() override;
+        ULONG STDMETHODCALLTYPE Release() override;
+
+        // IDeckLinkMemoryAllocator implementation
+        HRESULT STDMETHODCALLTYPE AllocateBuffer(unsigned int bufferSize, void** allocatedBuffer) override;
+        HRESULT STDMETHODCALLTYPE ReleaseBuffer(void* buffer) override;
+        HRESULT STDMETHODCALLTYPE Commit() override;
+        HRESULT STDMETHODCALLTYPE Decommit() override;
+
+    private:
+        // Buffers beyond this count are freed when released, smallest first.
+        static const std::size_t kMaxFreeBuffers = 16;
+
+        ~DeckLinkInputFramePool();
+
+        void Run();
+        void TrimFreeBuffers();
+
+        std::atomic<ULONG>                          m_RefCount;
+        std::atomic<std::uint32_t>                  m_Misses;
+
+        mutable std::mutex                          m_Mutex;
+        std::condition_variable                     m_Condition;
+        std::vector<void*>                          m_FreeBuffers;
+        std::unordered_map<void*, std::uint32_t>    m_BufferSizes;  // Every buffer, free or in use.
+        std::uint32_t                               m_ReserveSize;
+        int                                         m_ReserveCount;
+        bool                                        m_Stopping;
+        std::thread                                 m_Thread;
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace MediaBlackmagic
+{
+    // Severity of a log message. The values are shared with the managed LogSeverity enum.
+    enum class ELogSeverity
+    {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+        Off
+    };
+
+    // Limits a message logged on a per-frame path to one per interval; the messages suppressed in
+    // between are counted and reported with the next one.
+    class LogRateLimit final
+    {
+    public:
+        explicit LogRateLimit(int intervalMs = 1000);
+
+        // Returns true if the message may be logged, with the number of messages suppressed since
+        // the last one.
+        bool Allow(std::uint32_t& suppressed);
+
+    private:
+        const std::int64_t          m_IntervalNs;
+        std::atomic<std::int64_t>   m_Next;
+        std::atomic<std::uint32_t>  m_Suppressed;
+    };
+
+    // Asynchronous logger of the plugin. Any thread formats its message straight into a slot of a
+    // bounded multi-producer ring, without locking nor allocating; a background thread writes the
+    // messages in batches into a size-capped file, rotated with a few backups. When the ring is full
+    // the message is dropped and counted rather than blocking the caller, so logging never changes
+    // the timing of the frame paths. Messages below the configured severity cost a relaxed load.
+    class DeckLinkLogger final
+    {
+    public:
+        // Sets the file, the minimum severity and the size after which the file is rotated. A null
+        // or empty path keeps the current one, the platform default at first. Logging at ELogSeverity::Off
+        // stops the writer.
+        static void Configure(const char* path, ELogSeverity severity, std::int64_t maxFileBytes);
+
+        // Writes the pending messages and stops the writer, when the plugin is unloaded.
+        static void Shutdown();
+
+        static inline bool IsEnabled(const ELogSeverity severity)
+        {
+            return static_cast<int>(severity) >= s_Severity.load(std::memory_order_relaxed);
+        }
+
+        // printf-style formatting; the messages are truncated to kMaxMessageLength characters.
+        static void Log(ELogSeverity severity, const char* format, ...);
+        static void Log(LogRateLimit& limit, ELogSeverity severity, const char* format, ...);
+
+        // Number of messages dropped because the ring was full.
+        static std::uint64_t CountDropped();
+
+        static const int kMaxMessageLength = 231;
+
+        // Size of the file before it is rotated, unless configured otherwise.
+        static const std::int64_t kDefaultMaxFileBytes = 8 * 1024 * 1024;
+
+    private:
+        static std::atomic<int> s_Severity;
+    };
+}
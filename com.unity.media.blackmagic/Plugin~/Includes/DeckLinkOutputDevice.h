@@ -17,10 +17,18 @@
 #include "../external/Unity/IUnityRenderingExtensions.h"
 #include "DeckLinkOutputLinkMode.h"
 #include "DeckLinkOutputKeyingMode.h"
+#include "DeckLinkCapabilitySnapshot.h"
 #include "DeckLinkDeviceUtilities.h"
+#include "DeckLinkOutputSubmissionQueue.h"
+#include "DeckLinkCompletionEvent.h"
+#include "DeckLinkDeviceReadiness.h"
+#include "DeckLinkDeviceStatus.h"
+#include "DeckLinkDeviceMetrics.h"
+#include "DeckLinkLogger.h"
+#include "DeckLinkStatusPoller.h"
+#include "FrameCopyEngine.h"
 
 #if _WIN64
-#include "ThreadedMemcpy.h"
 #include "d3d11.h"
 #include "PinnedMemoryAllocator.h"
 #include "DeckLinkOutputGPUDirect.h"
@@ -29,6 +37,7 @@
 namespace MediaBlackmagic
 {
     struct HDRMetadata;
+    class DeckLinkPassthroughRoute;
 
     const uint32_t k_BufferedFrameNum = 1;
 
@@ -40,6 +49,10 @@ namespace MediaBlackmagic
         {
         public:
             HDRVideoFrame(bool handleAllocation, IDeckLinkMutableVideoFrame* videoFrame, BMDDisplayModeFlags& deviceColorspace);
+            virtual ~HDRVideoFrame();
+
+            // Replaces the wrapped frame, moving the wrapper's reference to the new one.
+            void SetVideoFrame(IDeckLinkMutableVideoFrame* videoFrame);
 
             // IUnknown interface
             virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv);
@@ -64,9 +77,11 @@ namespace MediaBlackmagic
             virtual HRESULT STDMETHODCALLTYPE GetBytes(BMDDeckLinkFrameMetadataID metadataID, void* buffer, uint32_t* bufferSize);
 
             // Metadata support
-            IDeckLinkMutableVideoFrame* m_VideoFrame;
+            IDeckLinkMutableVideoFrame* m_VideoFrame;   // Referenced by the wrapper.
             bool m_HandleAllocation;
             BMDDisplayModeFlags& m_DeviceColorspace;
+            // References to the wrapper itself: its owner's, and the driver's while it is scheduled.
+            std::atomic<ULONG> m_RefCount;
 
             static void SetTransferFunction(uint32_t eotf);
             static HDRMetadata m_Metadata;
@@ -82,27 +97,69 @@ namespace MediaBlackmagic
         inline void SetFameErrorCallback(const FrameError& callback) { m_FrameErrorCallback = callback; }
         inline void SetFrameCompletedCallback(const FrameCompleted& callback) { m_FrameCompletedCallback = callback; }
         inline void SetDefaultScheduleTime(const float value) { m_DefaultScheduleTime = value; }
+        inline void SetFrameReleasedCallback(const DeckLinkOutputSubmissionQueue::FrameReleased& callback) { m_SubmissionQueue.SetFrameReleasedCallback(callback); }
 
         const std::string&  GetErrorString() const;
         std::int64_t        GetFrameDuration() const;
         void                GetFrameRate(std::int32_t& numerator, std::int32_t& denominator) const;
         IntPair             GetFrameDimensions() const;
-        const std::string&  RetrievePixelFormat();
+        const char*         RetrievePixelFormat() const;
 
         bool  IsProgressive() const;
         bool  IsReferenceLocked() const;
+        bool  GetHardwareClockPhase(std::int64_t& phase) const;
+
+        // Frames which may be queued on the card at once: the preroll depth and the repeated
+        // frame in async mode, the buffered frame limit in manual mode.
+        int   GetMaxQueuedFrames() const;
 
         inline unsigned int CountDroppedFrames() const { return m_DroppedFrameCount; }
         inline unsigned int CountLateFrames() const { return m_LateFrameCount; }
         inline bool IsAsyncMode() const { return m_IsAsync; }
         inline bool IsInitialized() const { return m_Initialized; }
+        inline BMDPixelFormat GetPixelFormat() const { return m_PixelFormat; }
+        inline int GetAudioChannelCount() const { return m_AudioChannelCount; }
+        inline _BMDAudioSampleRate GetAudioSampleRate() const { return bmdAudioSampleRate48kHz; }   // The only rate supported.
 
         void  Stop();
+
+        // Same, waiting for the end of the playback until the deadline at most.
+        void  Stop(std::chrono::steady_clock::time_point deadline);
+
+        // Phased stop, to stop many devices at once: BeginStop requests the end of the playback
+        // without waiting, and WaitStopped waits for it until the deadline. Stop completes the
+        // teardown. Returns false if the playback didn't stop in time.
+        void  BeginStop();
+        bool  WaitStopped(std::chrono::steady_clock::time_point deadline);
+
         void  FeedFrame(void* frameData, unsigned int timecode);
+
+        // Async submission: the frames are handed over to a worker thread which feeds them.
+        bool  EnableAsyncSubmission(int capacity, ESubmissionBackpressure policy);
+        void  DisableAsyncSubmission();
+        bool  SubmitFrame(void* frameData, unsigned int timecode);
+        inline OutputSubmissionStatistics GetSubmissionStatistics() const { return m_SubmissionQueue.GetStatistics(); }
         void  WaitFrameCompletion(std::int64_t frameNumber);
+        inline const DeckLinkCompletionEvent& GetCompletionEvent() const { return m_CompletionEvent; }
+        inline const DeckLinkDeviceStatus& GetStatus() const { return m_Status; }
+        inline DeckLinkDeviceMetrics& GetMetrics() { return m_Metrics; }
+        inline int GetIndex() const { return m_Index; }
+
+        // Trace flow of the next fed frame; by default, the flow of the input frame uploaded last.
+        inline void SetFeedTraceFlow(std::uint64_t flow) { m_FeedTraceFlow.store(flow, std::memory_order_relaxed); }
+        // Trace flow of the next scheduled frame, for the frames routed from an input.
+        inline void SetScheduleTraceFlow(std::uint64_t flow) { m_ScheduleTraceFlow.store(flow, std::memory_order_relaxed); }
+        inline const DeckLinkStatusPoller* GetStatusPoller() const { return m_StatusPoller; }
+        inline DeckLinkDeviceReadiness& GetReadiness() { return m_Readiness; }
         void  FeedAudioSampleFrames(const float* samples, int sampleCount);
 
-        void  StartAsyncMode(int deviceIndex,
+        // Passthrough routing: while a route is attached, the fed frames are used as its fill/key
+        // source and the captured frames are scheduled by the route itself.
+        void  SetPassthroughRoute(DeckLinkPassthroughRoute* route);
+        bool  ScheduleRoutedFrame(IDeckLinkMutableVideoFrame* frame, unsigned int timecode);
+        IDeckLinkMutableVideoFrame* CreateRouteFrame();
+
+        bool  StartAsyncMode(int deviceIndex,
                              int deviceSelected,
                              BMDDisplayMode mode,
                              int pixelFormat,
@@ -114,7 +171,7 @@ namespace MediaBlackmagic
                              int audioSampleRate,
                              bool useGPUDirect);
 
-        void  StartManualMode(int deviceIndex,
+        bool  StartManualMode(int deviceIndex,
                               int deviceSelected,
                               BMDDisplayMode mode,
                               int pixelFormat,
@@ -135,6 +192,16 @@ namespace MediaBlackmagic
         bool IsSupportedLinkMode(EOutputLinkMode mode);
         bool SetLinkConfiguration(EOutputLinkMode mode);
 
+        // Applies a new configuration to the running output. Only the changed settings are
+        // applied: the playback is restarted at the next frame boundary for a new display mode,
+        // pixel format or HDR state, and the frames are kept if their size still fits.
+        bool Reconfigure(BMDDisplayMode mode,
+                         int pixelFormat,
+                         int colorSpace,
+                         int transferFunction,
+                         EOutputKeyingMode keying,
+                         EOutputLinkMode linkMode);
+
         // IDeckLinkVideoOutputCallback implementation
         HRESULT STDMETHODCALLTYPE ScheduledFrameCompleted(IDeckLinkVideoFrame* completedFrame,
                                                           BMDOutputFrameCompletionResult result) override;
@@ -163,14 +230,6 @@ namespace MediaBlackmagic
         static const std::string k_FrameFlushed;
         static const std::string k_FrameSucceeded;
 
-        struct OutputFormatData
-        {
-            std::string pixelFormatValue;
-            bool        pixelFormatChanged;
-
-            OutputFormatData() : pixelFormatValue(""), pixelFormatChanged(true) {}
-        };
-
         std::list<HDRVideoFrame*>  m_HDRFrames;
 
         HDRVideoFrame               m_Frame;
@@ -188,7 +247,6 @@ namespace MediaBlackmagic
         FrameError                  m_FrameErrorCallback;
         FrameCompleted              m_FrameCompletedCallback;
 
-        OutputFormatData            m_OutputFormatData;
         std::atomic<ULONG>          m_RefCount;
         std::string                 m_Error;
         std::vector<int32_t>        m_AudioBuffer;
@@ -203,7 +261,6 @@ namespace MediaBlackmagic
         // reader needs to be able to put back a chunk if it has been partially consumed or, if it
         // proves too difficult, we can keep the incompletely-used chunk separately.
 
-        std::condition_variable m_Condition;
         std::list<AudioChunk>   m_FreeAudioChunks;
         std::list<AudioChunk>   m_AudioChunks;
         std::mutex              m_AudioChunksMutex;
@@ -212,6 +269,26 @@ namespace MediaBlackmagic
         std::mutex              m_Mutex;
         std::int64_t            m_Queued;
         std::int64_t            m_Completed;
+        DeckLinkCompletionEvent m_CompletionEvent;
+        DeckLinkDeviceStatus    m_Status;
+        DeckLinkDeviceMetrics   m_Metrics;
+        LogRateLimit            m_LateLogLimit;
+        LogRateLimit            m_DroppedLogLimit;
+        struct ScheduledFrame
+        {
+            std::chrono::steady_clock::time_point   scheduleTime;
+            std::uint64_t                           traceFlow;
+        };
+
+        std::mutex                  m_ScheduleTimesMutex;
+        std::deque<ScheduledFrame>  m_ScheduleTimes;            // Scheduled frames, completed in order.
+        RollingWindow               m_DeadlineSlack;            // Recorded by the feeding thread, in flicks.
+        std::atomic<std::uint64_t>  m_FeedTraceFlow;
+        std::atomic<std::uint64_t>  m_ScheduleTraceFlow;
+        DeckLinkStatusPoller*   m_StatusPoller;
+        DeckLinkDeviceReadiness m_Readiness;
+        int                     m_DeviceSelected;
+        DeckLinkCapabilitySnapshot::Pointer m_Capabilities;
         float                   m_DefaultScheduleTime;
         IDeckLinkConfiguration* m_Configuration;
         std::deque<IDeckLinkMutableVideoFrame*>	m_OutputVideoFrameQueue;
@@ -219,10 +296,19 @@ namespace MediaBlackmagic
         bool                    m_IsGPUDirectAvailable;
         std::condition_variable	m_PlaybackStoppedCondition;
         bool                    m_Stopped;
+        bool                    m_StopRequested;
+        bool                    m_StopPending;
+        int                     m_StaleStopCallbacks;   // Of the stops which were still pending when the playback restarted.
+        std::atomic<bool>       m_Reconfiguring;
+        int                     m_Preroll;
+        EOutputLinkMode         m_LinkMode;
+        DeckLinkPassthroughRoute* m_PassthroughRoute;
+        std::mutex              m_PassthroughRouteMutex;
+        DeckLinkOutputSubmissionQueue m_SubmissionQueue;
+        FrameCopyEngine         m_FrameCopy;
 
 #if _WIN64
         DeckLinkOutputGPUDirectDevice* m_OutputGPUDirect;
-        ThreadedMemcpy                 m_ThreadedMemcpy;
 
         public:
             void InitializeGPUDirectResources(ID3D11Device* d3d11Device, ID3D11DeviceContext* d3d11Context);
@@ -230,10 +316,18 @@ namespace MediaBlackmagic
 #endif
 
         IDeckLinkMutableVideoFrame* AllocateFrame();
+        void AllocateFramePool();
+        void ReleaseFramePool();
+        void ReleaseHDRFrames();
+        bool CanReuseFramePool(IDeckLinkDisplayMode* displayMode, BMDPixelFormat pixelFormat, BMDDisplayModeFlags colorSpace) const;
+        void PrerollFrames(IDeckLinkMutableVideoFrame* frame);
+        bool SwitchVideoMode(BMDDisplayMode mode, BMDPixelFormat pixelFormat, BMDDisplayModeFlags colorSpace, EOutputLinkMode linkMode);
 
         void CopyFrameData(IDeckLinkMutableVideoFrame* frame, const void* data);
         void SetTimecode(IDeckLinkMutableVideoFrame* frame, unsigned int timecode) const;
         void ScheduleFrame(IDeckLinkVideoFrame* frame);
+        void RecordDeadlineSlack();
+        std::uint64_t TakeFeedTraceFlow();
 
         void FeedFrameHDR(void* frameData, unsigned int timecode);
         void FeedFrameSDR(void* frameData, unsigned int timecode);
@@ -255,6 +349,8 @@ namespace MediaBlackmagic
         bool InitializeAudioOutput(int prerollVideoFrameCount, int channelCount, int sampleRate);
         void ReleaseAudioOutput();
 
+        bool IsPixelFormatSupportedInCurrentMode(bool keying) const;
+
         std::uint32_t GetFrameByteLength(std::uint32_t width) const;
     };
 }
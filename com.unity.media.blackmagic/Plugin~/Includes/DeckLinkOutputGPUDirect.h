@@ -5,8 +5,8 @@
 #include "../Common.h"
 #include "../external/Unity/IUnityRenderingExtensions.h"
 #include "DeckLinkDeviceUtilities.h"
+#include "DeckLinkLogger.h"
 
-#include "ThreadedMemcpy.h"
 #include "d3d11.h"
 #include "PinnedMemoryAllocator.h"
 
@@ -37,6 +37,7 @@ namespace MediaBlackmagic
         uint64_t               m_FrameCount;
         bool                   m_GPUDirectAvailable;
         PinnedMemoryAllocator* m_PlayoutAllocator;
+        LogRateLimit           m_FrameLogLimit;     // The errors of the per-frame copies.
 
         bool CopyBufferResources(void* frameSourceData);
         bool CopyResource(ID3D11Texture2D* nativeSrc, ID3D11Texture2D* tex2DDest);
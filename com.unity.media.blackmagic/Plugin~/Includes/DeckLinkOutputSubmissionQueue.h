@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "../external/Unity/IUnityInterface.h"
+
+namespace MediaBlackmagic
+{
+    enum class ESubmissionBackpressure
+    {
+        Block,      // The caller waits until the worker frees a slot.
+        DropOldest, // The oldest queued frame is released without being played out.
+        DropNewest  // The submitted frame is rejected.
+    };
+
+    enum class ESubmissionStage
+    {
+        Copy,
+        Schedule
+    };
+
+    struct OutputSubmissionStatistics
+    {
+        std::uint32_t submitted;
+        std::uint32_t consumed;
+        std::uint32_t dropped;
+        std::int32_t  queued;
+
+        // Durations in nanoseconds.
+        std::int64_t  lastQueueWait;
+        std::int64_t  lastCopy;
+        std::int64_t  lastSchedule;
+        std::int64_t  maxQueueWait;
+        std::int64_t  maxCopy;
+        std::int64_t  maxSchedule;
+    };
+
+    // Bounded queue of frames handed over by Unity, drained by a worker thread which does the
+    // copy, packing and scheduling. The caller keeps ownership of each buffer until it is
+    // notified through the released callback.
+    class DeckLinkOutputSubmissionQueue final
+    {
+    public:
+        typedef std::function<void(void* frameData, unsigned int timecode)> Consumer;
+        typedef void(UNITY_INTERFACE_API* FrameReleased)(int deviceIndex, void* frameData, bool dropped);
+
+        DeckLinkOutputSubmissionQueue();
+        ~DeckLinkOutputSubmissionQueue();
+
+        bool Start(int deviceIndex, int capacity, ESubmissionBackpressure policy, const Consumer& consumer);
+        void Stop();
+
+        inline bool IsRunning() const { return m_Running; }
+        inline void SetFrameReleasedCallback(const FrameReleased& callback) { m_FrameReleasedCallback = callback; }
+
+        bool Submit(void* frameData, unsigned int timecode);
+        void RecordStage(ESubmissionStage stage, std::chrono::steady_clock::duration duration);
+
+        OutputSubmissionStatistics GetStatistics() const;
+
+    private:
+        struct Submission
+        {
+            void*                                   frameData;
+            unsigned int                            timecode;
+            std::chrono::steady_clock::time_point   submitTime;
+        };
+
+        int                         m_DeviceIndex;
+        std::size_t                 m_Capacity;
+        ESubmissionBackpressure     m_Policy;
+        Consumer                    m_Consumer;
+        FrameReleased               m_FrameReleasedCallback;
+
+        std::mutex                  m_StateMutex;       // Serializes Start and Stop, so a second Stop waits for the first.
+        mutable std::mutex          m_Mutex;
+        std::condition_variable     m_QueueCondition;
+        std::condition_variable     m_SpaceCondition;
+        std::deque<Submission>      m_Queue;
+        std::thread                 m_Worker;
+        std::atomic<bool>           m_Running;          // Read by the feeding and the stopping threads.
+        bool                        m_Stopping;
+
+        OutputSubmissionStatistics  m_Statistics;
+
+        void Run();
+        void Release(void* frameData, bool dropped);
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Common.h"
+#include "DeckLinkFrameSynchronizer.h"
+
+namespace MediaBlackmagic
+{
+    class DeckLinkInputDevice;
+    class DeckLinkOutputDevice;
+
+    enum class EPassthroughCompositing
+    {
+        None,   // The captured frames are played out untouched.
+        Fill,   // The frames fed by Unity replace the captured frames while they keep coming.
+        Key     // The frames fed by Unity are alpha-blended over the captured frames (8-bit RGB only).
+    };
+
+    // Routes the frames captured by an input device to an output device, entirely on the
+    // capture thread. Every captured frame is copied (or repacked when the pixel formats differ)
+    // into a ring of output frames and the frame captured 'delay' frames earlier is scheduled,
+    // so Unity is only involved when it feeds a fill or key frame. The captured audio is kept
+    // with its frame and fed when the frame is played out, so it goes through the same delay.
+    // When synchronized, the frames are instead pulled at the output clock rate through a frame
+    // synchronizer, for inputs which are not locked to the output reference.
+    class DeckLinkPassthroughRoute final
+    {
+    public:
+        DeckLinkPassthroughRoute(DeckLinkInputDevice* input, DeckLinkOutputDevice* output);
+        ~DeckLinkPassthroughRoute();
+
+        bool Start(int delayFrames, EPassthroughCompositing compositing, bool synchronize);
+        void Stop();
+
+        bool SetDelay(int delayFrames);
+        inline int GetDelay() const { return m_Delay; }
+        void SetCompositing(EPassthroughCompositing compositing);
+
+        inline unsigned int CountRoutedFrames() const { return m_RoutedFrameCount; }
+        inline unsigned int CountSkippedFrames() const { return m_SkippedFrameCount; }
+        // Returns a copy, as SetDelay may set the error on another thread.
+        std::string GetErrorString() const;
+        inline bool IsSynchronized() const { return m_Synchronize; }
+        inline FrameSynchronizerStatistics GetSynchronizerStatistics() const { return m_Synchronizer.GetStatistics(); }
+
+        // Called by the output device in place of its own frame copy while the route is attached.
+        void FeedOverlay(const void* frameData, unsigned int timecode);
+
+        // Called by the input device from its capture thread.
+        void OnInputFrame(IDeckLinkVideoInputFrame* videoFrame,
+                          IDeckLinkAudioInputPacket* audioPacket,
+                          unsigned int timecode,
+                          std::int64_t hardwareTimestamp,
+                          std::int64_t frameDuration);
+
+        // Called by the output device from its completion thread when synchronized. The frame is
+        // returned with a reference, which the caller releases.
+        bool OnOutputFrame(IDeckLinkMutableVideoFrame*& frame, unsigned int& timecode);
+
+    private:
+        const int k_MaxDelayFrames = 120;
+        const std::uint64_t k_InvalidSequence = ~0ULL;
+        // Frames the synchronizer may hold on top of its target depth.
+        const int k_SynchronizerHeadroomFrames = 2;
+
+        struct RouteSlot
+        {
+            IDeckLinkMutableVideoFrame* frame;
+            unsigned int                timecode;
+            std::uint64_t               sequence;
+            std::uint64_t               traceFlow;
+            std::vector<float>          audio;      // Interleaved, as fed to the output.
+        };
+
+        DeckLinkInputDevice*        m_Input;
+        DeckLinkOutputDevice*       m_Output;
+        IDeckLinkVideoConversion*   m_Conversion;
+
+        mutable std::mutex          m_RingMutex;        // Guards m_Error as well.
+        std::vector<RouteSlot>      m_Ring;
+        std::uint64_t               m_Sequence;
+        std::atomic<int>            m_Delay;
+        bool                        m_Synchronize;
+        DeckLinkFrameSynchronizer   m_Synchronizer;
+        std::uint64_t               m_LastPresented;
+
+        bool                        m_ForwardAudio;
+        int                         m_AudioSampleFramesPerVideoFrame;
+
+        std::mutex                  m_OverlayMutex;
+        std::vector<std::uint8_t>   m_Overlay;
+        std::uint64_t               m_OverlaySerial;
+        std::uint64_t               m_OverlayConsumedSerial;
+        unsigned int                m_OverlayTimecode;
+        EPassthroughCompositing     m_Compositing;
+
+        std::atomic<unsigned int>   m_RoutedFrameCount;
+        std::atomic<unsigned int>   m_SkippedFrameCount;
+        std::string                 m_Error;
+        bool                        m_Started;
+
+        // The frames are allocated and released outside of the ring lock, so the capture thread
+        // keeps routing meanwhile.
+        bool AllocateRing(std::vector<RouteSlot>& ring, std::size_t slotCount);
+        void SetError(const char* error);
+        void ReleaseRing(std::vector<RouteSlot>& ring);
+
+        bool CopyInputFrame(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkMutableVideoFrame* slotFrame);
+        bool ApplyOverlay(IDeckLinkMutableVideoFrame* slotFrame, unsigned int& timecode);
+        void CopyInputAudio(IDeckLinkAudioInputPacket* audioPacket, std::vector<float>& samples);
+        void FeedSlotAudio(const RouteSlot& slot);
+    };
+}
@@ -20,6 +20,11 @@ namespace MediaBlackmagic
         virtual ~DeckLinkProfileCallback();
 
         bool WaitForProfileActivation(void);
+        bool WaitForProfileActivation(std::chrono::steady_clock::time_point deadline);
+
+        // Time of the ProfileActivated callback for the requested profile, or of the first wait if
+        // it was already active.
+        std::chrono::steady_clock::time_point GetActivationTime();
 
         HRESULT STDMETHODCALLTYPE ProfileChanging(IDeckLinkProfile* profileToBeActivated, dlbool_t /*streamsWillBeForcedToStop*/) override;
         HRESULT STDMETHODCALLTYPE ProfileActivated(IDeckLinkProfile* activatedProfile) override;
@@ -34,6 +39,7 @@ namespace MediaBlackmagic
         BMDProfileID            m_requestedProfileID;
         IDeckLinkProfile*       m_requestedProfile;
         bool                    m_requestedProfileActivated;
+        std::chrono::steady_clock::time_point m_activationTime;
         std::atomic<ULONG>      m_refCount;
     };
 }
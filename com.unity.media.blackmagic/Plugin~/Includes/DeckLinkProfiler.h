@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../external/Unity/IUnityProfiler.h"
+
+namespace MediaBlackmagic
+{
+    // Unity Profiler markers of the plugin.
+    enum class EProfilerMarker
+    {
+        TextureUpdateLock = 0,
+        InputFrameArrived,      // Frame number, bytes.
+        FeedFrameSDR,           // Timecode.
+        FeedFrameHDR,           // Timecode.
+        ScheduleFrame,          // Frame number.
+        RenderAudioSamples,     // Buffered sample frames.
+        Copy,                   // Bytes.
+        Pack,                   // Bytes.
+        OpenDevice,             // Device index.
+        CloseDevice,            // Device index.
+
+        Count
+    };
+
+    // Forwards the samples of the plugin threads to the Unity Profiler, when Unity provides it
+    // and the profiler is available (development builds and the Editor). Otherwise every call
+    // returns right away.
+    class DeckLinkProfiler final
+    {
+    public:
+        static void Initialize(IUnityProfiler* profiler);
+        static void Shutdown();
+
+        // Registers the calling thread under the plugin group, and names it in the trace; the
+        // threads of the plugin when they start.
+        static void RegisterThread(const char* name);
+        static void UnregisterThread();
+
+        // Registers the calling DeckLink callback thread on the first callback for the device
+        // 'owner'. The threads are unregistered once no device they called back uses them.
+        static void RegisterCallbackThread(const char* name, const void* owner);
+        static void UnregisterCallbackThreads(const void* owner);
+
+        // Returns false if the sample was not emitted, so the matching EndSample must be skipped.
+        // A sample which was begun is ended even if the profiler was shut down in between.
+        static bool BeginSample(EProfilerMarker marker);
+        static bool BeginSample(EProfilerMarker marker, std::int64_t value, std::uint64_t bytes);
+        static void EndSample(EProfilerMarker marker);
+
+    private:
+        static std::atomic<IUnityProfiler*>    s_Profiler;     // Null once shut down: no new sample.
+        static std::atomic<IUnityProfiler*>    s_Interface;    // Kept to end the samples and unregister the threads.
+        static const UnityProfilerMarkerDesc*  s_Markers[static_cast<int>(EProfilerMarker::Count)];
+    };
+
+    // Sample covering the enclosing scope.
+    class ProfilerSample final
+    {
+    public:
+        explicit ProfilerSample(const EProfilerMarker marker) :
+            m_Marker(marker),
+            m_Begun(DeckLinkProfiler::BeginSample(marker))
+        {
+        }
+
+        ProfilerSample(const EProfilerMarker marker, const std::int64_t value, const std::uint64_t bytes = 0) :
+            m_Marker(marker),
+            m_Begun(DeckLinkProfiler::BeginSample(marker, value, bytes))
+        {
+        }
+
+        ~ProfilerSample()
+        {
+            if (m_Begun)
+                DeckLinkProfiler::EndSample(m_Marker);
+        }
+
+        ProfilerSample(const ProfilerSample&) = delete;
+        ProfilerSample& operator=(const ProfilerSample&) = delete;
+
+    private:
+        const EProfilerMarker m_Marker;
+        const bool            m_Begun;
+    };
+
+    // Registration of a thread owned by the plugin, for its lifetime.
+    class ProfilerThreadScope final
+    {
+    public:
+        explicit ProfilerThreadScope(const char* name) { DeckLinkProfiler::RegisterThread(name); }
+        ~ProfilerThreadScope() { DeckLinkProfiler::UnregisterThread(); }
+
+        ProfilerThreadScope(const ProfilerThreadScope&) = delete;
+        ProfilerThreadScope& operator=(const ProfilerThreadScope&) = delete;
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../Common.h"
+#include "DeckLinkDeviceStatus.h"
+
+namespace MediaBlackmagic
+{
+    // Copy of the last status sampled from a card. The layout is shared with the managed
+    // DeckLinkHealth struct.
+    struct DeckLinkHealth
+    {
+        std::int64_t  sampleTime;         // Steady clock time of the last sample, in nanoseconds.
+        std::int64_t  referencePhase;     // Output frame boundary against the host clock, in flicks (-1 if unknown).
+        std::uint32_t sampleCount;
+        std::int32_t  referenceLocked;
+        std::int32_t  referenceMode;      // BMDDisplayMode of the reference signal.
+        std::int32_t  inputSignalLocked;
+        std::int32_t  inputPixelFormat;
+        std::int32_t  outputPixelFormat;
+        std::int32_t  temperature;        // Degrees Celsius.
+        std::int32_t  busy;               // BMDDeviceBusyState
+    };
+
+    enum class EHealthEvent
+    {
+        ReferenceLocked,
+        ReferenceLost,
+        ReferencePhaseJump,
+        InputSignalLocked,
+        InputSignalLost
+    };
+
+    struct DeckLinkHealthEvent
+    {
+        std::int64_t  time;               // Steady clock time, in nanoseconds.
+        std::int32_t  type;               // EHealthEvent
+        std::int32_t  reserved;
+        std::int64_t  value;              // Phase jump in flicks, 0 otherwise.
+    };
+
+    // Low-priority thread sampling the IDeckLinkStatus of a card at a fixed rate. The input and
+    // output devices of a card share the poller, and read the last sample without a lock or a
+    // driver round-trip. Changes of the reference lock, reference phase and input signal lock
+    // are kept in a bounded history.
+    class DeckLinkStatusPoller final
+    {
+    public:
+        // Returns the poller of the card, starting it on first use. Null if the card has no status.
+        static DeckLinkStatusPoller* Acquire(IDeckLink* device, int deviceSelected);
+        void Release();
+
+        static void SetPollingInterval(int intervalMs);
+
+        // The poller publishes the reference lock of the card into the status blocks of its
+        // devices. A block is detached before its device releases the poller.
+        void AttachStatus(DeckLinkDeviceStatus* status);
+        void DetachStatus(DeckLinkDeviceStatus* status);
+
+        DeckLinkHealth GetHealth() const;
+
+        inline bool IsReferenceLocked() const { return m_ReferenceLocked.load(std::memory_order_relaxed) != 0; }
+        inline BMDPixelFormat GetOutputPixelFormat() const { return static_cast<BMDPixelFormat>(m_OutputPixelFormat.load(std::memory_order_relaxed)); }
+
+        // Copies up to 'capacity' events, oldest first, and returns the number copied.
+        int CopyHistory(DeckLinkHealthEvent* events, int capacity) const;
+
+    private:
+        static const int kDefaultPollingIntervalMs = 100;
+        static const std::size_t kMaxHistory = 256;
+
+        // A phase step larger than this fraction of a frame is a jump rather than jitter or drift.
+        static const int kPhaseJumpDivisor = 8;
+
+        static std::mutex                               s_RegistryMutex;
+        static std::map<int, DeckLinkStatusPoller*>     s_Registry;
+        static std::atomic<int>                         s_PollingIntervalMs;
+
+        DeckLinkStatusPoller(int deviceSelected, IDeckLinkStatus* status, IDeckLinkOutput* output);
+        ~DeckLinkStatusPoller();
+
+        void Run();
+        void Sample();
+        void Record(EHealthEvent type, std::int64_t value, std::int64_t time);
+
+        int                         m_DeviceSelected;
+        int                         m_RefCount;
+        IDeckLinkStatus*            m_Status;
+        IDeckLinkOutput*            m_Output;
+
+        std::mutex                  m_Mutex;
+        std::condition_variable     m_Condition;
+        bool                        m_Stopping;
+        std::thread                 m_Thread;
+
+        std::atomic<std::int64_t>   m_SampleTime;
+        std::atomic<std::int64_t>   m_ReferencePhase;
+        std::atomic<std::uint32_t>  m_SampleCount;
+        std::atomic<std::int32_t>   m_ReferenceLocked;
+        std::atomic<std::int32_t>   m_ReferenceMode;
+        std::atomic<std::int32_t>   m_InputSignalLocked;
+        std::atomic<std::int32_t>   m_InputPixelFormat;
+        std::atomic<std::int32_t>   m_OutputPixelFormat;
+        std::atomic<std::int32_t>   m_Temperature;
+        std::atomic<std::int32_t>   m_Busy;
+
+        mutable std::mutex              m_HistoryMutex;
+        std::deque<DeckLinkHealthEvent> m_History;
+
+        std::mutex                          m_StatusesMutex;
+        std::vector<DeckLinkDeviceStatus*>  m_Statuses;
+    };
+}
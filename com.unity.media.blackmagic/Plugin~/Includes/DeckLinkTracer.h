@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "DeckLinkEventRing.h"
+
+namespace MediaBlackmagic
+{
+    // Spans of the capture and playout pipeline. The values are shared with the managed TraceSpan enum.
+    enum class ETraceSpan
+    {
+        InputCallback = 0,      // VideoInputFrameArrived, where the flow of a captured frame starts.
+        ManagedDelivery,        // The frame arrived callback into the managed code.
+        TextureUpdate,          // The render thread texture update of the input.
+        Readback,               // The GPU readback of the output, recorded by the managed code.
+        FeedFrame,              // The copy of a frame into the output.
+        ScheduleFrame,          // ScheduleVideoFrame.
+        FrameCompleted,         // ScheduledFrameCompleted, where the flow ends.
+        PassthroughCopy,        // The copy of a captured frame into its passthrough route.
+
+        Count
+    };
+
+    // Optional timeline of the pipeline. Each span is written into a preallocated ring without
+    // locking, and carries the flow ID of its frame: the ID given to a frame on capture follows
+    // it through the texture update, the readback and the output, so one frame can be followed
+    // from glass to glass. When the tracer is disabled, a span costs a relaxed atomic load.
+    class DeckLinkTracer final
+    {
+    public:
+        // Starts recording into a ring of 'capacity' spans; the oldest spans are overwritten.
+        // The ring is allocated on the first call and kept until the plugin is unloaded.
+        static bool Enable(int capacity);
+        static void Disable();
+        static inline bool IsEnabled() { return s_Events.IsEnabled(); }
+
+        // Steady clock time in nanoseconds, the time base of the spans.
+        static std::int64_t Now();
+
+        static std::uint64_t NewFlow();
+
+        // Flow of the input frame uploaded last, which the next output frames continue.
+        static inline void SetCurrentFlow(std::uint64_t flow) { s_CurrentFlow.store(flow, std::memory_order_relaxed); }
+        static inline std::uint64_t GetCurrentFlow() { return s_CurrentFlow.load(std::memory_order_relaxed); }
+
+        static void Record(ETraceSpan span, int deviceIndex, std::uint64_t flow, std::int64_t begin, std::int64_t end);
+
+        // Names the calling thread in the trace, from its first span on. The name must outlive the
+        // thread, as a literal does.
+        static void NameThread(const char* name);
+
+        // Writes the recorded spans as a Chrome JSON trace, which the Perfetto UI also opens.
+        // Returns the number of spans written, or -1 if the file can't be written.
+        static int Write(const char* path);
+
+    private:
+        struct Event
+        {
+            std::int64_t    begin;
+            std::int64_t    end;
+            std::uint64_t   flow;
+            std::uint32_t   threadId;
+            std::int16_t    span;
+            std::int16_t    deviceIndex;
+        };
+
+        static std::uint32_t GetThreadId();
+        static void RecordThreadName();
+
+        static DeckLinkEventRing<Event>     s_Events;
+        static std::atomic<std::uint64_t>   s_NextFlow;
+        static std::atomic<std::uint64_t>   s_CurrentFlow;
+        static std::atomic<std::uint32_t>   s_NextThreadId;
+
+        static std::mutex                                       s_Mutex;
+        static std::unordered_map<std::uint32_t, std::string>   s_ThreadNames;
+    };
+
+    // Span covering the enclosing scope, recorded only if the tracer is enabled on entry.
+    class TraceSpan final
+    {
+    public:
+        TraceSpan(const ETraceSpan span, const int deviceIndex, const std::uint64_t flow) :
+            m_Span(span),
+            m_DeviceIndex(deviceIndex),
+            m_Flow(flow),
+            m_Begin(DeckLinkTracer::IsEnabled() ? DeckLinkTracer::Now() : 0)
+        {
+        }
+
+        ~TraceSpan()
+        {
+            if (m_Begin != 0)
+                DeckLinkTracer::Record(m_Span, m_DeviceIndex, m_Flow, m_Begin, DeckLinkTracer::Now());
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+        inline void SetFlow(std::uint64_t flow) { m_Flow = flow; }
+
+    private:
+        const ETraceSpan    m_Span;
+        const int           m_DeviceIndex;
+        std::uint64_t       m_Flow;
+        const std::int64_t  m_Begin;
+    };
+}
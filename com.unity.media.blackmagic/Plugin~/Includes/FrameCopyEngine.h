@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include "../Common.h"
+
+namespace MediaBlackmagic
+{
+    // Instruction sets of the copy kernels.
+    enum class ECopyKernel
+    {
+        Memcpy,     // std::memcpy, for the copies below the streaming threshold.
+        SSE2,
+        AVX2,
+        AVX512,
+        NEON,
+
+        Count
+    };
+
+    // Copies the frames fed by Unity into the frames of the driver. The frame-sized copies use
+    // non-temporal stores and prefetch the source ahead, so they don't evict the working set of the
+    // render thread from the last-level cache; the kernel is chosen at runtime from the instruction
+    // sets of the CPU. A copy is split at page boundaries into chunks, which the worker threads of
+    // a pool shared by every engine of the process and the calling thread take in turn. While
+    // another engine uses the workers, the calling thread copies alone.
+    //
+    // The thread count and the chunk size are tuned per frame size, for every engine at once: the
+    // first copy of a size starts a thread which measures each candidate on scratch buffers, and
+    // the copies run on the calling thread alone until the fastest candidate is known.
+    class FrameCopyEngine final
+    {
+    public:
+        // Smaller copies stay in the cache, as the data is likely read again soon.
+        static const std::size_t k_StreamingThreshold = 1 << 20;
+        static const std::size_t k_PageBytes = 4096;
+        static const int k_MaxThreads = 8;      // With the calling thread.
+
+        FrameCopyEngine();
+        ~FrameCopyEngine();
+
+        FrameCopyEngine(const FrameCopyEngine&) = delete;
+        FrameCopyEngine& operator=(const FrameCopyEngine&) = delete;
+
+        // Thread-safe. A copy which overlaps another one, of any engine, runs on the calling thread alone.
+        void Copy(void* destination, const void* source, std::size_t bytes);
+
+        // Gets the settings tuned for the size. Returns false while the size is being tuned.
+        bool GetTuning(std::size_t bytes, int& threadCount, std::size_t& chunkBytes) const;
+
+        // Uses the given settings for every size instead of the tuned ones; a thread count of 0
+        // uses the tuned ones again.
+        void SetFixedTuning(int threadCount, std::size_t chunkBytes);
+
+        // The fastest kernel the CPU and the operating system support.
+        static ECopyKernel GetKernel();
+        static bool IsKernelSupported(ECopyKernel kernel);
+        static const char* GetKernelName(ECopyKernel kernel);
+
+        // Copies on the calling thread with the given kernel, which has to be supported.
+        static void CopyWithKernel(ECopyKernel kernel, void* destination, const void* source, std::size_t bytes);
+
+    private:
+        // The worker threads and the tunings, shared by the engines.
+        class Pool;
+
+        Pool* const                 m_Pool;
+
+        mutable std::mutex          m_Mutex;
+        int                         m_FixedThreadCount;
+        std::size_t                 m_FixedChunkBytes;
+    };
+}
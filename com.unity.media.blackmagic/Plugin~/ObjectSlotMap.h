@@ -0,0 +1,179 @@
+#pragma once
+
+#include "Common.h"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace MediaBlackmagic
+{
+    // Binds object pointers to generational integer IDs.
+    // An ID packs a slot index with the generation of the slot, so an ID which outlived its
+    // object resolves to nothing instead of to whatever reuses the slot. A slot whose generation
+    // would wrap around is retired rather than reused. Lookups by ID are
+    // lock-free and pin the object, and removing an object waits until it is no longer pinned,
+    // so a reader (e.g. the render thread) never sees an object being destroyed. Add and Remove
+    // are serialized between themselves only.
+    template <typename T, std::size_t Capacity = 256> class ObjectSlotMap final
+    {
+        static constexpr std::uint32_t CountIndexBits(const std::size_t capacity)
+        {
+            return capacity <= 1 ? 0 : 1 + CountIndexBits((capacity + 1) / 2);
+        }
+
+        // The index takes as few bits as the capacity needs, the generation the rest of a
+        // positive int.
+        static const std::uint32_t k_IndexBits = CountIndexBits(Capacity);
+        static const std::uint32_t k_IndexMask = (1u << k_IndexBits) - 1;
+        static const std::uint32_t k_GenerationMask = (1u << (31 - k_IndexBits)) - 1;
+
+        static_assert(Capacity > 0 && k_IndexBits <= 16, "The slot index must leave room for the generation.");
+
+        struct Slot
+        {
+            Slot() : generation(0), object(nullptr), pins(0) {}
+
+            std::atomic<std::uint32_t>          generation;     // Odd while the slot is in use.
+            std::atomic<T*>                     object;
+            mutable std::atomic<std::uint32_t>  pins;
+        };
+
+    public:
+        // Object resolved from an ID, pinned until the end of the scope.
+        class Pinned final
+        {
+        public:
+            Pinned() : m_Slot(nullptr), m_Object(nullptr) {}
+            Pinned(const Slot* slot, T* object) : m_Slot(slot), m_Object(object) {}
+            Pinned(Pinned&& other) : m_Slot(other.m_Slot), m_Object(other.m_Object)
+            {
+                other.m_Slot = nullptr;
+                other.m_Object = nullptr;
+            }
+            ~Pinned()
+            {
+                if (m_Slot != nullptr)
+                    m_Slot->pins.fetch_sub(1, std::memory_order_release);
+            }
+
+            Pinned(const Pinned&) = delete;
+            Pinned& operator=(const Pinned&) = delete;
+            Pinned& operator=(Pinned&&) = delete;
+
+            inline T* Get() const { return m_Object; }
+            inline T* operator->() const { return m_Object; }
+            inline explicit operator bool() const { return m_Object != nullptr; }
+
+        private:
+            const Slot* m_Slot;
+            T*          m_Object;
+        };
+
+        ObjectSlotMap() : count_(0)
+        {
+            freeSlots_.reserve(Capacity);
+            for (auto i = Capacity; i > 0; --i)
+                freeSlots_.push_back(static_cast<std::uint32_t>(i - 1));
+        }
+
+        // Returns the ID of the object, or 0 when every slot is in use or retired.
+        int Add(T* instance)
+        {
+            std::lock_guard<std::mutex> lock(writeMutex_);
+
+            if (instance == nullptr || freeSlots_.empty())
+                return 0;
+
+            const auto index = freeSlots_.back();
+            freeSlots_.pop_back();
+
+            auto& slot = slots_[index];
+            slot.object.store(instance, std::memory_order_relaxed);
+            const auto generation = slot.generation.load(std::memory_order_relaxed) + 1;
+            slot.generation.store(generation, std::memory_order_release);
+
+            const auto id = MakeID(index, generation);
+            ids_[instance] = id;
+            count_.fetch_add(1, std::memory_order_relaxed);
+            return id;
+        }
+
+        // Waits until no reader has the object pinned.
+        void Remove(T* instance)
+        {
+            std::lock_guard<std::mutex> lock(writeMutex_);
+
+            auto it = ids_.find(instance);
+            if (it == ids_.end())
+                return;
+
+            const auto index = static_cast<std::uint32_t>(it->second) & k_IndexMask;
+            ids_.erase(it);
+
+            auto& slot = slots_[index];
+            const auto generation = slot.generation.fetch_add(1, std::memory_order_seq_cst) + 1;
+            slot.object.store(nullptr, std::memory_order_relaxed);
+
+            while (slot.pins.load(std::memory_order_seq_cst) != 0)
+                std::this_thread::yield();
+
+            // The next generation would repeat the IDs of the first ones.
+            if (generation < k_GenerationMask)
+                freeSlots_.push_back(index);
+            count_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Lock-free: never blocks and doesn't allocate.
+        Pinned Acquire(int id) const
+        {
+            const auto index = static_cast<std::uint32_t>(id) & k_IndexMask;
+            if (id == 0 || index >= Capacity)
+                return Pinned();
+
+            const auto& slot = slots_[index];
+            slot.pins.fetch_add(1, std::memory_order_seq_cst);
+
+            const auto generation = slot.generation.load(std::memory_order_seq_cst);
+            if ((generation & 1) != 0 && MakeID(index, generation) == id)
+            {
+                const auto object = slot.object.load(std::memory_order_acquire);
+                if (object != nullptr)
+                    return Pinned(&slot, object);
+            }
+
+            slot.pins.fetch_sub(1, std::memory_order_release);
+            return Pinned();
+        }
+
+        // Returns the ID of the object, or 0 if it isn't in the map.
+        int GetID(T* instance) const
+        {
+            std::lock_guard<std::mutex> lock(writeMutex_);
+
+            auto it = ids_.find(instance);
+            return it != ids_.end() ? it->second : 0;
+        }
+
+        size_t ObjectCount() const
+        {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static inline int MakeID(const std::uint32_t index, const std::uint32_t generation)
+        {
+            // Generations in use are odd, so an ID is never 0.
+            return static_cast<int>(((generation & k_GenerationMask) << k_IndexBits) | index);
+        }
+
+        std::array<Slot, Capacity>          slots_;
+        std::atomic<std::size_t>            count_;
+
+        mutable std::mutex                  writeMutex_;
+        std::vector<std::uint32_t>          freeSlots_;
+        std::unordered_map<T*, int>         ids_;
+    };
+}
@@ -10,6 +10,7 @@
 
 #include "BlackmagicPluginEvents.h"
 #include "PluginUtils.h"
+#include "DeckLinkLogger.h"
 #include "DeckLinkOutputDevice.h"
 
 enum class BlackmagicOutputEventID
@@ -27,6 +28,7 @@ namespace MediaBlackmagic
     static IUnknown*               s_GraphicsDevice = nullptr;
     static bool                    s_Initialized = false;
     static std::atomic<bool>       s_IsGPUDirectAvailable = false;
+    static LogRateLimit            s_RenderEventLogLimit(1000);
 
 #pragma region Low Level Plugin Interface
     void OnPluginLoadGraphics(IUnityInterfaces* unityInterfaces)
@@ -63,7 +65,7 @@ namespace MediaBlackmagic
             s_GraphicsDevice = s_UnityGraphicsD3D11->GetDevice();
             return true;
         default:
-            MediaBlackmagic::WriteFileDebug("Error, graphics API not supported.\n");
+            MediaBlackmagic::DeckLinkLogger::Log(MediaBlackmagic::ELogSeverity::Error, "GPUDirect: the graphics API %d is not supported.", static_cast<int>(renderer));
             return false;
         }
     }
@@ -134,13 +136,13 @@ namespace MediaBlackmagic
     {
         if (!data)
         {
-            MediaBlackmagic::WriteFileDebug("Error, Data send is null.\n");
+            MediaBlackmagic::DeckLinkLogger::Log(s_RenderEventLogLimit, MediaBlackmagic::ELogSeverity::Error, "GPUDirect: render event without data.");
             return false;
         }
 
         if (!s_GraphicsDevice)
         {
-            MediaBlackmagic::WriteFileDebug("Error, s_D3D11Device is null.\n");
+            MediaBlackmagic::DeckLinkLogger::Log(s_RenderEventLogLimit, MediaBlackmagic::ELogSeverity::Error, "GPUDirect: render event without a D3D11 device.");
             return false;
         }
 
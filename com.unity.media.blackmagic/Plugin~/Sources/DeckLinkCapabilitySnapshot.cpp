@@ -0,0 +1,470 @@
+#include <cstring>
+#include <future>
+
+#include "DeckLinkCapabilitySnapshot.h"
+#include "DeckLinkDeviceUtilities.h"
+
+namespace MediaBlackmagic
+{
+    std::mutex DeckLinkCapabilitySnapshot::s_BuildMutex;
+    std::mutex DeckLinkCapabilitySnapshot::s_Mutex;
+    DeckLinkCapabilitySnapshot::Pointer DeckLinkCapabilitySnapshot::s_Current;
+    std::atomic<bool> DeckLinkCapabilitySnapshot::s_Stale(true);
+    std::uint32_t DeckLinkCapabilitySnapshot::s_Generation = 0;
+
+    namespace
+    {
+        const int kPixelFormatCount = sizeof(kPixelFormatMappings) / sizeof(kPixelFormatMappings[0]) - 1;
+
+        static_assert(kPixelFormatCount <= 32, "The pixel format masks hold 32 formats.");
+
+        std::int64_t GetAttributeInt(IDeckLinkProfileAttributes* attributes, const BMDDeckLinkAttributeID id, const std::int64_t fallback)
+        {
+            dllonglong value = 0;
+            return attributes->GetInt(id, &value) == S_OK ? static_cast<std::int64_t>(value) : fallback;
+        }
+
+        bool GetAttributeFlag(IDeckLinkProfileAttributes* attributes, const BMDDeckLinkAttributeID id)
+        {
+            dlbool_t value = false;
+            return attributes->GetFlag(id, &value) == S_OK && value;
+        }
+
+        ModeCapabilities DescribeMode(IDeckLinkDisplayMode* mode)
+        {
+            ModeCapabilities capabilities;
+            capabilities.displayMode = mode->GetDisplayMode();
+            capabilities.width = static_cast<std::int32_t>(mode->GetWidth());
+            capabilities.height = static_cast<std::int32_t>(mode->GetHeight());
+            capabilities.fieldDominance = static_cast<std::int32_t>(mode->GetFieldDominance());
+
+            BMDTimeValue frameDuration = 0;
+            BMDTimeScale timeScale = 0;
+            mode->GetFrameRate(&frameDuration, &timeScale);
+            capabilities.frameDuration = frameDuration;
+            capabilities.timeScale = timeScale;
+
+            capabilities.pixelFormats = 0;
+            capabilities.keyingPixelFormats = 0;
+            return capabilities;
+        }
+
+        void QueryInputModes(IDeckLink* device, std::vector<ModeCapabilities>& modes)
+        {
+            DeckLinkInput* input = nullptr;
+            if (device->QueryInterface(IID_DeckLinkInput, reinterpret_cast<void**>(&input)) != S_OK)
+                return;
+
+            IDeckLinkDisplayModeIterator* iterator = nullptr;
+            if (input->GetDisplayModeIterator(&iterator) == S_OK)
+            {
+                IDeckLinkDisplayMode* mode;
+                while (iterator->Next(&mode) == S_OK)
+                {
+                    auto capabilities = DescribeMode(mode);
+                    mode->Release();
+
+                    for (auto i = 0; i < kPixelFormatCount; i++)
+                    {
+                        dlbool_t supported = false;
+                        if (input->DoesSupportVideoMode(
+                                bmdVideoConnectionUnspecified,
+                                capabilities.displayMode,
+                                static_cast<BMDPixelFormat>(kPixelFormatMappings[i].id),
+                                bmdNoVideoInputConversion,
+                                bmdSupportedVideoModeDefault,
+                                nullptr,
+                                &supported) == S_OK && supported)
+                        {
+                            capabilities.pixelFormats |= 1u << i;
+                        }
+                    }
+
+                    modes.push_back(capabilities);
+                }
+                iterator->Release();
+            }
+
+            input->Release();
+        }
+
+        void QueryOutputModes(IDeckLink* device, const bool keying, std::vector<ModeCapabilities>& modes)
+        {
+            IDeckLinkOutput* output = nullptr;
+            if (device->QueryInterface(IID_IDeckLinkOutput, reinterpret_cast<void**>(&output)) != S_OK)
+                return;
+
+            IDeckLinkDisplayModeIterator* iterator = nullptr;
+            if (output->GetDisplayModeIterator(&iterator) == S_OK)
+            {
+                IDeckLinkDisplayMode* mode;
+                while (iterator->Next(&mode) == S_OK)
+                {
+                    auto capabilities = DescribeMode(mode);
+                    mode->Release();
+
+                    for (auto i = 0; i < kPixelFormatCount; i++)
+                    {
+                        const auto pixelFormat = static_cast<BMDPixelFormat>(kPixelFormatMappings[i].id);
+
+                        dlbool_t supported = false;
+                        if (output->DoesSupportVideoMode(
+                                bmdVideoConnectionUnspecified,
+                                capabilities.displayMode,
+                                pixelFormat,
+                                bmdNoVideoOutputConversion,
+                                bmdSupportedVideoModeDefault,
+                                nullptr,
+                                &supported) == S_OK && supported)
+                        {
+                            capabilities.pixelFormats |= 1u << i;
+                        }
+
+                        supported = false;
+                        if (keying && output->DoesSupportVideoMode(
+                                bmdVideoConnectionUnspecified,
+                                capabilities.displayMode,
+                                pixelFormat,
+                                bmdNoVideoOutputConversion,
+                                bmdSupportedVideoModeKeying,
+                                nullptr,
+                                &supported) == S_OK && supported)
+                        {
+                            capabilities.keyingPixelFormats |= 1u << i;
+                        }
+                    }
+
+                    modes.push_back(capabilities);
+                }
+                iterator->Release();
+            }
+
+            output->Release();
+        }
+
+        const ModeCapabilities* FindMode(const std::vector<ModeCapabilities>& modes, const BMDDisplayMode displayMode)
+        {
+            for (const auto& mode : modes)
+            {
+                if (mode.displayMode == displayMode)
+                    return &mode;
+            }
+            return nullptr;
+        }
+
+        // Appends an array to the flat layout, and returns its offset.
+        std::int32_t Reserve(std::size_t& size, const std::size_t elementSize, const std::size_t count)
+        {
+            size = (size + elementSize - 1) / elementSize * elementSize;
+            const auto offset = static_cast<std::int32_t>(size);
+            size += elementSize * count;
+            return offset;
+        }
+
+        template <typename T>
+        inline T* ArrayAt(std::vector<std::uint8_t>& buffer, const std::int32_t offset)
+        {
+            return reinterpret_cast<T*>(buffer.data() + offset);
+        }
+    }
+
+    DeckLinkCapabilitySnapshot::Pointer DeckLinkCapabilitySnapshot::Get()
+    {
+        std::lock_guard<std::mutex> buildLock(s_BuildMutex);
+
+        // Clear the flag first, so an invalidation during the build isn't lost.
+        const auto stale = s_Stale.exchange(false);
+        if (stale || GetCurrent() == nullptr)
+        {
+            auto snapshot = Build(++s_Generation);
+
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            s_Current = std::move(snapshot);
+        }
+        return GetCurrent();
+    }
+
+    DeckLinkCapabilitySnapshot::Pointer DeckLinkCapabilitySnapshot::GetCurrent()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        return s_Current;
+    }
+
+    void DeckLinkCapabilitySnapshot::RefreshIfStale()
+    {
+        if (s_Stale.load())
+            Get();
+    }
+
+    void DeckLinkCapabilitySnapshot::Invalidate()
+    {
+        s_Stale.store(true);
+    }
+
+    int DeckLinkCapabilitySnapshot::GetPixelFormatBit(const BMDPixelFormat pixelFormat)
+    {
+        for (auto i = 0; i < kPixelFormatCount; i++)
+        {
+            if (kPixelFormatMappings[i].id == static_cast<unsigned int>(pixelFormat))
+                return i;
+        }
+        return -1;
+    }
+
+    DeckLinkCapabilitySnapshot::Pointer DeckLinkCapabilitySnapshot::Build(const std::uint32_t generation)
+    {
+        std::vector<IDeckLink*> cards;
+
+        IDeckLinkIterator* iterator;
+        if (GetDeckLinkIterator(&iterator) == S_OK)
+        {
+            IDeckLink* device;
+            while (iterator->Next(&device) == S_OK)
+                cards.push_back(device);
+            iterator->Release();
+        }
+
+        // Each card answers its own queries, so the cost is the one of the slowest card
+        // rather than the sum of all of them.
+        std::vector<std::future<DeviceCapabilities>> queries;
+        queries.reserve(cards.size());
+        for (auto card : cards)
+        {
+            queries.push_back(std::async(std::launch::async, [card]()
+            {
+#if defined(_WIN32)
+                // The driver is a COM server, which every thread calling it has to join.
+                const auto initialized = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+                auto capabilities = Query(card);
+#if defined(_WIN32)
+                if (SUCCEEDED(initialized))
+                    CoUninitialize();
+#endif
+                return capabilities;
+            }));
+        }
+
+        std::vector<DeviceCapabilities> devices;
+        devices.reserve(cards.size());
+        for (auto& query : queries)
+            devices.push_back(query.get());
+
+        return Pointer(new DeckLinkCapabilitySnapshot(generation, std::move(devices)));
+    }
+
+    DeviceCapabilities DeckLinkCapabilitySnapshot::Query(IDeckLink* device)
+    {
+        DeviceCapabilities capabilities;
+        capabilities.device = device;
+        capabilities.persistentId = 0;
+        capabilities.groupId = 0;
+        capabilities.duplex = static_cast<std::int32_t>(bmdDuplexInactive);
+        capabilities.videoIOSupport = 0;
+        capabilities.keying = 0;
+        capabilities.links = 0;
+        capabilities.inputFormatDetection = 0;
+
+        dlstring_t name;
+        if (device->GetDisplayName(&name) == S_OK)
+        {
+            capabilities.name = DlToStdString(name);
+            DeleteString(name);
+        }
+
+        IDeckLinkProfileAttributes* attributes = nullptr;
+        if (device->QueryInterface(IID_IDeckLinkProfileAttributes, reinterpret_cast<void**>(&attributes)) != S_OK)
+            return capabilities;
+
+        capabilities.persistentId = GetAttributeInt(attributes, BMDDeckLinkPersistentID, 0);
+        capabilities.groupId = GetAttributeInt(attributes, BMDDeckLinkDeviceGroupID, 0);
+        capabilities.duplex = static_cast<std::int32_t>(GetAttributeInt(attributes, BMDDeckLinkDuplex, bmdDuplexInactive));
+        capabilities.videoIOSupport = static_cast<std::int32_t>(GetAttributeInt(attributes, BMDDeckLinkVideoIOSupport, 0));
+
+        if (GetAttributeFlag(attributes, BMDDeckLinkSupportsInternalKeying))
+            capabilities.keying |= static_cast<std::int32_t>(ECapabilityKeying::Internal);
+        if (GetAttributeFlag(attributes, BMDDeckLinkSupportsExternalKeying))
+            capabilities.keying |= static_cast<std::int32_t>(ECapabilityKeying::External);
+
+        if (GetAttributeFlag(attributes, BMDDeckLinkSupportsDualLinkSDI))
+            capabilities.links |= static_cast<std::int32_t>(ECapabilityLink::DualLink);
+        if (GetAttributeFlag(attributes, BMDDeckLinkSupportsQuadLinkSDI))
+            capabilities.links |= static_cast<std::int32_t>(ECapabilityLink::QuadLink);
+
+        capabilities.inputFormatDetection = GetAttributeFlag(attributes, BMDDeckLinkSupportsInputFormatDetection) ? 1 : 0;
+
+        attributes->Release();
+
+        if (!capabilities.IsActive())
+            return capabilities;
+
+        if ((capabilities.videoIOSupport & bmdDeviceSupportsCapture) != 0)
+            QueryInputModes(device, capabilities.inputModes);
+
+        if ((capabilities.videoIOSupport & bmdDeviceSupportsPlayback) != 0)
+            QueryOutputModes(device, capabilities.keying != 0, capabilities.outputModes);
+
+        return capabilities;
+    }
+
+    DeckLinkCapabilitySnapshot::DeckLinkCapabilitySnapshot(const std::uint32_t generation, std::vector<DeviceCapabilities>&& devices) :
+        m_Generation(generation),
+        m_Devices(std::move(devices))
+    {
+        Flatten();
+    }
+
+    DeckLinkCapabilitySnapshot::~DeckLinkCapabilitySnapshot()
+    {
+        for (auto& device : m_Devices)
+        {
+            device.device->Release();
+            device.device = nullptr;
+        }
+    }
+
+    const DeviceCapabilities* DeckLinkCapabilitySnapshot::GetDevice(const int deviceSelected) const
+    {
+        if (deviceSelected < 0 || deviceSelected >= static_cast<int>(m_Devices.size()))
+            return nullptr;
+
+        return &m_Devices[deviceSelected];
+    }
+
+    bool DeckLinkCapabilitySnapshot::TryIsInputPixelFormatSupported(const int deviceSelected,
+                                                                    const BMDDisplayMode displayMode,
+                                                                    const BMDPixelFormat pixelFormat,
+                                                                    bool& supported) const
+    {
+        const auto device = GetDevice(deviceSelected);
+        const auto bit = GetPixelFormatBit(pixelFormat);
+        const auto mode = device != nullptr ? FindMode(device->inputModes, displayMode) : nullptr;
+        if (mode == nullptr || bit < 0)
+            return false;
+
+        supported = (mode->pixelFormats & (1u << bit)) != 0;
+        return true;
+    }
+
+    bool DeckLinkCapabilitySnapshot::TryIsOutputPixelFormatSupported(const int deviceSelected,
+                                                                     const BMDDisplayMode displayMode,
+                                                                     const BMDPixelFormat pixelFormat,
+                                                                     const bool keying,
+                                                                     bool& supported) const
+    {
+        const auto device = GetDevice(deviceSelected);
+        const auto bit = GetPixelFormatBit(pixelFormat);
+        const auto mode = device != nullptr ? FindMode(device->outputModes, displayMode) : nullptr;
+        if (mode == nullptr || bit < 0)
+            return false;
+
+        supported = ((keying ? mode->keyingPixelFormats : mode->pixelFormats) & (1u << bit)) != 0;
+        return true;
+    }
+
+    int DeckLinkCapabilitySnapshot::CopyTo(void* buffer, const int size) const
+    {
+        const auto totalSize = static_cast<int>(m_Flat.size());
+        if (buffer != nullptr && size >= totalSize)
+        {
+            std::memcpy(buffer, m_Flat.data(), m_Flat.size());
+        }
+        return totalSize;
+    }
+
+    void DeckLinkCapabilitySnapshot::Flatten()
+    {
+        const auto deviceCount = m_Devices.size();
+
+        auto modeCount = static_cast<std::size_t>(0);
+        auto namesSize = static_cast<std::size_t>(0);
+        for (const auto& device : m_Devices)
+        {
+            modeCount += device.inputModes.size() + device.outputModes.size();
+            namesSize += device.name.size() + 1;
+        }
+
+        // Layout first, then fill. The 64-bit arrays come first so that they stay aligned.
+        CapabilitySnapshotHeader header;
+        auto size = sizeof(CapabilitySnapshotHeader);
+
+        header.persistentIdOffset = Reserve(size, sizeof(std::int64_t), deviceCount);
+        header.groupIdOffset = Reserve(size, sizeof(std::int64_t), deviceCount);
+        header.frameDurationOffset = Reserve(size, sizeof(std::int64_t), modeCount);
+        header.timeScaleOffset = Reserve(size, sizeof(std::int64_t), modeCount);
+
+        header.pixelFormatsOffset = Reserve(size, sizeof(std::int32_t), kPixelFormatCount);
+        header.duplexOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.videoIOSupportOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.keyingOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.linksOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.inputFormatDetectionOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.nameOffsetOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.firstInputModeOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.inputModeCountOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.firstOutputModeOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+        header.outputModeCountOffset = Reserve(size, sizeof(std::int32_t), deviceCount);
+
+        header.displayModeOffset = Reserve(size, sizeof(std::int32_t), modeCount);
+        header.widthOffset = Reserve(size, sizeof(std::int32_t), modeCount);
+        header.heightOffset = Reserve(size, sizeof(std::int32_t), modeCount);
+        header.fieldDominanceOffset = Reserve(size, sizeof(std::int32_t), modeCount);
+        header.pixelFormatMaskOffset = Reserve(size, sizeof(std::uint32_t), modeCount);
+        header.keyingPixelFormatMaskOffset = Reserve(size, sizeof(std::uint32_t), modeCount);
+
+        auto nameOffset = Reserve(size, sizeof(char), namesSize);
+
+        header.totalSize = static_cast<std::int32_t>(size);
+        header.generation = m_Generation;
+        header.deviceCount = static_cast<std::int32_t>(deviceCount);
+        header.modeCount = static_cast<std::int32_t>(modeCount);
+        header.pixelFormatCount = kPixelFormatCount;
+
+        m_Flat.assign(size, 0);
+        std::memcpy(m_Flat.data(), &header, sizeof(header));
+
+        for (auto i = 0; i < kPixelFormatCount; i++)
+            ArrayAt<std::int32_t>(m_Flat, header.pixelFormatsOffset)[i] = static_cast<std::int32_t>(kPixelFormatMappings[i].id);
+
+        auto modeIndex = 0;
+        auto writeMode = [&](const ModeCapabilities& mode)
+        {
+            ArrayAt<std::int64_t>(m_Flat, header.frameDurationOffset)[modeIndex] = mode.frameDuration;
+            ArrayAt<std::int64_t>(m_Flat, header.timeScaleOffset)[modeIndex] = mode.timeScale;
+            ArrayAt<std::int32_t>(m_Flat, header.displayModeOffset)[modeIndex] = static_cast<std::int32_t>(mode.displayMode);
+            ArrayAt<std::int32_t>(m_Flat, header.widthOffset)[modeIndex] = mode.width;
+            ArrayAt<std::int32_t>(m_Flat, header.heightOffset)[modeIndex] = mode.height;
+            ArrayAt<std::int32_t>(m_Flat, header.fieldDominanceOffset)[modeIndex] = mode.fieldDominance;
+            ArrayAt<std::uint32_t>(m_Flat, header.pixelFormatMaskOffset)[modeIndex] = mode.pixelFormats;
+            ArrayAt<std::uint32_t>(m_Flat, header.keyingPixelFormatMaskOffset)[modeIndex] = mode.keyingPixelFormats;
+            modeIndex++;
+        };
+
+        for (auto i = static_cast<std::size_t>(0); i < deviceCount; i++)
+        {
+            const auto& device = m_Devices[i];
+
+            ArrayAt<std::int64_t>(m_Flat, header.persistentIdOffset)[i] = device.persistentId;
+            ArrayAt<std::int64_t>(m_Flat, header.groupIdOffset)[i] = device.groupId;
+            ArrayAt<std::int32_t>(m_Flat, header.duplexOffset)[i] = device.duplex;
+            ArrayAt<std::int32_t>(m_Flat, header.videoIOSupportOffset)[i] = device.videoIOSupport;
+            ArrayAt<std::int32_t>(m_Flat, header.keyingOffset)[i] = device.keying;
+            ArrayAt<std::int32_t>(m_Flat, header.linksOffset)[i] = device.links;
+            ArrayAt<std::int32_t>(m_Flat, header.inputFormatDetectionOffset)[i] = device.inputFormatDetection;
+
+            ArrayAt<std::int32_t>(m_Flat, header.nameOffsetOffset)[i] = nameOffset;
+            std::memcpy(m_Flat.data() + nameOffset, device.name.c_str(), device.name.size() + 1);
+            nameOffset += static_cast<std::int32_t>(device.name.size() + 1);
+
+            ArrayAt<std::int32_t>(m_Flat, header.firstInputModeOffset)[i] = modeIndex;
+            ArrayAt<std::int32_t>(m_Flat, header.inputModeCountOffset)[i] = static_cast<std::int32_t>(device.inputModes.size());
+            for (const auto& mode : device.inputModes)
+                writeMode(mode);
+
+            ArrayAt<std::int32_t>(m_Flat, header.firstOutputModeOffset)[i] = modeIndex;
+            ArrayAt<std::int32_t>(m_Flat, header.outputModeCountOffset)[i] = static_cast<std::int32_t>(device.outputModes.size());
+            for (const auto& mode : device.outputModes)
+                writeMode(mode);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#include <chrono>
+
+#include "DeckLinkCompletionEvent.h"
+#include "platform.h"
+
+namespace MediaBlackmagic
+{
+    std::atomic<std::uint32_t> DeckLinkCompletionEvent::s_Epoch(0);
+
+    DeckLinkCompletionEvent::DeckLinkCompletionEvent() :
+        m_CompletedFrames(0)
+    {
+    }
+
+    void DeckLinkCompletionEvent::Signal(const std::int64_t completedFrames)
+    {
+        m_CompletedFrames.store(completedFrames, std::memory_order_release);
+
+        s_Epoch.fetch_add(1, std::memory_order_acq_rel);
+        WakeAllOnAddress(&s_Epoch);
+    }
+
+    std::int64_t DeckLinkCompletionEvent::GetCompletedFrames() const
+    {
+        return m_CompletedFrames.load(std::memory_order_acquire);
+    }
+
+    bool DeckLinkCompletionEvent::Wait(const std::int64_t frameNumber, const int timeoutMs) const
+    {
+        return WaitUntil([=]() { return GetCompletedFrames() >= frameNumber; }, timeoutMs);
+    }
+
+    int DeckLinkCompletionEvent::WaitAny(const DeckLinkCompletionEvent* const* events,
+                                         const std::int64_t* frameNumbers,
+                                         const int count,
+                                         const int timeoutMs)
+    {
+        if (events == nullptr || frameNumbers == nullptr || count <= 0)
+            return -1;
+
+        auto index = -1;
+        WaitUntil([&]()
+        {
+            for (auto i = 0; i < count; ++i)
+            {
+                if (events[i] != nullptr && events[i]->GetCompletedFrames() >= frameNumbers[i])
+                {
+                    index = i;
+                    return true;
+                }
+            }
+            return false;
+        }, timeoutMs);
+
+        return index;
+    }
+
+    bool DeckLinkCompletionEvent::WaitAll(const DeckLinkCompletionEvent* const* events,
+                                          const std::int64_t* frameNumbers,
+                                          const int count,
+                                          const int timeoutMs)
+    {
+        if (events == nullptr || frameNumbers == nullptr || count <= 0)
+            return false;
+
+        return WaitUntil([&]()
+        {
+            for (auto i = 0; i < count; ++i)
+            {
+                if (events[i] == nullptr || events[i]->GetCompletedFrames() < frameNumbers[i])
+                    return false;
+            }
+            return true;
+        }, timeoutMs);
+    }
+
+    template<typename Predicate>
+    bool DeckLinkCompletionEvent::WaitUntil(const Predicate& predicate, const int timeoutMs)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        while (true)
+        {
+            // Read the epoch before the predicate, so a signal in between makes the wait return at once.
+            const auto epoch = s_Epoch.load(std::memory_order_acquire);
+
+            if (predicate())
+                return true;
+
+            auto remainingMs = -1;
+            if (timeoutMs >= 0)
+            {
+                const auto remaining = deadline - std::chrono::steady_clock::now();
+                remainingMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count());
+                if (remaining <= std::chrono::steady_clock::duration::zero())
+                    return false;
+
+                // Round up, so the last sub-millisecond slice doesn't spin.
+                remainingMs = remainingMs < 1 ? 1 : remainingMs;
+            }
+
+            WaitOnAddressValue(&s_Epoch, epoch, remainingMs);
+        }
+    }
+}
@@ -1,27 +1,33 @@
 #include <stdexcept>
 #include "DeckLinkDeviceDiscovery.h"
+#include "DeckLinkCapabilitySnapshot.h"
 #include "DeckLinkProfileCallback.h"
 #include "../Common.h"
 #include <algorithm>
+#include <chrono>
+#include <vector>
 
 namespace MediaBlackmagic
 {
     DeckLinkDeviceDiscovery::DeckLinkDeviceDiscovery() :
         m_deckLinkDiscovery(nullptr),
-        m_refCount(1),
         m_deviceArrivedCallback(nullptr),
         m_deviceRemovedCallback(nullptr),
         m_deviceNameArrivedCallback(nullptr),
-        m_deviceNameRemovedCallback(nullptr)
+        m_deviceNameRemovedCallback(nullptr),
+        m_deviceEventCallback(nullptr),
+        m_refCount(1),
+        m_NextFallbackID(0)
     {
     }
 
     DeckLinkDeviceDiscovery::~DeckLinkDeviceDiscovery()
     {
         for (auto& device : m_ActiveDevices)
-            device.Release();
+            device.second.Release();
 
         m_ActiveDevices.clear();
+        m_DeviceIDs.clear();
     }
 
     HRESULT DeckLinkDeviceDiscovery::DeckLinkDeviceArrived(IDeckLink* deckLink)
@@ -29,6 +35,10 @@ namespace MediaBlackmagic
         if (deckLink == nullptr)
             return S_OK;
 
+        DeckLinkCapabilitySnapshot::Invalidate();
+
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
         dlstring_t name;
         if (deckLink->GetDisplayName(&name) == S_OK)
         {
@@ -36,19 +46,52 @@ namespace MediaBlackmagic
 
             const auto stdName = DlToStdString(name);
 
-            m_ActiveDevices.emplace_back(deckLink, stdName);
-            auto& latestDevice = m_ActiveDevices.back();
+            int64_t id, groupID;
+            GetDeviceIDs(deckLink, &id, &groupID);
+
+            // A device reconnected without a removal notification replaces its previous entry.
+            auto previous = m_ActiveDevices.find(id);
+            if (previous != m_ActiveDevices.end())
+            {
+                m_DeviceIDs.erase(previous->second.device);
+                previous->second.Release();
+                m_ActiveDevices.erase(previous);
+            }
+
+            auto& latestDevice = m_ActiveDevices.emplace(id, DeviceInfo(deckLink, stdName)).first->second;
+            latestDevice.id = id;
+            latestDevice.groupID = groupID;
+            m_DeviceIDs[deckLink] = id;
+
+            // Activating the profile would force the streaming sub-devices of the card to stop:
+            // the card keeps its current profile, as its other sub-devices already know it.
+            if (!IsGroupBusy(groupID))
+            {
+                latestDevice.hasConnectorMapping = SetDeviceProfile(deckLink, latestDevice);
+            }
+            else
+            {
+                for (const auto& device : m_ActiveDevices)
+                {
+                    if (device.first != id && device.second.groupID == groupID)
+                    {
+                        latestDevice.hasConnectorMapping = device.second.hasConnectorMapping;
+                        latestDevice.compatibleProfiles = device.second.compatibleProfiles;
+                        break;
+                    }
+                }
+            }
 
-            const auto hasConnectorMapping = SetDeviceProfile(deckLink, latestDevice);
-            latestDevice.hasConnectorMapping = hasConnectorMapping;
+            latestDevice.deviceType = static_cast<int>(CheckDeckLinkDeviceType(deckLink));
 
             if (!stdName.empty())
             {
-                const auto deviceType = CheckDeckLinkDeviceType(deckLink);
-                m_deviceNameArrivedCallback(stdName.c_str(), static_cast<int>(deviceType));
+                m_deviceNameArrivedCallback(stdName.c_str(), latestDevice.deviceType);
             }
+            InvokeDeviceEvent(EDeviceEvent::Arrived, latestDevice);
 
-            m_ActiveDevices.sort();
+            // Only the other sub-devices of the card may have changed with its profile.
+            NotifyProfileChanges();
 
             DeleteString(name);
         }
@@ -61,21 +104,29 @@ namespace MediaBlackmagic
         if (deckLink == nullptr)
             return S_OK;
 
-        auto position = std::find(m_ActiveDevices.begin(), m_ActiveDevices.end(), deckLink);
-        m_ActiveDevices.erase(position);
-        deckLink->Release();
+        DeckLinkCapabilitySnapshot::Invalidate();
 
-        if (m_deviceNameRemovedCallback)
-        {
-            dlstring_t name;
-            deckLink->GetDisplayName(&name);
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
 
-            auto stdName = DlToStdString(name);
-            auto deviceType = CheckDeckLinkDeviceType(deckLink);
+        const auto id = m_DeviceIDs.find(deckLink);
+        if (id == m_DeviceIDs.end())
+            return S_OK;
 
-            m_deviceNameRemovedCallback(stdName.c_str(), static_cast<int>(deviceType));
-            DeleteString(name);
+        const auto position = m_ActiveDevices.find(id->second);
+        m_DeviceIDs.erase(id);
+        if (position == m_ActiveDevices.end())
+            return S_OK;
+
+        // The type announced on arrival: the removed device may already be inactive.
+        const auto& deviceInfo = position->second;
+        if (m_deviceNameRemovedCallback)
+        {
+            m_deviceNameRemovedCallback(deviceInfo.name.c_str(), deviceInfo.deviceType);
         }
+        InvokeDeviceEvent(EDeviceEvent::Removed, deviceInfo);
+
+        position->second.Release();
+        m_ActiveDevices.erase(position);
 
         return S_OK;
     }
@@ -106,6 +157,8 @@ namespace MediaBlackmagic
 
     void DeckLinkDeviceDiscovery::AddConnectorMapping(int64_t groupID, EConnectorMapping profile)
     {
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
         DeckLinkCardInfo cardInfo;
         cardInfo.connectorMapping = profile;
         cardInfo.groupID = groupID;
@@ -191,6 +244,8 @@ namespace MediaBlackmagic
 
     bool DeckLinkDeviceDiscovery::ChangeAllDevicesConnectorMapping(const EConnectorMapping profile, const int64_t groupID)
     {
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
         std::list<DeckLinkCardInfo>::iterator it;
         for (it = m_ConnectorMappings.begin(); it != m_ConnectorMappings.end(); ++it)
         {
@@ -203,8 +258,9 @@ namespace MediaBlackmagic
         auto queryDeckLinkConfigurationSucceed = true;
 
         // Change the active profile (Connector Mapping) for all devices
-        for (auto& deviceInfo : m_ActiveDevices)
+        for (auto& device : m_ActiveDevices)
         {
+            auto& deviceInfo = device.second;
             if (!IsDeviceMatchingGroupID(deviceInfo.device, groupID))
             {
                 ReloadDeckLinkDevicesEvent(*deviceInfo.device);
@@ -221,16 +277,348 @@ namespace MediaBlackmagic
             }
             ReloadDeckLinkDevicesEvent(*deviceInfo.device);
         }
+        NotifyProfileChanges();
 
         return queryDeckLinkConfigurationSucceed;
     }
 
+    int DeckLinkDeviceDiscovery::ChangeConnectorMappings(const int64_t* groupIDs,
+                                                         const EConnectorMapping* profiles,
+                                                         const int count,
+                                                         const int timeoutMs,
+                                                         ConnectorMappingResult* results)
+    {
+        using clock = std::chrono::steady_clock;
+
+        // The devices are looked up again by ID after each wait: they may have been removed or
+        // replaced by the notification thread meanwhile. Each switch holds the stored connector
+        // mapping it replaced, so a rollback only restores the entries this call changed.
+        struct ProfileSwitch
+        {
+            int64_t                     deviceID;
+            IDeckLinkProfileManager*    manager;
+            DeckLinkProfileCallback*    callback;
+            _BMDProfileID               previousProfileID;
+            bool                        changedConnectorMapping;
+            bool                        hadConnectorMapping;
+            EConnectorMapping           previousConnectorMapping;
+            clock::time_point           issueTime;
+        };
+
+        const auto isFailed = [](const ConnectorMappingResult& result)
+        {
+            return result.result == static_cast<int32_t>(EConnectorMappingResult::Refused) ||
+                   result.result == static_cast<int32_t>(EConnectorMappingResult::TimedOut);
+        };
+
+        const auto timeout = std::chrono::milliseconds(std::max(timeoutMs, 0));
+        std::vector<ProfileSwitch> switches(std::max(count, 0));
+
+        std::unique_lock<std::recursive_mutex> lock(m_DevicesMutex);
+
+        // Issue SetActive on every card first, so that the cards switch their profile in parallel.
+        for (int i = 0; i < count; ++i)
+        {
+            auto& profileSwitch = switches[i];
+            profileSwitch = ProfileSwitch{};
+
+            auto& result = results[i];
+            result.groupID = groupIDs[i];
+            result.elapsed = 0;
+            result.result = static_cast<int32_t>(EConnectorMappingResult::Incompatible);
+            result.rolledBack = 0;
+
+            // The profile of a card applies to all its sub-devices: the first one is enough.
+            auto device = std::find_if(m_ActiveDevices.begin(), m_ActiveDevices.end(),
+                [&](const std::pair<const int64_t, DeviceInfo>& entry) { return entry.second.groupID == groupIDs[i]; });
+
+            _BMDProfileID profileID;
+            if (device == m_ActiveDevices.end() || !TryGetConnectorMappingProfile(profiles[i], &profileID))
+                continue;
+
+            auto deviceInfo = &device->second;
+
+            IDeckLinkProfileManager* manager = nullptr;
+            if (deviceInfo->device->QueryInterface(IID_IDeckLinkProfileManager, (void**)&manager) != S_OK)
+                continue;
+
+            IDeckLinkProfile* profile = nullptr;
+            if (manager->GetProfile(profileID, &profile) != S_OK)
+            {
+                manager->Release();
+                continue;
+            }
+
+            // Stored before the switch: the sub-devices arriving in the new profile apply it again.
+            profileSwitch.deviceID = device->first;
+            profileSwitch.hadConnectorMapping = TryGetStoredConnectorMapping(groupIDs[i], profileSwitch.previousConnectorMapping);
+            if (!profileSwitch.hadConnectorMapping || profileSwitch.previousConnectorMapping != profiles[i])
+            {
+                profileSwitch.changedConnectorMapping = true;
+                SetConnectorMapping(groupIDs[i], profiles[i]);
+            }
+
+            dlbool_t isActive = false;
+            if (profile->IsActive(&isActive) == S_OK && isActive)
+            {
+                result.result = static_cast<int32_t>(EConnectorMappingResult::Unchanged);
+                profile->Release();
+                manager->Release();
+                continue;
+            }
+
+            // The active profile, to roll back the card if it fails.
+            IDeckLinkProfileAttributes* attributes = nullptr;
+            int64_t previousProfileID = 0;
+            if (deviceInfo->device->QueryInterface(IID_IDeckLinkProfileAttributes, (void**)&attributes) == S_OK)
+            {
+                attributes->GetInt(BMDDeckLinkProfileID, &previousProfileID);
+                attributes->Release();
+            }
+
+            profileSwitch.manager = manager;
+            profileSwitch.previousProfileID = static_cast<_BMDProfileID>(previousProfileID);
+            profileSwitch.callback = new DeckLinkProfileCallback(profile);
+            manager->SetCallback(profileSwitch.callback);
+
+            profileSwitch.issueTime = clock::now();
+            const auto activated = profile->SetActive();
+            result.result = static_cast<int32_t>(activated == S_OK ? EConnectorMappingResult::Activated : EConnectorMappingResult::Refused);
+
+            // We keep track of the new current profile, and we release the previous reference.
+            if (deviceInfo->deckLinkProfile != nullptr)
+            {
+                deviceInfo->deckLinkProfile->Release();
+            }
+            deviceInfo->deckLinkProfile = profile;
+        }
+
+        lock.unlock();
+
+        // Then wait for all the cards against a single deadline.
+        const auto deadline = clock::now() + timeout;
+        for (int i = 0; i < count; ++i)
+        {
+            auto& profileSwitch = switches[i];
+            auto& result = results[i];
+            if (result.result != static_cast<int32_t>(EConnectorMappingResult::Activated))
+                continue;
+
+            const auto activated = profileSwitch.callback->WaitForProfileActivation(deadline);
+            const auto end = activated ? profileSwitch.callback->GetActivationTime() : deadline;
+
+            result.elapsed = std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - profileSwitch.issueTime).count(), 0);
+            if (!activated)
+            {
+                result.result = static_cast<int32_t>(EConnectorMappingResult::TimedOut);
+            }
+        }
+
+        lock.lock();
+
+        // Restore the stored connector mappings of the failed cards, keyed by device: a card
+        // listed more than once ends up in the profile of its last switch, and gets back the
+        // mapping stored before its first one if that last switch failed.
+        for (int i = 0; i < count; ++i)
+        {
+            const auto deviceID = switches[i].deviceID;
+            if (deviceID == 0)
+                continue;
+
+            auto first = true;
+            auto changed = false;
+            auto last = i;
+            for (int j = 0; j < count; ++j)
+            {
+                if (switches[j].deviceID != deviceID)
+                    continue;
+
+                first &= j >= i;
+                changed |= switches[j].changedConnectorMapping;
+                last = j;
+            }
+
+            if (!first || !changed || !isFailed(results[last]))
+                continue;
+
+            const auto groupID = results[i].groupID;
+            if (switches[i].hadConnectorMapping)
+            {
+                SetConnectorMapping(groupID, switches[i].previousConnectorMapping);
+            }
+            else
+            {
+                m_ConnectorMappings.remove_if([groupID](const DeckLinkCardInfo& info) { return info.groupID == groupID; });
+            }
+        }
+
+        // Roll back the failed cards, again in parallel.
+        auto failedCount = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            auto& profileSwitch = switches[i];
+            auto& result = results[i];
+
+            if (!isFailed(result))
+                continue;
+
+            ++failedCount;
+
+            IDeckLinkProfile* previousProfile = nullptr;
+            if (profileSwitch.manager->GetProfile(profileSwitch.previousProfileID, &previousProfile) != S_OK)
+                continue;
+
+            profileSwitch.callback->Release();
+            profileSwitch.callback = new DeckLinkProfileCallback(previousProfile);
+            profileSwitch.manager->SetCallback(profileSwitch.callback);
+
+            dlbool_t isActive = false;
+            if ((previousProfile->IsActive(&isActive) == S_OK && isActive) || previousProfile->SetActive() == S_OK)
+            {
+                result.rolledBack = 1;
+            }
+
+            const auto device = m_ActiveDevices.find(profileSwitch.deviceID);
+            if (device == m_ActiveDevices.end())
+            {
+                previousProfile->Release();
+                continue;
+            }
+
+            auto& deviceInfo = device->second;
+            if (deviceInfo.deckLinkProfile != nullptr)
+            {
+                deviceInfo.deckLinkProfile->Release();
+            }
+            deviceInfo.deckLinkProfile = previousProfile;
+        }
+
+        lock.unlock();
+
+        const auto rollbackDeadline = clock::now() + timeout;
+        for (int i = 0; i < count; ++i)
+        {
+            auto& profileSwitch = switches[i];
+            if (results[i].rolledBack != 0 && !profileSwitch.callback->WaitForProfileActivation(rollbackDeadline))
+            {
+                results[i].rolledBack = 0;
+            }
+
+            if (profileSwitch.callback != nullptr)
+                profileSwitch.callback->Release();
+
+            if (profileSwitch.manager != nullptr)
+                profileSwitch.manager->Release();
+        }
+
+        lock.lock();
+
+        for (auto& device : m_ActiveDevices)
+        {
+            auto& deviceInfo = device.second;
+            ReloadDeckLinkDevicesEvent(*deviceInfo.device);
+        }
+        NotifyProfileChanges();
+
+        return failedCount;
+    }
+
+    void DeckLinkDeviceDiscovery::GetDeviceIDs(IDeckLink* const device, int64_t* id, int64_t* groupID)
+    {
+        *id = 0;
+        *groupID = 0;
+
+        IDeckLinkProfileAttributes* attributes = nullptr;
+        if (device->QueryInterface(IID_IDeckLinkProfileAttributes, (void**)&attributes) == S_OK)
+        {
+            if (attributes->GetInt(BMDDeckLinkPersistentID, id) != S_OK &&
+                attributes->GetInt(BMDDeckLinkTopologicalID, id) != S_OK)
+            {
+                *id = 0;
+            }
+
+            if (attributes->GetInt(BMDDeckLinkDeviceGroupID, groupID) != S_OK)
+            {
+                *groupID = 0;
+            }
+            attributes->Release();
+        }
+
+        // Without either attribute the device gets a negative ID of its own, which doesn't survive
+        // a reconnection.
+        if (*id == 0)
+        {
+            *id = --m_NextFallbackID;
+        }
+    }
+
+    bool DeckLinkDeviceDiscovery::IsGroupBusy(const int64_t groupID)
+    {
+        for (const auto& device : m_ActiveDevices)
+        {
+            if (device.second.groupID != groupID)
+                continue;
+
+            IDeckLinkStatus* status = nullptr;
+            if (device.second.device->QueryInterface(IID_IDeckLinkStatus, (void**)&status) != S_OK)
+                continue;
+
+            int64_t busy = 0;
+            const auto result = status->GetInt(bmdDeckLinkStatusBusy, &busy);
+            status->Release();
+
+            if (result == S_OK && (busy & (bmdDeviceCaptureBusy | bmdDevicePlaybackBusy)) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    void DeckLinkDeviceDiscovery::NotifyProfileChanges()
+    {
+        for (auto& device : m_ActiveDevices)
+        {
+            auto& deviceInfo = device.second;
+            const auto deviceType = static_cast<int>(CheckDeckLinkDeviceType(deviceInfo.device));
+            if (deviceType == deviceInfo.deviceType)
+                continue;
+
+            deviceInfo.deviceType = deviceType;
+            InvokeDeviceEvent(EDeviceEvent::ProfileChanged, deviceInfo);
+        }
+    }
+
+    void DeckLinkDeviceDiscovery::InvokeDeviceEvent(const EDeviceEvent event, const DeviceInfo& deviceInfo)
+    {
+        if (m_deviceEventCallback != nullptr)
+        {
+            m_deviceEventCallback(static_cast<int>(event), deviceInfo.id, deviceInfo.name.c_str(), deviceInfo.deviceType);
+        }
+    }
+
+    void DeckLinkDeviceDiscovery::SetConnectorMapping(const int64_t groupID, const EConnectorMapping profile)
+    {
+        auto cardInfo = std::find_if(m_ConnectorMappings.begin(), m_ConnectorMappings.end(),
+            [groupID](const DeckLinkCardInfo& info) { return info.groupID == groupID; });
+
+        if (cardInfo != m_ConnectorMappings.end())
+        {
+            cardInfo->connectorMapping = profile;
+        }
+        else
+        {
+            AddConnectorMapping(groupID, profile);
+        }
+    }
+
     bool DeckLinkDeviceDiscovery::IsLinkModeCompatible(const EOutputLinkMode linkMode, const int64_t groupID)
     {
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
         // Can be optimized, but this is the easier way to determine the compatibility of
         // a specific feature without having to create and instantiate a Device in C#.
-        for (auto& deviceInfo : m_ActiveDevices)
+        for (auto& device : m_ActiveDevices)
         {
+            auto& deviceInfo = device.second;
             if (!IsDeviceMatchingGroupID(deviceInfo.device, groupID))
                 continue;
 
@@ -242,10 +630,13 @@ namespace MediaBlackmagic
 
     bool DeckLinkDeviceDiscovery::IsKeyingModeCompatible(const EOutputKeyingMode keyingMode, const int64_t groupID)
     {
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
         // Can be optimized, but this is the easier way to determine the compatibility of
         // a specific feature without having to create and instantiate a Device in C#.
-        for (auto& deviceInfo : m_ActiveDevices)
+        for (auto& device : m_ActiveDevices)
         {
+            auto& deviceInfo = device.second;
             if (!IsDeviceMatchingGroupID(deviceInfo.device, groupID))
                 continue;
 
@@ -334,18 +725,22 @@ namespace MediaBlackmagic
             return false;
         }
 
+        deckLinkAttributes->Release();
+
+        return TryGetStoredConnectorMapping(groupID, profile);
+    }
+
+    bool DeckLinkDeviceDiscovery::TryGetStoredConnectorMapping(const int64_t groupID, EConnectorMapping& profile) const
+    {
         for (auto const& l : m_ConnectorMappings)
         {
             if (l.groupID == groupID)
             {
                 profile = l.connectorMapping;
-                deckLinkAttributes->Release();
                 return true;
             }
         }
 
-        deckLinkAttributes->Release();
-
         return false;
     }
 
@@ -478,9 +873,12 @@ namespace MediaBlackmagic
 
     bool DeckLinkDeviceDiscovery::HasConnectorMappingProfiles()
     {
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
         auto hasConnectorMapping = false;
-        for (const auto& deviceInfo : m_ActiveDevices)
+        for (const auto& device : m_ActiveDevices)
         {
+            const auto& deviceInfo = device.second;
             if (deviceInfo.hasConnectorMapping)
             {
                 hasConnectorMapping = deviceInfo.hasConnectorMapping;
@@ -491,9 +889,11 @@ namespace MediaBlackmagic
 
     bool DeckLinkDeviceDiscovery::IsConnectorMappingProfileCompatible(const EConnectorMapping profile)
     {
-        for (const auto& deviceInfo : m_ActiveDevices)
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
+        for (const auto& device : m_ActiveDevices)
         {
-            const auto device = deviceInfo.device;
+            const auto& deviceInfo = device.second;
             const auto listProfiles = deviceInfo.compatibleProfiles;
 
             auto profileIsCompatible =
@@ -525,8 +925,11 @@ namespace MediaBlackmagic
 
     void DeckLinkDeviceDiscovery::ReloadAllDeckLinkDevicesEvent()
     {
-        for (auto& deviceInfo : m_ActiveDevices)
+        std::lock_guard<std::recursive_mutex> lock(m_DevicesMutex);
+
+        for (auto& device : m_ActiveDevices)
         {
+            auto& deviceInfo = device.second;
             ReloadDeckLinkDevicesEvent(*deviceInfo.device);
         }
     }
@@ -47,190 +47,49 @@ namespace MediaBlackmagic
     {
         clearAllDeviceNames();
 
-        IDeckLinkIterator* iterator;
-        if (GetDeckLinkIterator(&iterator) != S_OK)
-            return;
-
-        IDeckLink* device;
-        while (iterator->Next(&device) == S_OK)
+        const auto capabilities = DeckLinkCapabilitySnapshot::Get();
+        for (const auto& device : capabilities->GetDevices())
         {
-            IDeckLinkProfileAttributes* deckLinkAttributes = nullptr;
-            if (device->QueryInterface(IID_IDeckLinkProfileAttributes, (void**)&deckLinkAttributes) != S_OK)
-            {
-                goto cleanup;
-                continue;
-            }
-
-            int64_t intAttribute;
-            if ((deckLinkAttributes->GetInt(BMDDeckLinkDuplex, &intAttribute) == S_OK) &&
-                (((BMDDuplexMode)intAttribute) != bmdDuplexInactive))
-            {
-                dlstring_t name;
-                ShouldOK(device->GetDisplayName(&name));
-                m_Names.push_back(DlToStdString(name));
-                DeleteString(name);
-            }
-
-            goto cleanup;
-
-        cleanup:
-            if (deckLinkAttributes != nullptr)
-                deckLinkAttributes->Release();
-
-            if (device != nullptr)
-                device->Release();
+            if (device.IsActive())
+                m_Names.push_back(device.name);
         }
-        iterator->Release();
     }
 
     void DeckLinkDeviceEnumerator::ScanInputDeviceNames()
     {
         clearInputDeviceNames();
 
-        IDeckLinkIterator* iterator;
-        if (GetDeckLinkIterator(&iterator) != S_OK)
-            return;
-
-        IDeckLink* device;
-        while (iterator->Next(&device) == S_OK)
+        const auto capabilities = DeckLinkCapabilitySnapshot::Get();
+        for (const auto& device : capabilities->GetDevices())
         {
-            IDeckLinkProfileAttributes* deckLinkAttributes = nullptr;
-
-            if (device->QueryInterface(IID_IDeckLinkProfileAttributes, (void**)&deckLinkAttributes) != S_OK)
-            {
-                goto cleanup;
-                continue;
-            }
-
-            // Check whether device is active for the device profile
-            int64_t intAttribute;
-            if ((deckLinkAttributes->GetInt(BMDDeckLinkDuplex, &intAttribute) != S_OK) ||
-                ((BMDDuplexMode)intAttribute == bmdDuplexInactive))
-            {
-                goto cleanup;
-                continue;
-            }
-
-            // Determine whether device supports capture and/or playback
-            if (deckLinkAttributes->GetInt(BMDDeckLinkVideoIOSupport, &intAttribute) != S_OK)
-            {
-                goto cleanup;
-                continue;
-            }
-
-            if (((BMDVideoIOSupport)intAttribute & bmdDeviceSupportsCapture) != 0)
-            {
-                dlstring_t name;
-                ShouldOK(device->GetDisplayName(&name));
-                m_InputDevices.push_back(DlToStdString(name));
-                DeleteString(name);
-            }
-
-            goto cleanup;
-
-        cleanup:
-            if (deckLinkAttributes != nullptr)
-                deckLinkAttributes->Release();
-
-            if (device != nullptr)
-                device->Release();
+            if (device.IsActive() && (device.videoIOSupport & bmdDeviceSupportsCapture) != 0)
+                m_InputDevices.push_back(device.name);
         }
-        iterator->Release();
     }
 
     void DeckLinkDeviceEnumerator::ScanOutputDeviceNames()
     {
         clearOutputDeviceNames();
 
-        IDeckLinkIterator* iterator;
-        if (GetDeckLinkIterator(&iterator) != S_OK)
-            return;
-
-        IDeckLink* device;
-        while (iterator->Next(&device) == S_OK)
+        const auto capabilities = DeckLinkCapabilitySnapshot::Get();
+        for (const auto& device : capabilities->GetDevices())
         {
-            IDeckLinkProfileAttributes* deckLinkAttributes = nullptr;
-
-            if (device->QueryInterface(IID_IDeckLinkProfileAttributes, (void**)&deckLinkAttributes) != S_OK)
-            {
-                goto cleanup;
-                continue;
-            }
-
-            // Check whether device is active for the device profile
-            int64_t intAttribute;
-            if ((deckLinkAttributes->GetInt(BMDDeckLinkDuplex, &intAttribute) != S_OK) ||
-                ((BMDDuplexMode)intAttribute == bmdDuplexInactive))
-            {
-                goto cleanup;
-                continue;
-            }
-
-            // Determine whether device supports capture and/or playback
-            if (deckLinkAttributes->GetInt(BMDDeckLinkVideoIOSupport, &intAttribute) != S_OK)
-            {
-                goto cleanup;
-                continue;
-            }
-
-            if (((BMDVideoIOSupport)intAttribute & bmdDeviceSupportsPlayback) != 0)
-            {
-                dlstring_t name;
-                ShouldOK(device->GetDisplayName(&name));
-                m_OutputDevices.push_back(DlToStdString(name));
-                DeleteString(name);
-            }
-
-        cleanup:
-            if (deckLinkAttributes != nullptr)
-                deckLinkAttributes->Release();
-
-            if (device != nullptr)
-                device->Release();
+            if (device.IsActive() && (device.videoIOSupport & bmdDeviceSupportsPlayback) != 0)
+                m_OutputDevices.push_back(device.name);
         }
-        iterator->Release();
     }
 
     void DeckLinkDeviceEnumerator::ScanOutputModes(int deviceIndex)
     {
         clearModes();
 
-        IDeckLinkIterator* iterator;
-        if (GetDeckLinkIterator(&iterator) != S_OK)
+        const auto capabilities = DeckLinkCapabilitySnapshot::Get();
+        const auto device = capabilities->GetDevice(deviceIndex);
+        if (device == nullptr)
             return;
 
-        IDeckLink* device = nullptr;
-        for (auto i = 0; i <= deviceIndex; i++)
-        {
-            if (device != nullptr)
-                device->Release();
-
-            if (iterator->Next(&device) != S_OK)
-            {
-                iterator->Release();
-                return;
-            }
-        }
-
-        iterator->Release();
-
-        IDeckLinkOutput* output;
-        device->QueryInterface(IID_IDeckLinkOutput, reinterpret_cast<void**>(&output));
-        device->Release();
-
-        IDeckLinkDisplayModeIterator* dmIterator;
-        output->GetDisplayModeIterator(&dmIterator);
-        output->Release();
-
-        IDeckLinkDisplayMode* mode;
-        while (dmIterator->Next(&mode) == S_OK)
-        {
-            auto displayMode = mode->GetDisplayMode();
-            auto displayModeAsInt = static_cast<int>(displayMode);
-            m_Modes.push_back(displayModeAsInt);
-            mode->Release();
-        }
-        dmIterator->Release();
+        for (const auto& mode : device->outputModes)
+            m_Modes.push_back(static_cast<int>(mode.displayMode));
     }
 
     bool DeckLinkDeviceEnumerator::SetAllDevicesDuplexMode(bool halfDuplex)
@@ -288,6 +147,10 @@ namespace MediaBlackmagic
         }
 
         iterator->Release();
+
+        // The duplex mode and the IO support of the cards changed with their profile.
+        DeckLinkCapabilitySnapshot::Invalidate();
+
         return queryDeckLinkConfigurationSucceed;
     }
 
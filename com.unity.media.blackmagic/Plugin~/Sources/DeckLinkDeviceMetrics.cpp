@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <limits>
+
+#include "DeckLinkDeviceMetrics.h"
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        const char* const k_MetricNames[] =
+        {
+            "InputCallback",
+            "InputJitter",
+            "DeliveryQueueDepth",
+            "Copy",
+            "Pack",
+            "ScheduleToCompletion",
+            "AudioRingFill",
+            "LateFrames",
+            "DroppedFrames",
+            "FlushedFrames",
+        };
+
+        static_assert(sizeof(k_MetricNames) / sizeof(k_MetricNames[0]) == static_cast<size_t>(EDeviceMetric::Count),
+                      "Every metric must have a name.");
+
+        // Durations are reported in microseconds, the other values as they are recorded.
+        bool IsDuration(const EDeviceMetric metric)
+        {
+            return metric != EDeviceMetric::DeliveryQueueDepth && metric != EDeviceMetric::AudioRingFill;
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram()
+    {
+        Reset();
+    }
+
+    int LatencyHistogram::GetBucket(std::int64_t value)
+    {
+        value = std::min(std::max<std::int64_t>(value, 0), (std::int64_t(1) << kMaxValueBits) - 1);
+
+        if (value < kSubBuckets)
+            return static_cast<int>(value);
+
+        // The position of the leading bit selects the power of two, the next bits the linear bucket.
+        auto magnitude = kSubBucketBits;
+        while ((value >> (magnitude + 1)) != 0)
+        {
+            ++magnitude;
+        }
+
+        const auto subBucket = (value >> (magnitude - kSubBucketBits)) & (kSubBuckets - 1);
+        return static_cast<int>((magnitude - kSubBucketBits + 1) * kSubBuckets + subBucket);
+    }
+
+    std::int64_t LatencyHistogram::GetHighestEquivalentValue(const int bucket)
+    {
+        if (bucket < kSubBuckets)
+            return bucket;
+
+        const auto octave = bucket >> kSubBucketBits;
+        const auto subBucket = bucket & (kSubBuckets - 1);
+        return ((kSubBuckets + subBucket + 1) << (octave - 1)) - 1;
+    }
+
+    void LatencyHistogram::Record(const std::int64_t value)
+    {
+        m_Buckets[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+        m_Count.fetch_add(1, std::memory_order_relaxed);
+        m_Sum.fetch_add(value, std::memory_order_relaxed);
+
+        auto min = m_Min.load(std::memory_order_relaxed);
+        while (value < min && !m_Min.compare_exchange_weak(min, value, std::memory_order_relaxed))
+        {
+        }
+
+        auto max = m_Max.load(std::memory_order_relaxed);
+        while (value > max && !m_Max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void LatencyHistogram::Reset()
+    {
+        for (auto& bucket : m_Buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+
+        m_Count.store(0, std::memory_order_relaxed);
+        m_Sum.store(0, std::memory_order_relaxed);
+        m_Min.store(std::numeric_limits<std::int64_t>::max(), std::memory_order_relaxed);
+        m_Max.store(0, std::memory_order_relaxed);
+    }
+
+    void LatencyHistogram::Merge(const LatencyHistogram& other)
+    {
+        for (auto i = 0; i < kBucketCount; ++i)
+        {
+            m_Buckets[i].fetch_add(other.m_Buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        const auto count = other.m_Count.load(std::memory_order_relaxed);
+        if (count == 0)
+            return;
+
+        m_Count.fetch_add(count, std::memory_order_relaxed);
+        m_Sum.fetch_add(other.m_Sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        const auto otherMin = other.m_Min.load(std::memory_order_relaxed);
+        auto min = m_Min.load(std::memory_order_relaxed);
+        while (otherMin < min && !m_Min.compare_exchange_weak(min, otherMin, std::memory_order_relaxed))
+        {
+        }
+
+        const auto otherMax = other.m_Max.load(std::memory_order_relaxed);
+        auto max = m_Max.load(std::memory_order_relaxed);
+        while (otherMax > max && !m_Max.compare_exchange_weak(max, otherMax, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void LatencyHistogram::Summarize(MetricSummary& summary) const
+    {
+        // The buckets may be updated while they are copied: the percentiles use the copied total.
+        std::array<std::uint32_t, kBucketCount> buckets;
+        std::uint64_t total = 0;
+        for (auto i = 0; i < kBucketCount; ++i)
+        {
+            buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+            total += buckets[i];
+        }
+
+        summary.count = m_Count.load(std::memory_order_relaxed);
+        summary.min = summary.count > 0 ? m_Min.load(std::memory_order_relaxed) : 0;
+        summary.max = m_Max.load(std::memory_order_relaxed);
+        summary.mean = summary.count > 0 ? m_Sum.load(std::memory_order_relaxed) / static_cast<std::int64_t>(summary.count) : 0;
+
+        const std::pair<double, std::int64_t*> percentiles[] =
+        {
+            { 0.5, &summary.p50 },
+            { 0.9, &summary.p90 },
+            { 0.99, &summary.p99 },
+            { 0.999, &summary.p999 },
+        };
+
+        auto bucket = 0;
+        std::uint64_t cumulated = 0;
+        for (const auto& percentile : percentiles)
+        {
+            const auto rank = static_cast<std::uint64_t>(percentile.first * static_cast<double>(total) + 0.5);
+            while (bucket < kBucketCount - 1 && (cumulated + buckets[bucket] < rank || buckets[bucket] == 0))
+            {
+                cumulated += buckets[bucket];
+                ++bucket;
+            }
+
+            *percentile.second = total > 0 ? std::min(GetHighestEquivalentValue(bucket), summary.max) : 0;
+        }
+    }
+
+    RollingWindow::RollingWindow() :
+        m_Count(0),
+        m_Next(0)
+    {
+    }
+
+    void RollingWindow::Add(const std::int64_t value)
+    {
+        m_Values[m_Next] = value;
+        m_Next = (m_Next + 1) % kCapacity;
+        m_Count = std::min(m_Count + 1, kCapacity);
+    }
+
+    void RollingWindow::Clear()
+    {
+        m_Count = 0;
+        m_Next = 0;
+    }
+
+    bool RollingWindow::Summarize(std::int64_t& min, std::int64_t& p1, std::int64_t& p50)
+    {
+        if (m_Count == 0)
+            return false;
+
+        // A full sort of the small window is cheaper than two selections plus a scan.
+        std::copy_n(m_Values.begin(), m_Count, m_Sorted.begin());
+        std::sort(m_Sorted.begin(), m_Sorted.begin() + m_Count);
+
+        min = m_Sorted[0];
+        p1 = m_Sorted[(m_Count - 1) / 100];
+        p50 = m_Sorted[(m_Count - 1) / 2];
+        return true;
+    }
+
+    std::mutex DeckLinkDeviceMetrics::s_RegistryMutex;
+    std::vector<DeckLinkDeviceMetrics*> DeckLinkDeviceMetrics::s_Registry;
+
+    DeckLinkDeviceMetrics::DeckLinkDeviceMetrics(const EDeviceDirection direction) :
+        m_Direction(direction),
+        m_DeviceIndex(-1)
+    {
+        for (auto& counter : m_Counters)
+        {
+            counter.store(0, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+        s_Registry.push_back(this);
+    }
+
+    DeckLinkDeviceMetrics::~DeckLinkDeviceMetrics()
+    {
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+        s_Registry.erase(std::remove(s_Registry.begin(), s_Registry.end(), this), s_Registry.end());
+    }
+
+    void DeckLinkDeviceMetrics::Record(const EDeviceMetric metric, const std::int64_t value)
+    {
+        const auto index = static_cast<int>(metric);
+        assert(index < kHistogramCount);
+        m_Histograms[index].Record(value);
+    }
+
+    void DeckLinkDeviceMetrics::RecordDuration(const EDeviceMetric metric, const std::chrono::steady_clock::duration duration)
+    {
+        Record(metric, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    void DeckLinkDeviceMetrics::Increment(const EDeviceMetric metric)
+    {
+        const auto index = static_cast<int>(metric) - kHistogramCount;
+        assert(index >= 0 && index < kCounterCount);
+        m_Counters[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceMetrics::Reset()
+    {
+        for (auto& histogram : m_Histograms)
+        {
+            histogram.Reset();
+        }
+
+        for (auto& counter : m_Counters)
+        {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<MetricSummary> DeckLinkDeviceMetrics::Collect()
+    {
+        std::vector<MetricSummary> summaries;
+
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+        for (const auto metrics : s_Registry)
+        {
+            MetricSummary summary = {};
+            summary.deviceIndex = metrics->m_DeviceIndex.load(std::memory_order_relaxed);
+            summary.direction = static_cast<std::int32_t>(metrics->m_Direction);
+
+            for (auto i = 0; i < kHistogramCount; ++i)
+            {
+                summary.metric = i;
+                metrics->m_Histograms[i].Summarize(summary);
+                if (summary.count > 0)
+                {
+                    summaries.push_back(summary);
+                }
+            }
+
+            summary.min = summary.max = summary.mean = 0;
+            summary.p50 = summary.p90 = summary.p99 = summary.p999 = 0;
+            for (auto i = 0; i < kCounterCount; ++i)
+            {
+                summary.metric = kHistogramCount + i;
+                summary.count = metrics->m_Counters[i].load(std::memory_order_relaxed);
+                if (summary.count > 0)
+                {
+                    summaries.push_back(summary);
+                }
+            }
+        }
+
+        return summaries;
+    }
+
+    int DeckLinkDeviceMetrics::Snapshot(MetricSummary* summaries, const int capacity)
+    {
+        const auto collected = Collect();
+        const auto count = static_cast<int>(collected.size());
+
+        if (summaries != nullptr)
+        {
+            std::copy_n(collected.begin(), std::min(std::max(capacity, 0), count), summaries);
+        }
+
+        return count;
+    }
+
+    std::string DeckLinkDeviceMetrics::Report()
+    {
+        std::string report;
+        char line[256];
+
+        for (const auto& summary : Collect())
+        {
+            const auto metric = static_cast<EDeviceMetric>(summary.metric);
+            const auto direction = summary.direction == static_cast<std::int32_t>(EDeviceDirection::Input) ? "Input" : "Output";
+            const auto name = k_MetricNames[summary.metric];
+
+            if (metric >= EDeviceMetric::FirstCounter)
+            {
+                std::snprintf(line, sizeof(line), "%s %d %s: %llu\n", direction, summary.deviceIndex, name,
+                              static_cast<unsigned long long>(summary.count));
+            }
+            else
+            {
+                const auto scale = IsDuration(metric) ? 1000.0 : 1.0;
+                std::snprintf(line, sizeof(line),
+                              "%s %d %s%s: n=%llu min=%.1f mean=%.1f p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f max=%.1f\n",
+                              direction, summary.deviceIndex, name, IsDuration(metric) ? " (us)" : "",
+                              static_cast<unsigned long long>(summary.count),
+                              summary.min / scale, summary.mean / scale, summary.p50 / scale, summary.p90 / scale,
+                              summary.p99 / scale, summary.p999 / scale, summary.max / scale);
+            }
+
+            report += line;
+        }
+
+        return report;
+    }
+
+    void DeckLinkDeviceMetrics::ResetAll()
+    {
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+        for (const auto metrics : s_Registry)
+        {
+            metrics->Reset();
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "DeckLinkDeviceProfile.h"
+#include "DeckLinkCapabilitySnapshot.h"
 
 namespace MediaBlackmagic
 {
@@ -35,6 +36,8 @@ namespace MediaBlackmagic
 
     HRESULT DeckLinkDeviceProfile::ProfileActivated(IDeckLinkProfile* activatedProfile)
     {
+        DeckLinkCapabilitySnapshot::Invalidate();
+
         // New profile activated
         if (m_profileActivatedCallbackDevice)
         {
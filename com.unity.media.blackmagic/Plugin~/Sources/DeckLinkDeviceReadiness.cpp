@@ -0,0 +1,97 @@
+#include <chrono>
+
+#include "DeckLinkDeviceReadiness.h"
+#include "DeckLinkProfiler.h"
+#include "platform.h"
+
+namespace MediaBlackmagic
+{
+    DeckLinkDeviceReadiness::DeckLinkDeviceReadiness() :
+        m_State(static_cast<std::uint32_t>(EDeviceReadiness::Pending))
+    {
+    }
+
+    DeckLinkDeviceReadiness::~DeckLinkDeviceReadiness()
+    {
+        Join();
+    }
+
+    void DeckLinkDeviceReadiness::Open(const OpenFunction& open)
+    {
+        std::string error;
+        const auto success = open(error);
+        Complete(success, std::move(error));
+    }
+
+    void DeckLinkDeviceReadiness::OpenInBackground(OpenFunction open)
+    {
+        Join();
+
+        m_State.store(static_cast<std::uint32_t>(EDeviceReadiness::Pending), std::memory_order_relaxed);
+        m_Worker = std::thread([this, open]()
+        {
+            ProfilerThreadScope thread("Device Open");
+#if defined(_WIN32)
+            // The device is opened through COM, which the worker joins for the time of the opening.
+            const auto initialized = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+            Open(open);
+#if defined(_WIN32)
+            if (SUCCEEDED(initialized))
+                CoUninitialize();
+#endif
+        });
+    }
+
+    void DeckLinkDeviceReadiness::Join()
+    {
+        if (m_Worker.joinable())
+        {
+            m_Worker.join();
+        }
+    }
+
+    EDeviceReadiness DeckLinkDeviceReadiness::GetState() const
+    {
+        return static_cast<EDeviceReadiness>(m_State.load(std::memory_order_acquire));
+    }
+
+    EDeviceReadiness DeckLinkDeviceReadiness::Wait(const int timeoutMs) const
+    {
+        const auto pending = static_cast<std::uint32_t>(EDeviceReadiness::Pending);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+        while (m_State.load(std::memory_order_acquire) == pending)
+        {
+            auto remainingMs = -1;
+            if (timeoutMs >= 0)
+            {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                if (remaining.count() <= 0)
+                    break;
+                remainingMs = static_cast<int>(remaining.count());
+            }
+
+            WaitOnAddressValue(&m_State, pending, remainingMs);
+        }
+
+        return GetState();
+    }
+
+    const char* DeckLinkDeviceReadiness::GetError() const
+    {
+        return GetState() == EDeviceReadiness::Failed ? m_Error.c_str() : "";
+    }
+
+    void DeckLinkDeviceReadiness::Complete(const bool success, std::string&& error)
+    {
+        if (!success && error.empty())
+            error = "The device could not be opened.";
+
+        m_Error = success ? std::string() : std::move(error);
+
+        const auto state = success ? EDeviceReadiness::Ready : EDeviceReadiness::Failed;
+        m_State.store(static_cast<std::uint32_t>(state), std::memory_order_release);
+        WakeAllOnAddress(&m_State);
+    }
+}
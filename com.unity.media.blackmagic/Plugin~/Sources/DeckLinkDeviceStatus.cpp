@@ -0,0 +1,184 @@
+#include <algorithm>
+
+#include "DeckLinkDeviceStatus.h"
+
+namespace MediaBlackmagic
+{
+    std::mutex DeckLinkDeviceStatus::s_RegistryMutex;
+    std::vector<DeckLinkDeviceStatus*> DeckLinkDeviceStatus::s_Registry;
+
+    DeckLinkDeviceStatus::DeckLinkDeviceStatus(const EDeviceDirection direction)
+    {
+        static_assert(sizeof(Block) == sizeof(DeviceStatus), "The status block must be readable as a DeviceStatus.");
+
+        m_Block.updateCount.store(0);
+        m_Block.direction.store(static_cast<std::int32_t>(direction));
+        m_Block.reserved.store(0);
+        Reset();
+
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+        s_Registry.push_back(this);
+    }
+
+    DeckLinkDeviceStatus::~DeckLinkDeviceStatus()
+    {
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+        s_Registry.erase(std::remove(s_Registry.begin(), s_Registry.end(), this), s_Registry.end());
+    }
+
+    DeckLinkDeviceStatus::WriteScope::WriteScope(DeckLinkDeviceStatus& status) :
+        m_Lock(status.m_WriteMutex),
+        m_Block(status.m_Block)
+    {
+        m_Block.updateCount.store(m_Block.updateCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    DeckLinkDeviceStatus::WriteScope::~WriteScope()
+    {
+        m_Block.updateCount.store(m_Block.updateCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    DeviceStatus DeckLinkDeviceStatus::Load() const
+    {
+        DeviceStatus status;
+        do
+        {
+            status = LoadFields();
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((status.updateCount & 1) != 0 || status.updateCount != m_Block.updateCount.load(std::memory_order_relaxed));
+        return status;
+    }
+
+    DeviceStatus DeckLinkDeviceStatus::LoadFields() const
+    {
+        DeviceStatus status;
+        status.updateCount = m_Block.updateCount.load(std::memory_order_acquire);
+        status.processedFrames = m_Block.processedFrames.load(std::memory_order_relaxed);
+        status.deviceIndex = m_Block.deviceIndex.load(std::memory_order_relaxed);
+        status.direction = m_Block.direction.load(std::memory_order_relaxed);
+        status.droppedFrames = m_Block.droppedFrames.load(std::memory_order_relaxed);
+        status.lateFrames = m_Block.lateFrames.load(std::memory_order_relaxed);
+        status.bufferedFrames = m_Block.bufferedFrames.load(std::memory_order_relaxed);
+        status.referenceLocked = m_Block.referenceLocked.load(std::memory_order_relaxed);
+        status.pixelFormat = m_Block.pixelFormat.load(std::memory_order_relaxed);
+        status.signalPresent = m_Block.signalPresent.load(std::memory_order_relaxed);
+        status.lastStatus = m_Block.lastStatus.load(std::memory_order_relaxed);
+        status.lastErrorCode = m_Block.lastErrorCode.load(std::memory_order_relaxed);
+        status.reserved = 0;
+        status.deadlineSlack = m_Block.deadlineSlack.load(std::memory_order_relaxed);
+        status.deadlineSlackMin = m_Block.deadlineSlackMin.load(std::memory_order_relaxed);
+        status.deadlineSlackP1 = m_Block.deadlineSlackP1.load(std::memory_order_relaxed);
+        status.deadlineSlackP50 = m_Block.deadlineSlackP50.load(std::memory_order_relaxed);
+        return status;
+    }
+
+    void DeckLinkDeviceStatus::SetDeviceIndex(const int deviceIndex)
+    {
+        WriteScope write(*this);
+        m_Block.deviceIndex.store(deviceIndex, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::SetProcessedFrames(const std::int64_t processedFrames)
+    {
+        WriteScope write(*this);
+        m_Block.processedFrames.store(processedFrames, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::IncrementProcessedFrames()
+    {
+        WriteScope write(*this);
+        m_Block.processedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::IncrementDroppedFrames()
+    {
+        WriteScope write(*this);
+        m_Block.droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::IncrementLateFrames()
+    {
+        WriteScope write(*this);
+        m_Block.lateFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::SetBufferedFrames(const int bufferedFrames)
+    {
+        WriteScope write(*this);
+        m_Block.bufferedFrames.store(bufferedFrames, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::SetReferenceLocked(const bool locked)
+    {
+        // Sampled by the status poller: the update count only moves when the lock changed.
+        if (m_Block.referenceLocked.load(std::memory_order_relaxed) == (locked ? 1 : 0))
+            return;
+
+        WriteScope write(*this);
+        m_Block.referenceLocked.store(locked ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::SetPixelFormat(const int pixelFormat)
+    {
+        WriteScope write(*this);
+        m_Block.pixelFormat.store(pixelFormat, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::SetSignalPresent(const bool present)
+    {
+        WriteScope write(*this);
+        m_Block.signalPresent.store(present ? 1 : 0, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::Report(const EDeviceStatus status, const int errorCode)
+    {
+        WriteScope write(*this);
+        m_Block.lastStatus.store(static_cast<std::int32_t>(status), std::memory_order_relaxed);
+        m_Block.lastErrorCode.store(errorCode, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::SetDeadlineSlack(const std::int64_t slack, const std::int64_t min, const std::int64_t p1, const std::int64_t p50)
+    {
+        WriteScope write(*this);
+        m_Block.deadlineSlack.store(slack, std::memory_order_relaxed);
+        m_Block.deadlineSlackMin.store(min, std::memory_order_relaxed);
+        m_Block.deadlineSlackP1.store(p1, std::memory_order_relaxed);
+        m_Block.deadlineSlackP50.store(p50, std::memory_order_relaxed);
+    }
+
+    void DeckLinkDeviceStatus::Reset()
+    {
+        WriteScope write(*this);
+        m_Block.processedFrames.store(0, std::memory_order_relaxed);
+        m_Block.deviceIndex.store(-1, std::memory_order_relaxed);
+        m_Block.droppedFrames.store(0, std::memory_order_relaxed);
+        m_Block.lateFrames.store(0, std::memory_order_relaxed);
+        m_Block.bufferedFrames.store(0, std::memory_order_relaxed);
+        m_Block.referenceLocked.store(0, std::memory_order_relaxed);
+        m_Block.pixelFormat.store(0, std::memory_order_relaxed);
+        m_Block.signalPresent.store(0, std::memory_order_relaxed);
+        m_Block.lastStatus.store(static_cast<std::int32_t>(EDeviceStatus::Unused), std::memory_order_relaxed);
+        m_Block.lastErrorCode.store(0, std::memory_order_relaxed);
+        m_Block.deadlineSlack.store(0, std::memory_order_relaxed);
+        m_Block.deadlineSlackMin.store(0, std::memory_order_relaxed);
+        m_Block.deadlineSlackP1.store(0, std::memory_order_relaxed);
+        m_Block.deadlineSlackP50.store(0, std::memory_order_relaxed);
+    }
+
+    int DeckLinkDeviceStatus::Snapshot(DeviceStatus* statuses, const int capacity)
+    {
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+
+        const auto count = static_cast<int>(s_Registry.size());
+        if (statuses != nullptr)
+        {
+            for (auto i = 0; i < count && i < capacity; ++i)
+            {
+                statuses[i] = s_Registry[i]->Load();
+            }
+        }
+
+        return count;
+    }
+}
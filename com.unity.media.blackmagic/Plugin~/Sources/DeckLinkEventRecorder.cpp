@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "DeckLinkEventRecorder.h"
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        const char k_Magic[4] = { 'D', 'L', 'E', 'R' };
+
+        // The frame durations of the display modes, from 23.98 to 120 frames per second, are whole
+        // numbers of ticks at this scale, so the frame numbers are exact. At 60000, the duration
+        // of a 23.98 frame would be 2502.5 ticks.
+        const BMDTimeScale k_StreamTimeScale = 240000;
+
+        std::int64_t Now()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        RecordedEvent MakeEvent(const ERecordedEvent type, const int deviceIndex)
+        {
+            RecordedEvent event = {};
+            event.time = Now();
+            event.frameNumber = -1;
+            event.deviceIndex = static_cast<std::int16_t>(deviceIndex);
+            event.type = static_cast<std::uint8_t>(type);
+            return event;
+        }
+    }
+
+    DeckLinkEventRing<RecordedEvent> DeckLinkEventRecorder::s_Events;
+
+    bool DeckLinkEventRecorder::Enable(const int capacity)
+    {
+        return s_Events.Enable(capacity);
+    }
+
+    void DeckLinkEventRecorder::Disable()
+    {
+        s_Events.Disable();
+    }
+
+    void DeckLinkEventRecorder::RecordFrameArrived(const int deviceIndex, IDeckLinkVideoInputFrame* videoFrame,
+                                                   IDeckLinkAudioInputPacket* audioPacket)
+    {
+        auto event = MakeEvent(ERecordedEvent::FrameArrived, deviceIndex);
+
+        if (videoFrame != nullptr)
+        {
+            BMDTimeValue frameTime = 0;
+            BMDTimeValue frameDuration = 0;
+            if (videoFrame->GetStreamTime(&frameTime, &frameDuration, k_StreamTimeScale) == S_OK && frameDuration > 0)
+                event.frameNumber = frameTime / frameDuration;
+
+            event.code = static_cast<std::uint32_t>(videoFrame->GetFlags());
+        }
+
+        if (audioPacket != nullptr)
+            event.detail = static_cast<std::uint32_t>(audioPacket->GetSampleFrameCount());
+
+        Record(event);
+    }
+
+    void DeckLinkEventRecorder::RecordFormatChanged(const int deviceIndex, const BMDVideoInputFormatChangedEvents events,
+                                                    IDeckLinkDisplayMode* mode, const BMDDetectedVideoInputFormatFlags flags)
+    {
+        auto event = MakeEvent(ERecordedEvent::FormatChanged, deviceIndex);
+        event.code = mode != nullptr ? static_cast<std::uint32_t>(mode->GetDisplayMode()) : static_cast<std::uint32_t>(bmdModeUnknown);
+        event.detail = static_cast<std::uint32_t>(flags);
+        event.events = static_cast<std::uint8_t>(events);
+
+        Record(event);
+    }
+
+    void DeckLinkEventRecorder::RecordFrameCompleted(const int deviceIndex, const BMDOutputFrameCompletionResult result)
+    {
+        auto event = MakeEvent(ERecordedEvent::FrameCompleted, deviceIndex);
+        event.code = static_cast<std::uint32_t>(result);
+
+        Record(event);
+    }
+
+    void DeckLinkEventRecorder::Record(const RecordedEvent& event)
+    {
+        s_Events.Record([&event](RecordedEvent& slot) { slot = event; });
+    }
+
+    int DeckLinkEventRecorder::Write(const char* path)
+    {
+        std::vector<RecordedEvent> events;
+        s_Events.Read(events);
+
+        // The callbacks of different cards claim their slots in any order around the same time.
+        std::stable_sort(events.begin(), events.end(), [](const RecordedEvent& lhs, const RecordedEvent& rhs) { return lhs.time < rhs.time; });
+
+        auto file = std::fopen(path, "wb");
+        if (file == nullptr)
+            return -1;
+
+        FileHeader header;
+        std::memcpy(header.magic, k_Magic, sizeof(k_Magic));
+        header.version = kFormatVersion;
+        header.eventSize = sizeof(RecordedEvent);
+        header.eventCount = static_cast<std::uint32_t>(events.size());
+
+        auto written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        if (written && !events.empty())
+            written = std::fwrite(events.data(), sizeof(RecordedEvent), events.size(), file) == events.size();
+        written = std::fclose(file) == 0 && written;
+
+        return written ? static_cast<int>(events.size()) : -1;
+    }
+
+    bool DeckLinkEventRecorder::Read(const char* path, std::vector<RecordedEvent>& events)
+    {
+        events.clear();
+
+        auto file = std::fopen(path, "rb");
+        if (file == nullptr)
+            return false;
+
+        // The count of events has to match the size of the file, so a damaged file isn't trusted with it.
+        std::fseek(file, 0, SEEK_END);
+        const auto fileSize = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+
+        FileHeader header;
+        auto valid = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                     std::memcmp(header.magic, k_Magic, sizeof(k_Magic)) == 0 &&
+                     header.version == kFormatVersion &&
+                     header.eventSize == sizeof(RecordedEvent) &&
+                     fileSize == static_cast<long>(sizeof(header) + static_cast<std::size_t>(header.eventCount) * sizeof(RecordedEvent));
+
+        if (valid)
+        {
+            events.resize(header.eventCount);
+            valid = header.eventCount == 0 ||
+                    std::fread(events.data(), sizeof(RecordedEvent), events.size(), file) == events.size();
+        }
+        std::fclose(file);
+
+        if (!valid)
+        {
+            events.clear();
+            return false;
+        }
+
+        valid = std::all_of(events.begin(), events.end(), [](const RecordedEvent& event)
+        {
+            return event.type < static_cast<std::uint8_t>(ERecordedEvent::Count);
+        });
+        if (!valid)
+            events.clear();
+        return valid;
+    }
+}
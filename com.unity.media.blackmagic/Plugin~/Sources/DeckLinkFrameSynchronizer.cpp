@@ -0,0 +1,134 @@
+#include <cmath>
+
+#include "DeckLinkFrameSynchronizer.h"
+
+namespace MediaBlackmagic
+{
+    DeckLinkFrameSynchronizer::DeckLinkFrameSynchronizer()
+    {
+        Reset(1, 0);
+    }
+
+    void DeckLinkFrameSynchronizer::Reset(const int targetDepth, const std::int64_t outputFrameDuration)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Queue.clear();
+        m_TargetDepth = targetDepth < 1 ? 1 : targetDepth;
+        m_OutputFrameDuration = outputFrameDuration;
+
+        m_HasInput = false;
+        m_LastInputTimestamp = 0;
+        m_LastPhase = 0;
+        m_PhaseRate = 0.0;
+
+        m_HasPresented = false;
+        m_LastPresented = 0;
+
+        m_DroppedFrames = 0;
+        m_RepeatedFrames = 0;
+        m_AudioSlip = 0;
+    }
+
+    void DeckLinkFrameSynchronizer::PushInputFrame(const std::uint64_t sequence,
+                                                   const std::int64_t inputTimestamp,
+                                                   const std::int64_t inputFrameDuration,
+                                                   const std::int64_t outputPhase)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_HasInput && m_OutputFrameDuration > 0)
+        {
+            // Number of input frame periods since the previous frame, so missed frames don't count as drift.
+            std::int64_t periods = 1;
+            if (inputTimestamp >= 0 && m_LastInputTimestamp >= 0 && inputFrameDuration > 0)
+            {
+                periods = std::llround(static_cast<double>(inputTimestamp - m_LastInputTimestamp) / inputFrameDuration);
+                periods = periods < 1 ? 1 : periods;
+            }
+
+            // Wrap the phase step in ]-T/2, T/2] so crossing an output frame boundary isn't a jump.
+            auto step = (outputPhase - m_LastPhase) % m_OutputFrameDuration;
+            if (step > m_OutputFrameDuration / 2)
+                step -= m_OutputFrameDuration;
+            else if (step <= -m_OutputFrameDuration / 2)
+                step += m_OutputFrameDuration;
+
+            const auto rate = static_cast<double>(step) / periods;
+            m_PhaseRate += (rate - m_PhaseRate) * k_DriftSmoothing;
+        }
+
+        m_HasInput = true;
+        m_LastInputTimestamp = inputTimestamp;
+        m_LastPhase = outputPhase;
+
+        m_Queue.push_back(sequence);
+
+        // Hard limit: the output stopped pulling or the input runs much faster.
+        while (static_cast<int>(m_Queue.size()) > m_TargetDepth + 2)
+        {
+            m_Queue.pop_front();
+            m_DroppedFrames++;
+            m_AudioSlip--;
+        }
+    }
+
+    DeckLinkFrameSynchronizer::EDecision DeckLinkFrameSynchronizer::PullOutputFrame(std::uint64_t& sequence)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        const auto depth = static_cast<int>(m_Queue.size());
+
+        // Drift within the dead band is indistinguishable from jitter.
+        const auto driftPpm = m_OutputFrameDuration > 0 ? m_PhaseRate * 1e6 / m_OutputFrameDuration : 0.0;
+        const auto inputSlower = driftPpm > k_DriftDeadBandPpm;
+        const auto inputFaster = driftPpm < -k_DriftDeadBandPpm;
+
+        // Prime the queue up to the target depth before presenting the first frame.
+        if (!m_HasPresented && depth < m_TargetDepth)
+            return EDecision::Starved;
+
+        // Repeat on underflow, or to keep the cushion when the input is measured slower.
+        if (depth == 0 || (depth < m_TargetDepth && inputSlower))
+        {
+            sequence = m_LastPresented;
+            m_RepeatedFrames++;
+            m_AudioSlip++;
+            return EDecision::Repeat;
+        }
+
+        auto decision = EDecision::Present;
+
+        // Drop when the input is measured faster, with one frame of hysteresis over the target.
+        if (depth > m_TargetDepth + 1 && inputFaster)
+        {
+            m_Queue.pop_front();
+            m_DroppedFrames++;
+            m_AudioSlip--;
+            decision = EDecision::Drop;
+        }
+
+        sequence = m_Queue.front();
+        m_Queue.pop_front();
+
+        m_HasPresented = true;
+        m_LastPresented = sequence;
+
+        return decision;
+    }
+
+    FrameSynchronizerStatistics DeckLinkFrameSynchronizer::GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        FrameSynchronizerStatistics statistics;
+        statistics.phase = m_LastPhase;
+        statistics.outputFrameDuration = m_OutputFrameDuration;
+        statistics.driftPpm = m_OutputFrameDuration > 0 ? m_PhaseRate * 1e6 / m_OutputFrameDuration : 0.0;
+        statistics.depth = static_cast<std::int32_t>(m_Queue.size());
+        statistics.droppedFrames = m_DroppedFrames;
+        statistics.repeatedFrames = m_RepeatedFrames;
+        statistics.audioSlip = m_AudioSlip;
+        return statistics;
+    }
+}
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <cstdlib>
+
 #include "DeckLinkInputDevice.h"
+#include "DeckLinkEventRecorder.h"
+#include "DeckLinkPassthroughRoute.h"
+#include "DeckLinkProfiler.h"
+#include "DeckLinkTracer.h"
 
 namespace MediaBlackmagic
 {
@@ -21,7 +27,22 @@ namespace MediaBlackmagic
         m_ColorSpace(0),
         m_HasInputSource(false),
         m_TextureData(nullptr),
-        m_GraphicsAPI(kUnityGfxRendererD3D11)
+        m_GraphicsAPI(kUnityGfxRendererD3D11),
+        m_PassthroughRoute(nullptr),
+        m_Status(EDeviceDirection::Input),
+        m_Metrics(EDeviceDirection::Input),
+        m_LastArrivalTime(0),
+        m_TraceFlow(0),
+        m_StatusPoller(nullptr),
+        m_DeviceSelected(-1),
+        m_FramePool(nullptr),
+        m_FormatChanges(0),
+        m_LastRestart(0),
+        m_MaxRestart(0),
+        m_LastRecovery(0),
+        m_LastRecoveryMisses(0),
+        m_FormatChangeTime(0),
+        m_FormatChangeMisses(0)
     {
     }
 
@@ -59,7 +80,14 @@ namespace MediaBlackmagic
         m_QueueLock.unlock();
     }
 
-    void DeckLinkInputDevice::Start(const int deviceIndex,
+    void DeckLinkInputDevice::SetPassthroughRoute(DeckLinkPassthroughRoute* route)
+    {
+        // Blocks until the capture thread is done with the previous route.
+        std::lock_guard<std::mutex> lock(m_PassthroughRouteLock);
+        m_PassthroughRoute = route;
+    }
+
+    bool DeckLinkInputDevice::Start(const int deviceIndex,
                                     const int deviceSelected,
                                     const int formatIndex,
                                     const int pixelFormat,
@@ -71,15 +99,36 @@ namespace MediaBlackmagic
         assert(m_DisplayMode == nullptr);
 
         if (!InitializeInput(deviceIndex, deviceSelected, formatIndex, pixelFormat, enablePassThrough, graphicsAPI))
-            return;
+            return false;
+
+        if (selectedFormat != nullptr)
+            GetVideoFormat(selectedFormat);
+
+        if (m_Input->StartStreams() != S_OK)
+        {
+            m_Error = "Can't start the input streams.";
+            return false;
+        }
+        return true;
+    }
 
-        GetVideoFormat(selectedFormat);
+    const std::string& DeckLinkInputDevice::GetErrorString() const
+    {
+        return m_Error;
+    }
 
-        ShouldOK(m_Input->StartStreams());
+    void DeckLinkInputDevice::GetSelectedFormat(InputVideoFormatData* format)
+    {
+        GetVideoFormat(format);
     }
 
     void DeckLinkInputDevice::Stop()
     {
+        ProfilerSample sample(EProfilerMarker::CloseDevice, m_Index);
+
+        // The device may still be opening on its worker.
+        m_Readiness.Join();
+
         // First stop the output stream, so displayMode may be released.
         if (m_Input != nullptr)
         {
@@ -87,6 +136,7 @@ namespace MediaBlackmagic
             m_Input->SetCallback(nullptr);
             m_Input->DisableVideoInput();
         }
+        DeckLinkProfiler::UnregisterCallbackThreads(this);
 
         // Release the internal objects.
         if (m_Configuration != nullptr)
@@ -108,6 +158,22 @@ namespace MediaBlackmagic
             m_Input = nullptr;
         }
 
+        // The driver holds its own reference until the last frame buffer is released.
+        if (m_FramePool != nullptr)
+        {
+            m_FramePool->Release();
+            m_FramePool = nullptr;
+        }
+
+        if (m_StatusPoller != nullptr)
+        {
+            m_StatusPoller->DetachStatus(&m_Status);
+            m_StatusPoller->Release();
+            m_StatusPoller = nullptr;
+        }
+
+        m_Capabilities.reset();
+        m_Status.SetSignalPresent(false);
         m_Initialized = false;
     }
 
@@ -147,6 +213,9 @@ namespace MediaBlackmagic
         IDeckLinkDisplayMode* mode,
         BMDDetectedVideoInputFormatFlags flags)
     {
+        if (DeckLinkEventRecorder::IsEnabled())
+            DeckLinkEventRecorder::RecordFormatChanged(m_Index, events, mode, flags);
+
         if (m_DisplayMode != nullptr && m_DisplayMode->GetDisplayMode() == mode->GetDisplayMode())
             return S_OK;
 
@@ -154,6 +223,13 @@ namespace MediaBlackmagic
         m_DisplayMode = mode;
         mode->AddRef();
 
+        // A profile or discovery event since the last change may have changed the modes of the
+        // card. Building the snapshot would block the driver, so the current one is taken even if
+        // stale; the status poller rebuilds it. The snapshot is only read on this thread once the
+        // streams started.
+        if (auto capabilities = DeckLinkCapabilitySnapshot::GetCurrent())
+            m_Capabilities = std::move(capabilities);
+
         const auto changeString = UpdateVideoFormatData(events, mode, flags);
         auto isPixelFormatValid = UpdatePixelFormatData(flags);
 
@@ -162,50 +238,40 @@ namespace MediaBlackmagic
         {
             m_InvalidPixelFormat = true;
 
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::IncompatiblePixelFormatAndVideoMode, "Incompatible pixel format and video mode.");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::IncompatiblePixelFormatAndVideoMode, "Incompatible pixel format and video mode.");
             return S_FALSE;
         }
 
+        const auto restartStart = std::chrono::steady_clock::now();
+        m_LastArrivalTime = 0;
+        m_FormatChangeMisses = m_FramePool != nullptr ? m_FramePool->CountMisses() : 0;
+
         EnablesVideoFormatFlag();
 
-        // Pause video capture
-        auto res = m_Input->StopStreams();
-        assert(res == S_OK);
+        // Before the restart, so the buffers of the new format are ready for its first frames.
+        ReserveFramePool();
 
-        res = m_Input->DisableVideoInput();
-        assert(res == S_OK);
-
-        // Flush any queued video frames
-        res = m_Input->FlushStreams();
+        // Pause rather than stop: the audio input and the callback stay set, and the video input
+        // is switched to the new mode in place. The frame buffers are reused from the pool.
+        auto res = m_Input->PauseStreams();
         assert(res == S_OK);
 
         // TO DO: we keep getting notified that the "preferred" input is 10-bits when we
         // do want 8-bits, at least for now.
         res = m_Input->EnableVideoInput(m_DisplayMode->GetDisplayMode(),
             (BMDPixelFormat)m_CurrentPixelFormat,
-#if _WIN64
-            bmdVideoInputEnableFormatDetection
-#else
-            bmdVideoInputFlagDefault
-#endif
-        );
+            GetVideoInputFlags());
 
         if (res != S_OK)
         {
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::DeviceAlreadyUsed, "Can't start input device (possibly already used).");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::DeviceAlreadyUsed, "Can't start input device (possibly already used).");
 
             m_Initialized = false;
             return res;
         }
 
-        // enable audio
-        res = m_Input->EnableAudioInput(m_AudioSampleRate, m_AudioSampleType, m_ChannelCount);
+        // Flush any queued video frames
+        res = m_Input->FlushStreams();
         assert(res == S_OK);
 
         // Notify the clients of the format change
@@ -215,6 +281,8 @@ namespace MediaBlackmagic
         res = m_Input->StartStreams();
         assert(res == S_OK);
 
+        RecordFormatChange(restartStart);
+
         m_Initialized = true;
 
         return res;
@@ -224,34 +292,52 @@ namespace MediaBlackmagic
         IDeckLinkVideoInputFrame* videoFrame,
         IDeckLinkAudioInputPacket* const audioPacket)
     {
+        const auto arrivalTime = std::chrono::steady_clock::now();
+
+        if (DeckLinkEventRecorder::IsEnabled())
+            DeckLinkEventRecorder::RecordFrameArrived(m_Index, videoFrame, audioPacket);
+
+        DeckLinkProfiler::RegisterCallbackThread("DeckLink Input", this);
+        ProfilerSample sample(EProfilerMarker::InputFrameArrived, m_Status.Load().processedFrames,
+                              videoFrame != nullptr ? videoFrame->GetRowBytes() * videoFrame->GetHeight() : 0);
+
+        // Every captured frame starts a new flow through the pipeline.
+        const auto traceFlow = DeckLinkTracer::IsEnabled() ? DeckLinkTracer::NewFlow() : 0;
+        TraceSpan traceSpan(ETraceSpan::InputCallback, m_Index, traceFlow);
+        m_TraceFlow.store(traceFlow, std::memory_order_relaxed);
+
         if (videoFrame == nullptr)
         {
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::NoInputSource, "Video frame is invalid.");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::NoInputSource, "Video frame is invalid.");
             return S_FALSE;
         }
         if (audioPacket == nullptr)
         {
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::AudioPacketInvalid, "Audio packet is invalid.");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::AudioPacketInvalid, "Audio packet is invalid.");
             return S_FALSE;
         }
         if (m_InvalidPixelFormat)
         {
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::IncompatiblePixelFormatAndVideoMode, "Incompatible pixel format and video mode.");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::IncompatiblePixelFormatAndVideoMode, "Incompatible pixel format and video mode.");
             return S_FALSE;
         }
 
         if (S_FALSE == DetectInputSource(videoFrame))
             return S_OK;
 
+        // First frame in the new format since the last format change.
+        if (m_FormatChangeTime.load(std::memory_order_relaxed) != 0)
+        {
+            const auto changeTime = m_FormatChangeTime.exchange(0);
+            if (changeTime != 0)
+            {
+                const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                m_LastRecovery = now - changeTime;
+                m_LastRecoveryMisses = m_FramePool->CountMisses() - m_FormatChangeMisses;
+            }
+        }
+
         // Retrieve the video data.
         std::uint8_t* videoData;
         ShouldOK(videoFrame->GetBytes(reinterpret_cast<void**>(&videoData)));
@@ -270,6 +356,32 @@ namespace MediaBlackmagic
         const auto videoStreamTimestamp = GetVideoStreamTimestamp(videoFrame);
         const auto videoTimecode = GetVideoTimecode(videoFrame);
 
+        // Deviation of the inter-arrival time from the nominal frame duration.
+        const auto arrivalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(arrivalTime.time_since_epoch()).count();
+        if (m_LastArrivalTime != 0)
+        {
+            const auto interval = arrivalNs - m_LastArrivalTime;
+            const auto nominal = 1000000000LL * duration / scale;
+            m_Metrics.Record(EDeviceMetric::InputJitter, std::abs(interval - nominal));
+        }
+        m_LastArrivalTime = arrivalNs;
+
+        m_Status.IncrementProcessedFrames();
+        m_Status.SetPixelFormat(videoPixelFormat);
+
+        // Route the frame to its output before handing it to Unity.
+        {
+            std::lock_guard<std::mutex> lock(m_PassthroughRouteLock);
+            if (m_PassthroughRoute != nullptr)
+            {
+                m_PassthroughRoute->OnInputFrame(videoFrame,
+                                                 audioPacket,
+                                                 videoTimecode,
+                                                 videoHardwareReferenceTimestamp,
+                                                 videoFrameDuration);
+            }
+        }
+
         // Read the HDR metadata if available.
         if (videoFrame->GetFlags() & bmdFrameContainsHDRMetadata)
         {
@@ -312,6 +424,7 @@ namespace MediaBlackmagic
         // Invoke the frame received callback.
         if (s_FrameArrivedCallback != nullptr)
         {
+            TraceSpan deliverySpan(ETraceSpan::ManagedDelivery, m_Index, traceFlow);
             s_FrameArrivedCallback(
                 m_Index,
                 videoData,
@@ -333,10 +446,9 @@ namespace MediaBlackmagic
         }
 
         // Everything went well, this callback gives the information to the C# manager.
-        if (s_FrameErrorCallback != nullptr)
-        {
-            s_FrameErrorCallback(m_Index, EDeviceStatus::Ok, InputError::NoError, "");
-        }
+        ReportFrameError(EDeviceStatus::Ok, InputError::NoError, "");
+
+        m_Metrics.RecordDuration(EDeviceMetric::InputCallback, std::chrono::steady_clock::now() - arrivalTime);
 
         return S_OK;
     }
@@ -345,18 +457,33 @@ namespace MediaBlackmagic
     {
         if ((videoFrame->GetFlags() & bmdFrameHasNoInputSource))
         {
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::NoInputSource, "No input device signal found.");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::NoInputSource, "No input device signal found.");
             m_HasInputSource = false;
+            m_Status.SetSignalPresent(false);
             return S_FALSE;
         }
 
         m_HasInputSource = true;
+        m_Status.SetSignalPresent(true);
         return S_OK;
     }
 
+    void DeckLinkInputDevice::ReportFrameError(const EDeviceStatus status, const InputError error, const char* message)
+    {
+        m_Status.Report(status, static_cast<int>(error));
+
+        if (status != EDeviceStatus::Ok)
+        {
+            DeckLinkLogger::Log(m_ErrorLogLimits[static_cast<int>(error)], status == EDeviceStatus::Error ? ELogSeverity::Error : ELogSeverity::Warning,
+                                "Input %d: %s", m_Index, message);
+        }
+
+        if (s_FrameErrorCallback != nullptr)
+        {
+            s_FrameErrorCallback(m_Index, status, error, message);
+        }
+    }
+
     std::uint32_t DeckLinkInputDevice::GetVideoTimecode(IDeckLinkVideoInputFrame* frame)
     {
         IDeckLinkTimecode* timecode = nullptr;
@@ -412,74 +539,65 @@ namespace MediaBlackmagic
                                               bool enablePassThrough,
                                               UnityGfxRenderer graphicsAPI)
     {
-        // Device iterator
-        IDeckLinkIterator* iterator;
-        auto res = GetDeckLinkIterator(&iterator);
+        // The snapshot holds every card, so no iteration is needed to reach the device.
+        m_Capabilities = DeckLinkCapabilitySnapshot::Get();
+        m_DeviceSelected = deviceSelected;
 
-        if (res != S_OK)
+        const auto capabilities = m_Capabilities->GetDevice(deviceSelected);
+        if (capabilities == nullptr)
         {
+            m_Error = m_Capabilities->GetDevices().empty() ? "Could not find DeckLink driver." : "Invalid device index.";
             return false;
         }
 
-        // Iterate until reaching the specified index.
-        IDeckLink* device = nullptr;
-        for (auto i = 0; i <= deviceSelected; i++)
-        {
-            if (device != nullptr)
-                device->Release();
-            res = iterator->Next(&device);
-
-            if (res != S_OK)
-            {
-                iterator->Release();
-                return false;
-            }
-        }
-
-        iterator->Release(); // The iterator is no longer needed.
+        auto device = capabilities->device;
+        device->AddRef();
 
         // Input interface of the specified device
-        res = device->QueryInterface(IID_DeckLinkInput, reinterpret_cast<void**>(&m_Input));
+        auto res = device->QueryInterface(IID_DeckLinkInput, reinterpret_cast<void**>(&m_Input));
 
         EnablePassThrough(device, enablePassThrough);
 
+        if (res == S_OK && m_StatusPoller == nullptr)
+        {
+            m_StatusPoller = DeckLinkStatusPoller::Acquire(device, deviceSelected);
+            if (m_StatusPoller != nullptr)
+                m_StatusPoller->AttachStatus(&m_Status);
+        }
+
         device->Release();
 
         if (res != S_OK)
         {
+            m_Error = "Device has no input.";
             return false;
         }
 
-        // Display mode iterator
-        IDeckLinkDisplayModeIterator* dmIterator;
-        res = m_Input->GetDisplayModeIterator(&dmIterator);
-
-        assert(res == S_OK);
-
-        // Iterate until reaching the specified index.
-        for (auto i = 0; i <= formatIndex; i++)
+        if (m_DisplayMode != nullptr)
         {
-            if (m_DisplayMode != nullptr)
-            {
-                m_DisplayMode->Release();
-                m_DisplayMode = nullptr;
-            }
-            res = dmIterator->Next(&m_DisplayMode);
-
-            if (res != S_OK)
-            {
-                dmIterator->Release();
-                m_DisplayMode = nullptr;
-                return false;
-            }
+            m_DisplayMode->Release();
+            m_DisplayMode = nullptr;
         }
 
-        dmIterator->Release(); // The iterator is no longer needed.
+        // The format index follows the order of the display mode iterator.
+        const auto& inputModes = capabilities->inputModes;
+        if (formatIndex < 0 || formatIndex >= static_cast<int>(inputModes.size()) ||
+            m_Input->GetDisplayMode(inputModes[formatIndex].displayMode, &m_DisplayMode) != S_OK)
+        {
+            m_Error = "Invalid video format index.";
+            m_DisplayMode = nullptr;
+            return false;
+        }
 
         // Set this object as a frame input callback.
         res = m_Input->SetCallback(this);
         assert(res == S_OK);
 
+        // The frame buffers outlive the format changes.
+        m_FramePool = new DeckLinkInputFramePool();
+        res = m_Input->SetVideoInputFrameMemoryAllocator(m_FramePool);
+        assert(res == S_OK);
+
         m_InvalidPixelFormat = false;
 
         // Try getting best quality
@@ -500,21 +618,23 @@ namespace MediaBlackmagic
         // callback is triggered, with the real video settings.
         if (!IsPixelFormatSupportedInCurrentMode(bmdFormat8BitYUV, m_DisplayMode->GetDisplayMode()))
         {
+            m_Error = "Unsupported video format (8-bit YUV isn't supported in this display mode).";
             return false;
         }
 
+        ReserveFramePool();
+
         // Enable the video input.
         res = m_Input->EnableVideoInput(m_DisplayMode->GetDisplayMode(),
                                         m_CurrentPixelFormat,
-                                        bmdVideoInputEnableFormatDetection);
+                                        GetVideoInputFlags());
 
         if (res != S_OK)
         {
+            m_Error = "Can't start input device (possibly already used).";
+
             // TODO: Rewrite the 'Error Callback' system, because this callback is triggered too soon (before the plugin creation).
-            if (s_FrameErrorCallback != nullptr)
-            {
-                s_FrameErrorCallback(m_Index, EDeviceStatus::Error, InputError::DeviceAlreadyUsed, "Can't start input device (possibly already used).");
-            }
+            ReportFrameError(EDeviceStatus::Error, InputError::DeviceAlreadyUsed, "Can't start input device (possibly already used).");
             return false;
         }
 
@@ -522,12 +642,17 @@ namespace MediaBlackmagic
         res = m_Input->EnableAudioInput(m_AudioSampleRate, m_AudioSampleType, m_ChannelCount);
         if (res != S_OK)
         {
-            // todo : report error
+            m_Error = "Can't enable the audio input.";
             return false;
         }
 
         m_Index = deviceIndex;
         m_GraphicsAPI = graphicsAPI;
+        m_Status.Reset();
+        m_Status.SetDeviceIndex(deviceIndex);
+        m_Metrics.Reset();
+        m_Metrics.SetDeviceIndex(deviceIndex);
+        m_Status.SetPixelFormat(m_CurrentPixelFormat);
         m_Initialized = true;
 
         return true;
@@ -686,6 +811,13 @@ namespace MediaBlackmagic
 
     dlbool_t DeckLinkInputDevice::IsPixelFormatSupportedInCurrentMode(BMDPixelFormat pix, BMDDisplayMode displayMode)
     {
+        bool isKnownSupported;
+        if (m_Capabilities != nullptr &&
+            m_Capabilities->TryIsInputPixelFormatSupported(m_DeviceSelected, displayMode, pix, isKnownSupported))
+        {
+            return isKnownSupported;
+        }
+
         dlbool_t isSupported;
         auto res = m_Input->DoesSupportVideoMode(
             bmdVideoConnectionUnspecified,
@@ -855,6 +987,95 @@ namespace MediaBlackmagic
         m_Configuration->SetFlag(bmdDeckLinkConfig444SDIVideoOutput, IsRGBPixelFormat(m_CurrentPixelFormat));
     }
 
+    BMDVideoInputFlags DeckLinkInputDevice::GetVideoInputFlags() const
+    {
+        // Format detection is used on every platform when the card supports it.
+        const auto capabilities = m_Capabilities != nullptr ? m_Capabilities->GetDevice(m_DeviceSelected) : nullptr;
+        if (capabilities != nullptr && !capabilities->inputFormatDetection)
+            return bmdVideoInputFlagDefault;
+
+        return bmdVideoInputEnableFormatDetection;
+    }
+
+    void DeckLinkInputDevice::ReserveFramePool()
+    {
+        if (m_FramePool == nullptr || m_DisplayMode == nullptr)
+            return;
+
+        // The pixel formats the next change may switch to: the requested one, or any of the
+        // formats the detection picks from.
+        static const BMDPixelFormat detectedFormats[] = { bmdFormat8BitYUV, bmdFormat10BitYUV, bmdFormat10BitRGB, bmdFormat10BitRGBX, bmdFormat10BitRGBXLE, bmdFormat12BitRGB, bmdFormat12BitRGBLE };
+        const auto requested = m_DesiredPixelFormat != bmdFormatUnspecified;
+        const auto pixelFormats = requested ? &m_DesiredPixelFormat : detectedFormats;
+        const auto pixelFormatCount = requested ? 1 : static_cast<int>(sizeof(detectedFormats) / sizeof(detectedFormats[0]));
+
+        const auto width = static_cast<std::int32_t>(m_DisplayMode->GetWidth());
+        const auto height = static_cast<std::int32_t>(m_DisplayMode->GetHeight());
+
+        // The current frames, in the format they are captured with.
+        auto bufferSize = DeckLinkInputFramePool::GetRowBytes(m_CurrentPixelFormat, width) * static_cast<std::uint32_t>(height);
+
+        // The format detection only switches the pixel format, or the rate and the scanning of
+        // the same resolution: the modes of the current size are the likely next ones. A
+        // candidate which doesn't fit the budget is left to the driver to allocate on demand.
+        const auto maxCandidateSize = k_MaxReservedBytes / static_cast<std::uint64_t>(kReservedFrameBuffers);
+        const auto capabilities = m_Capabilities != nullptr ? m_Capabilities->GetDevice(m_DeviceSelected) : nullptr;
+        for (auto i = 0; i < pixelFormatCount; i++)
+        {
+            auto supported = capabilities == nullptr;
+            if (capabilities != nullptr)
+            {
+                const auto bit = DeckLinkCapabilitySnapshot::GetPixelFormatBit(pixelFormats[i]);
+                for (const auto& mode : capabilities->inputModes)
+                {
+                    if (mode.width == width && mode.height == height &&
+                        (bit < 0 || (mode.pixelFormats & (1u << bit)) != 0))
+                    {
+                        supported = true;
+                        break;
+                    }
+                }
+            }
+
+            const auto size = DeckLinkInputFramePool::GetRowBytes(pixelFormats[i], width) * static_cast<std::uint32_t>(height);
+            if (supported && size <= maxCandidateSize)
+                bufferSize = std::max(bufferSize, size);
+        }
+
+        const auto count = bufferSize > 0 ? std::min(static_cast<std::uint64_t>(kReservedFrameBuffers), k_MaxReservedBytes / bufferSize) : 0;
+        m_FramePool->Reserve(bufferSize, static_cast<int>(count));
+    }
+
+    void DeckLinkInputDevice::RecordFormatChange(const std::chrono::steady_clock::time_point start)
+    {
+        const auto end = std::chrono::steady_clock::now();
+        const auto restart = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+        m_LastRestart = restart;
+        if (restart > m_MaxRestart.load(std::memory_order_relaxed))
+        {
+            m_MaxRestart = restart;
+        }
+        m_FormatChanges.fetch_add(1, std::memory_order_relaxed);
+
+        // The recovery ends with the first frame in the new format.
+        m_FormatChangeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+    }
+
+    void DeckLinkInputDevice::GetFormatChangeStatistics(InputFormatChangeStatistics* statistics) const
+    {
+        statistics->lastRestart = m_LastRestart.load(std::memory_order_relaxed);
+        statistics->maxRestart = m_MaxRestart.load(std::memory_order_relaxed);
+        statistics->lastRecovery = m_LastRecovery.load(std::memory_order_relaxed);
+        statistics->formatChanges = m_FormatChanges.load(std::memory_order_relaxed);
+        statistics->lastRecoveryMisses = m_LastRecoveryMisses.load(std::memory_order_relaxed);
+
+        const auto pool = m_FramePool;
+        statistics->pooledBytes = pool != nullptr ? pool->CountBytes() : 0;
+        statistics->poolMisses = pool != nullptr ? pool->CountMisses() : 0;
+        statistics->pooledBuffers = pool != nullptr ? pool->CountBuffers() : 0;
+    }
+
     bool DeckLinkInputDevice::IsRGBPixelFormat(BMDPixelFormat pixeFormat) const
     {
         assert(m_DisplayMode != nullptr);
@@ -0,0 +1,229 @@
+#include <algorithm>
+
+#include "DeckLinkInputFramePool.h"
+#include "DeckLinkProfiler.h"
+
+namespace MediaBlackmagic
+{
+    DeckLinkInputFramePool::DeckLinkInputFramePool() :
+        m_RefCount(1),
+        m_Misses(0),
+        m_ReserveSize(0),
+        m_ReserveCount(0),
+        m_Stopping(false)
+    {
+        m_Thread = std::thread(&DeckLinkInputFramePool::Run, this);
+    }
+
+    DeckLinkInputFramePool::~DeckLinkInputFramePool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Condition.notify_all();
+
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+
+        // The driver released every buffer before releasing the allocator.
+        for (const auto& buffer : m_BufferSizes)
+        {
+            FreePageAlignedBuffer(buffer.first);
+        }
+    }
+
+    void DeckLinkInputFramePool::Reserve(const std::uint32_t bufferSize, const int count)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_ReserveSize = bufferSize;
+            m_ReserveCount = std::min(count, static_cast<int>(kMaxFreeBuffers));
+        }
+        m_Condition.notify_all();
+    }
+
+    std::uint32_t DeckLinkInputFramePool::GetRowBytes(const BMDPixelFormat pixelFormat, const std::int32_t width)
+    {
+        const auto w = static_cast<std::uint32_t>(std::max(width, 0));
+
+        switch (pixelFormat)
+        {
+        case bmdFormat8BitYUV:
+            return w * 2;
+        case bmdFormat10BitYUV:
+            return ((w + 47) / 48) * 128;
+        case bmdFormat8BitARGB:
+        case bmdFormat8BitBGRA:
+            return w * 4;
+        case bmdFormat10BitRGB:
+        case bmdFormat10BitRGBXLE:
+        case bmdFormat10BitRGBX:
+            return ((w + 63) / 64) * 256;
+        case bmdFormat12BitRGB:
+        case bmdFormat12BitRGBLE:
+            return (w * 36) / 8;
+        default:
+            return 0;
+        }
+    }
+
+    int DeckLinkInputFramePool::CountBuffers() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return static_cast<int>(m_BufferSizes.size());
+    }
+
+    std::int64_t DeckLinkInputFramePool::CountBytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        std::int64_t bytes = 0;
+        for (const auto& buffer : m_BufferSizes)
+        {
+            bytes += buffer.second;
+        }
+        return bytes;
+    }
+
+    void DeckLinkInputFramePool::Run()
+    {
+        SetCurrentThreadBackgroundPriority();
+        ProfilerThreadScope thread("Input Frame Pool");
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        while (true)
+        {
+            const auto missingBuffers = [this]()
+            {
+                const auto large = std::count_if(m_BufferSizes.begin(), m_BufferSizes.end(),
+                    [this](const std::pair<void* const, std::uint32_t>& buffer) { return buffer.second >= m_ReserveSize; });
+                return m_ReserveSize > 0 && large < m_ReserveCount;
+            };
+
+            m_Condition.wait(lock, [&] { return m_Stopping || missingBuffers(); });
+
+            if (m_Stopping)
+                return;
+
+            // Allocate outside the lock, so the driver is never blocked by the reservation.
+            const auto size = m_ReserveSize;
+            lock.unlock();
+            auto buffer = AllocatePageAlignedBuffer(size);
+            lock.lock();
+
+            if (buffer == nullptr)
+            {
+                // Out of memory: the driver will allocate on demand.
+                m_ReserveCount = 0;
+                continue;
+            }
+
+            m_BufferSizes[buffer] = size;
+            m_FreeBuffers.push_back(buffer);
+            TrimFreeBuffers();
+        }
+    }
+
+    void DeckLinkInputFramePool::TrimFreeBuffers()
+    {
+        while (m_FreeBuffers.size() > kMaxFreeBuffers)
+        {
+            auto smallest = std::min_element(m_FreeBuffers.begin(), m_FreeBuffers.end(),
+                [this](void* lhs, void* rhs) { return m_BufferSizes[lhs] < m_BufferSizes[rhs]; });
+
+            FreePageAlignedBuffer(*smallest);
+            m_BufferSizes.erase(*smallest);
+            m_FreeBuffers.erase(smallest);
+        }
+    }
+
+    HRESULT STDMETHODCALLTYPE DeckLinkInputFramePool::QueryInterface(REFIID iid, LPVOID* ppv)
+    {
+        if (iid == IID_IUnknown || iid == IID_IDeckLinkMemoryAllocator)
+        {
+            *ppv = static_cast<IDeckLinkMemoryAllocator*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE DeckLinkInputFramePool::AddRef()
+    {
+        return m_RefCount.fetch_add(1) + 1;
+    }
+
+    ULONG STDMETHODCALLTYPE DeckLinkInputFramePool::Release()
+    {
+        const auto count = m_RefCount.fetch_sub(1) - 1;
+        if (count == 0)
+            delete this;
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE DeckLinkInputFramePool::AllocateBuffer(const unsigned int bufferSize, void** allocatedBuffer)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            // The smallest free buffer which fits.
+            auto best = m_FreeBuffers.end();
+            for (auto it = m_FreeBuffers.begin(); it != m_FreeBuffers.end(); ++it)
+            {
+                const auto size = m_BufferSizes[*it];
+                if (size >= bufferSize && (best == m_FreeBuffers.end() || size < m_BufferSizes[*best]))
+                {
+                    best = it;
+                }
+            }
+
+            if (best != m_FreeBuffers.end())
+            {
+                *allocatedBuffer = *best;
+                m_FreeBuffers.erase(best);
+                return S_OK;
+            }
+        }
+
+        m_Misses.fetch_add(1, std::memory_order_relaxed);
+
+        *allocatedBuffer = AllocatePageAlignedBuffer(bufferSize);
+        if (*allocatedBuffer == nullptr)
+            return E_OUTOFMEMORY;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_BufferSizes[*allocatedBuffer] = bufferSize;
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE DeckLinkInputFramePool::ReleaseBuffer(void* buffer)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_FreeBuffers.push_back(buffer);
+            TrimFreeBuffers();
+        }
+
+        // The trimmed buffer may have been a reserved one.
+        m_Condition.notify_all();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE DeckLinkInputFramePool::Commit()
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE DeckLinkInputFramePool::Decommit()
+    {
+        // The buffers are kept while the input is disabled: they are reused when it is enabled
+        // again with the next format.
+        return S_OK;
+    }
+}
@@ -0,0 +1,367 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "DeckLinkLogger.h"
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        const std::size_t k_RingCapacity = 4096;                       // Power of two.
+        const int k_BackupCount = 2;
+        const auto k_WriteInterval = std::chrono::milliseconds(100);
+
+        // One message in the ring. The sequence tells the producers and the writer whose turn it is.
+        struct LogCell
+        {
+            std::atomic<std::uint64_t>  sequence;
+            std::int64_t                time;           // System clock, in milliseconds.
+            std::int32_t                severity;
+            std::uint32_t               suppressed;
+            char                        text[DeckLinkLogger::kMaxMessageLength + 1];
+        };
+
+        const char k_SeverityLetters[] = { 'D', 'I', 'W', 'E' };
+
+        std::string GetDefaultPath()
+        {
+#if _WIN64
+            return "C:/Blackmagic/Debug_BMD.txt";
+#else
+            const auto directory = std::getenv("TMPDIR");
+            return std::string(directory != nullptr && *directory != '\0' ? directory : "/tmp") + "/Blackmagic_Log.log";
+#endif
+        }
+
+        std::int64_t GetTimeMs()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        // State shared by the producers and the writer. It is never destroyed, so late messages of
+        // threads still running at process exit stay valid.
+        struct LoggerState
+        {
+            LoggerState() :
+                cells(new LogCell[k_RingCapacity]),
+                tail(0),
+                head(0),
+                dropped(0),
+                path(GetDefaultPath()),
+                maxFileBytes(DeckLinkLogger::kDefaultMaxFileBytes),
+                pathChanged(true),
+                stopping(false),
+                file(nullptr),
+                fileBytes(0)
+            {
+                for (std::size_t i = 0; i < k_RingCapacity; ++i)
+                {
+                    cells[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            std::unique_ptr<LogCell[]>  cells;
+            std::atomic<std::uint64_t>  tail;           // Next cell claimed by a producer.
+            std::uint64_t               head;           // Next cell read by the writer.
+            std::atomic<std::uint64_t>  dropped;
+
+            std::mutex                  mutex;
+            std::condition_variable     condition;
+            std::string                 path;
+            std::int64_t                maxFileBytes;
+            bool                        pathChanged;
+            bool                        stopping;
+            std::thread                 writer;
+
+            // Owned by the writer thread.
+            std::FILE*                  file;
+            std::int64_t                fileBytes;
+            std::string                 batch;
+        };
+
+        LoggerState& GetState()
+        {
+            static auto state = new LoggerState();
+            return *state;
+        }
+
+        void RotateFile(const std::string& path)
+        {
+            for (auto i = k_BackupCount; i > 0; --i)
+            {
+                const auto from = i > 1 ? path + "." + std::to_string(i - 1) : path;
+                const auto to = path + "." + std::to_string(i);
+                std::remove(to.c_str());
+                std::rename(from.c_str(), to.c_str());
+            }
+        }
+
+        void OpenFile(LoggerState& state, const std::string& path, const bool rotate)
+        {
+            if (state.file != nullptr)
+            {
+                std::fclose(state.file);
+                state.file = nullptr;
+            }
+
+            // Every session starts a new file and keeps the previous ones as backups.
+            if (rotate)
+            {
+                RotateFile(path);
+            }
+
+            state.file = std::fopen(path.c_str(), "ab");
+            state.fileBytes = 0;
+        }
+
+        void FormatCell(std::string& batch, const LogCell& cell)
+        {
+            const auto seconds = static_cast<std::time_t>(cell.time / 1000);
+            std::tm local = {};
+#if _WIN64
+            localtime_s(&local, &seconds);
+#else
+            localtime_r(&seconds, &local);
+#endif
+
+            char prefix[48];
+            const auto severity = cell.severity >= 0 && cell.severity < 4 ? k_SeverityLetters[cell.severity] : '?';
+            std::snprintf(prefix, sizeof(prefix), "%04d-%02d-%02d %02d:%02d:%02d.%03d [%c] ",
+                          local.tm_year + 1900, local.tm_mon + 1, local.tm_mday,
+                          local.tm_hour, local.tm_min, local.tm_sec, static_cast<int>(cell.time % 1000), severity);
+
+            batch += prefix;
+            batch += cell.text;
+
+            // The messages of the former API end with their own line break.
+            if (!batch.empty() && batch.back() == '\n')
+                batch.pop_back();
+
+            if (cell.suppressed > 0)
+            {
+                batch += " (" + std::to_string(cell.suppressed) + " similar messages suppressed)";
+            }
+            batch += '\n';
+        }
+
+        // Moves the available messages into the batch. Only called by the writer.
+        void DrainRing(LoggerState& state)
+        {
+            while (true)
+            {
+                auto& cell = state.cells[state.head & (k_RingCapacity - 1)];
+                if (cell.sequence.load(std::memory_order_acquire) != state.head + 1)
+                    break;
+
+                FormatCell(state.batch, cell);
+                cell.sequence.store(state.head + k_RingCapacity, std::memory_order_release);
+                ++state.head;
+            }
+        }
+
+        void WriteBatch(LoggerState& state, const std::string& path, const std::int64_t maxFileBytes)
+        {
+            if (state.batch.empty())
+                return;
+
+            if (state.file != nullptr)
+            {
+                std::fwrite(state.batch.data(), 1, state.batch.size(), state.file);
+                std::fflush(state.file);
+                state.fileBytes += static_cast<std::int64_t>(state.batch.size());
+
+                if (maxFileBytes > 0 && state.fileBytes >= maxFileBytes)
+                {
+                    OpenFile(state, path, true);
+                }
+            }
+
+            state.batch.clear();
+        }
+
+        void RunWriter()
+        {
+            auto& state = GetState();
+            std::unique_lock<std::mutex> lock(state.mutex);
+
+            while (true)
+            {
+                if (state.pathChanged)
+                {
+                    const auto path = state.path;
+                    state.pathChanged = false;
+
+                    lock.unlock();
+                    OpenFile(state, path, true);
+                    lock.lock();
+                }
+
+                const auto path = state.path;
+                const auto maxFileBytes = state.maxFileBytes;
+                const auto stopping = state.stopping;
+
+                lock.unlock();
+                DrainRing(state);
+                WriteBatch(state, path, maxFileBytes);
+                lock.lock();
+
+                if (stopping)
+                    break;
+
+                state.condition.wait_for(lock, k_WriteInterval);
+            }
+
+            if (state.file != nullptr)
+            {
+                std::fclose(state.file);
+                state.file = nullptr;
+            }
+        }
+
+        void Enqueue(const ELogSeverity severity, const std::uint32_t suppressed, const char* format, va_list arguments)
+        {
+            auto& state = GetState();
+
+            auto position = state.tail.load(std::memory_order_relaxed);
+            LogCell* cell = nullptr;
+            while (true)
+            {
+                cell = &state.cells[position & (k_RingCapacity - 1)];
+                const auto sequence = cell->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::int64_t>(sequence - position);
+
+                if (difference == 0)
+                {
+                    if (state.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    // The writer is behind: drop rather than wait.
+                    state.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                {
+                    position = state.tail.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->time = GetTimeMs();
+            cell->severity = static_cast<std::int32_t>(severity);
+            cell->suppressed = suppressed;
+            std::vsnprintf(cell->text, sizeof(cell->text), format, arguments);
+
+            cell->sequence.store(position + 1, std::memory_order_release);
+
+            // Errors are written right away; the other messages wait for the next batch.
+            if (severity >= ELogSeverity::Error)
+            {
+                state.condition.notify_one();
+            }
+        }
+    }
+
+    std::atomic<int> DeckLinkLogger::s_Severity(static_cast<int>(ELogSeverity::Off));
+
+    LogRateLimit::LogRateLimit(const int intervalMs) :
+        m_IntervalNs(static_cast<std::int64_t>(intervalMs) * 1000000),
+        m_Next(0),
+        m_Suppressed(0)
+    {
+    }
+
+    bool LogRateLimit::Allow(std::uint32_t& suppressed)
+    {
+        const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        auto next = m_Next.load(std::memory_order_relaxed);
+        if (now < next || !m_Next.compare_exchange_strong(next, now + m_IntervalNs, std::memory_order_relaxed))
+        {
+            m_Suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        suppressed = m_Suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    void DeckLinkLogger::Configure(const char* path, const ELogSeverity severity, const std::int64_t maxFileBytes)
+    {
+        auto& state = GetState();
+        std::unique_lock<std::mutex> lock(state.mutex);
+
+        if (path != nullptr && *path != '\0' && state.path != path)
+        {
+            state.path = path;
+            state.pathChanged = true;
+        }
+        state.maxFileBytes = maxFileBytes;
+        s_Severity.store(static_cast<int>(severity), std::memory_order_relaxed);
+
+        if (severity == ELogSeverity::Off)
+        {
+            if (state.writer.joinable())
+            {
+                state.stopping = true;
+                lock.unlock();
+                state.condition.notify_all();
+                state.writer.join();
+                lock.lock();
+                state.stopping = false;
+                state.pathChanged = true;
+            }
+            return;
+        }
+
+        if (!state.writer.joinable())
+        {
+            state.writer = std::thread(RunWriter);
+        }
+        else
+        {
+            state.condition.notify_all();
+        }
+    }
+
+    void DeckLinkLogger::Shutdown()
+    {
+        Configure(nullptr, ELogSeverity::Off, GetState().maxFileBytes);
+    }
+
+    void DeckLinkLogger::Log(const ELogSeverity severity, const char* format, ...)
+    {
+        if (!IsEnabled(severity))
+            return;
+
+        va_list arguments;
+        va_start(arguments, format);
+        Enqueue(severity, 0, format, arguments);
+        va_end(arguments);
+    }
+
+    void DeckLinkLogger::Log(LogRateLimit& limit, const ELogSeverity severity, const char* format, ...)
+    {
+        std::uint32_t suppressed = 0;
+        if (!IsEnabled(severity) || !limit.Allow(suppressed))
+            return;
+
+        va_list arguments;
+        va_start(arguments, format);
+        Enqueue(severity, suppressed, format, arguments);
+        va_end(arguments);
+    }
+
+    std::uint64_t DeckLinkLogger::CountDropped()
+    {
+        return GetState().dropped.load(std::memory_order_relaxed);
+    }
+}
@@ -1,6 +1,10 @@
 #include <iostream>
 #include "DeckLinkOutputDevice.h"
 #include "DeckLinkDeviceUtilities.h"
+#include "DeckLinkEventRecorder.h"
+#include "DeckLinkPassthroughRoute.h"
+#include "DeckLinkProfiler.h"
+#include "DeckLinkTracer.h"
 #include "PluginUtils.h"
 
 namespace MediaBlackmagic
@@ -22,7 +26,6 @@ namespace MediaBlackmagic
         m_TimeScale(1),
         m_LateFrameCount(0),
         m_DroppedFrameCount(0),
-        m_OutputFormatData(),
         m_RefCount(1),
         m_Error(""),
         m_AudioStreamTime(0),
@@ -30,6 +33,14 @@ namespace MediaBlackmagic
         m_AudioChannelCount(0),
         m_Queued(0),
         m_Completed(0),
+        m_Status(EDeviceDirection::Output),
+        m_Metrics(EDeviceDirection::Output),
+        m_LateLogLimit(1000),
+        m_DroppedLogLimit(1000),
+        m_FeedTraceFlow(0),
+        m_ScheduleTraceFlow(0),
+        m_StatusPoller(nullptr),
+        m_DeviceSelected(-1),
         m_DefaultScheduleTime(0.0f),
         m_IsAsync(true),
         m_KeyingMode(EOutputKeyingMode::None),
@@ -39,23 +50,23 @@ namespace MediaBlackmagic
         m_Configuration(nullptr),
         m_UseGPUDirect(false),
         m_IsGPUDirectAvailable(false),
-        m_Stopped(false)
+        m_Stopped(false),
+        m_StopRequested(false),
+        m_StopPending(false),
+        m_StaleStopCallbacks(0),
+        m_Reconfiguring(false),
+        m_Preroll(0),
+        m_LinkMode(EOutputLinkMode::Single),
+        m_PassthroughRoute(nullptr)
 #if _WIN64
         ,m_OutputGPUDirect(nullptr)
 #endif
     {
-#if _WIN64
-        m_ThreadedMemcpy.Initialize();
-#endif
 //InitLog();
     }
 
     DeckLinkOutputDevice::~DeckLinkOutputDevice()
     {
-#if _WIN64
-        m_ThreadedMemcpy.Destroy();
-#endif
-
         // Internal objects should have been released.
         assert(m_Output == nullptr);
         assert(m_DisplayMode == nullptr);
@@ -96,46 +107,47 @@ namespace MediaBlackmagic
 
     bool DeckLinkOutputDevice::IsReferenceLocked() const
     {
-        assert(m_Output != nullptr);
-        BMDReferenceStatus stat;
-        ShouldOK(m_Output->GetReferenceStatus(&stat));
-        return stat & bmdReferenceLocked;
+        // Sampled by the status poller, so this doesn't query the driver.
+        return m_StatusPoller != nullptr && m_StatusPoller->IsReferenceLocked();
     }
 
-    const std::string& DeckLinkOutputDevice::GetErrorString() const
+    bool DeckLinkOutputDevice::GetHardwareClockPhase(std::int64_t& phase) const
     {
-        return m_Error;
-    }
+        if (m_Output == nullptr)
+            return false;
 
-    const std::string& DeckLinkOutputDevice::RetrievePixelFormat()
-    {
-        std::lock_guard<std::mutex> lock(m_Mutex);
+        BMDTimeValue hardwareTime;
+        BMDTimeValue timeInFrame;
+        BMDTimeValue ticksPerFrame;
+        if (m_Output->GetHardwareReferenceClock(flicksPerSecond, &hardwareTime, &timeInFrame, &ticksPerFrame) != S_OK)
+            return false;
 
-        // Cache the Pixel Format value if it hasn't changed.
-        if (!m_OutputFormatData.pixelFormatChanged)
-        {
-            return m_OutputFormatData.pixelFormatValue;
-        }
+        phase = timeInFrame;
+        return true;
+    }
 
-        IDeckLinkStatus* deckLinkStatus = NULL;
-        if (m_Output->QueryInterface(IID_IDeckLinkStatus, (void**)&deckLinkStatus) != S_OK)
-        {
-            return m_OutputFormatData.pixelFormatValue;
-        }
+    int DeckLinkOutputDevice::GetMaxQueuedFrames() const
+    {
+        // Async mode schedules a frame per completed one, on top of the preroll; manual mode
+        // refuses the frames beyond the limit.
+        return IsAsyncMode() ? m_Preroll + 1 : static_cast<int>(kMaxBufferedFrames);
+    }
 
-        if (!GetDeckLinkStatus(deckLinkStatus,
-            bmdDeckLinkStatusLastVideoOutputPixelFormat,
-            m_OutputFormatData.pixelFormatValue).empty())
-        {
-            m_OutputFormatData.pixelFormatChanged = false;
-        }
+    const std::string& DeckLinkOutputDevice::GetErrorString() const
+    {
+        return m_Error;
+    }
 
-        deckLinkStatus->Release();
+    const char* DeckLinkOutputDevice::RetrievePixelFormat() const
+    {
+        // Sampled by the status poller, so this doesn't query the driver.
+        if (m_StatusPoller == nullptr || m_StatusPoller->GetOutputPixelFormat() == 0)
+            return "";
 
-        return m_OutputFormatData.pixelFormatValue;
+        return getPixelFormatName(kPixelFormatMappings, m_StatusPoller->GetOutputPixelFormat());
     }
 
-    void DeckLinkOutputDevice::StartAsyncMode(
+    bool DeckLinkOutputDevice::StartAsyncMode(
         int deviceIndex,
         int deviceSelected,
         BMDDisplayMode mode,
@@ -164,7 +176,7 @@ namespace MediaBlackmagic
             audioChannelCount,
             audioSampleRate,
             useGPUDirect))
-            return;
+            return false;
         m_IsAsync = true;
 
         // Prerolling
@@ -175,20 +187,8 @@ namespace MediaBlackmagic
             auto frameUsedToPrerolled = m_OutputVideoFrameQueue.front();
             m_OutputVideoFrameQueue.push_back(frameUsedToPrerolled);
             m_OutputVideoFrameQueue.pop_front();
-            m_Frame.m_VideoFrame = frameUsedToPrerolled;
 
-            for (auto i = 0; i < preroll; i++)
-            {
-                const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
-                if (isHDR)
-                {
-                    ScheduleFrame(&m_Frame);
-                }
-                else
-                {
-                    ScheduleFrame(m_Frame.m_VideoFrame);
-                }
-            }
+            PrerollFrames(frameUsedToPrerolled);
         }
 
         if (m_PrerollingAudio)
@@ -199,12 +199,19 @@ namespace MediaBlackmagic
 
         // Access denied: the SDI port is already used by another software.
         if (m_Output->StartScheduledPlayback(0, m_TimeScale, 1) != S_OK)
-            return;
+        {
+            m_Error = "Can't start the playback (the SDI port is possibly used by another application).";
+            return false;
+        }
+
+        m_Status.SetPixelFormat(m_PixelFormat);
+        m_Status.SetSignalPresent(true);
 
         m_Initialized = true;
+        return true;
     }
 
-    void DeckLinkOutputDevice::StartManualMode(
+    bool DeckLinkOutputDevice::StartManualMode(
         int deviceIndex,
         int deviceSelected,
         BMDDisplayMode mode,
@@ -232,7 +239,7 @@ namespace MediaBlackmagic
             audioChannelCount,
             audioSampleRate,
             useGPUDirect))
-            return;
+            return false;
         m_IsAsync = false;
 
         //Prerolling
@@ -243,45 +250,73 @@ namespace MediaBlackmagic
             m_OutputVideoFrameQueue.pop_front();
 
             if (newFrame == nullptr)
-                return;
-
-            for (auto i = 0; i < preroll; i++)
             {
-                const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
-                if (isHDR)
-                {
-                    auto newHDRFrame = new DeckLinkOutputDevice::HDRVideoFrame(true, newFrame, m_ColorSpace);
-                    ScheduleFrame(newHDRFrame);
-
-                    m_HDRFrames.push_back(newHDRFrame);
-                }
-                else
-                {
-                    ScheduleFrame(newFrame);
-                }
+                m_Error = "Can't allocate the output frames.";
+                return false;
             }
+
+            PrerollFrames(newFrame);
         }
 
         // Access denied: the SDI port is already used by another software.
         if (m_Output->StartScheduledPlayback(0, m_TimeScale, 1) != S_OK)
-            return;
+        {
+            m_Error = "Can't start the playback (the SDI port is possibly used by another application).";
+            return false;
+        }
+
+        m_Status.SetPixelFormat(m_PixelFormat);
+        m_Status.SetSignalPresent(true);
 
         m_Initialized = true;
+        return true;
     }
 
-    void DeckLinkOutputDevice::Stop()
+    void DeckLinkOutputDevice::BeginStop()
+    {
+        // The device may still be opening on its worker.
+        m_Readiness.Join();
+
+        // The submission worker feeds frames through the mutex, so it must be stopped first.
+        m_SubmissionQueue.Stop();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_Output == nullptr || m_StopRequested)
+            return;
+
+        // ScheduledPlaybackHasStopped is only called if the playback was running.
+        m_StopRequested = true;
+        m_StopPending = (m_Output->StopScheduledPlayback(0, nullptr, 0) == S_OK);
+    }
+
+    bool DeckLinkOutputDevice::WaitStopped(std::chrono::steady_clock::time_point deadline)
     {
         std::unique_lock<std::mutex> lock(m_Mutex);
 
+        if (!m_StopPending)
+            return true;
+
+        return m_PlaybackStoppedCondition.wait_until(lock, deadline, [this] { return m_Stopped == true; });
+    }
+
+    void DeckLinkOutputDevice::Stop()
+    {
+        Stop(std::chrono::steady_clock::now() + std::chrono::milliseconds(200));
+    }
+
+    void DeckLinkOutputDevice::Stop(const std::chrono::steady_clock::time_point deadline)
+    {
+        ProfilerSample sample(EProfilerMarker::CloseDevice, m_Index);
+
         // First stop the output stream, so frame and displayMode may be released.
+        BeginStop();
+        WaitStopped(deadline);
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
         if (m_Output != nullptr)
         {
-            m_Output->StopScheduledPlayback(0, nullptr, 0);
-            {
-                // Wait for scheduled playback to complete
-                m_PlaybackStoppedCondition.wait_for(lock, std::chrono::milliseconds(200), [this] { return m_Stopped == true; });
-            }
-
             // TODO: There is a weird crash in the Blackmagic API when we are running our new Unit Tests
             // with the Test Runner Unity API on macOS. It never happens when we are running our device(s)
             // in 'Update In Editor' mode or in Playmode. Dirty fix right now is to not call the 2 methods below.
@@ -295,31 +330,9 @@ namespace MediaBlackmagic
             m_Output->SetScheduledFrameCompletionCallback(nullptr);
             m_Output->SetAudioCallback(nullptr);
         }
+        DeckLinkProfiler::UnregisterCallbackThreads(this);
 
-        while (!m_OutputVideoFrameQueue.empty())
-        {
-            auto frame = m_OutputVideoFrameQueue.front();
-            if (frame != nullptr)
-            {
-                // TODO: frames are currently not released correctly.
-                // This ensures that the video frames are finally deallocated.
-
-                int maxValue = frame->Release();
-                while (maxValue > 0 && frame->Release() > 0)
-                {
-                    maxValue--;
-                }
-                frame = nullptr;
-            }
-            m_OutputVideoFrameQueue.pop_front();
-        }
-
-        auto it = m_HDRFrames.begin();
-
-        while (it != m_HDRFrames.end())
-        {
-            it = m_HDRFrames.erase(it);
-        }
+        ReleaseFramePool();
 
 #if _WIN64
         if (m_OutputGPUDirect != nullptr)
@@ -352,6 +365,19 @@ namespace MediaBlackmagic
             m_Output = nullptr;
         }
 
+        m_StopRequested = false;
+        m_StopPending = false;
+        m_StaleStopCallbacks = 0;
+
+        if (m_StatusPoller != nullptr)
+        {
+            m_StatusPoller->DetachStatus(&m_Status);
+            m_StatusPoller->Release();
+            m_StatusPoller = nullptr;
+        }
+
+        m_Capabilities.reset();
+        m_Status.SetSignalPresent(false);
         m_Initialized = false;
     }
 
@@ -366,6 +392,15 @@ namespace MediaBlackmagic
         if ((!m_Error.empty() && (count > kMaxBufferedFrames)) || m_Stopped)
             return;
 
+        {
+            std::lock_guard<std::mutex> lock(m_PassthroughRouteMutex);
+            if (m_PassthroughRoute != nullptr)
+            {
+                m_PassthroughRoute->FeedOverlay(frameData, timecode);
+                return;
+            }
+        }
+
         const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
 
         if (!isHDR)
@@ -378,8 +413,42 @@ namespace MediaBlackmagic
         }
     }
 
+    bool DeckLinkOutputDevice::EnableAsyncSubmission(const int capacity, const ESubmissionBackpressure policy)
+    {
+        if (!m_Initialized)
+            return false;
+
+        // GPUDirect synchronizes with the D3D11 context, which must stay on the render thread.
+        if (m_UseGPUDirect)
+        {
+            m_Error = "Async submission is not supported with GPUDirect.";
+            return false;
+        }
+
+        return m_SubmissionQueue.Start(m_Index, capacity, policy, [this](void* frameData, unsigned int timecode)
+        {
+            FeedFrame(frameData, timecode);
+        });
+    }
+
+    void DeckLinkOutputDevice::DisableAsyncSubmission()
+    {
+        m_SubmissionQueue.Stop();
+    }
+
+    bool DeckLinkOutputDevice::SubmitFrame(void* frameData, const unsigned int timecode)
+    {
+        // Returns false when the frame was not queued; the caller keeps its buffer in that case.
+        const auto submitted = m_SubmissionQueue.Submit(frameData, timecode);
+        m_Metrics.Record(EDeviceMetric::DeliveryQueueDepth, m_SubmissionQueue.GetStatistics().queued);
+        return submitted;
+    }
+
     void DeckLinkOutputDevice::FeedFrameSDR(void* frameData, unsigned int timecode)
     {
+        ProfilerSample sample(EProfilerMarker::FeedFrameSDR, timecode);
+        TraceSpan traceSpan(ETraceSpan::FeedFrame, m_Index, TakeFeedTraceFlow());
+
         std::unique_lock<std::mutex> lock(m_Mutex);
 
         auto newFrame = m_OutputVideoFrameQueue.front();
@@ -398,30 +467,39 @@ namespace MediaBlackmagic
 
         ShouldOK(newFrame->GetBytes(&pointer));
         const std::uint32_t byteLen = GetFrameByteLength(width) * height;
+        const auto copyStart = std::chrono::steady_clock::now();
+        {
+            ProfilerSample copySample(EProfilerMarker::Copy, 0, byteLen);
 
 #if _WIN64
-        if (m_OutputGPUDirect != nullptr && m_IsGPUDirectAvailable)
-        {
-            m_OutputGPUDirect->StartGPUSynchronization(frameData, pointer);
-        }
-        else if (m_OutputGPUDirect == nullptr)
-        {
-            m_ThreadedMemcpy.MemcpyOperation(pointer, frameData, byteLen);
-        }
-        else
-        {
-            if (m_FrameErrorCallback != nullptr)
-                m_FrameErrorCallback(m_Index, "GPUDirect initialization failed.", EDeviceStatus::Error);
-            return;
-        }
+            if (m_OutputGPUDirect != nullptr && m_IsGPUDirectAvailable)
+            {
+                m_OutputGPUDirect->StartGPUSynchronization(frameData, pointer);
+            }
+            else if (m_OutputGPUDirect == nullptr)
+            {
+                m_FrameCopy.Copy(pointer, frameData, byteLen);
+            }
+            else
+            {
+                if (m_FrameErrorCallback != nullptr)
+                    m_FrameErrorCallback(m_Index, "GPUDirect initialization failed.", EDeviceStatus::Error);
+                return;
+            }
 #else
-        std::memcpy(pointer, frameData, byteLen);
+            m_FrameCopy.Copy(pointer, frameData, byteLen);
 #endif
+        }
+
+        const auto copyDuration = std::chrono::steady_clock::now() - copyStart;
+        m_SubmissionQueue.RecordStage(ESubmissionStage::Copy, copyDuration);
+        m_Metrics.RecordDuration(EDeviceMetric::Copy, copyDuration);
 
         if (IsAsyncMode())
         {
             // Async mode: Replace the frame_ object with it.
-            m_Frame.m_VideoFrame = newFrame;
+            m_Frame.SetVideoFrame(newFrame);
+            RecordDeadlineSlack();
         }
         else
         {
@@ -434,6 +512,7 @@ namespace MediaBlackmagic
             if (count < kMaxBufferedFrames)
             {
                 // Manual mode: Immediately schedule it.
+                RecordDeadlineSlack();
                 ScheduleFrame(newFrame);
             }
             else
@@ -456,6 +535,9 @@ namespace MediaBlackmagic
 
     void DeckLinkOutputDevice::FeedFrameHDR(void* frameData, unsigned int timecode)
     {
+        ProfilerSample sample(EProfilerMarker::FeedFrameHDR, timecode);
+        TraceSpan traceSpan(ETraceSpan::FeedFrame, m_Index, TakeFeedTraceFlow());
+
         std::unique_lock<std::mutex> lock(m_Mutex);
 
         auto newMutableFrame = m_OutputVideoFrameQueue.front();
@@ -478,11 +560,7 @@ namespace MediaBlackmagic
 
         if (m_HDRFrames.size() > kMaxBufferedFrames)
         {
-            auto it = m_HDRFrames.begin();
-            while (it != m_HDRFrames.end())
-            {
-                it = m_HDRFrames.erase(it);
-            }
+            ReleaseHDRFrames();
         }
 
         m_HDRFrames.push_back(newFrame);
@@ -494,29 +572,38 @@ namespace MediaBlackmagic
         
         ShouldOK(newFrame->GetBytes(&pointer));
         const std::uint32_t byteLen = GetFrameByteLength(width) * height;
+        const auto copyStart = std::chrono::steady_clock::now();
+        {
+            ProfilerSample copySample(EProfilerMarker::Copy, 0, byteLen);
 
 #if _WIN64
-        if (m_OutputGPUDirect != nullptr && m_IsGPUDirectAvailable)
-        {
-            m_OutputGPUDirect->StartGPUSynchronization(frameData, pointer);
-        }
-        else if (m_OutputGPUDirect == nullptr)
-        {
-            m_ThreadedMemcpy.MemcpyOperation(pointer, frameData, byteLen);
-        }
-        else
-        {
-            if (m_FrameErrorCallback != nullptr)
-                m_FrameErrorCallback(m_Index, "GPUDirect initialization failed.", EDeviceStatus::Error);
-            return;
-        }
+            if (m_OutputGPUDirect != nullptr && m_IsGPUDirectAvailable)
+            {
+                m_OutputGPUDirect->StartGPUSynchronization(frameData, pointer);
+            }
+            else if (m_OutputGPUDirect == nullptr)
+            {
+                m_FrameCopy.Copy(pointer, frameData, byteLen);
+            }
+            else
+            {
+                if (m_FrameErrorCallback != nullptr)
+                    m_FrameErrorCallback(m_Index, "GPUDirect initialization failed.", EDeviceStatus::Error);
+                return;
+            }
 #else
-        std::memcpy(pointer, frameData, byteLen);
+            m_FrameCopy.Copy(pointer, frameData, byteLen);
 #endif
+        }
+
+        const auto copyDuration = std::chrono::steady_clock::now() - copyStart;
+        m_SubmissionQueue.RecordStage(ESubmissionStage::Copy, copyDuration);
+        m_Metrics.RecordDuration(EDeviceMetric::Copy, copyDuration);
 
         if (IsAsyncMode())
         {
-            m_Frame.m_VideoFrame = newFrame->m_VideoFrame;
+            m_Frame.SetVideoFrame(newFrame->m_VideoFrame);
+            RecordDeadlineSlack();
         }
         else
         {
@@ -529,6 +616,7 @@ namespace MediaBlackmagic
             if (count < kMaxBufferedFrames)
             {
                 // Manual mode: Immediately schedule it.
+                RecordDeadlineSlack();
                 ScheduleFrame(newFrame);
             }
             else
@@ -549,14 +637,83 @@ namespace MediaBlackmagic
 #endif
     }
 
+    void DeckLinkOutputDevice::SetPassthroughRoute(DeckLinkPassthroughRoute* route)
+    {
+        // Blocks until the completion thread is done with the previous route.
+        std::lock_guard<std::mutex> routeLock(m_PassthroughRouteMutex);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PassthroughRoute = route;
+
+        // The routed frames belong to the route: go back to our own frames once it is detached.
+        if (route == nullptr && IsAsyncMode() && !m_OutputVideoFrameQueue.empty())
+        {
+            m_Frame.SetVideoFrame(m_OutputVideoFrameQueue.back());
+        }
+    }
+
+    IDeckLinkMutableVideoFrame* DeckLinkOutputDevice::CreateRouteFrame()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_Output == nullptr || m_DisplayMode == nullptr)
+            return nullptr;
+
+        return AllocateFrame();
+    }
+
+    bool DeckLinkOutputDevice::ScheduleRoutedFrame(IDeckLinkMutableVideoFrame* frame, const unsigned int timecode)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_Output == nullptr || m_Stopped)
+            return false;
+
+        SetTimecode(frame, timecode);
+
+        if (IsAsyncMode())
+        {
+            // Async mode: the completion callback keeps repeating the latest routed frame, which
+            // the wrapper references as the route may release it at any time.
+            m_Frame.SetVideoFrame(frame);
+            return true;
+        }
+
+        unsigned int count;
+        m_Output->GetBufferedVideoFrameCount(&count);
+
+        if (count >= kMaxBufferedFrames)
+        {
+            if (m_FrameErrorCallback != nullptr)
+            {
+                m_FrameErrorCallback(m_Index, "Overqueuing routed frames (not pushed).", EDeviceStatus::Warning);
+            }
+            return false;
+        }
+
+        const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
+        if (isHDR)
+        {
+            if (m_HDRFrames.size() > kMaxBufferedFrames)
+            {
+                ReleaseHDRFrames();
+            }
+
+            auto newHDRFrame = new DeckLinkOutputDevice::HDRVideoFrame(true, frame, m_ColorSpace);
+            m_HDRFrames.push_back(newHDRFrame);
+            ScheduleFrame(newHDRFrame);
+        }
+        else
+        {
+            ScheduleFrame(frame);
+        }
+
+        return true;
+    }
+
     void DeckLinkOutputDevice::WaitFrameCompletion(std::int64_t frameNumber)
     {
         // Wait for completion of a specified frame.
-        std::unique_lock<std::mutex> lock(m_Mutex);
-        auto res = m_Condition.wait_for(
-            lock, std::chrono::milliseconds(200),
-            [=]() { return m_Completed >= frameNumber; }
-        );
+        auto res = m_CompletionEvent.Wait(frameNumber, 200);
 
         if (!res && m_FrameErrorCallback != nullptr)
         {
@@ -689,6 +846,12 @@ namespace MediaBlackmagic
         DeckLinkOutputDevice::ScheduledFrameCompleted(IDeckLinkVideoFrame* completedFrame,
             BMDOutputFrameCompletionResult result)
     {
+        DeckLinkProfiler::RegisterCallbackThread("DeckLink Output", this);
+        TraceSpan traceSpan(ETraceSpan::FrameCompleted, m_Index, 0);
+
+        if (DeckLinkEventRecorder::IsEnabled())
+            DeckLinkEventRecorder::RecordFrameCompleted(m_Index, result);
+
         auto cbValid = m_FrameErrorCallback != nullptr;
 
         switch (result)
@@ -696,32 +859,95 @@ namespace MediaBlackmagic
         case bmdOutputFrameDisplayedLate:
             if (cbValid) m_FrameErrorCallback(m_Index, k_FrameDisplayedLate.c_str(), EDeviceStatus::Warning);
             m_LateFrameCount++;
+            m_Status.IncrementLateFrames();
+            m_Metrics.Increment(EDeviceMetric::LateFrames);
+            DeckLinkLogger::Log(m_LateLogLimit, ELogSeverity::Warning, "Output %d: frame displayed late.", m_Index);
+            m_Status.Report(EDeviceStatus::Warning, result);
             break;
         case bmdOutputFrameDropped:
             if (cbValid) m_FrameErrorCallback(m_Index, k_FrameDropped.c_str(), EDeviceStatus::Error);
             m_DroppedFrameCount++;
+            m_Status.IncrementDroppedFrames();
+            m_Metrics.Increment(EDeviceMetric::DroppedFrames);
+            DeckLinkLogger::Log(m_DroppedLogLimit, ELogSeverity::Warning, "Output %d: frame dropped.", m_Index);
+            m_Status.Report(EDeviceStatus::Error, result);
             break;
         case bmdOutputFrameFlushed:
             if (cbValid) m_FrameErrorCallback(m_Index, k_FrameFlushed.c_str(), EDeviceStatus::Error);
+            m_Metrics.Increment(EDeviceMetric::FlushedFrames);
+            m_Status.Report(EDeviceStatus::Error, result);
             break;
         default:
             if (cbValid) m_FrameErrorCallback(m_Index, k_FrameSucceeded.c_str(), EDeviceStatus::Ok);
             break;
         }
 
-        // Increment the frame count and notify the main thread.
-        if (m_FrameCompletedCallback != nullptr)
+        // Publish the device status, so the managed side doesn't have to query it.
+        if (completedFrame != nullptr)
         {
-            m_FrameCompletedCallback(m_Index, m_Completed);
+            m_Status.SetPixelFormat(completedFrame->GetPixelFormat());
+        }
+        {
+            // The frames complete in the order they were scheduled; the same frame object may be
+            // scheduled several times in async mode.
+            std::lock_guard<std::mutex> lock(m_ScheduleTimesMutex);
+            if (!m_ScheduleTimes.empty())
+            {
+                const auto& scheduled = m_ScheduleTimes.front();
+                if (result != bmdOutputFrameFlushed)
+                {
+                    m_Metrics.RecordDuration(EDeviceMetric::ScheduleToCompletion, std::chrono::steady_clock::now() - scheduled.scheduleTime);
+                }
+                traceSpan.SetFlow(scheduled.traceFlow);
+                m_ScheduleTimes.pop_front();
+            }
         }
+        if (m_Output != nullptr)
+        {
+            unsigned int buffered;
+            if (m_Output->GetBufferedVideoFrameCount(&buffered) == S_OK)
+            {
+                m_Status.SetBufferedFrames(static_cast<int>(buffered));
+            }
 
-        m_Completed++;
-        m_Condition.notify_all();
+        }
 
-        // Async mode: Schedule the next frame.
-        if (IsAsyncMode() && !m_Stopped)
+        // Increment the frame count and notify the main thread. The frames flushed by a stop or
+        // a reconfiguration were never output.
+        if (result != bmdOutputFrameFlushed)
         {
+            if (m_FrameCompletedCallback != nullptr)
+            {
+                m_FrameCompletedCallback(m_Index, m_Completed);
+            }
+
+            m_Completed++;
+            m_Status.SetProcessedFrames(m_Completed);
+            m_CompletionEvent.Signal(m_Completed);
+        }
+
+        // Async mode: Schedule the next frame. The frames flushed by a reconfiguration are not replaced.
+        if (IsAsyncMode() && !m_Stopped && !m_Reconfiguring)
+        {
+            // A synchronized passthrough route provides the frame for this output frame.
+            IDeckLinkMutableVideoFrame* routedFrame = nullptr;
+            unsigned int routedTimecode = 0;
+            {
+                std::lock_guard<std::mutex> routeLock(m_PassthroughRouteMutex);
+                if (m_PassthroughRoute != nullptr && m_PassthroughRoute->IsSynchronized())
+                {
+                    m_PassthroughRoute->OnOutputFrame(routedFrame, routedTimecode);
+                }
+            }
+
             std::lock_guard<std::mutex> lock(m_Mutex);
+            if (routedFrame != nullptr)
+            {
+                SetTimecode(routedFrame, routedTimecode);
+                m_Frame.SetVideoFrame(routedFrame);
+                routedFrame->Release();
+            }
+
             const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
             if (isHDR)
             {
@@ -746,6 +972,13 @@ namespace MediaBlackmagic
     {
         {
             std::lock_guard<std::mutex> lock(m_Mutex);
+
+            // The stop of the playback before a reconfiguration, which was restarted since.
+            if (m_StaleStopCallbacks > 0)
+            {
+                m_StaleStopCallbacks--;
+                return S_OK;
+            }
             m_Stopped = true;
         }
         m_PlaybackStoppedCondition.notify_one();
@@ -770,6 +1003,96 @@ namespace MediaBlackmagic
       return frame;
     }
 
+    void DeckLinkOutputDevice::AllocateFramePool()
+    {
+        for (uint32_t i = 0; i < kAllocatedBufferedFrames; i++)
+        {
+            auto newFrame = AllocateFrame();
+            if (newFrame == nullptr)
+            {
+                DeckLinkLogger::Log(ELogSeverity::Error, "Output %d: CreateVideoFrame failed, the frame pool has %d frames.",
+                                    m_Index, static_cast<int>(m_OutputVideoFrameQueue.size()));
+                break;
+            }
+
+            // The pool keeps the reference the frame was created with.
+            m_OutputVideoFrameQueue.push_back(newFrame);
+        }
+    }
+
+    void DeckLinkOutputDevice::ReleaseFramePool()
+    {
+        m_Frame.SetVideoFrame(nullptr);
+
+        // The frames still scheduled, or held by a passthrough route, are freed by their last reference.
+        while (!m_OutputVideoFrameQueue.empty())
+        {
+            auto frame = m_OutputVideoFrameQueue.front();
+            if (frame != nullptr)
+            {
+                frame->Release();
+            }
+            m_OutputVideoFrameQueue.pop_front();
+        }
+
+        ReleaseHDRFrames();
+    }
+
+    void DeckLinkOutputDevice::ReleaseHDRFrames()
+    {
+        // The frames still scheduled keep the driver's reference until they are completed.
+        for (auto frame : m_HDRFrames)
+        {
+            frame->Release();
+        }
+
+        m_HDRFrames.clear();
+    }
+
+    bool DeckLinkOutputDevice::CanReuseFramePool(IDeckLinkDisplayMode* displayMode, const BMDPixelFormat pixelFormat, const BMDDisplayModeFlags colorSpace) const
+    {
+        if (m_OutputVideoFrameQueue.empty() || m_OutputVideoFrameQueue.front() == nullptr)
+            return false;
+
+        // The frames are only bound to their size, pixel format and HDR flag, not to the frame rate.
+        auto frame = m_OutputVideoFrameQueue.front();
+        const auto isHDR = colorSpace == bmdDisplayModeColorspaceRec2020;
+        const auto frameIsHDR = (frame->GetFlags() & bmdFrameContainsHDRMetadata) != 0;
+
+        return frame->GetWidth() == displayMode->GetWidth() &&
+            frame->GetHeight() == displayMode->GetHeight() &&
+            frame->GetPixelFormat() == pixelFormat &&
+            frameIsHDR == isHDR;
+    }
+
+    void DeckLinkOutputDevice::PrerollFrames(IDeckLinkMutableVideoFrame* frame)
+    {
+        if (IsAsyncMode())
+        {
+            m_Frame.SetVideoFrame(frame);
+        }
+
+        for (auto i = 0; i < m_Preroll; i++)
+        {
+            const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
+            if (isHDR && IsAsyncMode())
+            {
+                ScheduleFrame(&m_Frame);
+            }
+            else if (isHDR)
+            {
+                auto newHDRFrame = new DeckLinkOutputDevice::HDRVideoFrame(true, frame, m_ColorSpace);
+                ScheduleFrame(newHDRFrame);
+
+                m_HDRFrames.push_back(newHDRFrame);
+            }
+            else
+            {
+                ScheduleFrame(frame);
+            }
+        }
+    }
+
     void DeckLinkOutputDevice::CopyFrameData(IDeckLinkMutableVideoFrame* frame, const void* data)
     {
         auto width = m_DisplayMode->GetWidth();
@@ -778,12 +1101,9 @@ namespace MediaBlackmagic
 
         ShouldOK(frame->GetBytes(&pointer));
         const std::uint32_t byteLen = GetFrameByteLength(width) * height;
+        ProfilerSample sample(EProfilerMarker::Copy, 0, byteLen);
 
-#if _WIN64
-        m_ThreadedMemcpy.MemcpyOperation(pointer, data, byteLen);
-#else
-        std::memcpy(pointer, data, byteLen);
-#endif
+        m_FrameCopy.Copy(pointer, data, byteLen);
     }
 
     void DeckLinkOutputDevice::SetTimecode(IDeckLinkMutableVideoFrame* frame,
@@ -808,13 +1128,71 @@ namespace MediaBlackmagic
         m_Queued = m_Queued + static_cast<int>(m_DefaultScheduleTime);
         auto time = m_FrameDuration * m_Queued++;
 
-        if (m_Output->ScheduleVideoFrame(frame, time, m_FrameDuration, m_TimeScale) == S_FALSE)
+        ProfilerSample sample(EProfilerMarker::ScheduleFrame, m_Queued - 1);
+        const auto traceFlow = DeckLinkTracer::IsEnabled() ? m_ScheduleTraceFlow.load(std::memory_order_relaxed) : 0;
+        TraceSpan traceSpan(ETraceSpan::ScheduleFrame, m_Index, traceFlow);
+
+        const auto scheduleStart = std::chrono::steady_clock::now();
         {
+            // Stored before scheduling: the frame may complete before ScheduleVideoFrame returns.
+            std::lock_guard<std::mutex> lock(m_ScheduleTimesMutex);
+            m_ScheduleTimes.push_back({ scheduleStart, traceFlow });
+        }
+
+        const auto result = m_Output->ScheduleVideoFrame(frame, time, m_FrameDuration, m_TimeScale);
+        if (result == S_FALSE)
+        {
+            std::lock_guard<std::mutex> lock(m_ScheduleTimesMutex);
+            if (!m_ScheduleTimes.empty())
+                m_ScheduleTimes.pop_back();
+
             if (m_FrameErrorCallback != nullptr)
             {
                 m_FrameErrorCallback(m_Index, "Failed to schedule a video frame.", EDeviceStatus::Error);
             }
         }
+        m_SubmissionQueue.RecordStage(ESubmissionStage::Schedule, std::chrono::steady_clock::now() - scheduleStart);
+    }
+
+    void DeckLinkOutputDevice::RecordDeadlineSlack()
+    {
+        // The stream time follows the hardware clock once the playback runs; during the preroll
+        // no frame is due yet.
+        BMDTimeValue streamTime;
+        double playbackSpeed;
+        if (m_Output->GetScheduledStreamTime(m_TimeScale, &streamTime, &playbackSpeed) != S_OK || playbackSpeed <= 0.0)
+            return;
+
+        // The manual mode schedules the fed frame right away, at the next time of the stream. The
+        // async mode takes it when the next frame completes, whatever the depth of the preroll.
+        const auto deadline = IsAsyncMode() ?
+            (streamTime / m_FrameDuration + 1) * m_FrameDuration :
+            m_FrameDuration * (m_Queued + static_cast<int>(m_DefaultScheduleTime));
+
+        const auto slack = flicksPerSecond * (deadline - streamTime) / m_TimeScale;
+        m_DeadlineSlack.Add(slack);
+
+        std::int64_t min, p1, p50;
+        if (m_DeadlineSlack.Summarize(min, p1, p50))
+        {
+            m_Status.SetDeadlineSlack(slack, min, p1, p50);
+        }
+    }
+
+    std::uint64_t DeckLinkOutputDevice::TakeFeedTraceFlow()
+    {
+        if (!DeckLinkTracer::IsEnabled())
+            return 0;
+
+        auto flow = m_FeedTraceFlow.exchange(0, std::memory_order_relaxed);
+        if (flow == 0)
+        {
+            flow = DeckLinkTracer::GetCurrentFlow();
+        }
+
+        // The fed frame is the one scheduled next.
+        m_ScheduleTraceFlow.store(flow, std::memory_order_relaxed);
+        return flow;
     }
 
     bool DeckLinkOutputDevice::InitializeOutput(
@@ -831,45 +1209,39 @@ namespace MediaBlackmagic
         bool useGPUDirect)
     {
         // Set frame allocation width
+        m_Preroll = preroll;
         m_PixelFormat = (BMDPixelFormat)pixelFormat;
         m_ColorSpace = (BMDDisplayModeFlags)colorSpace;
         m_UseGPUDirect = useGPUDirect;
         HDRVideoFrame::SetTransferFunction(transferFunction);
 
-        // Device iterator
-        IDeckLinkIterator* iterator;
-        auto res = GetDeckLinkIterator(&iterator);
+        // The snapshot holds every card, so no iteration is needed to reach the device.
+        m_Capabilities = DeckLinkCapabilitySnapshot::Get();
+        m_DeviceSelected = deviceSelected;
 
-        if (res != S_OK)
+        const auto capabilities = m_Capabilities->GetDevice(deviceSelected);
+        if (capabilities == nullptr)
         {
-            m_Error = "Could not find DeckLink driver.";
+            m_Error = m_Capabilities->GetDevices().empty() ? "Could not find DeckLink driver." : "Invalid device index.";
             return false;
         }
 
-        // Iterate until reaching the specified index.
-        IDeckLink* device = nullptr;
-        for (auto i = 0; i <= deviceSelected; i++)
-        {
-            if (device != nullptr)
-                device->Release();
-            res = iterator->Next(&device);
-
-            if (res != S_OK)
-            {
-                m_Error = "Invalid device index.";
-                iterator->Release();
-                return false;
-            }
-        }
-
-        iterator->Release(); // The iterator is no longer needed.
+        auto device = capabilities->device;
+        device->AddRef();
 
         // Output interface of the specified device
-        res = device->QueryInterface(
+        auto res = device->QueryInterface(
             IID_IDeckLinkOutput,
             reinterpret_cast<void**>(&m_Output)
         );
 
+        if (res == S_OK && m_StatusPoller == nullptr)
+        {
+            m_StatusPoller = DeckLinkStatusPoller::Acquire(device, deviceSelected);
+            if (m_StatusPoller != nullptr)
+                m_StatusPoller->AttachStatus(&m_Status);
+        }
+
         device->Release(); // The device object is no longer needed.
 
         if (res != S_OK)
@@ -899,9 +1271,9 @@ namespace MediaBlackmagic
 
         if (!displayModeFound)
         {
+            m_Error = "Unsupported display mode (video format, framerate, and scanning mode combination).";
             if (m_FrameErrorCallback != nullptr)
             {
-                m_Error = "Unsupported display mode (video format, framerate, and scanning mode combination).";
                 m_FrameErrorCallback(m_Index, m_Error.c_str(), EDeviceStatus::Error);
             }
 
@@ -926,18 +1298,7 @@ namespace MediaBlackmagic
         // Enable the video output.
         res = m_Output->EnableVideoOutput(m_DisplayMode->GetDisplayMode(), bmdVideoOutputRP188);
 
-        for (uint32_t i = 0; i < kAllocatedBufferedFrames; i++)
-        {
-            auto newFrame = AllocateFrame();
-            if (newFrame == nullptr)
-            {
-                WriteFileDebug("m_Output->CreateVideoFrame failed.\n");
-                break;
-            }
-
-            newFrame->AddRef();
-            m_OutputVideoFrameQueue.push_back(newFrame);
-        }
+        AllocateFramePool();
 
         // Set this object as a frame completion callback.
         res = m_Output->SetScheduledFrameCompletionCallback(this);
@@ -945,9 +1306,9 @@ namespace MediaBlackmagic
 
         if (res != S_OK)
         {
+            m_Error = "Can't open output device (possibly already used).";
             if (m_FrameErrorCallback != nullptr)
             {
-                m_Error = "Can't open output device (possibly already used).";
                 m_FrameErrorCallback(m_Index, m_Error.c_str(), EDeviceStatus::Error);
             }
             return false;
@@ -956,35 +1317,248 @@ namespace MediaBlackmagic
         if (!enableAudio || InitializeAudioOutput(preroll, audioChannelCount, audioSampleRate))
         {
             m_Index = deviceIndex;
+            m_Status.Reset();
+            m_Status.SetDeviceIndex(deviceIndex);
+            m_Metrics.Reset();
+            m_Metrics.SetDeviceIndex(deviceIndex);
+            {
+                std::lock_guard<std::mutex> lock(m_ScheduleTimesMutex);
+                m_ScheduleTimes.clear();
+            }
+            m_DeadlineSlack.Clear();
             return true;
         }
 
+        m_Error = "Can't enable the audio output.";
         m_Output->DisableVideoOutput();
         return false;
     }
 
-    bool DeckLinkOutputDevice::IsValidConfiguration() const
+    bool DeckLinkOutputDevice::Reconfigure(
+        BMDDisplayMode mode,
+        int pixelFormat,
+        int colorSpace,
+        int transferFunction,
+        EOutputKeyingMode keying,
+        EOutputLinkMode linkMode)
     {
-        dlbool_t isSupported(false);
-        if (m_Output != nullptr && m_DisplayMode != nullptr)
+        if (!m_Initialized || m_Output == nullptr || m_DisplayMode == nullptr)
+        {
+            m_Error = "The output device is not running.";
+            return false;
+        }
+
+        const auto newPixelFormat = static_cast<BMDPixelFormat>(pixelFormat);
+        const auto newColorSpace = static_cast<BMDDisplayModeFlags>(colorSpace);
+        const auto keyingEnabled = keying != EOutputKeyingMode::None;
+
+        // The profile of the card may have changed since the device started.
+        m_Capabilities = DeckLinkCapabilitySnapshot::Get();
+
+        bool isKnownSupported;
+        if (m_Capabilities != nullptr &&
+            m_Capabilities->TryIsOutputPixelFormatSupported(m_DeviceSelected, mode, newPixelFormat, keyingEnabled, isKnownSupported) &&
+            !isKnownSupported)
+        {
+            m_Error = "Unsupported display mode (video format, framerate, and scanning mode combination).";
+            return false;
+        }
+
+        HDRVideoFrame::SetTransferFunction(transferFunction);
+
+        // Only a new display mode, pixel format or HDR state needs the playback to be restarted.
+        const auto isHDR = m_ColorSpace == bmdDisplayModeColorspaceRec2020;
+        const auto newIsHDR = newColorSpace == bmdDisplayModeColorspaceRec2020;
+        const auto restart = mode != m_DisplayMode->GetDisplayMode() || newPixelFormat != m_PixelFormat || newIsHDR != isHDR;
+
+        if (restart)
+        {
+            if (!SwitchVideoMode(mode, newPixelFormat, newColorSpace, linkMode))
+                return false;
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_ColorSpace = newColorSpace;
+            }
+
+            if (linkMode != m_LinkMode && !SetLinkConfiguration(linkMode))
+            {
+                m_Error = "Can't change the link mode.";
+                return false;
+            }
+        }
+
+        if (keying == m_KeyingMode)
+            return true;
+
+        if (!keyingEnabled)
+        {
+            DisableKeying();
+            return true;
+        }
+
+        if (!ChangeKeyingMode(keying))
+        {
+            m_Error = "Can't change the keying mode.";
+            return false;
+        }
+        return true;
+    }
+
+    bool DeckLinkOutputDevice::SwitchVideoMode(
+        BMDDisplayMode mode,
+        BMDPixelFormat pixelFormat,
+        BMDDisplayModeFlags colorSpace,
+        EOutputLinkMode linkMode)
+    {
+        {
+            // A route allocates its frames with the current format.
+            std::lock_guard<std::mutex> routeLock(m_PassthroughRouteMutex);
+            if (m_PassthroughRoute != nullptr)
+            {
+                m_Error = "Can't change the video format of an output used by a passthrough route.";
+                return false;
+            }
+        }
+
+        IDeckLinkDisplayMode* displayMode = nullptr;
+        if (m_Output->GetDisplayMode(mode, &displayMode) != S_OK || displayMode == nullptr)
+        {
+            m_Error = "Unsupported display mode (video format, framerate, and scanning mode combination).";
+            return false;
+        }
+
+        // Stop at the next frame boundary, so the last frame of the old format is displayed whole.
+        m_Reconfiguring = true;
+
+        BMDTimeValue streamTime = 0;
+        BMDTimeValue stopTime = 0;
+        double playbackSpeed = 0.0;
+        if (m_Output->GetScheduledStreamTime(m_TimeScale, &streamTime, &playbackSpeed) == S_OK)
+        {
+            stopTime = (streamTime / m_FrameDuration + 1) * m_FrameDuration;
+        }
+
+        const auto frameTime = std::chrono::microseconds(m_FrameDuration * 1000000 / m_TimeScale);
+        const auto stopRequested = m_Output->StopScheduledPlayback(stopTime, nullptr, m_TimeScale) == S_OK;
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        if (stopRequested &&
+            !m_PlaybackStoppedCondition.wait_for(lock, frameTime * 2 + std::chrono::milliseconds(20), [this] { return m_Stopped == true; }))
+        {
+            // The callback of this stop comes after the restart, and must not stop the new playback.
+            m_StaleStopCallbacks++;
+        }
+
+        m_Output->DisableVideoOutput();
+        if (m_AudioChannelCount > 0)
+        {
+            m_Output->FlushBufferedAudioSamples();
+        }
+
+        // The frames only have to be reallocated if their size or pixel format changed.
+        const auto reusePool = CanReuseFramePool(displayMode, pixelFormat, colorSpace);
+        if (!reusePool)
+        {
+            ReleaseFramePool();
+        }
+        ReleaseHDRFrames();
+
+        m_DisplayMode->Release();
+        m_DisplayMode = displayMode;
+        m_DisplayMode->GetFrameRate(&m_FrameDuration, &m_TimeScale);
+        m_PixelFormat = pixelFormat;
+        m_ColorSpace = colorSpace;
+
+        if (linkMode != m_LinkMode)
+        {
+            SetLinkConfiguration(linkMode);
+        }
+
+        auto started = false;
+        if (m_Output->EnableVideoOutput(m_DisplayMode->GetDisplayMode(), bmdVideoOutputRP188) != S_OK)
+        {
+            m_Error = "Can't enable the video output with the new display mode.";
+        }
+        else
         {
-            auto mode = bmdSupportedVideoModeDefault;
-            if (m_KeyingMode != EOutputKeyingMode::None)
+            if (!reusePool)
+            {
+                AllocateFramePool();
+            }
+
+            if (m_OutputVideoFrameQueue.empty() || m_OutputVideoFrameQueue.front() == nullptr)
+            {
+                m_Error = "Can't allocate the output frames.";
+            }
+            else
             {
-                mode = bmdSupportedVideoModeKeying;
+                // A reused pool prerolls from the last fed frame, which the playback repeats
+                // on underruns, so the new format starts with the current picture.
+                if (!reusePool)
+                {
+                    m_OutputVideoFrameQueue.push_back(m_OutputVideoFrameQueue.front());
+                    m_OutputVideoFrameQueue.pop_front();
+                }
+
+                m_Queued = 0;
+                m_Stopped = false;
+                PrerollFrames(m_OutputVideoFrameQueue.back());
+
+                started = m_Output->StartScheduledPlayback(0, m_TimeScale, 1) == S_OK;
+                if (!started)
+                {
+                    m_Error = "Can't start the playback (the SDI port is possibly used by another application).";
+                }
             }
+        }
+
+        m_Reconfiguring = false;
+
+        if (!started)
+        {
+            // Nothing is fed to the output anymore; it still has to be destroyed.
+            m_Stopped = true;
+            m_Status.SetSignalPresent(false);
+            return false;
+        }
+
+        m_Status.SetPixelFormat(m_PixelFormat);
+        return true;
+    }
+
+    bool DeckLinkOutputDevice::IsValidConfiguration() const
+    {
+        if (m_Output != nullptr && m_DisplayMode != nullptr)
+        {
+            return IsPixelFormatSupportedInCurrentMode(m_KeyingMode != EOutputKeyingMode::None);
+        }
+        return false;
+    }
 
-            auto res = m_Output->DoesSupportVideoMode(
-                bmdVideoConnectionUnspecified,
-                m_DisplayMode->GetDisplayMode(),
-                m_PixelFormat,
-                bmdNoVideoOutputConversion,
-                mode,
-                NULL,
-                &isSupported
-            );
-            assert(res == S_OK);
+    bool DeckLinkOutputDevice::IsPixelFormatSupportedInCurrentMode(const bool keying) const
+    {
+        bool isKnownSupported;
+        if (m_Capabilities != nullptr &&
+            m_Capabilities->TryIsOutputPixelFormatSupported(m_DeviceSelected, m_DisplayMode->GetDisplayMode(), m_PixelFormat, keying, isKnownSupported))
+        {
+            return isKnownSupported;
         }
+
+        dlbool_t isSupported(false);
+        auto res = m_Output->DoesSupportVideoMode(
+            bmdVideoConnectionUnspecified,
+            m_DisplayMode->GetDisplayMode(),
+            m_PixelFormat,
+            bmdNoVideoOutputConversion,
+            keying ? bmdSupportedVideoModeKeying : bmdSupportedVideoModeDefault,
+            NULL,
+            &isSupported
+        );
+        assert(res == S_OK);
         return isSupported;
     }
 
@@ -1014,17 +1588,7 @@ namespace MediaBlackmagic
     {
         auto ret = SupportsOutputKeying(reinterpret_cast<IDeckLink*>(m_Output), keying);
 
-        dlbool_t supp;
-        auto doesSupport = !m_Output->DoesSupportVideoMode(
-            bmdVideoConnectionUnspecified,
-            m_DisplayMode->GetDisplayMode(),
-            m_PixelFormat,
-            bmdNoVideoOutputConversion,
-            bmdSupportedVideoModeKeying,
-            nullptr,
-            &supp);
-
-        return ret && doesSupport && supp;
+        return ret && IsPixelFormatSupportedInCurrentMode(true);
     }
 
     bool DeckLinkOutputDevice::ChangeKeyingMode(const EOutputKeyingMode mode)
@@ -1083,7 +1647,10 @@ namespace MediaBlackmagic
             goto cleanup;
 
         if (m_Configuration->SetInt(bmdDeckLinkConfigSDIOutputLinkConfiguration, bmdMode) == S_OK)
+        {
+            m_LinkMode = mode;
             success = true;
+        }
 
     cleanup:
         return success;
@@ -1095,8 +1662,12 @@ namespace MediaBlackmagic
     DeckLinkOutputDevice::HDRVideoFrame::HDRVideoFrame(const bool handleAllocation, IDeckLinkMutableVideoFrame* videoFrame, BMDDisplayModeFlags& deviceColorspace) :
         m_HandleAllocation(handleAllocation),
         m_VideoFrame(videoFrame),
-        m_DeviceColorspace(deviceColorspace)
+        m_DeviceColorspace(deviceColorspace),
+        m_RefCount(1)
     {
+        if (m_VideoFrame != nullptr)
+            m_VideoFrame->AddRef();
+
         m_Metadata.EOTF = static_cast<uint32_t>(EOTF::HLG);
         m_Metadata.referencePrimaries = kDefaultRec2020Colorimetrics;
         m_Metadata.maxDisplayMasteringLuminance = kDefaultMaxDisplayMasteringLuminance;
@@ -1105,6 +1676,25 @@ namespace MediaBlackmagic
         m_Metadata.maxFALL = kDefaultMaxFALL;
     }
 
+    DeckLinkOutputDevice::HDRVideoFrame::~HDRVideoFrame()
+    {
+        if (m_VideoFrame != nullptr)
+            m_VideoFrame->Release();
+    }
+
+    void DeckLinkOutputDevice::HDRVideoFrame::SetVideoFrame(IDeckLinkMutableVideoFrame* videoFrame)
+    {
+        if (videoFrame == m_VideoFrame)
+            return;
+
+        if (videoFrame != nullptr)
+            videoFrame->AddRef();
+        if (m_VideoFrame != nullptr)
+            m_VideoFrame->Release();
+
+        m_VideoFrame = videoFrame;
+    }
+
     void DeckLinkOutputDevice::HDRVideoFrame::SetTransferFunction(const uint32_t eotf)
     {
         m_Metadata.EOTF = eotf;
@@ -1160,25 +1750,18 @@ namespace MediaBlackmagic
 
     ULONG STDMETHODCALLTYPE DeckLinkOutputDevice::HDRVideoFrame::AddRef()
     {
-        return m_VideoFrame->AddRef();
+        // The references are counted on the wrapper, which holds one on the wrapped frame.
+        return ++m_RefCount;
     }
 
     ULONG STDMETHODCALLTYPE DeckLinkOutputDevice::HDRVideoFrame::Release()
     {
-        ULONG ret = 0;
-
-        // TO DO: this code is commented due to leak and crash issue in Async Mode & BT.2020
-        // In the future, we should investigate a more efficient way to manage our own frame pool.
-
-        /*if (m_VideoFrame != nullptr)
+        // The wrapper itself is freed with its last reference, unless it is owned by the device.
+        const ULONG ret = --m_RefCount;
+        if (ret == 0 && m_HandleAllocation)
         {
-            ret = m_VideoFrame->Release();
+            delete this;
         }
-        if (ret == 0)
-        {
-            m_VideoFrame = nullptr;
-            if (m_HandleAllocation) delete this;
-        }*/
         return ret;
     }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DeckLinkOutputDevice.h"
+#include "DeckLinkProfiler.h"
 #include <stdlib.h>
 
 namespace MediaBlackmagic
@@ -56,10 +57,16 @@ namespace MediaBlackmagic
 
     HRESULT STDMETHODCALLTYPE DeckLinkOutputDevice::RenderAudioSamples(dlbool_t preroll)
     {
+        DeckLinkProfiler::RegisterCallbackThread("DeckLink Audio", this);
+
         uint32_t bufferedFrameCount = 0;
         if (m_Output->GetBufferedAudioSampleFrameCount(&bufferedFrameCount) != S_OK)
             return E_FAIL;
 
+        ProfilerSample sample(EProfilerMarker::RenderAudioSamples, bufferedFrameCount);
+
+        m_Metrics.Record(EDeviceMetric::AudioRingFill, bufferedFrameCount);
+
         if (bufferedFrameCount > kBufferedAudioLevel)
         {
             if (m_PrerollingAudio)
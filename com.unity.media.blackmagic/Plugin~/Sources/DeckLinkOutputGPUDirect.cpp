@@ -14,6 +14,7 @@ namespace MediaBlackmagic
         , m_FrameCount(0)
         , m_GPUDirectAvailable(false)
         , m_PlayoutAllocator(nullptr)
+        , m_FrameLogLimit(1000)
     {
     }
 
@@ -35,7 +36,7 @@ namespace MediaBlackmagic
 
         if (m_PlayoutAllocator && m_OutputDevice->SetVideoOutputFrameMemoryAllocator(m_PlayoutAllocator) != S_OK)
         {
-            WriteFileDebug("SetVideoOutputFrameMemoryAllocator failed.\n");
+            DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: SetVideoOutputFrameMemoryAllocator failed.");
             return false;
         }
 
@@ -46,7 +47,7 @@ namespace MediaBlackmagic
     {
         if (!VideoFrameTransfer::Initialize(m_D3d11Device, frameByteLength, height, (void*)m_PlayoutTexture))
         {
-            WriteFileDebug("VideoFrameTransfer::initialize failed.\n");
+            DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: the frame transfer failed to initialize.");
             return false;
         }
 
@@ -88,13 +89,13 @@ namespace MediaBlackmagic
         {
             if (!CopyBufferResources(frameData))
             {
-                WriteFileDebug("Error, copy resources failed.\n");
+                DeckLinkLogger::Log(m_FrameLogLimit, ELogSeverity::Error, "GPUDirect: the frame texture could not be copied.");
                 return false;
             }
 
             if (!m_PlayoutAllocator->TransferFrame(pointer, (void*)m_PlayoutTexture))
             {
-                WriteFileDebug("mPlayoutAllocator->transferFrame failed.\n");
+                DeckLinkLogger::Log(m_FrameLogLimit, ELogSeverity::Error, "GPUDirect: the frame transfer to system memory failed.");
             }
 
             // Wait for transfer to system memory to complete
@@ -119,7 +120,7 @@ namespace MediaBlackmagic
 
         if (!destTexture || !frameSourceData)
         {
-            WriteFileDebug("Error, incorrect input texture(s).\n");
+            DeckLinkLogger::Log(m_FrameLogLimit, ELogSeverity::Error, "GPUDirect: missing source or playout texture.");
             return false;
         }
 
@@ -133,13 +134,12 @@ namespace MediaBlackmagic
 
         if (!destTexture || !nativeSrc)
         {
-            WriteFileDebug("Error, invalid IUnknown resource(s).\n");
+            DeckLinkLogger::Log(m_FrameLogLimit, ELogSeverity::Error, "GPUDirect: invalid texture resources.");
             return false;
         }
 
         if (!CopyResource(nativeSrc, destTexture))
         {
-            WriteFileDebug("Error, Couldn't copy resources.\n");
             return false;
         }
 
@@ -173,7 +173,7 @@ namespace MediaBlackmagic
 
         if (((HRESULT)(r)) < 0)
         {
-            WriteFileDebug("Error, CreateTexture2D.\n");
+            DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: CreateTexture2D failed with 0x%08x.", static_cast<unsigned int>(r));
             return nullptr;
         }
 
@@ -0,0 +1,205 @@
+#include <algorithm>
+
+#include "DeckLinkOutputSubmissionQueue.h"
+#include "DeckLinkProfiler.h"
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        std::int64_t ToNanoseconds(const std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        }
+    }
+
+    DeckLinkOutputSubmissionQueue::DeckLinkOutputSubmissionQueue() :
+        m_DeviceIndex(-1),
+        m_Capacity(0),
+        m_Policy(ESubmissionBackpressure::Block),
+        m_Consumer(nullptr),
+        m_FrameReleasedCallback(nullptr),
+        m_Running(false),
+        m_Stopping(false),
+        m_Statistics()
+    {
+    }
+
+    DeckLinkOutputSubmissionQueue::~DeckLinkOutputSubmissionQueue()
+    {
+        Stop();
+    }
+
+    bool DeckLinkOutputSubmissionQueue::Start(const int deviceIndex,
+                                              const int capacity,
+                                              const ESubmissionBackpressure policy,
+                                              const Consumer& consumer)
+    {
+        std::lock_guard<std::mutex> stateLock(m_StateMutex);
+
+        if (m_Running || capacity <= 0 || consumer == nullptr)
+            return false;
+
+        m_DeviceIndex = deviceIndex;
+        m_Capacity = static_cast<std::size_t>(capacity);
+        m_Policy = policy;
+        m_Consumer = consumer;
+        m_Statistics = OutputSubmissionStatistics();
+        m_Stopping = false;
+        m_Running = true;
+
+        m_Worker = std::thread(&DeckLinkOutputSubmissionQueue::Run, this);
+        return true;
+    }
+
+    void DeckLinkOutputSubmissionQueue::Stop()
+    {
+        // Disabling the async submission and closing the device may stop the queue at once: the
+        // second caller returns once the worker was joined and the pending frames released.
+        std::lock_guard<std::mutex> stateLock(m_StateMutex);
+
+        if (!m_Running)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_QueueCondition.notify_all();
+        m_SpaceCondition.notify_all();
+
+        if (m_Worker.joinable())
+        {
+            m_Worker.join();
+        }
+
+        // Hand the frames which were never played out back to the caller.
+        std::deque<Submission> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            pending.swap(m_Queue);
+            m_Statistics.dropped += static_cast<std::uint32_t>(pending.size());
+            m_Statistics.queued = 0;
+        }
+
+        for (const auto& submission : pending)
+        {
+            Release(submission.frameData, true);
+        }
+
+        m_Running = false;
+    }
+
+    bool DeckLinkOutputSubmissionQueue::Submit(void* frameData, const unsigned int timecode)
+    {
+        if (frameData == nullptr)
+            return false;
+
+        void* droppedFrame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+
+            if (!m_Running || m_Stopping)
+                return false;
+
+            if (m_Queue.size() >= m_Capacity)
+            {
+                switch (m_Policy)
+                {
+                case ESubmissionBackpressure::Block:
+                    m_SpaceCondition.wait(lock, [this] { return m_Stopping || m_Queue.size() < m_Capacity; });
+                    if (m_Stopping)
+                        return false;
+                    break;
+                case ESubmissionBackpressure::DropOldest:
+                    droppedFrame = m_Queue.front().frameData;
+                    m_Queue.pop_front();
+                    m_Statistics.dropped++;
+                    break;
+                case ESubmissionBackpressure::DropNewest:
+                    m_Statistics.dropped++;
+                    return false;
+                }
+            }
+
+            m_Queue.push_back({ frameData, timecode, std::chrono::steady_clock::now() });
+            m_Statistics.submitted++;
+            m_Statistics.queued = static_cast<std::int32_t>(m_Queue.size());
+        }
+        m_QueueCondition.notify_one();
+
+        if (droppedFrame != nullptr)
+        {
+            Release(droppedFrame, true);
+        }
+
+        return true;
+    }
+
+    void DeckLinkOutputSubmissionQueue::RecordStage(const ESubmissionStage stage, const std::chrono::steady_clock::duration duration)
+    {
+        const auto nanoseconds = ToNanoseconds(duration);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        switch (stage)
+        {
+        case ESubmissionStage::Copy:
+            m_Statistics.lastCopy = nanoseconds;
+            m_Statistics.maxCopy = std::max(m_Statistics.maxCopy, nanoseconds);
+            break;
+        case ESubmissionStage::Schedule:
+            m_Statistics.lastSchedule = nanoseconds;
+            m_Statistics.maxSchedule = std::max(m_Statistics.maxSchedule, nanoseconds);
+            break;
+        }
+    }
+
+    OutputSubmissionStatistics DeckLinkOutputSubmissionQueue::GetStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Statistics;
+    }
+
+    void DeckLinkOutputSubmissionQueue::Run()
+    {
+        ProfilerThreadScope thread("Output Submission");
+
+        while (true)
+        {
+            Submission submission;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_QueueCondition.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+
+                if (m_Stopping)
+                    return;
+
+                submission = m_Queue.front();
+                m_Queue.pop_front();
+
+                const auto queueWait = ToNanoseconds(std::chrono::steady_clock::now() - submission.submitTime);
+                m_Statistics.lastQueueWait = queueWait;
+                m_Statistics.maxQueueWait = std::max(m_Statistics.maxQueueWait, queueWait);
+                m_Statistics.queued = static_cast<std::int32_t>(m_Queue.size());
+            }
+            m_SpaceCondition.notify_one();
+
+            m_Consumer(submission.frameData, submission.timecode);
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Statistics.consumed++;
+            }
+
+            Release(submission.frameData, false);
+        }
+    }
+
+    void DeckLinkOutputSubmissionQueue::Release(void* frameData, const bool dropped)
+    {
+        if (m_FrameReleasedCallback != nullptr)
+        {
+            m_FrameReleasedCallback(m_DeviceIndex, frameData, dropped);
+        }
+    }
+}
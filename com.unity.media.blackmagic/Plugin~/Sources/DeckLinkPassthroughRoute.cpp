@@ -0,0 +1,510 @@
+#include <algorithm>
+#include <cstring>
+
+#include "DeckLinkPassthroughRoute.h"
+#include "DeckLinkLogger.h"
+#include "DeckLinkProfiler.h"
+#include "DeckLinkTracer.h"
+#include "DeckLinkInputDevice.h"
+#include "DeckLinkOutputDevice.h"
+
+namespace MediaBlackmagic
+{
+    DeckLinkPassthroughRoute::DeckLinkPassthroughRoute(DeckLinkInputDevice* input, DeckLinkOutputDevice* output) :
+        m_Input(input),
+        m_Output(output),
+        m_Conversion(nullptr),
+        m_Sequence(0),
+        m_Delay(0),
+        m_Synchronize(false),
+        m_LastPresented(0),
+        m_ForwardAudio(false),
+        m_AudioSampleFramesPerVideoFrame(0),
+        m_OverlaySerial(0),
+        m_OverlayConsumedSerial(0),
+        m_OverlayTimecode(0),
+        m_Compositing(EPassthroughCompositing::None),
+        m_RoutedFrameCount(0),
+        m_SkippedFrameCount(0),
+        m_Error(""),
+        m_Started(false)
+    {
+        assert(m_Input != nullptr);
+        assert(m_Output != nullptr);
+
+        // The route keeps both devices alive until it is destroyed.
+        m_Input->AddRef();
+        m_Output->AddRef();
+    }
+
+    DeckLinkPassthroughRoute::~DeckLinkPassthroughRoute()
+    {
+        Stop();
+
+        m_Input->Release();
+        m_Output->Release();
+    }
+
+    bool DeckLinkPassthroughRoute::Start(const int delayFrames, const EPassthroughCompositing compositing, const bool synchronize)
+    {
+        assert(!m_Started);
+
+        if (!m_Input->IsInitialized())
+        {
+            SetError("Input device is not initialized.");
+            return false;
+        }
+
+        if (!m_Output->IsInitialized())
+        {
+            SetError("Output device is not initialized.");
+            return false;
+        }
+
+        // The synchronizer is clocked by the async mode completion callback of the output.
+        if (synchronize && !m_Output->IsAsyncMode())
+        {
+            SetError("The frame synchronizer requires an output device in async mode.");
+            return false;
+        }
+
+        m_Synchronize = synchronize;
+
+        // The samples are forwarded without resampling nor remapping the channels.
+        const auto outputChannelCount = m_Output->GetAudioChannelCount();
+        m_ForwardAudio = outputChannelCount > 0 &&
+                         m_Input->GetAudioChannelCount() == outputChannelCount &&
+                         m_Input->GetAudioSampleRate() == m_Output->GetAudioSampleRate();
+        if (outputChannelCount > 0 && !m_ForwardAudio)
+        {
+            DeckLinkLogger::Log(ELogSeverity::Warning, "Passthrough route to output %d: the audio format of the input differs, the audio is not forwarded.",
+                                m_Output->GetIndex());
+        }
+
+        m_AudioSampleFramesPerVideoFrame = static_cast<int>(m_Input->GetAudioSampleRate() * m_Output->GetFrameDuration() / flicksPerSecond);
+
+        // The conversion object is only required when the input and output pixel formats differ.
+        if (GetDeckLinkVideoConversion(&m_Conversion) != S_OK)
+        {
+            m_Conversion = nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_OverlayMutex);
+            m_Overlay.assign(m_Output->GetBackingFrameByteWidth() * m_Output->GetBackingFrameByteHeight(), 0);
+            m_Compositing = compositing;
+        }
+
+        if (!SetDelay(delayFrames))
+        {
+            Stop();
+            return false;
+        }
+
+        // The output must know about the route before the capture thread starts pushing frames.
+        m_Output->SetPassthroughRoute(this);
+        m_Input->SetPassthroughRoute(this);
+        m_Started = true;
+
+        return true;
+    }
+
+    void DeckLinkPassthroughRoute::Stop()
+    {
+        if (m_Started)
+        {
+            // Detach from the capture thread first, so no frame is pushed while the ring is released.
+            m_Input->SetPassthroughRoute(nullptr);
+            m_Output->SetPassthroughRoute(nullptr);
+        }
+
+        // A route which failed to start may still hold its frames.
+        std::vector<RouteSlot> ring;
+        {
+            std::lock_guard<std::mutex> lock(m_RingMutex);
+            m_Ring.swap(ring);
+        }
+        ReleaseRing(ring);
+
+        if (m_Conversion != nullptr)
+        {
+            m_Conversion->Release();
+            m_Conversion = nullptr;
+        }
+
+        m_Started = false;
+    }
+
+    bool DeckLinkPassthroughRoute::SetDelay(const int delayFrames)
+    {
+        if (delayFrames < 0 || delayFrames > k_MaxDelayFrames)
+        {
+            SetError("Invalid passthrough delay.");
+            return false;
+        }
+
+        // Growing the delay line restarts it; shrinking it keeps the frames already captured. The
+        // frames still queued on the output card are not overwritten before they are played out.
+        const auto headroom = m_Synchronize ? k_SynchronizerHeadroomFrames : 0;
+        const auto slotCount = static_cast<std::size_t>(delayFrames + m_Output->GetMaxQueuedFrames() + headroom);
+
+        bool grow;
+        {
+            std::lock_guard<std::mutex> lock(m_RingMutex);
+            grow = slotCount > m_Ring.size();
+        }
+
+        std::vector<RouteSlot> ring;
+        if (grow && !AllocateRing(ring, slotCount))
+            return false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_RingMutex);
+
+            if (grow)
+            {
+                m_Ring.swap(ring);
+                m_Sequence = 0;
+            }
+
+            m_Delay = delayFrames;
+
+            if (m_Synchronize)
+            {
+                m_Synchronizer.Reset(delayFrames, m_Output->GetFrameDuration());
+            }
+        }
+
+        // The frames of the previous ring.
+        ReleaseRing(ring);
+        return true;
+    }
+
+    void DeckLinkPassthroughRoute::SetCompositing(const EPassthroughCompositing compositing)
+    {
+        std::lock_guard<std::mutex> lock(m_OverlayMutex);
+        m_Compositing = compositing;
+        m_OverlayConsumedSerial = m_OverlaySerial;
+    }
+
+    void DeckLinkPassthroughRoute::FeedOverlay(const void* frameData, const unsigned int timecode)
+    {
+        std::lock_guard<std::mutex> lock(m_OverlayMutex);
+
+        if (m_Overlay.empty() || m_Compositing == EPassthroughCompositing::None)
+            return;
+
+        std::memcpy(m_Overlay.data(), frameData, m_Overlay.size());
+        m_OverlayTimecode = timecode;
+        m_OverlaySerial++;
+    }
+
+    void DeckLinkPassthroughRoute::OnInputFrame(IDeckLinkVideoInputFrame* videoFrame,
+                                                IDeckLinkAudioInputPacket* audioPacket,
+                                                const unsigned int timecode,
+                                                const std::int64_t hardwareTimestamp,
+                                                const std::int64_t frameDuration)
+    {
+        std::lock_guard<std::mutex> lock(m_RingMutex);
+
+        if (m_Ring.empty())
+            return;
+
+        // Write the captured frame at the head of the delay line.
+        const auto sequence = m_Sequence++;
+        auto& head = m_Ring[sequence % m_Ring.size()];
+
+        const auto traceFlow = m_Input->GetTraceFlow();
+        TraceSpan traceSpan(ETraceSpan::PassthroughCopy, m_Output->GetIndex(), traceFlow);
+
+        const auto copyStart = std::chrono::steady_clock::now();
+        const auto copied = CopyInputFrame(videoFrame, head.frame);
+        m_Output->GetMetrics().RecordDuration(videoFrame->GetPixelFormat() != head.frame->GetPixelFormat() ? EDeviceMetric::Pack : EDeviceMetric::Copy,
+                                              std::chrono::steady_clock::now() - copyStart);
+
+        if (copied)
+        {
+            head.timecode = timecode;
+            head.sequence = sequence;
+            head.traceFlow = traceFlow;
+            CopyInputAudio(audioPacket, head.audio);
+        }
+        else
+        {
+            head.sequence = k_InvalidSequence;
+        }
+
+        // Synchronized: the output clock pulls the frames, the input clock only measures its phase.
+        if (m_Synchronize)
+        {
+            std::int64_t phase;
+            if (head.sequence == sequence && m_Output->GetHardwareClockPhase(phase))
+            {
+                m_Synchronizer.PushInputFrame(sequence, hardwareTimestamp, frameDuration, phase);
+            }
+            return;
+        }
+
+        // The delay line is still filling up.
+        const auto delay = static_cast<std::uint64_t>(m_Delay);
+        if (sequence < delay)
+            return;
+
+        // Play out the frame captured 'delay' frames ago, if it made it into the ring.
+        auto& tail = m_Ring[(sequence - delay) % m_Ring.size()];
+        if (tail.sequence != sequence - delay)
+        {
+            m_SkippedFrameCount++;
+            return;
+        }
+
+        auto outputTimecode = tail.timecode;
+        ApplyOverlay(tail.frame, outputTimecode);
+        m_Output->SetScheduleTraceFlow(tail.traceFlow);
+
+        if (m_Output->ScheduleRoutedFrame(tail.frame, outputTimecode))
+        {
+            FeedSlotAudio(tail);
+            m_RoutedFrameCount++;
+        }
+        else
+        {
+            m_SkippedFrameCount++;
+        }
+
+        // A slot is only played out once.
+        tail.sequence = k_InvalidSequence;
+    }
+
+    bool DeckLinkPassthroughRoute::OnOutputFrame(IDeckLinkMutableVideoFrame*& frame, unsigned int& timecode)
+    {
+        std::lock_guard<std::mutex> lock(m_RingMutex);
+
+        if (m_Ring.empty())
+            return false;
+
+        std::uint64_t sequence;
+        const auto decision = m_Synchronizer.PullOutputFrame(sequence);
+        if (decision == DeckLinkFrameSynchronizer::EDecision::Starved)
+            return false;
+
+        auto& slot = m_Ring[sequence % m_Ring.size()];
+        if (slot.sequence != sequence)
+        {
+            m_SkippedFrameCount++;
+            return false;
+        }
+
+        // A repeated frame was already composited when it was first presented.
+        timecode = slot.timecode;
+        if (decision != DeckLinkFrameSynchronizer::EDecision::Repeat || sequence != m_LastPresented)
+        {
+            ApplyOverlay(slot.frame, timecode);
+        }
+
+        // The audio follows the frames, so a dropped frame drops its audio and a repeated frame
+        // repeats it.
+        FeedSlotAudio(slot);
+
+        m_LastPresented = sequence;
+        m_RoutedFrameCount++;
+        m_Output->SetScheduleTraceFlow(slot.traceFlow);
+
+        // The ring may be replaced as soon as the lock is released.
+        frame = slot.frame;
+        frame->AddRef();
+        return true;
+    }
+
+    std::string DeckLinkPassthroughRoute::GetErrorString() const
+    {
+        std::lock_guard<std::mutex> lock(m_RingMutex);
+        return m_Error;
+    }
+
+    void DeckLinkPassthroughRoute::SetError(const char* error)
+    {
+        std::lock_guard<std::mutex> lock(m_RingMutex);
+        m_Error = error;
+    }
+
+    bool DeckLinkPassthroughRoute::AllocateRing(std::vector<RouteSlot>& ring, const std::size_t slotCount)
+    {
+        // Room for a frame of audio with some jitter, so the capture thread doesn't allocate.
+        const auto audioCapacity = m_ForwardAudio ? static_cast<std::size_t>(2 * m_AudioSampleFramesPerVideoFrame * m_Output->GetAudioChannelCount()) : 0;
+
+        ring.reserve(slotCount);
+        for (std::size_t i = 0; i < slotCount; i++)
+        {
+            auto frame = m_Output->CreateRouteFrame();
+            if (frame == nullptr)
+            {
+                SetError("Failed to allocate the passthrough frames.");
+                ReleaseRing(ring);
+                return false;
+            }
+
+            ring.push_back({ frame, 0, k_InvalidSequence, 0, {} });
+            ring.back().audio.reserve(audioCapacity);
+        }
+
+        return true;
+    }
+
+    void DeckLinkPassthroughRoute::ReleaseRing(std::vector<RouteSlot>& ring)
+    {
+        // Frames still queued on the card, or repeated by the output, keep their own reference
+        // until they are completed or replaced.
+        for (auto& slot : ring)
+        {
+            slot.frame->Release();
+        }
+
+        ring.clear();
+    }
+
+    bool DeckLinkPassthroughRoute::CopyInputFrame(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkMutableVideoFrame* slotFrame)
+    {
+        const auto height = slotFrame->GetHeight();
+
+        if (videoFrame->GetWidth() != slotFrame->GetWidth() || videoFrame->GetHeight() != height)
+            return false;
+
+        if (videoFrame->GetPixelFormat() != slotFrame->GetPixelFormat())
+        {
+            // Repack natively, e.g. from the captured YUV to the RGB format used for keying.
+            ProfilerSample sample(EProfilerMarker::Pack, 0, slotFrame->GetRowBytes() * height);
+            return m_Conversion != nullptr && m_Conversion->ConvertFrame(videoFrame, slotFrame) == S_OK;
+        }
+
+        std::uint8_t* source = nullptr;
+        std::uint8_t* destination = nullptr;
+
+        if (videoFrame->GetBytes(reinterpret_cast<void**>(&source)) != S_OK ||
+            slotFrame->GetBytes(reinterpret_cast<void**>(&destination)) != S_OK)
+            return false;
+
+        const auto sourceRowBytes = videoFrame->GetRowBytes();
+        const auto destinationRowBytes = slotFrame->GetRowBytes();
+        ProfilerSample sample(EProfilerMarker::Copy, 0, destinationRowBytes * height);
+
+        if (sourceRowBytes == destinationRowBytes)
+        {
+            std::memcpy(destination, source, destinationRowBytes * height);
+            return true;
+        }
+
+        const auto rowBytes = std::min(sourceRowBytes, destinationRowBytes);
+        for (long row = 0; row < height; row++)
+        {
+            std::memcpy(destination + row * destinationRowBytes, source + row * sourceRowBytes, rowBytes);
+        }
+
+        return true;
+    }
+
+    bool DeckLinkPassthroughRoute::ApplyOverlay(IDeckLinkMutableVideoFrame* slotFrame, unsigned int& timecode)
+    {
+        std::lock_guard<std::mutex> lock(m_OverlayMutex);
+
+        if (m_Compositing == EPassthroughCompositing::None || m_OverlaySerial == 0)
+            return false;
+
+        const auto fresh = m_OverlaySerial != m_OverlayConsumedSerial;
+        m_OverlayConsumedSerial = m_OverlaySerial;
+
+        std::uint8_t* pointer = nullptr;
+        if (slotFrame->GetBytes(reinterpret_cast<void**>(&pointer)) != S_OK)
+            return false;
+
+        const auto byteLength = static_cast<std::size_t>(slotFrame->GetRowBytes() * slotFrame->GetHeight());
+        if (m_Overlay.size() < byteLength)
+            return false;
+
+        if (m_Compositing == EPassthroughCompositing::Fill)
+        {
+            // Fall back to the captured frames as soon as Unity stops feeding frames.
+            if (!fresh)
+                return false;
+
+            std::memcpy(pointer, m_Overlay.data(), byteLength);
+            timecode = m_OverlayTimecode;
+            return true;
+        }
+
+        // Keying: the last frame fed stays over the captured frames until it is replaced.
+        int alphaOffset;
+        switch (slotFrame->GetPixelFormat())
+        {
+        case bmdFormat8BitARGB:
+            alphaOffset = 0;
+            break;
+        case bmdFormat8BitBGRA:
+            alphaOffset = 3;
+            break;
+        default:
+            return false;
+        }
+
+        const auto overlay = m_Overlay.data();
+        for (std::size_t i = 0; i < byteLength; i += 4)
+        {
+            const std::uint32_t alpha = overlay[i + alphaOffset];
+            if (alpha == 0)
+                continue;
+
+            for (int c = 0; c < 4; c++)
+            {
+                if (c == alphaOffset)
+                {
+                    pointer[i + c] = 0xff;
+                    continue;
+                }
+
+                pointer[i + c] = static_cast<std::uint8_t>(
+                    (overlay[i + c] * alpha + pointer[i + c] * (255 - alpha) + 127) / 255);
+            }
+        }
+
+        return true;
+    }
+
+    void DeckLinkPassthroughRoute::CopyInputAudio(IDeckLinkAudioInputPacket* audioPacket, std::vector<float>& samples)
+    {
+        samples.clear();
+
+        if (!m_ForwardAudio || audioPacket == nullptr)
+            return;
+
+        void* source = nullptr;
+        if (audioPacket->GetBytes(&source) != S_OK)
+            return;
+
+        const auto sampleCount = static_cast<std::size_t>(audioPacket->GetSampleFrameCount()) * m_Input->GetAudioChannelCount();
+        samples.resize(sampleCount);
+
+        // The input captures 16 or 32-bit integer samples; the output is fed normalized floats.
+        if (m_Input->GetAudioSampleType() == bmdAudioSampleType32bitInteger)
+        {
+            for (std::size_t i = 0; i < sampleCount; i++)
+            {
+                samples[i] = static_cast<const std::int32_t*>(source)[i] / 2147483648.0f;
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < sampleCount; i++)
+            {
+                samples[i] = static_cast<const std::int16_t*>(source)[i] / 32768.0f;
+            }
+        }
+    }
+
+    void DeckLinkPassthroughRoute::FeedSlotAudio(const RouteSlot& slot)
+    {
+        if (!slot.audio.empty())
+        {
+            m_Output->FeedAudioSampleFrames(slot.audio.data(), static_cast<int>(slot.audio.size()));
+        }
+    }
+}
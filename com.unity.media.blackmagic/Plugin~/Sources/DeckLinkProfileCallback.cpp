@@ -1,4 +1,5 @@
 #include "DeckLinkProfileCallback.h"
+#include "DeckLinkCapabilitySnapshot.h"
 
 namespace MediaBlackmagic
 {
@@ -38,12 +39,23 @@ namespace MediaBlackmagic
     }
 
     bool DeckLinkProfileCallback::WaitForProfileActivation(void)
+    {
+        return WaitForProfileActivation(std::chrono::steady_clock::now() + kProfileActivationTimeout);
+    }
+
+    bool DeckLinkProfileCallback::WaitForProfileActivation(const std::chrono::steady_clock::time_point deadline)
     {
         dlbool_t isActiveProfile = false;
 
         // Check whether requested profile is already the active profile, then we can return without waiting
         if ((m_requestedProfile->IsActive(&isActiveProfile) == S_OK) && isActiveProfile)
         {
+            std::lock_guard<std::mutex> lock(m_profileActivatedMutex);
+            if (!m_requestedProfileActivated)
+            {
+                m_requestedProfileActivated = true;
+                m_activationTime = std::chrono::steady_clock::now();
+            }
             return true;
         }
         else
@@ -53,10 +65,16 @@ namespace MediaBlackmagic
                 return true;
             else
                 // Wait until the ProfileActivated callback occurs
-                return m_profileActivatedCondition.wait_for(lock, kProfileActivationTimeout, [&] { return m_requestedProfileActivated; });
+                return m_profileActivatedCondition.wait_until(lock, deadline, [&] { return m_requestedProfileActivated; });
         }
     }
 
+    std::chrono::steady_clock::time_point DeckLinkProfileCallback::GetActivationTime()
+    {
+        std::lock_guard<std::mutex> lock(m_profileActivatedMutex);
+        return m_activationTime;
+    }
+
     HRESULT STDMETHODCALLTYPE DeckLinkProfileCallback::ProfileChanging(IDeckLinkProfile* profileToBeActivated, dlbool_t /*streamsWillBeForcedToStop*/)
     {
         // The profile change is stalled until we return from the callback. 
@@ -73,12 +91,17 @@ namespace MediaBlackmagic
         BMDProfileID activatedProfileID;
 
         GetDeckLinkProfileID(activatedProfile, &activatedProfileID);
+        DeckLinkCapabilitySnapshot::Invalidate();
 
         if (activatedProfileID == m_requestedProfileID)
         {
             {
                 std::lock_guard<std::mutex> lock(m_profileActivatedMutex);
-                m_requestedProfileActivated = true;
+                if (!m_requestedProfileActivated)
+                {
+                    m_requestedProfileActivated = true;
+                    m_activationTime = std::chrono::steady_clock::now();
+                }
             }
             m_profileActivatedCondition.notify_one();
         }
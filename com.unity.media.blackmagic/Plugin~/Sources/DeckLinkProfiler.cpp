@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DeckLinkProfiler.h"
+#include "DeckLinkTracer.h"
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        struct MarkerInfo
+        {
+            const char*             name;
+            UnityProfilerCategoryId category;
+            const char*             valueName;      // Name of the first metadata, if any.
+            bool                    hasBytes;       // Whether the marker carries a byte count.
+        };
+
+        const MarkerInfo k_MarkerInfos[] =
+        {
+            { "TextureUpdateLock",              kUnityProfilerCategoryOther,    nullptr,            false },
+            { "DeckLink.InputFrameArrived",     kUnityProfilerCategoryVideo,    "Frame",            true },
+            { "DeckLink.FeedFrameSDR",          kUnityProfilerCategoryVideo,    "Timecode",         false },
+            { "DeckLink.FeedFrameHDR",          kUnityProfilerCategoryVideo,    "Timecode",         false },
+            { "DeckLink.ScheduleFrame",         kUnityProfilerCategoryVideo,    "Frame",            false },
+            { "DeckLink.RenderAudioSamples",    kUnityProfilerCategoryAudio,    "Buffered",         false },
+            { "DeckLink.Copy",                  kUnityProfilerCategoryVideo,    nullptr,            true },
+            { "DeckLink.Pack",                  kUnityProfilerCategoryVideo,    nullptr,            true },
+            { "DeckLink.OpenDevice",            kUnityProfilerCategoryLoading,  "Device",           false },
+            { "DeckLink.CloseDevice",           kUnityProfilerCategoryLoading,  "Device",           false },
+        };
+
+        static_assert(sizeof(k_MarkerInfos) / sizeof(k_MarkerInfos[0]) == static_cast<size_t>(EProfilerMarker::Count),
+                      "Every marker must be described.");
+
+        const char* const k_ThreadGroupName = "Blackmagic";
+
+        // Whether the calling thread is registered, and with which profiler.
+        thread_local IUnityProfiler* t_RegisteredProfiler = nullptr;
+        thread_local bool t_TraceNamed = false;
+
+        // A DeckLink callback thread, and the devices it called back.
+        struct CallbackThread
+        {
+            std::thread::id             thread;
+            UnityProfilerThreadId       threadId;
+            std::vector<const void*>    owners;
+        };
+
+        std::mutex s_CallbackThreadsMutex;
+        std::vector<CallbackThread> s_CallbackThreads;
+
+        // Changed whenever threads are unregistered, so the callback threads check their
+        // registration again.
+        std::atomic<std::uint32_t> s_CallbackThreadsEpoch(0);
+        thread_local std::uint32_t t_CallbackThreadEpoch = ~0u;
+        thread_local const void* t_CallbackThreadOwner = nullptr;
+
+        // Takes s_CallbackThreadsMutex.
+        void UnregisterCallbackThreadsIf(IUnityProfiler* profiler, const void* owner, const bool all)
+        {
+            std::lock_guard<std::mutex> lock(s_CallbackThreadsMutex);
+
+            for (auto it = s_CallbackThreads.begin(); it != s_CallbackThreads.end();)
+            {
+                auto& owners = it->owners;
+                owners.erase(std::remove(owners.begin(), owners.end(), owner), owners.end());
+                if (!all && !owners.empty())
+                {
+                    ++it;
+                    continue;
+                }
+
+                if (profiler != nullptr)
+                    profiler->UnregisterThread(it->threadId);
+                it = s_CallbackThreads.erase(it);
+            }
+            s_CallbackThreadsEpoch.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    std::atomic<IUnityProfiler*> DeckLinkProfiler::s_Profiler(nullptr);
+    std::atomic<IUnityProfiler*> DeckLinkProfiler::s_Interface(nullptr);
+    const UnityProfilerMarkerDesc* DeckLinkProfiler::s_Markers[static_cast<int>(EProfilerMarker::Count)] = {};
+
+    void DeckLinkProfiler::Initialize(IUnityProfiler* profiler)
+    {
+        if (profiler == nullptr)
+            return;
+
+        for (auto i = 0; i < static_cast<int>(EProfilerMarker::Count); ++i)
+        {
+            const auto& info = k_MarkerInfos[i];
+            const auto dataCount = (info.valueName != nullptr ? 1 : 0) + (info.hasBytes ? 1 : 0);
+
+            if (profiler->CreateMarker(&s_Markers[i], info.name, info.category, kUnityProfilerMarkerFlagDefault, dataCount) != 0)
+            {
+                s_Markers[i] = nullptr;
+                continue;
+            }
+
+            auto index = 0;
+            if (info.valueName != nullptr)
+                profiler->SetMarkerMetadataName(s_Markers[i], index++, info.valueName, kUnityProfilerMarkerDataTypeInt64, kUnityProfilerMarkerDataUnitUndefined);
+            if (info.hasBytes)
+                profiler->SetMarkerMetadataName(s_Markers[i], index, "Bytes", kUnityProfilerMarkerDataTypeUInt64, kUnityProfilerMarkerDataUnitBytes);
+        }
+
+        // Release players have the profiler compiled out: nothing is emitted there.
+        if (profiler->IsAvailable() != 0)
+        {
+            s_Interface.store(profiler, std::memory_order_release);
+            s_Profiler.store(profiler, std::memory_order_release);
+        }
+    }
+
+    void DeckLinkProfiler::Shutdown()
+    {
+        s_Profiler.store(nullptr, std::memory_order_release);
+        UnregisterCallbackThreadsIf(s_Interface.load(std::memory_order_acquire), nullptr, true);
+    }
+
+    void DeckLinkProfiler::RegisterThread(const char* name)
+    {
+        if (!t_TraceNamed)
+        {
+            DeckLinkTracer::NameThread(name);
+            t_TraceNamed = true;
+        }
+
+        const auto profiler = s_Profiler.load(std::memory_order_acquire);
+        if (profiler == nullptr || t_RegisteredProfiler == profiler)
+            return;
+
+        if (profiler->RegisterThread(nullptr, k_ThreadGroupName, name) == 0)
+        {
+            t_RegisteredProfiler = profiler;
+        }
+    }
+
+    void DeckLinkProfiler::UnregisterThread()
+    {
+        // Also after a shutdown: the registration outlives it otherwise.
+        if (t_RegisteredProfiler != nullptr && t_RegisteredProfiler == s_Interface.load(std::memory_order_acquire))
+        {
+            t_RegisteredProfiler->UnregisterThread(0);
+        }
+        t_RegisteredProfiler = nullptr;
+    }
+
+    void DeckLinkProfiler::RegisterCallbackThread(const char* name, const void* owner)
+    {
+        if (!t_TraceNamed)
+        {
+            DeckLinkTracer::NameThread(name);
+            t_TraceNamed = true;
+        }
+
+        // Once per device and thread, unless threads were unregistered since.
+        const auto epoch = s_CallbackThreadsEpoch.load(std::memory_order_acquire);
+        if (t_CallbackThreadEpoch == epoch && t_CallbackThreadOwner == owner)
+            return;
+
+        const auto profiler = s_Profiler.load(std::memory_order_acquire);
+        if (profiler == nullptr)
+            return;
+
+        std::lock_guard<std::mutex> lock(s_CallbackThreadsMutex);
+
+        const auto thread = std::this_thread::get_id();
+        auto entry = std::find_if(s_CallbackThreads.begin(), s_CallbackThreads.end(),
+                                  [thread](const CallbackThread& callbackThread) { return callbackThread.thread == thread; });
+        if (entry == s_CallbackThreads.end())
+        {
+            UnityProfilerThreadId threadId = 0;
+            if (profiler->RegisterThread(&threadId, k_ThreadGroupName, name) != 0)
+                return;
+
+            s_CallbackThreads.push_back(CallbackThread{ thread, threadId, {} });
+            entry = s_CallbackThreads.end() - 1;
+        }
+
+        if (std::find(entry->owners.begin(), entry->owners.end(), owner) == entry->owners.end())
+            entry->owners.push_back(owner);
+
+        t_CallbackThreadEpoch = epoch;
+        t_CallbackThreadOwner = owner;
+    }
+
+    void DeckLinkProfiler::UnregisterCallbackThreads(const void* owner)
+    {
+        UnregisterCallbackThreadsIf(s_Interface.load(std::memory_order_acquire), owner, false);
+    }
+
+    bool DeckLinkProfiler::BeginSample(const EProfilerMarker marker)
+    {
+        const auto profiler = s_Profiler.load(std::memory_order_acquire);
+        const auto desc = s_Markers[static_cast<int>(marker)];
+        if (profiler == nullptr || desc == nullptr)
+            return false;
+
+        profiler->BeginSample(desc);
+        return true;
+    }
+
+    bool DeckLinkProfiler::BeginSample(const EProfilerMarker marker, const std::int64_t value, const std::uint64_t bytes)
+    {
+        const auto profiler = s_Profiler.load(std::memory_order_acquire);
+        const auto desc = s_Markers[static_cast<int>(marker)];
+        if (profiler == nullptr || desc == nullptr)
+            return false;
+
+        const auto& info = k_MarkerInfos[static_cast<int>(marker)];
+
+        UnityProfilerMarkerData data[2] = {};
+        std::uint16_t count = 0;
+        if (info.valueName != nullptr)
+        {
+            data[count].type = kUnityProfilerMarkerDataTypeInt64;
+            data[count].size = sizeof(value);
+            data[count].ptr = &value;
+            ++count;
+        }
+        if (info.hasBytes)
+        {
+            data[count].type = kUnityProfilerMarkerDataTypeUInt64;
+            data[count].size = sizeof(bytes);
+            data[count].ptr = &bytes;
+            ++count;
+        }
+
+        profiler->BeginSample(desc, count, data);
+        return true;
+    }
+
+    void DeckLinkProfiler::EndSample(const EProfilerMarker marker)
+    {
+        const auto profiler = s_Interface.load(std::memory_order_acquire);
+        const auto desc = s_Markers[static_cast<int>(marker)];
+        if (profiler != nullptr && desc != nullptr)
+        {
+            profiler->EndSample(desc);
+        }
+    }
+}
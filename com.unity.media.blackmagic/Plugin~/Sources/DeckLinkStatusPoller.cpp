@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include "DeckLinkStatusPoller.h"
+#include "DeckLinkCapabilitySnapshot.h"
+#include "DeckLinkProfiler.h"
+
+namespace MediaBlackmagic
+{
+    std::mutex DeckLinkStatusPoller::s_RegistryMutex;
+    std::map<int, DeckLinkStatusPoller*> DeckLinkStatusPoller::s_Registry;
+    std::atomic<int> DeckLinkStatusPoller::s_PollingIntervalMs(kDefaultPollingIntervalMs);
+
+    namespace
+    {
+        std::int64_t SteadyNanoseconds()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        std::int32_t GetStatusInt(IDeckLinkStatus* status, const BMDDeckLinkStatusID id, const std::int32_t fallback)
+        {
+            dllonglong value = 0;
+            return status->GetInt(id, &value) == S_OK ? static_cast<std::int32_t>(value) : fallback;
+        }
+
+        std::int32_t GetStatusFlag(IDeckLinkStatus* status, const BMDDeckLinkStatusID id)
+        {
+            dlbool_t value = false;
+            return status->GetFlag(id, &value) == S_OK && value ? 1 : 0;
+        }
+    }
+
+    DeckLinkStatusPoller* DeckLinkStatusPoller::Acquire(IDeckLink* device, const int deviceSelected)
+    {
+        std::lock_guard<std::mutex> lock(s_RegistryMutex);
+
+        auto it = s_Registry.find(deviceSelected);
+        if (it != s_Registry.end())
+        {
+            it->second->m_RefCount++;
+            return it->second;
+        }
+
+        IDeckLinkStatus* status = nullptr;
+        if (device == nullptr || device->QueryInterface(IID_IDeckLinkStatus, reinterpret_cast<void**>(&status)) != S_OK)
+            return nullptr;
+
+        // Input-only cards have no output, and then no reference phase.
+        IDeckLinkOutput* output = nullptr;
+        if (device->QueryInterface(IID_IDeckLinkOutput, reinterpret_cast<void**>(&output)) != S_OK)
+            output = nullptr;
+
+        auto poller = new DeckLinkStatusPoller(deviceSelected, status, output);
+        s_Registry[deviceSelected] = poller;
+        return poller;
+    }
+
+    void DeckLinkStatusPoller::Release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_RegistryMutex);
+            if (--m_RefCount > 0)
+                return;
+
+            s_Registry.erase(m_DeviceSelected);
+        }
+
+        delete this;
+    }
+
+    void DeckLinkStatusPoller::SetPollingInterval(const int intervalMs)
+    {
+        s_PollingIntervalMs = intervalMs < 1 ? 1 : intervalMs;
+    }
+
+    void DeckLinkStatusPoller::AttachStatus(DeckLinkDeviceStatus* status)
+    {
+        std::lock_guard<std::mutex> lock(m_StatusesMutex);
+        m_Statuses.push_back(status);
+        status->SetReferenceLocked(IsReferenceLocked());
+    }
+
+    void DeckLinkStatusPoller::DetachStatus(DeckLinkDeviceStatus* status)
+    {
+        std::lock_guard<std::mutex> lock(m_StatusesMutex);
+        m_Statuses.erase(std::remove(m_Statuses.begin(), m_Statuses.end(), status), m_Statuses.end());
+    }
+
+    DeckLinkStatusPoller::DeckLinkStatusPoller(const int deviceSelected, IDeckLinkStatus* status, IDeckLinkOutput* output) :
+        m_DeviceSelected(deviceSelected),
+        m_RefCount(1),
+        m_Status(status),
+        m_Output(output),
+        m_Stopping(false),
+        m_SampleTime(0),
+        m_ReferencePhase(-1),
+        m_SampleCount(0),
+        m_ReferenceLocked(0),
+        m_ReferenceMode(0),
+        m_InputSignalLocked(0),
+        m_InputPixelFormat(0),
+        m_OutputPixelFormat(0),
+        m_Temperature(0),
+        m_Busy(0)
+    {
+        // Sample once before returning, so the getters are valid from the start.
+        Sample();
+
+        m_Thread = std::thread(&DeckLinkStatusPoller::Run, this);
+    }
+
+    DeckLinkStatusPoller::~DeckLinkStatusPoller()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_Condition.notify_all();
+
+        if (m_Thread.joinable())
+        {
+            m_Thread.join();
+        }
+
+        if (m_Output != nullptr)
+        {
+            m_Output->Release();
+            m_Output = nullptr;
+        }
+
+        m_Status->Release();
+        m_Status = nullptr;
+    }
+
+    DeckLinkHealth DeckLinkStatusPoller::GetHealth() const
+    {
+        DeckLinkHealth health;
+        health.sampleTime = m_SampleTime.load(std::memory_order_relaxed);
+        health.referencePhase = m_ReferencePhase.load(std::memory_order_relaxed);
+        health.sampleCount = m_SampleCount.load(std::memory_order_acquire);
+        health.referenceLocked = m_ReferenceLocked.load(std::memory_order_relaxed);
+        health.referenceMode = m_ReferenceMode.load(std::memory_order_relaxed);
+        health.inputSignalLocked = m_InputSignalLocked.load(std::memory_order_relaxed);
+        health.inputPixelFormat = m_InputPixelFormat.load(std::memory_order_relaxed);
+        health.outputPixelFormat = m_OutputPixelFormat.load(std::memory_order_relaxed);
+        health.temperature = m_Temperature.load(std::memory_order_relaxed);
+        health.busy = m_Busy.load(std::memory_order_relaxed);
+        return health;
+    }
+
+    int DeckLinkStatusPoller::CopyHistory(DeckLinkHealthEvent* events, const int capacity) const
+    {
+        std::lock_guard<std::mutex> lock(m_HistoryMutex);
+
+        auto count = 0;
+        for (auto it = m_History.begin(); it != m_History.end() && count < capacity; ++it)
+        {
+            events[count++] = *it;
+        }
+        return count;
+    }
+
+    void DeckLinkStatusPoller::Run()
+    {
+        SetCurrentThreadBackgroundPriority();
+        ProfilerThreadScope thread("Status Poller");
+#if defined(_WIN32)
+        // The capability snapshot is built through COM, which the poller joins while it runs.
+        const auto initialized = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        while (!m_Condition.wait_for(lock, std::chrono::milliseconds(s_PollingIntervalMs.load()), [this] { return m_Stopping; }))
+        {
+            lock.unlock();
+            Sample();
+
+            // Rebuilds the capabilities invalidated by a profile or discovery event here rather
+            // than on the driver callbacks which read them.
+            DeckLinkCapabilitySnapshot::RefreshIfStale();
+            lock.lock();
+        }
+
+#if defined(_WIN32)
+        if (SUCCEEDED(initialized))
+            CoUninitialize();
+#endif
+    }
+
+    void DeckLinkStatusPoller::Sample()
+    {
+        const auto referenceLocked = GetStatusFlag(m_Status, bmdDeckLinkStatusReferenceSignalLocked);
+        const auto inputSignalLocked = GetStatusFlag(m_Status, bmdDeckLinkStatusVideoInputSignalLocked);
+
+        m_ReferenceMode.store(GetStatusInt(m_Status, bmdDeckLinkStatusReferenceSignalMode, 0), std::memory_order_relaxed);
+        m_InputPixelFormat.store(GetStatusInt(m_Status, bmdDeckLinkStatusCurrentVideoInputPixelFormat, 0), std::memory_order_relaxed);
+        m_OutputPixelFormat.store(GetStatusInt(m_Status, bmdDeckLinkStatusLastVideoOutputPixelFormat, 0), std::memory_order_relaxed);
+        m_Temperature.store(GetStatusInt(m_Status, bmdDeckLinkStatusDeviceTemperature, 0), std::memory_order_relaxed);
+        m_Busy.store(GetStatusInt(m_Status, bmdDeckLinkStatusBusy, 0), std::memory_order_relaxed);
+
+        // Position of the output frame boundary against the host clock. It only moves with the
+        // drift between both clocks, unless the output re-locked to another reference.
+        auto phase = static_cast<std::int64_t>(-1);
+        auto phaseStep = static_cast<std::int64_t>(0);
+        BMDTimeValue hardwareTime;
+        BMDTimeValue timeInFrame;
+        BMDTimeValue ticksPerFrame;
+        if (m_Output != nullptr &&
+            m_Output->GetHardwareReferenceClock(flicksPerSecond, &hardwareTime, &timeInFrame, &ticksPerFrame) == S_OK &&
+            ticksPerFrame > 0)
+        {
+            const auto hostTime = static_cast<std::int64_t>(SteadyNanoseconds() * (static_cast<double>(flicksPerSecond) / 1e9));
+            phase = ((hostTime - timeInFrame) % ticksPerFrame + ticksPerFrame) % ticksPerFrame;
+
+            const auto previous = m_ReferencePhase.load(std::memory_order_relaxed);
+            if (previous >= 0)
+            {
+                phaseStep = (phase - previous) % ticksPerFrame;
+                if (phaseStep > ticksPerFrame / 2)
+                    phaseStep -= ticksPerFrame;
+                else if (phaseStep <= -ticksPerFrame / 2)
+                    phaseStep += ticksPerFrame;
+
+                if (std::abs(phaseStep) < ticksPerFrame / kPhaseJumpDivisor)
+                    phaseStep = 0;
+            }
+        }
+        m_ReferencePhase.store(phase, std::memory_order_relaxed);
+
+        const auto time = SteadyNanoseconds();
+        const auto isFirstSample = m_SampleCount.load(std::memory_order_relaxed) == 0;
+
+        if (!isFirstSample && referenceLocked != m_ReferenceLocked.load(std::memory_order_relaxed))
+            Record(referenceLocked ? EHealthEvent::ReferenceLocked : EHealthEvent::ReferenceLost, 0, time);
+        if (!isFirstSample && inputSignalLocked != m_InputSignalLocked.load(std::memory_order_relaxed))
+            Record(inputSignalLocked ? EHealthEvent::InputSignalLocked : EHealthEvent::InputSignalLost, 0, time);
+        if (phaseStep != 0)
+            Record(EHealthEvent::ReferencePhaseJump, phaseStep, time);
+
+        m_ReferenceLocked.store(referenceLocked, std::memory_order_relaxed);
+        m_InputSignalLocked.store(inputSignalLocked, std::memory_order_relaxed);
+        m_SampleTime.store(time, std::memory_order_relaxed);
+        m_SampleCount.fetch_add(1, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(m_StatusesMutex);
+            for (auto status : m_Statuses)
+            {
+                status->SetReferenceLocked(referenceLocked != 0);
+            }
+        }
+    }
+
+    void DeckLinkStatusPoller::Record(const EHealthEvent type, const std::int64_t value, const std::int64_t time)
+    {
+        std::lock_guard<std::mutex> lock(m_HistoryMutex);
+
+        if (m_History.size() >= kMaxHistory)
+        {
+            m_History.pop_front();
+        }
+        m_History.push_back({ time, static_cast<std::int32_t>(type), 0, value });
+    }
+}
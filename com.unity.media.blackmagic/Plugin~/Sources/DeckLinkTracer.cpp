@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "DeckLinkTracer.h"
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        struct SpanInfo
+        {
+            const char* name;
+            const char* category;
+            bool        flowIn;     // Continues the flow of an earlier span.
+            bool        flowOut;    // Continues into a later span.
+        };
+
+        const SpanInfo k_SpanInfos[] =
+        {
+            { "InputCallback",      "Input",        false,  true },
+            { "ManagedDelivery",    "Input",        true,   true },
+            { "TextureUpdate",      "Render",       true,   true },
+            { "Readback",           "Render",       true,   true },
+            { "FeedFrame",          "Output",       true,   true },
+            { "ScheduleFrame",      "Output",       true,   true },
+            { "FrameCompleted",     "Output",       true,   false },
+            { "PassthroughCopy",    "Passthrough",  true,   true },
+        };
+
+        static_assert(sizeof(k_SpanInfos) / sizeof(k_SpanInfos[0]) == static_cast<size_t>(ETraceSpan::Count),
+                      "Every span must be described.");
+
+        thread_local std::uint32_t t_ThreadId = 0;
+        thread_local const char* t_ThreadName = nullptr;
+        thread_local bool t_ThreadNameRecorded = false;
+
+        void WriteEscaped(std::FILE* file, const std::string& text)
+        {
+            for (const auto c : text)
+            {
+                if (c == '"' || c == '\\')
+                    std::fputc('\\', file);
+                if (static_cast<unsigned char>(c) >= 0x20)
+                    std::fputc(c, file);
+            }
+        }
+    }
+
+    DeckLinkEventRing<DeckLinkTracer::Event> DeckLinkTracer::s_Events;
+    std::atomic<std::uint64_t> DeckLinkTracer::s_NextFlow(1);
+    std::atomic<std::uint64_t> DeckLinkTracer::s_CurrentFlow(0);
+    std::atomic<std::uint32_t> DeckLinkTracer::s_NextThreadId(1);
+    std::mutex DeckLinkTracer::s_Mutex;
+    std::unordered_map<std::uint32_t, std::string> DeckLinkTracer::s_ThreadNames;
+
+    bool DeckLinkTracer::Enable(const int capacity)
+    {
+        return s_Events.Enable(capacity);
+    }
+
+    void DeckLinkTracer::Disable()
+    {
+        s_Events.Disable();
+    }
+
+    std::int64_t DeckLinkTracer::Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::uint64_t DeckLinkTracer::NewFlow()
+    {
+        return s_NextFlow.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint32_t DeckLinkTracer::GetThreadId()
+    {
+        if (t_ThreadId == 0)
+        {
+            t_ThreadId = s_NextThreadId.fetch_add(1, std::memory_order_relaxed);
+        }
+        return t_ThreadId;
+    }
+
+    void DeckLinkTracer::Record(const ETraceSpan span, const int deviceIndex, const std::uint64_t flow, const std::int64_t begin, const std::int64_t end)
+    {
+        if (!s_Events.IsEnabled())
+            return;
+
+        if (!t_ThreadNameRecorded && t_ThreadName != nullptr)
+            RecordThreadName();
+
+        const auto threadId = GetThreadId();
+        s_Events.Record([&](Event& event)
+        {
+            event.begin = begin;
+            event.end = end;
+            event.flow = flow;
+            event.threadId = threadId;
+            event.span = static_cast<std::int16_t>(span);
+            event.deviceIndex = static_cast<std::int16_t>(deviceIndex);
+        });
+    }
+
+    void DeckLinkTracer::NameThread(const char* name)
+    {
+        // Only the threads which record spans are named in the trace: the devices start threads
+        // for as long as the application runs, and most of them are never traced.
+        t_ThreadName = name;
+        t_ThreadNameRecorded = false;
+    }
+
+    void DeckLinkTracer::RecordThreadName()
+    {
+        const auto threadId = GetThreadId();
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_ThreadNames[threadId] = t_ThreadName;
+        t_ThreadNameRecorded = true;
+    }
+
+    int DeckLinkTracer::Write(const char* path)
+    {
+        std::unordered_map<std::uint32_t, std::string> threadNames;
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            threadNames = s_ThreadNames;
+        }
+
+        std::vector<Event> events;
+        s_Events.Read(events);
+
+        std::sort(events.begin(), events.end(), [](const Event& lhs, const Event& rhs) { return lhs.begin < rhs.begin; });
+
+        auto file = std::fopen(path, "wb");
+        if (file == nullptr)
+            return -1;
+
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+
+        auto first = true;
+        for (const auto& thread : threadNames)
+        {
+            std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                         first ? "" : ",\n", thread.first);
+            WriteEscaped(file, thread.second);
+            std::fputs("\"}}", file);
+            first = false;
+        }
+
+        for (const auto& event : events)
+        {
+            const auto& info = k_SpanInfos[event.span];
+
+            // Timestamps are in microseconds.
+            std::fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                         first ? "" : ",\n", info.name, info.category, event.threadId,
+                         event.begin / 1000.0, (event.end - event.begin) / 1000.0);
+
+            if (event.flow != 0)
+            {
+                std::fprintf(file, ",\"bind_id\":\"0x%" PRIx64 "\"%s%s", event.flow,
+                             info.flowIn ? ",\"flow_in\":true" : "", info.flowOut ? ",\"flow_out\":true" : "");
+            }
+
+            std::fprintf(file, ",\"args\":{\"device\":%d,\"flow\":%" PRIu64 "}}", event.deviceIndex, event.flow);
+            first = false;
+        }
+
+        std::fputs("\n]}\n", file);
+        const auto written = std::fclose(file) == 0;
+
+        return written ? static_cast<int>(events.size()) : -1;
+    }
+}
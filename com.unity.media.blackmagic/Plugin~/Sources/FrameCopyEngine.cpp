@@ -0,0 +1,766 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "FrameCopyEngine.h"
+#include "DeckLinkProfiler.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRAME_COPY_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define FRAME_COPY_NEON 1
+#include <arm_neon.h>
+#endif
+
+// The kernels of the wider instruction sets are compiled for them alone, so the plugin still runs
+// on the CPUs without them.
+#if defined(__GNUC__) || defined(__clang__)
+#define FRAME_COPY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FRAME_COPY_TARGET(isa)
+#endif
+
+namespace MediaBlackmagic
+{
+    namespace
+    {
+        const std::size_t k_CacheLineBytes = 64;
+
+        // Far enough ahead to cover the latency of the memory. The source is prefetched into the L2
+        // cache, where the loads would bring it anyway: prefetched into L1 alone, with the
+        // non-temporal hint, the lines were evicted before they were read and the copies ran at a
+        // third of their bandwidth.
+        const std::size_t k_PrefetchDistance = 1024;
+
+        // Chunk sizes tried besides the equal split of a copy between the threads.
+        const std::size_t k_ChunkCandidates[] = { 256 * 1024, 1024 * 1024 };
+
+        std::size_t AlignUp(const std::size_t value, const std::size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        // Copies up to the first cache line boundary of the destination, so the kernels store whole
+        // aligned lines. The source is read unaligned.
+        void CopyHead(std::uint8_t*& destination, const std::uint8_t*& source, std::size_t& bytes)
+        {
+            const auto misalignment = reinterpret_cast<std::uintptr_t>(destination) & (k_CacheLineBytes - 1);
+            const auto head = std::min(bytes, (k_CacheLineBytes - misalignment) & (k_CacheLineBytes - 1));
+
+            std::memcpy(destination, source, head);
+            destination += head;
+            source += head;
+            bytes -= head;
+        }
+
+#if FRAME_COPY_X86
+        void CopySSE2(std::uint8_t* destination, const std::uint8_t* source, std::size_t bytes)
+        {
+            CopyHead(destination, source, bytes);
+
+            for (; bytes >= k_CacheLineBytes; destination += k_CacheLineBytes, source += k_CacheLineBytes, bytes -= k_CacheLineBytes)
+            {
+                _mm_prefetch(reinterpret_cast<const char*>(source + k_PrefetchDistance), _MM_HINT_T1);
+
+                const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+                const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16));
+                const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32));
+                const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 48));
+                _mm_stream_si128(reinterpret_cast<__m128i*>(destination), a);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(destination + 16), b);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(destination + 32), c);
+                _mm_stream_si128(reinterpret_cast<__m128i*>(destination + 48), d);
+            }
+
+            // The streaming stores are weakly ordered: complete them before the copy is reported done.
+            _mm_sfence();
+            std::memcpy(destination, source, bytes);
+        }
+
+        FRAME_COPY_TARGET("avx2")
+        void CopyAVX2(std::uint8_t* destination, const std::uint8_t* source, std::size_t bytes)
+        {
+            CopyHead(destination, source, bytes);
+
+            for (; bytes >= 2 * k_CacheLineBytes; destination += 2 * k_CacheLineBytes, source += 2 * k_CacheLineBytes, bytes -= 2 * k_CacheLineBytes)
+            {
+                _mm_prefetch(reinterpret_cast<const char*>(source + k_PrefetchDistance), _MM_HINT_T1);
+                _mm_prefetch(reinterpret_cast<const char*>(source + k_PrefetchDistance + k_CacheLineBytes), _MM_HINT_T1);
+
+                const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+                const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 32));
+                const auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 64));
+                const auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 96));
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(destination), a);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 32), b);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 64), c);
+                _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 96), d);
+            }
+
+            _mm_sfence();
+            std::memcpy(destination, source, bytes);
+        }
+
+        FRAME_COPY_TARGET("avx512f")
+        void CopyAVX512(std::uint8_t* destination, const std::uint8_t* source, std::size_t bytes)
+        {
+            CopyHead(destination, source, bytes);
+
+            for (; bytes >= 2 * k_CacheLineBytes; destination += 2 * k_CacheLineBytes, source += 2 * k_CacheLineBytes, bytes -= 2 * k_CacheLineBytes)
+            {
+                _mm_prefetch(reinterpret_cast<const char*>(source + k_PrefetchDistance), _MM_HINT_T1);
+                _mm_prefetch(reinterpret_cast<const char*>(source + k_PrefetchDistance + k_CacheLineBytes), _MM_HINT_T1);
+
+                const auto a = _mm512_loadu_si512(source);
+                const auto b = _mm512_loadu_si512(source + 64);
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(destination), a);
+                _mm512_stream_si512(reinterpret_cast<__m512i*>(destination + 64), b);
+            }
+
+            _mm_sfence();
+            std::memcpy(destination, source, bytes);
+        }
+
+        ECopyKernel DetectCopyKernel()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            const auto maxLeaf = info[0];
+
+            // The operating system has to save the wider registers as well.
+            __cpuid(info, 1);
+            const auto osSavesRegisters = (info[2] & (1 << 27)) != 0;
+            const auto xcr0 = osSavesRegisters ? _xgetbv(0) : 0;
+
+            auto avx2 = false;
+            auto avx512 = false;
+            if (maxLeaf >= 7)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+                avx512 = (info[1] & (1 << 16)) != 0;
+            }
+
+            if (avx512 && (xcr0 & 0xE6) == 0xE6)
+                return ECopyKernel::AVX512;
+            if (avx2 && (xcr0 & 0x6) == 0x6)
+                return ECopyKernel::AVX2;
+            return ECopyKernel::SSE2;
+#else
+            // Also checks that the operating system saves the wider registers.
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return ECopyKernel::AVX512;
+            if (__builtin_cpu_supports("avx2"))
+                return ECopyKernel::AVX2;
+            return ECopyKernel::SSE2;
+#endif
+        }
+#elif FRAME_COPY_NEON
+        void CopyNEON(std::uint8_t* destination, const std::uint8_t* source, std::size_t bytes)
+        {
+            CopyHead(destination, source, bytes);
+
+            for (; bytes >= k_CacheLineBytes; destination += k_CacheLineBytes, source += k_CacheLineBytes, bytes -= k_CacheLineBytes)
+            {
+                __builtin_prefetch(source + k_PrefetchDistance, 0, 2);
+
+                const auto a = vld1q_u8(source);
+                const auto b = vld1q_u8(source + 16);
+                const auto c = vld1q_u8(source + 32);
+                const auto d = vld1q_u8(source + 48);
+#if defined(__clang__)
+                // Compiled to STNP, the non-temporal store pair.
+                __builtin_nontemporal_store(a, reinterpret_cast<uint8x16_t*>(destination));
+                __builtin_nontemporal_store(b, reinterpret_cast<uint8x16_t*>(destination + 16));
+                __builtin_nontemporal_store(c, reinterpret_cast<uint8x16_t*>(destination + 32));
+                __builtin_nontemporal_store(d, reinterpret_cast<uint8x16_t*>(destination + 48));
+#else
+                vst1q_u8(destination, a);
+                vst1q_u8(destination + 16, b);
+                vst1q_u8(destination + 32, c);
+                vst1q_u8(destination + 48, d);
+#endif
+            }
+
+            std::memcpy(destination, source, bytes);
+        }
+
+        ECopyKernel DetectCopyKernel()
+        {
+            // Part of every ARMv8-A CPU.
+            return ECopyKernel::NEON;
+        }
+#else
+        ECopyKernel DetectCopyKernel()
+        {
+            return ECopyKernel::Memcpy;
+        }
+#endif
+    }
+
+    class FrameCopyEngine::Pool final
+    {
+    public:
+        // Returns the pool of the process, creating it on first use.
+        static Pool* Acquire();
+        void Release();
+
+        inline int GetMaxThreads() const { return m_MaxThreads; }
+
+        // Copies with the given settings, on the calling thread alone while another copy uses the workers.
+        void Copy(std::uint8_t* destination, const std::uint8_t* source, std::size_t bytes, int threadCount, std::size_t chunkBytes);
+
+        // Gets the settings tuned for the size. Returns false while the size is being tuned, after
+        // queuing it for the tuner if 'tune' is set.
+        bool FindTuning(std::size_t bytes, bool tune, int& threadCount, std::size_t& chunkBytes);
+
+    private:
+        // Copies of each candidate measured before the fastest one is chosen.
+        static const int k_TrialCopies = 3;
+
+        // The outputs share the tunings, and each copies frames of one size, or of a few while it
+        // changes format.
+        static const std::size_t k_MaxTunedSizes = 8;
+
+        struct Tuning
+        {
+            std::size_t     bytes;
+            int             threadCount;
+            std::size_t     chunkBytes;
+            bool            tuned;
+            std::uint64_t   lastUse;
+        };
+
+        static std::mutex   s_Mutex;
+        static Pool*        s_Pool;
+
+        Pool();
+        ~Pool();
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        void RunCopy(std::uint8_t* destination, const std::uint8_t* source, std::size_t bytes, int workers,
+                     std::size_t chunkBytes, std::size_t chunkCount);
+        void CopyChunks();
+        void StartWorkers(int count);
+        void RunWorker(int index, std::uint64_t generation);
+        void RunTuner();
+        void Tune(std::size_t bytes, int& threadCount, std::size_t& chunkBytes);
+
+        const int                   m_MaxThreads;
+        const ECopyKernel           m_Kernel;
+        int                         m_References;       // Guarded by s_Mutex.
+
+        // Held by the copy which uses the workers.
+        std::mutex                  m_CopyMutex;
+
+        // The tuned sizes, and the sizes queued for the tuner.
+        std::mutex                  m_TuningMutex;
+        std::vector<Tuning>         m_Tunings;
+        std::uint64_t               m_Uses;
+        std::thread                 m_Tuner;
+        bool                        m_TunerRunning;
+        std::atomic<bool>           m_TunerStopping;
+
+        // The copy being run, which the workers with an index below m_JobWorkers take part in.
+        std::mutex                  m_JobMutex;
+        std::condition_variable     m_StartCondition;
+        std::condition_variable     m_DoneCondition;
+        std::uint64_t               m_JobGeneration;
+        int                         m_JobWorkers;
+        int                         m_PendingWorkers;
+        bool                        m_Stopping;
+        std::uint8_t*               m_JobDestination;
+        const std::uint8_t*         m_JobSource;
+        std::size_t                 m_JobBytes;
+        std::size_t                 m_JobChunkBytes;
+        std::size_t                 m_JobChunkCount;
+        std::atomic<std::size_t>    m_NextChunk;
+
+        // Started when a copy first needs them.
+        std::vector<std::thread>    m_Workers;
+    };
+
+    std::mutex FrameCopyEngine::Pool::s_Mutex;
+    FrameCopyEngine::Pool* FrameCopyEngine::Pool::s_Pool = nullptr;
+
+    FrameCopyEngine::Pool* FrameCopyEngine::Pool::Acquire()
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        if (s_Pool == nullptr)
+            s_Pool = new Pool();
+
+        ++s_Pool->m_References;
+        return s_Pool;
+    }
+
+    void FrameCopyEngine::Pool::Release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+            if (--m_References > 0)
+                return;
+
+            s_Pool = nullptr;
+        }
+
+        // The threads are stopped with the last engine, rather than when the plugin is unloaded.
+        delete this;
+    }
+
+    FrameCopyEngine::Pool::Pool() :
+        m_MaxThreads(std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), k_MaxThreads))),
+        m_Kernel(GetKernel()),
+        m_References(0),
+        m_Uses(0),
+        m_TunerRunning(false),
+        m_TunerStopping(false),
+        m_JobGeneration(0),
+        m_JobWorkers(0),
+        m_PendingWorkers(0),
+        m_Stopping(false),
+        m_JobDestination(nullptr),
+        m_JobSource(nullptr),
+        m_JobBytes(0),
+        m_JobChunkBytes(0),
+        m_JobChunkCount(0),
+        m_NextChunk(0)
+    {
+    }
+
+    FrameCopyEngine::Pool::~Pool()
+    {
+        // The tuner is stopped first, as its copies wait for the workers.
+        m_TunerStopping.store(true, std::memory_order_relaxed);
+        if (m_Tuner.joinable())
+            m_Tuner.join();
+
+        {
+            std::lock_guard<std::mutex> lock(m_JobMutex);
+            m_Stopping = true;
+        }
+        m_StartCondition.notify_all();
+
+        for (auto& worker : m_Workers)
+        {
+            worker.join();
+        }
+    }
+
+    void FrameCopyEngine::Pool::Copy(std::uint8_t* destination, const std::uint8_t* source, const std::size_t bytes,
+                                     const int threadCount, const std::size_t chunkBytes)
+    {
+        const auto chunk = AlignUp(std::max(chunkBytes, k_PageBytes), k_PageBytes);
+        const auto chunkCount = (bytes + chunk - 1) / chunk;
+        const auto workers = static_cast<int>(std::min<std::size_t>(static_cast<std::size_t>(std::max(threadCount, 1)), chunkCount)) - 1;
+
+        if (workers <= 0)
+        {
+            CopyWithKernel(m_Kernel, destination, source, bytes);
+            return;
+        }
+
+        // The outputs copy their frames around the same time: rather than waiting for the
+        // workers, which would serialize the outputs, the copy runs on the calling thread.
+        std::unique_lock<std::mutex> lock(m_CopyMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            CopyWithKernel(m_Kernel, destination, source, bytes);
+            return;
+        }
+
+        RunCopy(destination, source, bytes, workers, chunk, chunkCount);
+    }
+
+    bool FrameCopyEngine::Pool::FindTuning(const std::size_t bytes, const bool tune, int& threadCount, std::size_t& chunkBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_TuningMutex);
+
+        ++m_Uses;
+
+        for (auto& tuning : m_Tunings)
+        {
+            if (tuning.bytes == bytes)
+            {
+                tuning.lastUse = m_Uses;
+                threadCount = tuning.threadCount;
+                chunkBytes = tuning.chunkBytes;
+                return tuning.tuned;
+            }
+        }
+
+        if (!tune)
+            return false;
+
+        if (m_Tunings.size() >= k_MaxTunedSizes)
+        {
+            m_Tunings.erase(std::min_element(m_Tunings.begin(), m_Tunings.end(),
+                [](const Tuning& lhs, const Tuning& rhs) { return lhs.lastUse < rhs.lastUse; }));
+        }
+
+        // With a single thread, there is no candidate to choose from.
+        const auto tuned = m_MaxThreads == 1;
+        m_Tunings.push_back({ bytes, 1, bytes, tuned, m_Uses });
+        if (tuned)
+        {
+            threadCount = 1;
+            chunkBytes = bytes;
+            return true;
+        }
+
+        if (!m_TunerRunning)
+        {
+            // The previous tuner has returned, or is about to.
+            if (m_Tuner.joinable())
+                m_Tuner.join();
+
+            m_TunerRunning = true;
+            m_Tuner = std::thread(&Pool::RunTuner, this);
+        }
+        return false;
+    }
+
+    void FrameCopyEngine::Pool::RunTuner()
+    {
+        ProfilerThreadScope thread("Frame Copy Tuning");
+
+        while (!m_TunerStopping.load(std::memory_order_relaxed))
+        {
+            std::size_t bytes = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_TuningMutex);
+                for (const auto& tuning : m_Tunings)
+                {
+                    if (!tuning.tuned)
+                    {
+                        bytes = tuning.bytes;
+                        break;
+                    }
+                }
+
+                if (bytes == 0)
+                {
+                    m_TunerRunning = false;
+                    return;
+                }
+            }
+
+            int threadCount = 1;
+            std::size_t chunkBytes = bytes;
+            Tune(bytes, threadCount, chunkBytes);
+
+            // The size may have been dropped for newer ones in the meantime.
+            std::lock_guard<std::mutex> lock(m_TuningMutex);
+            for (auto& tuning : m_Tunings)
+            {
+                if (tuning.bytes == bytes)
+                {
+                    tuning.threadCount = threadCount;
+                    tuning.chunkBytes = chunkBytes;
+                    tuning.tuned = true;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_TuningMutex);
+        m_TunerRunning = false;
+    }
+
+    void FrameCopyEngine::Pool::Tune(const std::size_t bytes, int& threadCount, std::size_t& chunkBytes)
+    {
+        struct Candidate
+        {
+            int             threadCount;
+            std::size_t     chunkBytes;
+            std::int64_t    bestDuration;   // Of the trial copies, in nanoseconds.
+        };
+
+        const auto maxDuration = std::numeric_limits<std::int64_t>::max();
+        std::vector<Candidate> candidates;
+        candidates.push_back({ 1, bytes, maxDuration });
+
+        // The powers of two below the maximum, then the maximum.
+        std::vector<int> threadCounts;
+        for (auto count = 2; count < m_MaxThreads; count *= 2)
+        {
+            threadCounts.push_back(count);
+        }
+        if (m_MaxThreads > 1)
+            threadCounts.push_back(m_MaxThreads);
+
+        for (const auto count : threadCounts)
+        {
+            // Split equally, then in smaller chunks which balance the threads which start late.
+            const auto split = AlignUp((bytes + count - 1) / count, k_PageBytes);
+            candidates.push_back({ count, split, maxDuration });
+
+            for (const auto chunk : k_ChunkCandidates)
+            {
+                if (chunk < split)
+                    candidates.push_back({ count, chunk, maxDuration });
+            }
+        }
+
+        // The candidates are measured on buffers of their own, so the frames of the outputs are
+        // never copied with a slow candidate. The pages are written first, as untouched pages
+        // would all map to the same zeroed page.
+        auto destination = static_cast<std::uint8_t*>(AllocatePageAlignedBuffer(bytes));
+        auto source = static_cast<std::uint8_t*>(AllocatePageAlignedBuffer(bytes));
+        if (destination != nullptr && source != nullptr)
+        {
+            std::memset(destination, 0, bytes);
+            std::memset(source, 0x5A, bytes);
+
+            for (auto trial = 0; trial < k_TrialCopies; ++trial)
+            {
+                for (auto& candidate : candidates)
+                {
+                    if (m_TunerStopping.load(std::memory_order_relaxed))
+                        break;
+
+                    const auto chunk = AlignUp(std::max(candidate.chunkBytes, k_PageBytes), k_PageBytes);
+                    const auto chunkCount = (bytes + chunk - 1) / chunk;
+                    const auto workers = static_cast<int>(std::min<std::size_t>(static_cast<std::size_t>(candidate.threadCount), chunkCount)) - 1;
+
+                    std::lock_guard<std::mutex> lock(m_CopyMutex);
+                    const auto start = std::chrono::steady_clock::now();
+                    if (workers <= 0)
+                        CopyWithKernel(m_Kernel, destination, source, bytes);
+                    else
+                        RunCopy(destination, source, bytes, workers, chunk, chunkCount);
+                    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                    // The best of the trials, as the others were slowed down by the rest of the system.
+                    candidate.bestDuration = std::min<std::int64_t>(candidate.bestDuration, duration);
+                }
+            }
+        }
+
+        if (destination != nullptr)
+            FreePageAlignedBuffer(destination);
+        if (source != nullptr)
+            FreePageAlignedBuffer(source);
+
+        const auto fastest = std::min_element(candidates.begin(), candidates.end(),
+            [](const Candidate& lhs, const Candidate& rhs) { return lhs.bestDuration < rhs.bestDuration; });
+        threadCount = fastest->threadCount;
+        chunkBytes = fastest->chunkBytes;
+    }
+
+    void FrameCopyEngine::Pool::RunCopy(std::uint8_t* destination, const std::uint8_t* source, const std::size_t bytes,
+                                        const int workers, const std::size_t chunkBytes, const std::size_t chunkCount)
+    {
+        StartWorkers(workers);
+        {
+            std::lock_guard<std::mutex> lock(m_JobMutex);
+            m_JobDestination = destination;
+            m_JobSource = source;
+            m_JobBytes = bytes;
+            m_JobChunkBytes = chunkBytes;
+            m_JobChunkCount = chunkCount;
+            m_NextChunk.store(0, std::memory_order_relaxed);
+            m_JobWorkers = workers;
+            m_PendingWorkers = workers;
+            ++m_JobGeneration;
+        }
+        m_StartCondition.notify_all();
+
+        CopyChunks();
+
+        std::unique_lock<std::mutex> lock(m_JobMutex);
+        m_DoneCondition.wait(lock, [this] { return m_PendingWorkers == 0; });
+    }
+
+    void FrameCopyEngine::Pool::CopyChunks()
+    {
+        // The chunks end at page boundaries of the destination, so no two threads store into a page.
+        const auto base = reinterpret_cast<std::uintptr_t>(m_JobDestination);
+        const auto boundary = [this, base](const std::size_t chunk) -> std::size_t
+        {
+            if (chunk == 0)
+                return 0;
+
+            const auto aligned = AlignUp(base + chunk * m_JobChunkBytes, k_PageBytes) - base;
+            return std::min(m_JobBytes, aligned);
+        };
+
+        for (auto chunk = m_NextChunk.fetch_add(1, std::memory_order_relaxed); chunk < m_JobChunkCount;
+             chunk = m_NextChunk.fetch_add(1, std::memory_order_relaxed))
+        {
+            const auto begin = boundary(chunk);
+            const auto end = boundary(chunk + 1);
+            if (end > begin)
+                CopyWithKernel(m_Kernel, m_JobDestination + begin, m_JobSource + begin, end - begin);
+        }
+    }
+
+    void FrameCopyEngine::Pool::StartWorkers(const int count)
+    {
+        // Only the copying thread changes the generation, so the new workers wait for the next copy.
+        while (static_cast<int>(m_Workers.size()) < count)
+        {
+            m_Workers.emplace_back(&Pool::RunWorker, this, static_cast<int>(m_Workers.size()), m_JobGeneration);
+        }
+    }
+
+    void FrameCopyEngine::Pool::RunWorker(const int index, std::uint64_t generation)
+    {
+        ProfilerThreadScope thread("Frame Copy");
+
+        std::unique_lock<std::mutex> lock(m_JobMutex);
+
+        while (true)
+        {
+            m_StartCondition.wait(lock, [&] { return m_Stopping || m_JobGeneration != generation; });
+
+            if (m_Stopping)
+                return;
+
+            generation = m_JobGeneration;
+            if (index >= m_JobWorkers)
+                continue;
+
+            lock.unlock();
+            CopyChunks();
+            lock.lock();
+
+            if (--m_PendingWorkers == 0)
+                m_DoneCondition.notify_one();
+        }
+    }
+
+    FrameCopyEngine::FrameCopyEngine() :
+        m_Pool(Pool::Acquire()),
+        m_FixedThreadCount(0),
+        m_FixedChunkBytes(0)
+    {
+    }
+
+    FrameCopyEngine::~FrameCopyEngine()
+    {
+        m_Pool->Release();
+    }
+
+    ECopyKernel FrameCopyEngine::GetKernel()
+    {
+        static const auto kernel = DetectCopyKernel();
+        return kernel;
+    }
+
+    bool FrameCopyEngine::IsKernelSupported(const ECopyKernel kernel)
+    {
+        switch (kernel)
+        {
+        case ECopyKernel::Memcpy:
+            return true;
+        case ECopyKernel::SSE2:
+        case ECopyKernel::AVX2:
+        case ECopyKernel::AVX512:
+            return GetKernel() != ECopyKernel::Memcpy && GetKernel() != ECopyKernel::NEON && kernel <= GetKernel();
+        case ECopyKernel::NEON:
+            return GetKernel() == ECopyKernel::NEON;
+        default:
+            return false;
+        }
+    }
+
+    const char* FrameCopyEngine::GetKernelName(const ECopyKernel kernel)
+    {
+        switch (kernel)
+        {
+        case ECopyKernel::Memcpy: return "memcpy";
+        case ECopyKernel::SSE2: return "SSE2";
+        case ECopyKernel::AVX2: return "AVX2";
+        case ECopyKernel::AVX512: return "AVX-512";
+        case ECopyKernel::NEON: return "NEON";
+        default: return "unknown";
+        }
+    }
+
+    void FrameCopyEngine::CopyWithKernel(const ECopyKernel kernel, void* destination, const void* source, const std::size_t bytes)
+    {
+        auto d = static_cast<std::uint8_t*>(destination);
+        auto s = static_cast<const std::uint8_t*>(source);
+
+        switch (kernel)
+        {
+#if FRAME_COPY_X86
+        case ECopyKernel::SSE2: CopySSE2(d, s, bytes); break;
+        case ECopyKernel::AVX2: CopyAVX2(d, s, bytes); break;
+        case ECopyKernel::AVX512: CopyAVX512(d, s, bytes); break;
+#elif FRAME_COPY_NEON
+        case ECopyKernel::NEON: CopyNEON(d, s, bytes); break;
+#endif
+        default: std::memcpy(d, s, bytes); break;
+        }
+    }
+
+    void FrameCopyEngine::Copy(void* destination, const void* source, const std::size_t bytes)
+    {
+        auto d = static_cast<std::uint8_t*>(destination);
+        auto s = static_cast<const std::uint8_t*>(source);
+
+        if (bytes < k_StreamingThreshold)
+        {
+            std::memcpy(d, s, bytes);
+            return;
+        }
+
+        int threadCount;
+        std::size_t chunkBytes;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            threadCount = m_FixedThreadCount;
+            chunkBytes = m_FixedChunkBytes;
+        }
+
+        // Until the size is tuned, the calling thread copies alone.
+        if (threadCount == 0 && !m_Pool->FindTuning(bytes, true, threadCount, chunkBytes))
+        {
+            threadCount = 1;
+            chunkBytes = bytes;
+        }
+
+        m_Pool->Copy(d, s, bytes, threadCount, chunkBytes);
+    }
+
+    bool FrameCopyEngine::GetTuning(const std::size_t bytes, int& threadCount, std::size_t& chunkBytes) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_FixedThreadCount > 0)
+            {
+                threadCount = m_FixedThreadCount;
+                chunkBytes = m_FixedChunkBytes;
+                return true;
+            }
+        }
+
+        return m_Pool->FindTuning(bytes, false, threadCount, chunkBytes);
+    }
+
+    void FrameCopyEngine::SetFixedTuning(const int threadCount, const std::size_t chunkBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_FixedThreadCount = std::max(0, std::min(threadCount, m_Pool->GetMaxThreads()));
+        m_FixedChunkBytes = chunkBytes;
+    }
+}
+
+#undef FRAME_COPY_TARGET
+#undef FRAME_COPY_NEON
+#undef FRAME_COPY_X86
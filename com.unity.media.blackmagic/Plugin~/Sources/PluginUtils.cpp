@@ -1,64 +1,30 @@
 #include "PluginUtils.h"
+#include "DeckLinkLogger.h"
 
 namespace MediaBlackmagic
 {
-    static const std::string k_FileName = "/Blackmagic_Log.log";
-    static std::string k_DefinitiveFilePath = "C:/Blackmagic/Debug_BMD.txt";
-
-    void WriteFileDebug(const char* const message, const bool append)
+    void InitLog()
     {
+        // Debug builds log everything by default; release builds log once configured.
 #ifdef DEBUG_LOG
-        std::ofstream myfile;
-        
-        if (append)
-        {
-            myfile.open(k_DefinitiveFilePath, std::ios_base::app | std::ios_base::out);
-        }
-        else
-        {
-            myfile.open(k_DefinitiveFilePath);
-        }
-
-        myfile << message;
-        myfile.close();
+        DeckLinkLogger::Configure(nullptr, ELogSeverity::Debug, DeckLinkLogger::kDefaultMaxFileBytes);
 #endif
     }
 
-    void WriteFileDebug(const char* const message, int value, const bool append)
+    // The debug lines are queued for the logger: every session starts a new file, so 'append' no
+    // longer truncates it. Errors and warnings are logged through DeckLinkLogger directly.
+    void WriteFileDebug(const char* const message, const bool append)
     {
-#ifdef DEBUG_LOG
-        std::ofstream myfile;
-
-        if (append)
-        {
-            myfile.open(k_DefinitiveFilePath, std::ios_base::app | std::ios_base::out);
-        }
-        else
-        {
-            myfile.open(k_DefinitiveFilePath);
-        }
+        DeckLinkLogger::Log(ELogSeverity::Debug, "%s", message);
+    }
 
-        myfile << message << value << "\n";
-        myfile.close();
-#endif
+    void WriteFileDebug(const char* const message, int value, const bool append)
+    {
+        DeckLinkLogger::Log(ELogSeverity::Debug, "%s%d", message, value);
     }
 
     void WriteFileDebug(const char* const message, unsigned long long value, const bool append)
     {
-#ifdef DEBUG_LOG
-        std::ofstream myfile;
-
-        if (append)
-        {
-            myfile.open(k_DefinitiveFilePath, std::ios_base::app | std::ios_base::out);
-        }
-        else
-        {
-            myfile.open(k_DefinitiveFilePath);
-        }
-
-        myfile << message << value << "\n";
-        myfile.close();
-#endif
+        DeckLinkLogger::Log(ELogSeverity::Debug, "%s%llu", message, value);
     }
 }
@@ -1,6 +1,7 @@
 #if _WIN64
 #include "VideoFrameTransfer.h"
 #include "PluginUtils.h"
+#include "DeckLinkLogger.h"
 
 namespace MediaBlackmagic
 {
@@ -60,7 +61,7 @@ namespace MediaBlackmagic
             auto hr = (dvpInitD3D11Device(pD3DDevice, 0));
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpInitD3D11Device failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpInitD3D11Device failed with status %d.", static_cast<int>(hr));
                 return false;
             }
 
@@ -75,14 +76,14 @@ namespace MediaBlackmagic
 
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpGetRequiredConstantsD3D11Device failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpGetRequiredConstantsD3D11Device failed with status %d.", static_cast<int>(hr));
                 return false;
             }
 
             hr = dvpCreateGPUD3D11Resource((ID3D11Resource*)playbackTexture, &m_DvpPlaybackTextureHandle);
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpCreateGPUD3D11Resource2 failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpCreateGPUD3D11Resource failed with status %d.", static_cast<int>(hr));
                 return false;
             }
         }
@@ -104,7 +105,7 @@ namespace MediaBlackmagic
             auto hr = dvpFreeBuffer(m_DvpPlaybackTextureHandle);
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpFreeBuffer2 failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpFreeBuffer failed with status %d.", static_cast<int>(hr));
                 return false;
             }
 
@@ -113,7 +114,7 @@ namespace MediaBlackmagic
                 hr = dvpCloseD3D11Device(pD3DDevice);
                 if (DVP_STATUS_OK != hr)
                 {
-                    WriteFileDebug("dvpCloseD3D11Device failed.\n");
+                    DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpCloseD3D11Device failed with status %d.", static_cast<int>(hr));
                     return false;
                 }
             }
@@ -175,7 +176,7 @@ namespace MediaBlackmagic
         const auto hr = dvpImportSyncObject(&syncObjectDesc, &mDvpSync);
         if (DVP_STATUS_OK != hr)
         {
-            WriteFileDebug("dvpImportSyncObject failed.\n");
+            DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpImportSyncObject failed with status %d.", static_cast<int>(hr));
             return;
         }
     }
@@ -185,7 +186,7 @@ namespace MediaBlackmagic
         const auto hr = dvpFreeSyncObject(mDvpSync);
         if (DVP_STATUS_OK != hr)
         {
-            WriteFileDebug("dvpImportSyncObject failed.\n");
+            DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpFreeSyncObject failed with status %d.", static_cast<int>(hr));
             return;
         }
         _aligned_free((void*)mSem);
@@ -203,7 +204,7 @@ namespace MediaBlackmagic
         {
             // Pin the memory
             if (!VirtualLock(m_Buffer, m_MemSize))
-                WriteFileDebug("Error pinning memory with VirtualLock\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: VirtualLock failed to pin the transfer buffer.");
 
             // Create necessary sysmem and gpu sync objects
             m_ExtSync = new SyncInfo(m_SemaphoreAllocSize, m_SemaphoreAddrAlignment);
@@ -225,14 +226,14 @@ namespace MediaBlackmagic
             auto hr = dvpCreateBuffer(&sysMemBuffersDesc, &m_DvpSysMemHandle);
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpCreateBuffer failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpCreateBuffer failed with status %d.", static_cast<int>(hr));
                 return;
             }
 
             hr = dvpBindToD3D11Device(m_DvpSysMemHandle, m_D3DDevice);
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpBindToD3D11Device failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpBindToD3D11Device failed with status %d.", static_cast<int>(hr));
                 return;
             }
 
@@ -249,7 +250,7 @@ namespace MediaBlackmagic
                 auto hr = dvpUnbindFromD3D11Device(m_DvpSysMemHandle, m_D3DDevice);
                 if (DVP_STATUS_OK != hr)
                 {
-                    WriteFileDebug("dvpUnbindFromD3D11Device failed.\n");
+                    DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpUnbindFromD3D11Device failed with status %d.", static_cast<int>(hr));
                     return;
                 }
             }
@@ -257,7 +258,7 @@ namespace MediaBlackmagic
             auto hr = dvpDestroyBuffer(m_DvpSysMemHandle);
             if (DVP_STATUS_OK != hr)
             {
-                WriteFileDebug("dvpDestroyBuffer failed.\n");
+                DeckLinkLogger::Log(ELogSeverity::Error, "GPUDirect: dvpDestroyBuffer failed with status %d.", static_cast<int>(hr));
                 return;
             }
 
@@ -30,10 +30,14 @@ var np = new NativeProgram("Blackmagic")
     Libraries = {
         {IsOSX(),  new SystemFramework("CoreFoundation")},
         {IsWin(), new StaticLibrary("external/NVIDIA_GPUDirect/lib/x64/dvp.lib")},
-        {IsLinux(), new SystemLibrary("dl")}
+        {IsLinux(), new SystemLibrary("dl"), new SystemLibrary("pthread")}
     }
 };
 
+// Hardware-free benchmarks: the plugin sources are linked with a virtual DeckLink driver instead
+// of the dispatch of the DeckLink API, so they run without a card. Linux only.
+var benchmarks = new[] { "CaptureBenchmark", "PlayoutBenchmark", "ScalingBenchmark", "SoakBenchmark", "ReplayBenchmark", "CopyBenchmark" }.Select(SetupBenchmark).ToArray();
+
 var windowsToolchain = ToolChain.Store.Windows().VS2019().Sdk_18362().x64();
 var linuxToolchain = ToolChain.Store.Linux().Centos_7_4().Clang_5_0_1().x64();
 var macX64ToolChain = ToolChain.Store.Mac().Sdk_11_1().x64();
@@ -51,8 +55,19 @@ foreach (var codegen in new[] { CodeGen.Debug, CodeGen.Release })
     if (windowsToolchain.CanBuild)
         SetupAndDeploy(windowsToolchain, $"../Runtime/Plugin/win64", codegen);
     if (linuxToolchain.CanBuild)
+    {
         SetupAndDeploy(linuxToolchain, $"../Runtime/Plugin/linux64", codegen);
 
+        // Outside of the package: the benchmarks aren't shipped.
+        foreach (var benchmark in benchmarks)
+        {
+            benchmark.SetupSpecificConfiguration(
+                new NativeProgramConfiguration(codegen, linuxToolchain, lump: true),
+                linuxToolchain.ExecutableFormat
+            ).DeployTo($"build/benchmarks/{codegen}");
+        }
+    }
+
     if (macX64ToolChain.CanBuild)
     {
         var x64 = SetupSpecificConfiguration(macX64ToolChain, codegen);
@@ -70,6 +85,27 @@ BuiltNativeProgram SetupSpecificConfiguration(ToolChain toolChain, CodeGen codeG
 
 BuiltNativeProgram SetupAndDeploy(ToolChain toolChain, NPath deployDir, CodeGen codeGen) => SetupSpecificConfiguration(toolChain, codeGen).DeployTo(deployDir);
 
+NativeProgram SetupBenchmark(string name) => new NativeProgram(name)
+{
+    Sources =
+    {
+        $"Benchmarks/{name}.cpp",
+        "Benchmarks/Common",
+        "Sources",
+        "platform/linux",
+    },
+    IncludeDirectories = {
+        "external/Unity",
+        "Includes",
+        "platform/linux",
+        "external/blackmagic/linux/include",
+    },
+    Libraries = {
+        new SystemLibrary("dl"),
+        new SystemLibrary("pthread")
+    }
+};
+
 Func<NativeProgramConfiguration, bool> IsOSX() => config => config.Platform is MacOSXPlatform;
 Func<NativeProgramConfiguration, bool> IsWin() => config => config.Platform is WindowsPlatform;
 Func<NativeProgramConfiguration, bool> IsLinux() => config => config.Platform is LinuxPlatform;
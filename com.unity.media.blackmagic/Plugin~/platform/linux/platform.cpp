@@ -27,6 +27,15 @@
 
 #include "platform.h"
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
 
 HRESULT GetDeckLinkIterator(IDeckLinkIterator **deckLinkIterator)
 {
@@ -60,3 +69,53 @@ HRESULT GetDeckLinkDiscovery(void** deckLinkIterator)
 
     return result;
 }
+
+HRESULT GetDeckLinkVideoConversion(IDeckLinkVideoConversion **deckLinkVideoConversion)
+{
+    auto result = S_OK;
+
+    // Create an IDeckLinkVideoConversion object to repack frames between pixel formats
+    *deckLinkVideoConversion = CreateVideoConversionInstance();
+    if (*deckLinkVideoConversion == NULL)
+    {
+        result = E_FAIL;
+    }
+
+    return result;
+}
+
+bool WaitOnAddressValue(std::atomic<uint32_t>* address, uint32_t expected, int timeoutMs)
+{
+    timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+
+    // The futex word is the atomic itself, which is lock-free and has the size of a uint32_t.
+    auto result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAIT_PRIVATE, expected,
+                          timeoutMs < 0 ? nullptr : &timeout, nullptr, 0);
+
+    return !(result == -1 && errno == ETIMEDOUT);
+}
+
+void WakeAllOnAddress(std::atomic<uint32_t>* address)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(address), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void SetCurrentThreadBackgroundPriority()
+{
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+}
+
+void* AllocatePageAlignedBuffer(size_t size)
+{
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, static_cast<size_t>(sysconf(_SC_PAGESIZE)), size) != 0)
+        return nullptr;
+    return buffer;
+}
+
+void FreePageAlignedBuffer(void* buffer)
+{
+    free(buffer);
+}
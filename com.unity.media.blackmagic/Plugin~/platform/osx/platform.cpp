@@ -27,6 +27,13 @@
 
 #include "platform.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <cstdlib>
+#include <unistd.h>
+
 
 HRESULT GetDeckLinkIterator(IDeckLinkIterator **deckLinkIterator)
 {
@@ -60,3 +67,62 @@ HRESULT GetDeckLinkDiscovery(void** deckLinkIterator)
 
     return result;
 }
+
+HRESULT GetDeckLinkVideoConversion(IDeckLinkVideoConversion **deckLinkVideoConversion)
+{
+    auto result = S_OK;
+
+    // Create an IDeckLinkVideoConversion object to repack frames between pixel formats
+    *deckLinkVideoConversion = CreateVideoConversionInstance();
+    if (*deckLinkVideoConversion == NULL)
+    {
+        result = E_FAIL;
+    }
+
+    return result;
+}
+
+// There is no public futex on macOS: emulate it with a process-wide condition variable.
+static std::mutex s_AddressMutex;
+static std::condition_variable s_AddressCondition;
+
+bool WaitOnAddressValue(std::atomic<uint32_t>* address, uint32_t expected, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(s_AddressMutex);
+    const auto predicate = [=]() { return address->load() != expected; };
+
+    if (timeoutMs < 0)
+    {
+        s_AddressCondition.wait(lock, predicate);
+        return true;
+    }
+
+    return s_AddressCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), predicate);
+}
+
+void WakeAllOnAddress(std::atomic<uint32_t>* address)
+{
+    // Taking the lock orders the wake after any waiter which already checked the value.
+    {
+        std::lock_guard<std::mutex> lock(s_AddressMutex);
+    }
+    s_AddressCondition.notify_all();
+}
+
+void SetCurrentThreadBackgroundPriority()
+{
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+}
+
+void* AllocatePageAlignedBuffer(size_t size)
+{
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, static_cast<size_t>(sysconf(_SC_PAGESIZE)), size) != 0)
+        return nullptr;
+    return buffer;
+}
+
+void FreePageAlignedBuffer(void* buffer)
+{
+    free(buffer);
+}
@@ -27,6 +27,8 @@
 
 #include "platform.h"
 
+#pragma comment(lib, "Synchronization.lib")
+
 
 HRESULT GetDeckLinkIterator(IDeckLinkIterator **deckLinkIterator)
 {
@@ -38,3 +40,40 @@ HRESULT GetDeckLinkDiscovery(void** deckLinkIterator)
 {
     return CoCreateInstance(CLSID_CDeckLinkDiscovery, NULL, CLSCTX_ALL, IID_IDeckLinkDiscovery, deckLinkIterator);
 }
+
+
+HRESULT GetDeckLinkVideoConversion(IDeckLinkVideoConversion **deckLinkVideoConversion)
+{
+    return CoCreateInstance(CLSID_CDeckLinkVideoConversion, NULL, CLSCTX_ALL, IID_IDeckLinkVideoConversion, (void**)deckLinkVideoConversion);
+}
+
+
+bool WaitOnAddressValue(std::atomic<uint32_t>* address, uint32_t expected, int timeoutMs)
+{
+    if (WaitOnAddress(address, &expected, sizeof(expected), timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs)))
+        return true;
+
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+
+void WakeAllOnAddress(std::atomic<uint32_t>* address)
+{
+    WakeByAddressAll(address);
+}
+
+
+void SetCurrentThreadBackgroundPriority()
+{
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+void* AllocatePageAlignedBuffer(size_t size)
+{
+    return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+void FreePageAlignedBuffer(void* buffer)
+{
+    VirtualFree(buffer, 0, MEM_RELEASE);
+}
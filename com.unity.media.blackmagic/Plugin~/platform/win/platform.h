@@ -28,6 +28,7 @@
 #pragma once
 
 #include <comdef.h>
+#include <atomic>
 #include <string>
 #include <functional>
 #include <stdint.h>
@@ -35,6 +36,19 @@
 
 HRESULT GetDeckLinkIterator(IDeckLinkIterator **deckLinkIterator);
 HRESULT GetDeckLinkDiscovery(void ** deckLinkIterator);
+HRESULT GetDeckLinkVideoConversion(IDeckLinkVideoConversion **deckLinkVideoConversion);
+
+// Blocks while the value at 'address' equals 'expected', until woken or 'timeoutMs' elapses
+// (a negative timeout waits forever). Returns false on timeout; spurious returns are allowed.
+bool WaitOnAddressValue(std::atomic<uint32_t>* address, uint32_t expected, int timeoutMs);
+void WakeAllOnAddress(std::atomic<uint32_t>* address);
+
+// Lowers the scheduling priority of the calling thread, for housekeeping threads.
+void SetCurrentThreadBackgroundPriority();
+
+// Page-aligned allocation, for the buffers the driver transfers frames into. Null on failure.
+void* AllocatePageAlignedBuffer(size_t size);
+void FreePageAlignedBuffer(void* buffer);
 
 
 #define dlbool_t	BOOL
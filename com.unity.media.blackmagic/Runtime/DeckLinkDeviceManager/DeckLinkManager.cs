@@ -73,6 +73,10 @@ namespace Unity.Media.Blackmagic
             // outside of the Main Thread.
             TryGetInstance(out _);
 
+            // The log and the recording are configured first, so they get the device initialization.
+            ConfigureLog();
+            ConfigureDriverEventRecording();
+
             // Devices and Data are released and recreated during OnEnable / OnDisable
             // because we cannot keep a Blackmagic object reference after an Assembly Reload,
             // it breaks the C# & C++ callbacks mechanism.
@@ -56,6 +56,7 @@ namespace Unity.Media.Blackmagic
         internal static IntPtr s_DeckLinkDeviceDiscovery = IntPtr.Zero;
         static DeckLinkDeviceDiscoveryPlugin.CallbackDevice s_ArrivedCallback;
         static DeckLinkDeviceDiscoveryPlugin.CallbackDevice s_RemovedCallback;
+        static DeckLinkDeviceDiscoveryPlugin.CallbackDeviceEvent s_DeviceEventCallback;
         static string k_DetectionError = "Detection error";
 
         string m_APIVersion;
@@ -114,6 +115,10 @@ namespace Unity.Media.Blackmagic
 
             DeckLinkDeviceDiscoveryPlugin.AddConnectorMapping(s_DeckLinkDeviceDiscovery, groupIDs, devicesArray, devicesCount);
 
+            s_DeviceEventCallback = OnDeviceEvent;
+            DeckLinkDeviceDiscoveryPlugin.SetDeckLinkOnDeviceEvent(s_DeckLinkDeviceDiscovery,
+                Marshal.GetFunctionPointerForDelegate(s_DeviceEventCallback));
+
             s_ArrivedCallback = OnDeviceArrived;
             DeckLinkDeviceDiscoveryPlugin.SetDeckLinkOnDeviceArrived(s_DeckLinkDeviceDiscovery,
                 Marshal.GetFunctionPointerForDelegate(s_ArrivedCallback));
@@ -127,6 +132,7 @@ namespace Unity.Media.Blackmagic
         {
             s_ArrivedCallback = null;
             s_RemovedCallback = null;
+            s_DeviceEventCallback = null;
 
             if (s_DeckLinkDeviceDiscovery != IntPtr.Zero)
             {
@@ -153,7 +159,8 @@ namespace Unity.Media.Blackmagic
                 var isInput = videoDeviceType.HasFlag(VideoDeviceType.Input);
                 var isOutput = videoDeviceType.HasFlag(VideoDeviceType.Output);
 
-                if (isInput)
+                // A reconnected device keeps its entry, so the indices of the other devices don't move.
+                if (isInput && !manager.m_InputDeviceNames.Contains(deviceNameStr))
                 {
                     manager.m_InputDeviceNames.Add(deviceNameStr);
                     manager.m_InputDeviceNames.Sort();
@@ -165,7 +172,7 @@ namespace Unity.Media.Blackmagic
                     logMessage = VideoDeviceType.Input.ToString();
                 }
 
-                if (isOutput)
+                if (isOutput && !manager.m_OutputDeviceNames.Contains(deviceNameStr))
                 {
                     manager.m_OutputDeviceNames.Add(deviceNameStr);
                     manager.m_OutputDeviceNames.Sort();
@@ -237,6 +244,41 @@ namespace Unity.Media.Blackmagic
             }
         }
 
+        [MonoPInvokeCallback(typeof(DeckLinkDeviceDiscoveryPlugin.CallbackDeviceEvent))]
+        static void OnDeviceEvent(int eventType, Int64 deviceID, IntPtr deviceName, int deviceType)
+        {
+            // Arrivals and removals are handled by the name callbacks; only the devices whose type
+            // changed with the profile of their card are updated here, without touching the others.
+            if ((DeviceEventType)eventType != DeviceEventType.ProfileChanged || deviceName == IntPtr.Zero)
+                return;
+
+            if (DeckLinkManager.s_VideoIOManagerInstance is var manager && manager == null)
+                return;
+
+            var deviceNameStr = Marshal.PtrToStringAnsi(deviceName);
+            if (String.IsNullOrEmpty(deviceNameStr))
+                return;
+
+            var videoDeviceType = (VideoDeviceType)deviceType;
+            UpdateDeviceName(manager.m_InputDeviceNames, deviceNameStr, videoDeviceType.HasFlag(VideoDeviceType.Input));
+            UpdateDeviceName(manager.m_OutputDeviceNames, deviceNameStr, videoDeviceType.HasFlag(VideoDeviceType.Output));
+
+            Debug.Log($"[DeckLinkDeviceDiscovery] (OnDeviceEvent) - Device {deviceID:X} is now {videoDeviceType}: {deviceNameStr}");
+        }
+
+        static void UpdateDeviceName(List<string> deviceNames, string deviceName, bool present)
+        {
+            if (present && !deviceNames.Contains(deviceName))
+            {
+                deviceNames.Add(deviceName);
+                deviceNames.Sort();
+            }
+            else if (!present)
+            {
+                deviceNames.Remove(deviceName);
+            }
+        }
+
         void AddCompatibleConnectorMappingProfiles(int deckLinkCardIndex)
         {
             var deckLinkCard = m_DeckLinkCards[deckLinkCardIndex];
@@ -253,8 +295,10 @@ namespace Unity.Media.Blackmagic
 
             var groupID = DeckLinkHardwareDiscoveryPlugin.GetDeckLinkDeviceGroupIDByIndex(deckLinkCardIndex);
 
-            CacheCompatibleLinkModes(deckLinkCardIndex, groupID);
-            CacheCompatibleKeyingModes(deckLinkCardIndex, groupID);
+            // Link and keying modes are not compatible for all profiles, we need to cache them again.
+            var capabilities = DeckLinkDeviceEnumerator.GetCapabilities();
+            deckLinkCard.compatibleLinkModes = DeckLinkDeviceDiscoveryPlugin.GetCompatibleLinkModes(capabilities, groupID);
+            deckLinkCard.compatibleKeyingModes = DeckLinkDeviceDiscoveryPlugin.GetCompatibleKeyingModes(capabilities, groupID);
 
             if (m_CacheCardCapacityOnStart)
             {
@@ -292,39 +336,6 @@ namespace Unity.Media.Blackmagic
             }
         }
 
-        void CacheCompatibleLinkModes(int deckLinkCardIndex, Int64 groupID)
-        {
-            var deckLinkCard = m_DeckLinkCards[deckLinkCardIndex];
-            deckLinkCard.compatibleLinkModes = 0;
-
-            // Link modes are not compatible for all profiles, we need to cache them again.
-            foreach (var linkMode in (LinkMode[])Enum.GetValues(typeof(LinkMode)))
-            {
-                if (DeckLinkDeviceDiscoveryPlugin.IsLinkModeCompatible(s_DeckLinkDeviceDiscovery, (int)linkMode, groupID))
-                {
-                    deckLinkCard.compatibleLinkModes |= (int)linkMode;
-                }
-            }
-        }
-
-        void CacheCompatibleKeyingModes(int deckLinkCardIndex, Int64 groupID)
-        {
-            var deckLinkCard = m_DeckLinkCards[deckLinkCardIndex];
-            deckLinkCard.compatibleKeyingModes = 0;
-
-            // Keying modes are not compatible for all profiles, we need to cache them again.
-            foreach (var keyingMode in (KeyingMode[])Enum.GetValues(typeof(KeyingMode)))
-            {
-                if (keyingMode == KeyingMode.None)
-                    continue;
-
-                if (DeckLinkDeviceDiscoveryPlugin.IsKeyingModeCompatible(s_DeckLinkDeviceDiscovery, (int)keyingMode, groupID))
-                {
-                    deckLinkCard.compatibleKeyingModes |= (int)keyingMode;
-                }
-            }
-        }
-
         // Optimization used in the UI code, allowing us to not show the Single/Dual/Quad Link properties
         // if they are always incompatible on the current Connector Mapping profile. This way, a user cannot create a profile
         // with settings that will always be invalid or not possible to use.
@@ -0,0 +1,83 @@
+using UnityEngine;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// The diagnostics recorded by the plugin for all the devices of the manager.
+    /// </summary>
+    partial class DeckLinkManager
+    {
+        [SerializeField]
+        internal LogSeverity m_LogSeverity = LogSeverity.Off;
+
+        [SerializeField]
+        internal string m_LogPath;
+
+        [SerializeField]
+        internal bool m_RecordDriverEvents;
+
+#if UNITY_EDITOR
+        [SerializeField]
+        bool m_DiagnosticsFoldout;
+#endif
+
+        /// <summary>
+        /// Retrieves the summaries of the metrics recorded by the live devices.
+        /// </summary>
+        /// <returns>One summary per metric recorded by each device.</returns>
+        internal MetricSummary[] GetDeviceMetrics() => DeckLinkDeviceMetricsPlugin.GetSnapshot();
+
+        /// <summary>
+        /// Retrieves the metrics of the live devices as text, one line per metric.
+        /// </summary>
+        /// <returns>The report of the metrics.</returns>
+        internal string GetDeviceMetricsReport() => DeckLinkDeviceMetricsPlugin.GetReport();
+
+        /// <summary>
+        /// Clears the metrics of the live devices.
+        /// </summary>
+        internal void ResetDeviceMetrics() => DeckLinkDeviceMetricsPlugin.Reset();
+
+        /// <summary>
+        /// The number of native log messages dropped because the writer couldn't keep up.
+        /// </summary>
+        internal ulong DroppedLogMessages => DeckLinkLogPlugin.DroppedMessages;
+
+        void ConfigureLog()
+        {
+            // An empty path keeps the default log file of the plugin.
+            DeckLinkLogPlugin.Configure(string.IsNullOrEmpty(m_LogPath) ? null : m_LogPath, m_LogSeverity);
+        }
+
+        /// <summary>
+        /// Writes the driver callbacks recorded since the recording was enabled.
+        /// </summary>
+        /// <param name="path">The path of the recording.</param>
+        /// <returns>The number of events written, or -1 if the file couldn't be written.</returns>
+        internal int WriteDriverEventRecording(string path) => DeckLinkEventRecorderPlugin.Write(path);
+
+        void ConfigureDriverEventRecording()
+        {
+            // Enabling clears the recording: it is kept running across the domain reloads, so the
+            // callbacks before entering or leaving the play mode can still be written.
+            if (m_RecordDriverEvents && !DeckLinkEventRecorderPlugin.IsEnabled)
+            {
+                if (!DeckLinkEventRecorderPlugin.Enable())
+                    Debug.LogError("Failed to enable the recording of the driver callbacks.");
+            }
+            else if (!m_RecordDriverEvents && DeckLinkEventRecorderPlugin.IsEnabled)
+            {
+                DeckLinkEventRecorderPlugin.Disable();
+            }
+        }
+
+        void OnValidate()
+        {
+            if (isActiveAndEnabled)
+            {
+                ConfigureLog();
+                ConfigureDriverEventRecording();
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 using System;
+using System.Collections.Generic;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using Unity.Jobs;
@@ -64,6 +65,7 @@ namespace Unity.Media.Blackmagic
 
         internal DeckLinkInputDevicePlugin m_Plugin;
         internal Texture2D m_SourceTexture;
+        readonly List<DeckLinkOutputDevice> m_PassthroughOutputs = new List<DeckLinkOutputDevice>();
         NativeArray<float> m_SynchronizedAudioBuffer;
 
         InputVideoFormat? m_Format;
@@ -351,8 +353,26 @@ namespace Unity.Media.Blackmagic
             return true;
         }
 
+        internal void AddPassthroughOutput(DeckLinkOutputDevice output)
+        {
+            if (!m_PassthroughOutputs.Contains(output))
+                m_PassthroughOutputs.Add(output);
+        }
+
+        internal void RemovePassthroughOutput(DeckLinkOutputDevice output)
+        {
+            m_PassthroughOutputs.Remove(output);
+        }
+
         void DestroyResources()
         {
+            // The passthrough routes hold the native device, and must be destroyed before it.
+            for (var i = m_PassthroughOutputs.Count - 1; i >= 0; i--)
+            {
+                m_PassthroughOutputs[i].DestroyPassthroughRoute();
+            }
+            m_PassthroughOutputs.Clear();
+
             if (m_Plugin != null)
             {
                 m_Plugin.Dispose();
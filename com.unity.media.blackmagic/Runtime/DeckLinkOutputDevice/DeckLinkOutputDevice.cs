@@ -108,6 +108,8 @@ namespace Unity.Media.Blackmagic
             public long frameCount;
             public AsyncGPUReadbackRequest request;
             public Timecode? timecode;
+            public ulong traceFlow;
+            public long traceStart;
         }
 
         internal static DeckLinkOutputDevice ManualModeInstance { get; private set; }
@@ -809,6 +811,7 @@ namespace Unity.Media.Blackmagic
                 ManualModeInstance = null;
 
             CleanupAudioOutput();
+            DestroyPassthroughRoute();
 
             if (m_Plugin != null)
             {
@@ -1005,6 +1008,7 @@ namespace Unity.Media.Blackmagic
                 m_RequiresReinit = true;
 
             base.PerformUpdate();
+            UpdatePassthroughRoute();
 
             var captureRenderTexture = CaptureRenderTexture;
             if (!IsActive || captureRenderTexture == null)
@@ -1137,6 +1141,8 @@ namespace Unity.Media.Blackmagic
                 }
                 else
                 {
+                    var tracing = DeckLinkTracerPlugin.IsEnabled;
+                    var traceStart = tracing ? DeckLinkTracerPlugin.Timestamp : 0;
                     var request = m_PooledRequests.RequestGPUReadBack(m_FrameCount, temporaryTextureFrame);
                     var timecode = GetTimecode();
 
@@ -1144,7 +1150,9 @@ namespace Unity.Media.Blackmagic
                     {
                         frameCount = m_FrameCount,
                         request = request,
-                        timecode = timecode
+                        timecode = timecode,
+                        traceFlow = tracing ? DeckLinkTracerPlugin.CurrentFlow : 0,
+                        traceStart = traceStart
                     });
 
                     RenderTexture.ReleaseTemporary(temporaryTextureFrame);
@@ -1184,6 +1192,12 @@ namespace Unity.Media.Blackmagic
 
                 var timecode = frame.timecode ?? new Timecode(m_Plugin.FrameDuration, m_FrameCount * m_Plugin.FrameDuration);
 
+                if (frame.traceStart != 0)
+                {
+                    DeckLinkTracerPlugin.RecordSpan(TraceSpan.Readback, m_DeviceIndex, frame.traceFlow, frame.traceStart, DeckLinkTracerPlugin.Timestamp);
+                    m_Plugin.SetTraceFlow(frame.traceFlow);
+                }
+
                 m_Plugin.FeedFrame(frame.request.GetData<byte>(), timecode);
 
                 m_PooledRequests.BMDRelease(frame.frameCount);
@@ -0,0 +1,153 @@
+using UnityEngine;
+
+namespace Unity.Media.Blackmagic
+{
+    partial class DeckLinkOutputDevice
+    {
+        const int k_MaxPassthroughDelay = 120;
+
+        [SerializeField]
+        internal DeckLinkInputDevice m_PassthroughInputDevice;
+
+        [SerializeField, Range(0, k_MaxPassthroughDelay)]
+        int m_PassthroughDelay;
+
+        [SerializeField]
+        PassthroughCompositing m_PassthroughCompositing = PassthroughCompositing.Fill;
+
+        [SerializeField]
+        bool m_PassthroughSynchronize;
+
+#if UNITY_EDITOR
+#pragma warning disable 414
+        [SerializeField]
+        bool m_PassthroughFoldout;
+#pragma warning restore 414
+#endif
+
+        DeckLinkPassthroughRoutePlugin m_PassthroughRoute;
+        DeckLinkInputDevice m_PassthroughRouteInputDevice;
+        DeckLinkInputDevicePlugin m_PassthroughRouteInputPlugin;
+        int m_PassthroughRouteDelay;
+        PassthroughCompositing m_PassthroughRouteCompositing;
+        bool m_PassthroughRouteSynchronize;
+        string m_PassthroughError;
+
+        /// <summary>
+        /// Whether the frames of the passthrough input device are routed to this device.
+        /// </summary>
+        internal bool IsPassthroughRouted => m_PassthroughRoute != null;
+
+        /// <summary>
+        /// The number of frames routed from the passthrough input device.
+        /// </summary>
+        internal uint RoutedPassthroughFrameCount => m_PassthroughRoute?.CountRoutedFrames() ?? 0;
+
+        /// <summary>
+        /// The number of input frames skipped by the passthrough route.
+        /// </summary>
+        internal uint SkippedPassthroughFrameCount => m_PassthroughRoute?.CountSkippedFrames() ?? 0;
+
+        /// <summary>
+        /// The reason the passthrough route couldn't be set up, or null.
+        /// </summary>
+        internal string PassthroughError => m_PassthroughError;
+
+        void UpdatePassthroughRoute()
+        {
+            var input = m_PassthroughInputDevice;
+            var inputPlugin = input != null && input.IsActive ? input.m_Plugin : null;
+
+            if (inputPlugin == null || !IsActive || m_Plugin == null)
+            {
+                DestroyPassthroughRoute();
+                return;
+            }
+
+            // Both devices have to stay the same for the route; a change of the synchronization
+            // recreates it, while the delay and the compositing are changed in place.
+            if (m_PassthroughRoute != null &&
+                (m_PassthroughRouteInputDevice != input ||
+                 m_PassthroughRouteInputPlugin != inputPlugin ||
+                 m_PassthroughRouteSynchronize != m_PassthroughSynchronize))
+            {
+                DestroyPassthroughRoute();
+            }
+
+            if (m_PassthroughRoute == null)
+            {
+                CreatePassthroughRoute(input, inputPlugin);
+                return;
+            }
+
+            if (m_PassthroughRouteDelay != m_PassthroughDelay)
+            {
+                m_PassthroughRouteDelay = m_PassthroughDelay;
+                if (!m_PassthroughRoute.SetDelay(m_PassthroughDelay))
+                    ReportPassthroughError(m_PassthroughRoute.GetError());
+            }
+
+            if (m_PassthroughRouteCompositing != m_PassthroughCompositing)
+            {
+                m_PassthroughRouteCompositing = m_PassthroughCompositing;
+                m_PassthroughRoute.SetCompositing(m_PassthroughCompositing);
+            }
+        }
+
+        void CreatePassthroughRoute(DeckLinkInputDevice input, DeckLinkInputDevicePlugin inputPlugin)
+        {
+            // The devices may still be opening: the creation is retried on the next update.
+            if (inputPlugin.Readiness != DeviceReadiness.Ready || m_Plugin.Readiness != DeviceReadiness.Ready)
+                return;
+
+            m_PassthroughRoute = DeckLinkPassthroughRoutePlugin.Create(inputPlugin, m_Plugin,
+                m_PassthroughDelay, m_PassthroughCompositing, m_PassthroughSynchronize);
+
+            if (m_PassthroughRoute == null)
+            {
+                ReportPassthroughError(DeckLinkPassthroughRoutePlugin.GetCreateError());
+                return;
+            }
+
+            m_PassthroughRouteInputDevice = input;
+            m_PassthroughRouteInputPlugin = inputPlugin;
+            m_PassthroughRouteDelay = m_PassthroughDelay;
+            m_PassthroughRouteCompositing = m_PassthroughCompositing;
+            m_PassthroughRouteSynchronize = m_PassthroughSynchronize;
+            m_PassthroughError = null;
+
+            input.AddPassthroughOutput(this);
+        }
+
+        /// <summary>
+        /// Detaches the passthrough route from both devices; it is set up again on the next update.
+        /// </summary>
+        /// <remarks>
+        /// The input device calls it before releasing its plugin.
+        /// </remarks>
+        internal void DestroyPassthroughRoute()
+        {
+            if (m_PassthroughRoute == null)
+                return;
+
+            m_PassthroughRoute.Dispose();
+            m_PassthroughRoute = null;
+
+            if (m_PassthroughRouteInputDevice != null)
+                m_PassthroughRouteInputDevice.RemovePassthroughOutput(this);
+
+            m_PassthroughRouteInputDevice = null;
+            m_PassthroughRouteInputPlugin = null;
+        }
+
+        void ReportPassthroughError(string error)
+        {
+            // The creation is retried on every update: the same error is only logged once.
+            if (error == null || error == m_PassthroughError)
+                return;
+
+            m_PassthroughError = error;
+            Debug.LogWarning($"Passthrough route to {name}: {error}");
+        }
+    }
+}
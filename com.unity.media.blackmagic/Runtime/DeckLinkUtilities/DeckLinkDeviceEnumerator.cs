@@ -69,6 +69,15 @@ namespace Unity.Media.Blackmagic
         {
             return DeckLinkDeviceEnumeratorPlugin.SetAllDevicesDuplexMode(halfDuplex);
         }
+
+        /// <summary>
+        /// Retrieves the capabilities of all the devices at once.
+        /// </summary>
+        /// <returns>A copy of the capability snapshot of the plugin; null if no driver is installed.</returns>
+        internal static DeckLinkCapabilitySnapshot GetCapabilities()
+        {
+            return DeckLinkCapabilitySnapshot.Acquire();
+        }
     }
 
     /// <summary>
@@ -0,0 +1,319 @@
+using System;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// The header of the flat capability buffer copied from the plugin.
+    /// </summary>
+    /// <remarks>
+    /// Every array starts at its byte offset from the start of the buffer. The device arrays hold
+    /// <see cref="deviceCount"/> entries, and the mode arrays <see cref="modeCount"/> entries.
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct CapabilitySnapshotHeader
+    {
+        /// <summary>
+        /// The size of the buffer, in bytes.
+        /// </summary>
+        public readonly int totalSize;
+
+        /// <summary>
+        /// Incremented every time the plugin rebuilds the snapshot.
+        /// </summary>
+        public readonly uint generation;
+
+        /// <summary>
+        /// The number of devices, in the order of the DeckLink iterator.
+        /// </summary>
+        public readonly int deviceCount;
+
+        /// <summary>
+        /// The number of display modes of all the devices.
+        /// </summary>
+        public readonly int modeCount;
+
+        /// <summary>
+        /// The number of pixel formats described by the support masks.
+        /// </summary>
+        public readonly int pixelFormatCount;
+
+        /// <summary>
+        /// The BMDPixelFormat of each bit of the support masks.
+        /// </summary>
+        public readonly int pixelFormatsOffset;
+
+        /// <summary>
+        /// The BMDDeckLinkPersistentID of each device, as longs.
+        /// </summary>
+        public readonly int persistentIdOffset;
+
+        /// <summary>
+        /// The BMDDeckLinkDeviceGroupID of each device, shared by the devices of a card, as longs.
+        /// </summary>
+        public readonly int groupIdOffset;
+
+        /// <summary>
+        /// The BMDDuplexMode of each device.
+        /// </summary>
+        public readonly int duplexOffset;
+
+        /// <summary>
+        /// The BMDVideoIOSupport of each device.
+        /// </summary>
+        public readonly int videoIOSupportOffset;
+
+        /// <summary>
+        /// The keying support of each device: 1 for internal keying, 2 for external keying.
+        /// </summary>
+        public readonly int keyingOffset;
+
+        /// <summary>
+        /// The link support of each device: 1 for dual link, 2 for quad link.
+        /// </summary>
+        public readonly int linksOffset;
+
+        /// <summary>
+        /// Non-zero for each device supporting input format detection.
+        /// </summary>
+        public readonly int inputFormatDetectionOffset;
+
+        /// <summary>
+        /// The byte offset of the null-terminated UTF-8 name of each device.
+        /// </summary>
+        public readonly int nameOffsetOffset;
+
+        /// <summary>
+        /// The index of the first input mode of each device.
+        /// </summary>
+        public readonly int firstInputModeOffset;
+
+        /// <summary>
+        /// The number of input modes of each device.
+        /// </summary>
+        public readonly int inputModeCountOffset;
+
+        /// <summary>
+        /// The index of the first output mode of each device.
+        /// </summary>
+        public readonly int firstOutputModeOffset;
+
+        /// <summary>
+        /// The number of output modes of each device.
+        /// </summary>
+        public readonly int outputModeCountOffset;
+
+        /// <summary>
+        /// The frame duration of each mode, as longs.
+        /// </summary>
+        public readonly int frameDurationOffset;
+
+        /// <summary>
+        /// The time scale of each mode, as longs.
+        /// </summary>
+        public readonly int timeScaleOffset;
+
+        /// <summary>
+        /// The BMDDisplayMode of each mode.
+        /// </summary>
+        public readonly int displayModeOffset;
+
+        /// <summary>
+        /// The width of each mode, in pixels.
+        /// </summary>
+        public readonly int widthOffset;
+
+        /// <summary>
+        /// The height of each mode, in pixels.
+        /// </summary>
+        public readonly int heightOffset;
+
+        /// <summary>
+        /// The BMDFieldDominance of each mode.
+        /// </summary>
+        public readonly int fieldDominanceOffset;
+
+        /// <summary>
+        /// The pixel formats supported by each mode, one bit per pixel format.
+        /// </summary>
+        public readonly int pixelFormatMaskOffset;
+
+        /// <summary>
+        /// The pixel formats supported by each output mode with keying enabled.
+        /// </summary>
+        public readonly int keyingPixelFormatMaskOffset;
+    }
+
+    /// <summary>
+    /// A copy of the capabilities of all the devices, read without calling into the driver.
+    /// </summary>
+    sealed class DeckLinkCapabilitySnapshot
+    {
+        readonly byte[] m_Buffer;
+        readonly CapabilitySnapshotHeader m_Header;
+
+        unsafe DeckLinkCapabilitySnapshot(byte[] buffer)
+        {
+            m_Buffer = buffer;
+            fixed (byte* header = buffer)
+            {
+                m_Header = *(CapabilitySnapshotHeader*)header;
+            }
+        }
+
+        /// <summary>
+        /// Incremented every time the plugin rebuilds the snapshot.
+        /// </summary>
+        public uint Generation => m_Header.generation;
+
+        /// <summary>
+        /// The number of devices, in the order of the DeckLink iterator.
+        /// </summary>
+        public int DeviceCount => m_Header.deviceCount;
+
+        /// <summary>
+        /// Copies the current capability snapshot from the plugin.
+        /// </summary>
+        /// <returns>The snapshot, or null if the plugin has none.</returns>
+        public static DeckLinkCapabilitySnapshot Acquire()
+        {
+            var size = DeckLinkDeviceEnumeratorPlugin.GetDeckLinkCapabilities(null, 0);
+            while (size > 0)
+            {
+                var buffer = new byte[size];
+                var total = DeckLinkDeviceEnumeratorPlugin.GetDeckLinkCapabilities(buffer, buffer.Length);
+                if (total <= buffer.Length)
+                    return new DeckLinkCapabilitySnapshot(buffer);
+
+                // The snapshot was rebuilt in between: retry with the new size.
+                size = total;
+            }
+            return null;
+        }
+
+        /// <summary>
+        /// Gets the display name of a device.
+        /// </summary>
+        public string GetName(int device)
+        {
+            var start = ReadInt(m_Header.nameOffsetOffset, device);
+            var end = Array.IndexOf(m_Buffer, (byte)0, start);
+            return Encoding.UTF8.GetString(m_Buffer, start, end - start);
+        }
+
+        /// <summary>
+        /// Gets the BMDDeckLinkPersistentID of a device, or 0 if it has none.
+        /// </summary>
+        public long GetPersistentId(int device) => ReadLong(m_Header.persistentIdOffset, device);
+
+        /// <summary>
+        /// Gets the group ID of the card of a device, or 0 if it has none.
+        /// </summary>
+        public long GetGroupId(int device) => ReadLong(m_Header.groupIdOffset, device);
+
+        /// <summary>
+        /// Checks whether a device is active in its current profile.
+        /// </summary>
+        public bool IsActive(int device) => ReadInt(m_Header.duplexOffset, device) != k_DuplexInactive;
+
+        /// <summary>
+        /// Checks whether a device can capture.
+        /// </summary>
+        public bool SupportsCapture(int device) => (ReadInt(m_Header.videoIOSupportOffset, device) & k_SupportsCapture) != 0;
+
+        /// <summary>
+        /// Checks whether a device can play back.
+        /// </summary>
+        public bool SupportsPlayback(int device) => (ReadInt(m_Header.videoIOSupportOffset, device) & k_SupportsPlayback) != 0;
+
+        /// <summary>
+        /// Checks whether a device supports a keying mode.
+        /// </summary>
+        public bool SupportsKeying(int device, KeyingMode keying)
+        {
+            var flags = ReadInt(m_Header.keyingOffset, device);
+            switch (keying)
+            {
+                case KeyingMode.Internal:
+                    return (flags & 1) != 0;
+                case KeyingMode.External:
+                    return (flags & 2) != 0;
+                default:
+                    return true;
+            }
+        }
+
+        /// <summary>
+        /// Checks whether a device supports a link mode. Every device supports a single link.
+        /// </summary>
+        public bool SupportsLinkMode(int device, LinkMode linkMode)
+        {
+            if (linkMode == LinkMode.Single)
+                return true;
+            if (!SupportsPlayback(device))
+                return false;
+
+            var flags = ReadInt(m_Header.linksOffset, device);
+            switch (linkMode)
+            {
+                case LinkMode.Dual:
+                    return (flags & 1) != 0;
+                case LinkMode.Quad:
+                    return (flags & 2) != 0;
+                default:
+                    return false;
+            }
+        }
+
+        /// <summary>
+        /// Gets the BMDDisplayMode of the output modes of a device, in the order of the SDK.
+        /// </summary>
+        public int[] GetOutputModes(int device)
+        {
+            var first = ReadInt(m_Header.firstOutputModeOffset, device);
+            var modes = new int[ReadInt(m_Header.outputModeCountOffset, device)];
+            for (var i = 0; i < modes.Length; i++)
+                modes[i] = ReadInt(m_Header.displayModeOffset, first + i);
+            return modes;
+        }
+
+        /// <summary>
+        /// Checks whether a device supports a pixel format for an output mode.
+        /// </summary>
+        /// <returns>True if supported; false if not, or if the mode or the pixel format is unknown.</returns>
+        public bool IsOutputPixelFormatSupported(int device, int displayMode, int pixelFormat, bool keying)
+        {
+            var bit = GetPixelFormatBit(pixelFormat);
+            var first = ReadInt(m_Header.firstOutputModeOffset, device);
+            var count = ReadInt(m_Header.outputModeCountOffset, device);
+            var maskOffset = keying ? m_Header.keyingPixelFormatMaskOffset : m_Header.pixelFormatMaskOffset;
+
+            for (var i = first; bit >= 0 && i < first + count; i++)
+            {
+                if (ReadInt(m_Header.displayModeOffset, i) == displayMode)
+                    return (ReadInt(maskOffset, i) & (1 << bit)) != 0;
+            }
+            return false;
+        }
+
+        int GetPixelFormatBit(int pixelFormat)
+        {
+            for (var i = 0; i < m_Header.pixelFormatCount; i++)
+            {
+                if (ReadInt(m_Header.pixelFormatsOffset, i) == pixelFormat)
+                    return i;
+            }
+            return -1;
+        }
+
+        int ReadInt(int arrayOffset, int index) => BitConverter.ToInt32(m_Buffer, arrayOffset + index * sizeof(int));
+
+        long ReadLong(int arrayOffset, int index) => BitConverter.ToInt64(m_Buffer, arrayOffset + index * sizeof(long));
+
+        // bmdDuplexInactive, bmdDeviceSupportsCapture and bmdDeviceSupportsPlayback.
+        const int k_DuplexInactive = 0x6478696E;
+        const int k_SupportsCapture = 1 << 0;
+        const int k_SupportsPlayback = 1 << 1;
+    }
+}
@@ -3,6 +3,87 @@ using System.Runtime.InteropServices;
 
 namespace Unity.Media.Blackmagic
 {
+    /// <summary>
+    /// The outcome of a connector mapping change on one card.
+    /// </summary>
+    enum ConnectorMappingResultType
+    {
+        /// <summary>
+        /// The profile was already active.
+        /// </summary>
+        Unchanged = 0,
+
+        /// <summary>
+        /// The profile is now active.
+        /// </summary>
+        Activated = 1,
+
+        /// <summary>
+        /// No card has this group ID, or the card doesn't support the profile.
+        /// </summary>
+        Incompatible = 2,
+
+        /// <summary>
+        /// The card refused the profile, for example while one of its devices is in use.
+        /// </summary>
+        Refused = 3,
+
+        /// <summary>
+        /// The profile wasn't activated before the deadline.
+        /// </summary>
+        TimedOut = 4,
+    }
+
+    /// <summary>
+    /// The outcome of a connector mapping change on one card, as reported by the plugin.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct ConnectorMappingResult
+    {
+        /// <summary>
+        /// The group ID of the card.
+        /// </summary>
+        public readonly long groupID;
+
+        /// <summary>
+        /// The time from the activation request to the activation, or to the deadline, in nanoseconds.
+        /// </summary>
+        public readonly long elapsed;
+
+        /// <summary>
+        /// The outcome of the change.
+        /// </summary>
+        public readonly ConnectorMappingResultType result;
+
+        readonly int m_RolledBack;
+
+        /// <summary>
+        /// True once the previous profile of a failed card is active again.
+        /// </summary>
+        public bool RolledBack => m_RolledBack != 0;
+    }
+
+    /// <summary>
+    /// The kind of change of a device, notified with its stable ID.
+    /// </summary>
+    enum DeviceEventType
+    {
+        /// <summary>
+        /// The device was connected.
+        /// </summary>
+        Arrived = 0,
+
+        /// <summary>
+        /// The device was disconnected.
+        /// </summary>
+        Removed = 1,
+
+        /// <summary>
+        /// The device type changed with the profile of its card.
+        /// </summary>
+        ProfileChanged = 2,
+    }
+
     static class DeckLinkDeviceDiscoveryPlugin
     {
         /// <summary>
@@ -13,6 +94,16 @@ namespace Unity.Media.Blackmagic
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         public delegate void CallbackDevice(IntPtr deviceName, int deviceType);
 
+        /// <summary>
+        /// The managed callback that is called for every change of a single device.
+        /// </summary>
+        /// <param name="eventType">The <see cref="DeviceEventType"/> of the change.</param>
+        /// <param name="deviceID">The persistent ID of the device, stable across reconnections.</param>
+        /// <param name="deviceName">The name of the device.</param>
+        /// <param name="deviceType">The type of the device.</param>
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        public delegate void CallbackDeviceEvent(int eventType, Int64 deviceID, IntPtr deviceName, int deviceType);
+
         /// <summary>
         /// The plugin callback that creates a DeckLink Discovery instance.
         /// </summary>
@@ -57,6 +148,17 @@ namespace Unity.Media.Blackmagic
         [DllImport(BlackmagicUtilities.k_PluginName)]
         public static extern void SetDeckLinkOnDeviceRemoved(IntPtr deviceDiscovery, IntPtr callBack);
 
+        /// <summary>
+        /// Initializes the per-device change plugin callback, of a specified instance.
+        /// </summary>
+        /// <remarks>
+        /// Must be set before the 'OnDeviceArrived' callback, which enables the notifications.
+        /// </remarks>
+        /// <param name="deviceDiscovery">The DeviceDiscovery instance.</param>
+        /// <param name="callBack">The managed callback to call.</param>
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        public static extern void SetDeckLinkOnDeviceEvent(IntPtr deviceDiscovery, IntPtr callBack);
+
         /// <summary>
         /// The plugin callback that destroys a DeckLink Discovery instance.
         /// </summary>
@@ -74,6 +176,35 @@ namespace Unity.Media.Blackmagic
         [DllImport(BlackmagicUtilities.k_PluginName)]
         public static extern bool ChangeAllDevicesConnectorMapping(IntPtr deviceDiscovery, int profile, Int64 groupID);
 
+        /// <summary>
+        /// Changes the connector mapping of many cards at once, as a single transaction.
+        /// </summary>
+        /// <remarks>
+        /// The profiles are activated on all the cards in parallel and awaited against a single deadline.
+        /// The cards which fail are rolled back to their previous profile; the others keep the new one.
+        /// </remarks>
+        /// <param name="deviceDiscovery">The instance of the device discovery.</param>
+        /// <param name="groupIDs">The group ID of each card to change.</param>
+        /// <param name="profiles">The connector mapping of each card.</param>
+        /// <param name="timeoutMs">The time allowed to activate all the profiles, in milliseconds.</param>
+        /// <param name="results">The outcome for each card, in the order of the group IDs.</param>
+        /// <returns>The number of cards which failed, or -1 if the device discovery is invalid.</returns>
+        public static int ChangeConnectorMappings(IntPtr deviceDiscovery, Int64[] groupIDs, DeckLinkConnectorMapping[] profiles, int timeoutMs, out ConnectorMappingResult[] results)
+        {
+            var count = Math.Min(groupIDs.Length, profiles.Length);
+            var profileValues = new int[count];
+            for (var i = 0; i < count; ++i)
+            {
+                profileValues[i] = (int)profiles[i];
+            }
+
+            results = new ConnectorMappingResult[count];
+            return ChangeConnectorMappings(deviceDiscovery, groupIDs, profileValues, count, timeoutMs, results);
+        }
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int ChangeConnectorMappings(IntPtr deviceDiscovery, Int64[] groupIDs, int[] profiles, int count, int timeoutMs, [Out] ConnectorMappingResult[] results);
+
         /// <summary>
         /// Determines if the DeckLink card has connector mapping profiles or not.
         /// </summary>
@@ -99,21 +230,49 @@ namespace Unity.Media.Blackmagic
         public static extern bool IsConnectorMappingProfileCompatible(IntPtr deviceDiscovery, int profile);
 
         /// <summary>
-        /// Determines if the link mode is compatible on the current DeckLink card.
+        /// Determines the link modes supported by the devices of a DeckLink card.
         /// </summary>
-        /// <param name="deviceDiscovery">The instance of the device discovery.</param>
-        /// <param name="linkMode">The tested link mode.</param>
-        /// <returns>True if the link mode is compatible, false otherwise.</returns>
-        [DllImport(BlackmagicUtilities.k_PluginName)]
-        public static extern bool IsLinkModeCompatible(IntPtr deviceDiscovery, int linkMode, Int64 groupID);
+        /// <param name="capabilities">The capability snapshot, copied once from the plugin for all the cards.</param>
+        /// <param name="groupID">The group ID of the card.</param>
+        /// <returns>The <see cref="LinkMode"/> flags supported by at least one device of the card.</returns>
+        public static int GetCompatibleLinkModes(DeckLinkCapabilitySnapshot capabilities, Int64 groupID)
+        {
+            var linkModes = 0;
+            for (var device = 0; capabilities != null && device < capabilities.DeviceCount; ++device)
+            {
+                if (capabilities.GetGroupId(device) != groupID)
+                    continue;
+
+                foreach (var linkMode in (LinkMode[])Enum.GetValues(typeof(LinkMode)))
+                {
+                    if (capabilities.SupportsLinkMode(device, linkMode))
+                        linkModes |= (int)linkMode;
+                }
+            }
+            return linkModes;
+        }
 
         /// <summary>
-        /// Determines if the keying mode is compatible on the current DeckLink card.
+        /// Determines the keying modes supported by the devices of a DeckLink card.
         /// </summary>
-        /// <param name="deviceDiscovery">The instance of the device discovery.</param>
-        /// <param name="linkMode">The tested keying mode.</param>
-        /// <returns>True if the keying mode is compatible, false otherwise.</returns>
-        [DllImport(BlackmagicUtilities.k_PluginName)]
-        public static extern bool IsKeyingModeCompatible(IntPtr deviceDiscovery, int keyingMode, Int64 groupID);
+        /// <param name="capabilities">The capability snapshot, copied once from the plugin for all the cards.</param>
+        /// <param name="groupID">The group ID of the card.</param>
+        /// <returns>The <see cref="KeyingMode"/> flags supported by at least one device of the card, without <see cref="KeyingMode.None"/>.</returns>
+        public static int GetCompatibleKeyingModes(DeckLinkCapabilitySnapshot capabilities, Int64 groupID)
+        {
+            var keyingModes = 0;
+            for (var device = 0; capabilities != null && device < capabilities.DeviceCount; ++device)
+            {
+                if (capabilities.GetGroupId(device) != groupID)
+                    continue;
+
+                foreach (var keyingMode in (KeyingMode[])Enum.GetValues(typeof(KeyingMode)))
+                {
+                    if (keyingMode != KeyingMode.None && capabilities.SupportsKeying(device, keyingMode))
+                        keyingModes |= (int)keyingMode;
+                }
+            }
+            return keyingModes;
+        }
     }
 }
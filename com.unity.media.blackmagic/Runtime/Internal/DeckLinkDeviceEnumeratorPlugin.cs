@@ -40,5 +40,14 @@ namespace Unity.Media.Blackmagic
         /// <returns>The mapping connector has been successfully changed or not.</returns>
         [DllImport(BlackmagicUtilities.k_PluginName)]
         public static extern bool SetAllDevicesDuplexMode(bool halfDuplex);
+
+        /// <summary>
+        /// Copies the capability snapshot of all the devices, built once and refreshed on discovery events.
+        /// </summary>
+        /// <param name="buffer">The buffer receiving the snapshot, or null to query its size.</param>
+        /// <param name="size">The size of the buffer, in bytes.</param>
+        /// <returns>The size of the snapshot in bytes. Nothing is copied if it is larger than the buffer.</returns>
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        public static extern int GetDeckLinkCapabilities(byte[] buffer, int size);
     }
 }
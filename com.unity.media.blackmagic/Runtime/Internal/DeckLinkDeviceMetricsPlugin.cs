@@ -0,0 +1,194 @@
+using System;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// A measurement recorded by the plugin for each device.
+    /// </summary>
+    /// <remarks>
+    /// The durations are in nanoseconds. The values from <see cref="LateFrames"/> on are counters.
+    /// </remarks>
+    enum DeviceMetric
+    {
+        /// <summary>
+        /// The time spent in the frame arrival callback of an input device.
+        /// </summary>
+        InputCallback = 0,
+
+        /// <summary>
+        /// The deviation of the time between two input frames from the frame duration.
+        /// </summary>
+        InputJitter = 1,
+
+        /// <summary>
+        /// The number of frames waiting in the submission queue of an output device when a frame is submitted.
+        /// </summary>
+        DeliveryQueueDepth = 2,
+
+        /// <summary>
+        /// The time spent copying a frame into a DeckLink frame.
+        /// </summary>
+        Copy = 3,
+
+        /// <summary>
+        /// The time spent converting a frame to the pixel format of the output.
+        /// </summary>
+        Pack = 4,
+
+        /// <summary>
+        /// The time from the scheduling of an output frame to its completion.
+        /// </summary>
+        ScheduleToCompletion = 5,
+
+        /// <summary>
+        /// The number of audio sample frames buffered by an output device when more audio is requested.
+        /// </summary>
+        AudioRingFill = 6,
+
+        /// <summary>
+        /// The number of frames displayed late.
+        /// </summary>
+        LateFrames = 7,
+
+        /// <summary>
+        /// The number of frames dropped.
+        /// </summary>
+        DroppedFrames = 8,
+
+        /// <summary>
+        /// The number of frames flushed.
+        /// </summary>
+        FlushedFrames = 9,
+    }
+
+    /// <summary>
+    /// The summary of one metric of one device.
+    /// </summary>
+    /// <remarks>
+    /// The percentiles are read from log-linear histograms, within about 3% of the recorded values.
+    /// For a counter, only <see cref="count"/> is set.
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct MetricSummary
+    {
+        /// <summary>
+        /// The index of the device.
+        /// </summary>
+        public readonly int deviceIndex;
+
+        /// <summary>
+        /// The direction of the device: 0 for an input device, 1 for an output device.
+        /// </summary>
+        public readonly int direction;
+
+        /// <summary>
+        /// The metric summarized.
+        /// </summary>
+        public readonly DeviceMetric metric;
+
+        readonly int m_Reserved;
+
+        /// <summary>
+        /// The number of values recorded, or the value of a counter.
+        /// </summary>
+        public readonly ulong count;
+
+        /// <summary>
+        /// The smallest value recorded.
+        /// </summary>
+        public readonly long min;
+
+        /// <summary>
+        /// The largest value recorded.
+        /// </summary>
+        public readonly long max;
+
+        /// <summary>
+        /// The mean of the values recorded.
+        /// </summary>
+        public readonly long mean;
+
+        /// <summary>
+        /// The median of the values recorded.
+        /// </summary>
+        public readonly long p50;
+
+        /// <summary>
+        /// The 90th percentile of the values recorded.
+        /// </summary>
+        public readonly long p90;
+
+        /// <summary>
+        /// The 99th percentile of the values recorded.
+        /// </summary>
+        public readonly long p99;
+
+        /// <summary>
+        /// The 99.9th percentile of the values recorded.
+        /// </summary>
+        public readonly long p999;
+    }
+
+    static class DeckLinkDeviceMetricsPlugin
+    {
+        /// <summary>
+        /// Retrieves the summaries of the metrics recorded by all the live devices.
+        /// </summary>
+        /// <returns>One summary per metric recorded by each device.</returns>
+        public static MetricSummary[] GetSnapshot()
+        {
+            var count = GetDeviceMetricsSnapshot(null, 0);
+            while (true)
+            {
+                var summaries = new MetricSummary[count];
+                var total = GetDeviceMetricsSnapshot(summaries, summaries.Length);
+                if (total <= summaries.Length)
+                {
+                    if (total < summaries.Length)
+                        Array.Resize(ref summaries, total);
+                    return summaries;
+                }
+
+                // A metric was recorded in between: retry with the new count.
+                count = total;
+            }
+        }
+
+        /// <summary>
+        /// Retrieves the metrics of all the live devices as text, one line per metric.
+        /// </summary>
+        /// <returns>The report of the metrics.</returns>
+        public static string GetReport()
+        {
+            var size = GetDeviceMetricsReport(null, 0);
+            while (true)
+            {
+                var buffer = new byte[size];
+                var required = GetDeviceMetricsReport(buffer, buffer.Length);
+                if (required <= buffer.Length)
+                    return Encoding.UTF8.GetString(buffer, 0, Math.Max(required - 1, 0));
+
+                size = required;
+            }
+        }
+
+        /// <summary>
+        /// Clears the metrics of all the live devices.
+        /// </summary>
+        public static void Reset()
+        {
+            ResetDeviceMetrics();
+        }
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetDeviceMetricsSnapshot([Out] MetricSummary[] summaries, int capacity);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetDeviceMetricsReport([Out] byte[] buffer, int capacity);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void ResetDeviceMetrics();
+    }
+}
@@ -0,0 +1,326 @@
+using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// The status of a device, as published by the plugin threads.
+    /// </summary>
+    /// <remarks>
+    /// The layout matches the native status block, so it can be read straight from the mapped block.
+    /// </remarks>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct DeviceStatus
+    {
+        /// <summary>
+        /// The number of frames completed by an output device, or arrived on an input device.
+        /// </summary>
+        public readonly long processedFrames;
+
+        /// <summary>
+        /// Odd while the plugin writes the status, incremented by two after every update.
+        /// </summary>
+        public readonly uint updateCount;
+
+        /// <summary>
+        /// The index of the device.
+        /// </summary>
+        public readonly int deviceIndex;
+
+        /// <summary>
+        /// The direction of the device: 0 for an input device, 1 for an output device.
+        /// </summary>
+        public readonly int direction;
+
+        /// <summary>
+        /// The number of frames dropped.
+        /// </summary>
+        public readonly uint droppedFrames;
+
+        /// <summary>
+        /// The number of frames displayed late.
+        /// </summary>
+        public readonly uint lateFrames;
+
+        /// <summary>
+        /// The number of frames buffered by the output hardware.
+        /// </summary>
+        public readonly int bufferedFrames;
+
+        /// <summary>
+        /// Non-zero when the device is locked to its reference input.
+        /// </summary>
+        public readonly int referenceLocked;
+
+        /// <summary>
+        /// The BMDPixelFormat of the last frame.
+        /// </summary>
+        public readonly int pixelFormat;
+
+        /// <summary>
+        /// Non-zero when an input signal is detected, or when the output playback is running.
+        /// </summary>
+        public readonly int signalPresent;
+
+        /// <summary>
+        /// The status of the last report.
+        /// </summary>
+        public readonly int lastStatus;
+
+        /// <summary>
+        /// The last error code: an InputError for input devices, a BMDOutputFrameCompletionResult for output devices.
+        /// </summary>
+        public readonly int lastErrorCode;
+
+        readonly int m_Reserved;
+
+        /// <summary>
+        /// The time left before the last frame fed to an output device was due on the card, in flicks.
+        /// </summary>
+        /// <remarks>
+        /// Negative when the frame was fed after the card needed it. Only measured while the playback runs.
+        /// </remarks>
+        public readonly long deadlineSlack;
+
+        /// <summary>
+        /// The minimum deadline slack over the last frames, in flicks.
+        /// </summary>
+        public readonly long deadlineSlackMin;
+
+        /// <summary>
+        /// The 1st percentile of the deadline slack over the last frames, in flicks.
+        /// </summary>
+        public readonly long deadlineSlackP1;
+
+        /// <summary>
+        /// The median deadline slack over the last frames, in flicks.
+        /// </summary>
+        public readonly long deadlineSlackP50;
+    }
+
+    /// <summary>
+    /// The progress of a device opened by the plugin.
+    /// </summary>
+    enum DeviceReadiness
+    {
+        /// <summary>
+        /// The device is still opening on a worker thread of the plugin.
+        /// </summary>
+        Pending = 0,
+
+        /// <summary>
+        /// The device is open and can be used.
+        /// </summary>
+        Ready = 1,
+
+        /// <summary>
+        /// The device failed to open; the reason is reported by the device.
+        /// </summary>
+        Failed = 2,
+    }
+
+    /// <summary>
+    /// The last status sampled from a card by its background poller.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct DeckLinkHealth
+    {
+        /// <summary>
+        /// The steady clock time of the last sample, in nanoseconds.
+        /// </summary>
+        public readonly long sampleTime;
+
+        /// <summary>
+        /// The position of the output frame boundary against the host clock, in flicks, or -1 if unknown.
+        /// </summary>
+        public readonly long referencePhase;
+
+        /// <summary>
+        /// The number of samples taken so far.
+        /// </summary>
+        public readonly uint sampleCount;
+
+        /// <summary>
+        /// Non-zero when the card is locked to its reference input.
+        /// </summary>
+        public readonly int referenceLocked;
+
+        /// <summary>
+        /// The BMDDisplayMode of the reference signal.
+        /// </summary>
+        public readonly int referenceMode;
+
+        /// <summary>
+        /// Non-zero when the card is locked to its input signal.
+        /// </summary>
+        public readonly int inputSignalLocked;
+
+        /// <summary>
+        /// The BMDPixelFormat of the current input.
+        /// </summary>
+        public readonly int inputPixelFormat;
+
+        /// <summary>
+        /// The BMDPixelFormat of the last output frame.
+        /// </summary>
+        public readonly int outputPixelFormat;
+
+        /// <summary>
+        /// The temperature of the card, in degrees Celsius.
+        /// </summary>
+        public readonly int temperature;
+
+        /// <summary>
+        /// The BMDDeviceBusyState of the card.
+        /// </summary>
+        public readonly int busy;
+    }
+
+    /// <summary>
+    /// The kind of change recorded in the health history of a card.
+    /// </summary>
+    enum DeckLinkHealthEventType
+    {
+        ReferenceLocked = 0,
+        ReferenceLost = 1,
+        ReferencePhaseJump = 2,
+        InputSignalLocked = 3,
+        InputSignalLost = 4,
+    }
+
+    /// <summary>
+    /// A change recorded in the health history of a card.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct DeckLinkHealthEvent
+    {
+        /// <summary>
+        /// The steady clock time of the change, in nanoseconds.
+        /// </summary>
+        public readonly long time;
+
+        /// <summary>
+        /// The kind of change.
+        /// </summary>
+        public readonly DeckLinkHealthEventType type;
+
+        readonly int m_Reserved;
+
+        /// <summary>
+        /// The phase jump in flicks for a reference phase jump, 0 otherwise.
+        /// </summary>
+        public readonly long value;
+    }
+
+    static class DeckLinkDeviceStatusPlugin
+    {
+        /// <summary>
+        /// Reads a status block mapped from the plugin.
+        /// </summary>
+        /// <param name="block">The address of the status block, or IntPtr.Zero.</param>
+        /// <returns>The device status, or the default status if the block isn't mapped.</returns>
+        public static unsafe DeviceStatus Read(IntPtr block)
+        {
+            if (block == IntPtr.Zero)
+                return default;
+
+            // The update count is a sequence lock: the copy is consistent if the count was even
+            // and didn't change while copying.
+            var updateCount = (uint*)((byte*)block + sizeof(long));
+            while (true)
+            {
+                var before = Volatile.Read(ref *updateCount);
+                if ((before & 1) == 0)
+                {
+                    var status = *(DeviceStatus*)block;
+                    Thread.MemoryBarrier();
+                    if (Volatile.Read(ref *updateCount) == before)
+                        return status;
+                }
+
+                Thread.SpinWait(1);
+            }
+        }
+
+        /// <summary>
+        /// Retrieves the status of all the live devices at once.
+        /// </summary>
+        /// <returns>The status of each live device.</returns>
+        public static DeviceStatus[] GetSnapshot()
+        {
+            var count = GetDeviceStatusSnapshot(null, 0);
+            while (true)
+            {
+                var statuses = new DeviceStatus[count];
+                var total = GetDeviceStatusSnapshot(statuses, statuses.Length);
+                if (total <= statuses.Length)
+                {
+                    if (total < statuses.Length)
+                        Array.Resize(ref statuses, total);
+                    return statuses;
+                }
+
+                // A device was created in between: retry with the new count.
+                count = total;
+            }
+        }
+
+        /// <summary>
+        /// Sets the rate at which the background pollers sample the status of the cards.
+        /// </summary>
+        /// <param name="intervalMs">The interval between two samples, in milliseconds.</param>
+        public static void SetPollingInterval(int intervalMs)
+        {
+            SetDeckLinkStatusPollingInterval(intervalMs);
+        }
+
+        /// <summary>
+        /// Stops many devices at once, waiting for all of them against a single deadline.
+        /// </summary>
+        /// <remarks>
+        /// The devices still have to be disposed afterwards, which is then immediate.
+        /// </remarks>
+        /// <param name="inputs">The Input Devices to stop, or null.</param>
+        /// <param name="outputs">The Output Devices to stop, or null.</param>
+        /// <param name="timeoutMs">The time allowed to stop all the devices, in milliseconds.</param>
+        /// <param name="missed">One flag per device, the Input Devices first, set if the device missed the deadline.</param>
+        /// <returns>The number of devices which missed the deadline.</returns>
+        public static int StopDevices(DeckLinkInputDevicePlugin[] inputs, DeckLinkOutputDevicePlugin[] outputs, int timeoutMs, out bool[] missed)
+        {
+            if (inputs == null)
+                inputs = Array.Empty<DeckLinkInputDevicePlugin>();
+            if (outputs == null)
+                outputs = Array.Empty<DeckLinkOutputDevicePlugin>();
+
+            var inputHandles = new IntPtr[inputs.Length];
+            for (var i = 0; i < inputs.Length; ++i)
+            {
+                inputHandles[i] = inputs[i] != null ? inputs[i].Device : IntPtr.Zero;
+            }
+
+            missed = new bool[inputs.Length + outputs.Length];
+            return StopDevices(inputHandles, inputs.Length, DeckLinkOutputDevicePlugin.GetDeviceHandles(outputs), outputs.Length, timeoutMs, missed);
+        }
+
+        /// <summary>
+        /// Trims a health history buffer to the number of events copied by the plugin.
+        /// </summary>
+        internal static DeckLinkHealthEvent[] TrimHistory(DeckLinkHealthEvent[] events, int count)
+        {
+            if (count < events.Length)
+                Array.Resize(ref events, count);
+            return events;
+        }
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void SetDeckLinkStatusPollingInterval(int intervalMs);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int StopDevices(IntPtr[] inputDevices, int inputCount, IntPtr[] outputDevices, int outputCount, int timeoutMs,
+            [Out, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.I1)] bool[] missed);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetDeviceStatusSnapshot([Out] DeviceStatus[] statuses, int capacity);
+    }
+}
@@ -0,0 +1,52 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// The native record of the driver callbacks, which can be replayed offline against virtual cards.
+    /// </summary>
+    /// <remarks>
+    /// The timing and metadata of every captured frame, input format change and completed output frame
+    /// are kept, so the callback pattern of a production incident (jitter, bursts after a driver hiccup,
+    /// format change storms) can be reproduced and benchmarked without the hardware.
+    /// </remarks>
+    static class DeckLinkEventRecorderPlugin
+    {
+        /// <summary>
+        /// Starts recording the driver callbacks into a ring buffer, the oldest events being overwritten.
+        /// </summary>
+        /// <param name="capacity">The number of events kept; only used on the first call.</param>
+        /// <returns>True if the recorder is recording, false otherwise.</returns>
+        public static bool Enable(int capacity = 1 << 18) => EnableDeckLinkEventRecording(capacity);
+
+        /// <summary>
+        /// Stops recording the driver callbacks; the recorded events can still be written.
+        /// </summary>
+        public static void Disable() => DisableDeckLinkEventRecording();
+
+        /// <summary>
+        /// Whether the recorder is recording.
+        /// </summary>
+        public static bool IsEnabled => IsDeckLinkEventRecordingEnabled();
+
+        /// <summary>
+        /// Writes the recorded events as a compact binary recording, which the replay benchmark of the plugin reads.
+        /// </summary>
+        /// <param name="path">The path of the recording.</param>
+        /// <returns>The number of events written, or -1 if the file couldn't be written.</returns>
+        public static int Write(string path) => WriteDeckLinkEventRecording(path);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool EnableDeckLinkEventRecording(int capacity);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void DisableDeckLinkEventRecording();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool IsDeckLinkEventRecordingEnabled();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int WriteDeckLinkEventRecording([MarshalAs(UnmanagedType.LPStr)] string path);
+    }
+}
@@ -116,6 +116,53 @@ namespace Unity.Media.Blackmagic
         }
     }
 
+    /// <summary>
+    /// The timings of the input restarts on format changes, in nanoseconds.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct InputFormatChangeStatistics
+    {
+        /// <summary>
+        /// The duration of the last restart of the input.
+        /// </summary>
+        public readonly long lastRestart;
+
+        /// <summary>
+        /// The longest restart of the input.
+        /// </summary>
+        public readonly long maxRestart;
+
+        /// <summary>
+        /// The time from the last format change to the first frame captured in the new format.
+        /// </summary>
+        public readonly long lastRecovery;
+
+        /// <summary>
+        /// The size of the frame buffers held by the plugin, in bytes.
+        /// </summary>
+        public readonly long pooledBytes;
+
+        /// <summary>
+        /// The number of format changes handled.
+        /// </summary>
+        public readonly uint formatChanges;
+
+        /// <summary>
+        /// The number of frame buffers allocated on demand, because none was large enough.
+        /// </summary>
+        public readonly uint poolMisses;
+
+        /// <summary>
+        /// The same as <see cref="poolMisses"/>, from the last format change to its first frame.
+        /// </summary>
+        public readonly uint lastRecoveryMisses;
+
+        /// <summary>
+        /// The number of frame buffers held by the plugin.
+        /// </summary>
+        public readonly int pooledBuffers;
+    }
+
     sealed class DeckLinkInputDevicePlugin : IDisposable
     {
         [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
@@ -301,8 +348,11 @@ namespace Unity.Media.Blackmagic
         }
 
         IntPtr m_Device;
+        IntPtr m_StatusBlock;
         int m_DeviceIndex;
 
+        internal IntPtr Device => m_Device;
+
 
         /// <summary>
         /// Determines if the device is initialized correctly.
@@ -368,9 +418,87 @@ namespace Unity.Media.Blackmagic
 
             selectedFormat = new InputVideoFormat(outFormat, string.Empty);
 
+            if (plugin.m_Device != IntPtr.Zero)
+                plugin.m_StatusBlock = GetInputDeviceStatusBlock(plugin.m_Device);
+
             return plugin;
         }
 
+        /// <summary>
+        /// Creates an input device which is opened on a worker thread of the plugin.
+        /// </summary>
+        /// <remarks>
+        /// The device must not be used before <see cref="Readiness"/> is <see cref="DeviceReadiness.Ready"/>.
+        /// Several devices created this way are opened in parallel.
+        /// </remarks>
+        public static DeckLinkInputDevicePlugin CreateDeferred(
+            int deviceIndex,
+            int deviceSelected,
+            int format,
+            BMDPixelFormat inPixelFormat,
+            bool enablePassThrough
+        )
+        {
+            var plugin = new DeckLinkInputDevicePlugin
+            {
+                m_DeviceIndex = deviceIndex,
+            };
+
+            s_IndexToPlugin.Add(deviceIndex, plugin);
+
+            var finalDeviceSelected = GetOffsetLogicalDevice(deviceSelected);
+
+            plugin.m_Device = CreateInputDeviceDeferred(
+                deviceIndex,
+                deviceSelected + finalDeviceSelected,
+                format,
+                (int)inPixelFormat,
+                enablePassThrough,
+                SystemInfo.graphicsDeviceType);
+
+            if (plugin.m_Device != IntPtr.Zero)
+                plugin.m_StatusBlock = GetInputDeviceStatusBlock(plugin.m_Device);
+
+            return plugin;
+        }
+
+        /// <summary>
+        /// Whether the device is still opening, ready to use, or failed to open.
+        /// </summary>
+        public DeviceReadiness Readiness => (DeviceReadiness)GetInputDeviceReadiness(m_Device);
+
+        /// <summary>
+        /// Waits until the device is done opening.
+        /// </summary>
+        /// <param name="timeoutMs">The maximum time to wait, in milliseconds; a negative value waits until done.</param>
+        /// <returns>The readiness of the device when the wait ended.</returns>
+        public DeviceReadiness WaitReady(int timeoutMs)
+        {
+            return (DeviceReadiness)WaitInputDeviceReady(m_Device, timeoutMs);
+        }
+
+        /// <summary>
+        /// Describes why the device failed to open; empty otherwise.
+        /// </summary>
+        public string OpenError => BlackmagicUtilities.FromUTF8(GetInputDeviceOpenError(m_Device));
+
+        /// <summary>
+        /// Retrieves the video format the device was opened with.
+        /// </summary>
+        /// <param name="selectedFormat">The video format of the device.</param>
+        /// <returns>True if the device is ready; false otherwise.</returns>
+        public bool TryGetSelectedFormat(out InputVideoFormat selectedFormat)
+        {
+            if (!GetInputDeviceSelectedFormat(m_Device, out var format))
+            {
+                selectedFormat = default;
+                return false;
+            }
+
+            selectedFormat = new InputVideoFormat(format, string.Empty);
+            return true;
+        }
+
         ~DeckLinkInputDevicePlugin()
         {
             if (m_Device != IntPtr.Zero)
@@ -389,6 +517,7 @@ namespace Unity.Media.Blackmagic
             {
                 s_IndexToPlugin.Remove(m_DeviceIndex);
 
+                m_StatusBlock = IntPtr.Zero;
                 DestroyInputDevice(m_Device);
 
                 m_Device = IntPtr.Zero;
@@ -428,7 +557,44 @@ namespace Unity.Media.Blackmagic
         /// <returns>True if it has an active video signal; false otherwise.</returns>
         public bool HasInputSource()
         {
-            return GetHasInputSource(m_Device);
+            return Status.signalPresent != 0;
+        }
+
+        /// <summary>
+        /// The status of the device, read from the block mapped from the plugin without calling into it.
+        /// </summary>
+        public DeviceStatus Status => DeckLinkDeviceStatusPlugin.Read(m_StatusBlock);
+
+        /// <summary>
+        /// Retrieves the last status sampled from the card by its background poller.
+        /// </summary>
+        /// <param name="health">The last sampled status.</param>
+        /// <returns>True if the card is polled; false otherwise.</returns>
+        public bool TryGetHealth(out DeckLinkHealth health)
+        {
+            return GetInputDeviceHealth(m_Device, out health);
+        }
+
+        /// <summary>
+        /// Retrieves the recorded changes of reference lock, reference phase and input signal lock of the card.
+        /// </summary>
+        /// <param name="capacity">The maximum number of events to retrieve.</param>
+        /// <returns>The recorded events, oldest first.</returns>
+        public DeckLinkHealthEvent[] GetHealthHistory(int capacity = 256)
+        {
+            var events = new DeckLinkHealthEvent[capacity];
+            var count = GetInputDeviceHealthHistory(m_Device, events, capacity);
+            return DeckLinkDeviceStatusPlugin.TrimHistory(events, count);
+        }
+
+        /// <summary>
+        /// Gets the timings of the input restarts on format changes.
+        /// </summary>
+        /// <returns>The format change statistics.</returns>
+        public InputFormatChangeStatistics GetFormatChangeStatistics()
+        {
+            GetInputDeviceFormatChangeStatistics(m_Device, out var statistics);
+            return statistics;
         }
 
         public readonly struct QueueLockScope : IDisposable
@@ -480,6 +646,27 @@ namespace Unity.Media.Blackmagic
             GraphicsDeviceType graphicsAPI,
             out InputVideoFormatData selectedFormat);
 
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr CreateInputDeviceDeferred(
+            int deviceIndex,
+            int deviceSelected,
+            int format,
+            int pixelFormat,
+            bool enablePassThrough,
+            GraphicsDeviceType graphicsAPI);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetInputDeviceReadiness(IntPtr inputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int WaitInputDeviceReady(IntPtr inputDevice, int timeoutMs);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr GetInputDeviceOpenError(IntPtr inputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool GetInputDeviceSelectedFormat(IntPtr inputDevice, out InputVideoFormatData selectedFormat);
+
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern void DestroyInputDevice(IntPtr inputDevice);
 
@@ -499,6 +686,15 @@ namespace Unity.Media.Blackmagic
         static extern uint GetInputDeviceID(IntPtr inputDevice);
 
         [DllImport(BlackmagicUtilities.k_PluginName)]
-        static extern bool GetHasInputSource(IntPtr inputDevice);
+        static extern IntPtr GetInputDeviceStatusBlock(IntPtr inputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool GetInputDeviceHealth(IntPtr inputDevice, out DeckLinkHealth health);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetInputDeviceHealthHistory(IntPtr inputDevice, [Out] DeckLinkHealthEvent[] events, int capacity);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void GetInputDeviceFormatChangeStatistics(IntPtr inputDevice, out InputFormatChangeStatistics statistics);
     }
 }
@@ -0,0 +1,53 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// The severity of a message written to the native log.
+    /// </summary>
+    enum LogSeverity
+    {
+        Debug = 0,
+        Info = 1,
+        Warning = 2,
+        Error = 3,
+
+        /// <summary>
+        /// Nothing is logged.
+        /// </summary>
+        Off = 4,
+    }
+
+    /// <summary>
+    /// The native log file of the plugin.
+    /// </summary>
+    /// <remarks>
+    /// The messages are queued by the plugin threads and written in batches by a background thread;
+    /// the messages repeated on every frame are rate-limited.
+    /// </remarks>
+    static class DeckLinkLogPlugin
+    {
+        /// <summary>
+        /// Sets the log file and the messages written to it.
+        /// </summary>
+        /// <param name="path">The path of the log file, or null to keep the current one.</param>
+        /// <param name="severity">The minimum severity of the messages written.</param>
+        /// <param name="maxFileBytes">The size after which the file is rotated, or 0 for no limit.</param>
+        public static void Configure(string path, LogSeverity severity, long maxFileBytes = 8 * 1024 * 1024)
+        {
+            ConfigureDeckLinkLog(path, (int)severity, maxFileBytes);
+        }
+
+        /// <summary>
+        /// The number of messages dropped because the writer couldn't keep up.
+        /// </summary>
+        public static ulong DroppedMessages => GetDeckLinkLogDroppedMessages();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void ConfigureDeckLinkLog(string path, int severity, long maxFileBytes);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern ulong GetDeckLinkLogDroppedMessages();
+    }
+}
@@ -8,6 +8,45 @@ using static Unity.Media.Blackmagic.BaseDeckLinkDevice;
 
 namespace Unity.Media.Blackmagic
 {
+    /// <summary>
+    /// The behavior of an async submission queue when it is full.
+    /// </summary>
+    enum SubmissionBackpressure
+    {
+        /// <summary>
+        /// The caller waits until a queued frame is consumed.
+        /// </summary>
+        Block = 0,
+
+        /// <summary>
+        /// The oldest queued frame is released without being played out.
+        /// </summary>
+        DropOldest = 1,
+
+        /// <summary>
+        /// The submitted frame is rejected.
+        /// </summary>
+        DropNewest = 2,
+    }
+
+    /// <summary>
+    /// The counters and per-stage timings of an async submission queue, in nanoseconds.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct OutputSubmissionStatistics
+    {
+        public readonly uint submitted;
+        public readonly uint consumed;
+        public readonly uint dropped;
+        public readonly int queued;
+        public readonly long lastQueueWait;
+        public readonly long lastCopy;
+        public readonly long lastSchedule;
+        public readonly long maxQueueWait;
+        public readonly long maxCopy;
+        public readonly long maxSchedule;
+    }
+
     sealed class DeckLinkOutputDevicePlugin : IDisposable
     {
         const int k_DefaultCapacity = 4;
@@ -16,6 +55,8 @@ namespace Unity.Media.Blackmagic
         internal delegate void FrameErrorCallback(int index, IntPtr message, StatusType status);
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         internal delegate void FrameCompletedCallback(int index, long frameNumber);
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate void FrameReleasedCallback(int index, IntPtr frameData, [MarshalAs(UnmanagedType.U1)] bool dropped);
 
         /// <summary>
         /// Represents a callback that can be used to retrieve the plugin errors.
@@ -24,7 +65,13 @@ namespace Unity.Media.Blackmagic
 
         internal event FrameCompletedCallback OnFrameCompleted;
 
+        /// <summary>
+        /// Invoked from the submission worker when a submitted buffer can be reused.
+        /// </summary>
+        internal event FrameReleasedCallback OnFrameReleased;
+
         IntPtr m_CurrentDevice;
+        IntPtr m_StatusBlock;
 
         internal IntPtr CurrentDevice => m_CurrentDevice;
 
@@ -45,6 +92,7 @@ namespace Unity.Media.Blackmagic
         /// <param name="device">Index of the device selected.</param>
         /// <param name="displayMode">A BMDDisplayMode enum value.</param>
         /// <param name="preroll">Queue length wait for Output Device completion.</param>
+        /// <param name="deferred">Opens the device on a worker thread of the plugin; see <see cref="Readiness"/>.</param>
         /// <returns> Static instance of the class. </returns>
         public static DeckLinkOutputDevicePlugin CreateAsyncOutputDevice(
             int deviceIndex,
@@ -57,12 +105,14 @@ namespace Unity.Media.Blackmagic
             bool enableAudio,
             int audioChannelCount,
             int audioSampleRate,
-            bool useGPUDirect
+            bool useGPUDirect,
+            bool deferred = false
         )
         {
             var finalDeviceSelected = GetOffsetLogicalDevice(deviceSelected);
 
-            var intPtr = CreateAsyncOutputDeviceNative(
+            var create = deferred ? (CreateOutputDeviceFunction)CreateAsyncOutputDeviceDeferred : CreateAsyncOutputDeviceNative;
+            var intPtr = create(
                 deviceIndex,
                 deviceSelected + finalDeviceSelected,
                 displayMode,
@@ -88,6 +138,7 @@ namespace Unity.Media.Blackmagic
         /// </summary>
         /// <param name="device">Index of the device selected.</param>
         /// <param name="displayMode">A BMDDisplayMode enum value.</param>
+        /// <param name="deferred">Opens the device on a worker thread of the plugin; see <see cref="Readiness"/>.</param>
         /// <returns>Static instance of the class.</returns>
         public static DeckLinkOutputDevicePlugin CreateManualOutputDevice(
             int deviceIndex,
@@ -100,12 +151,14 @@ namespace Unity.Media.Blackmagic
             bool enableAudio,
             int audioChannelCount,
             int audioSampleRate,
-            bool useGPUDirect
+            bool useGPUDirect,
+            bool deferred = false
         )
         {
             var finalDeviceSelected = GetOffsetLogicalDevice(deviceSelected);
 
-            var intPtr = CreateManualOutputDeviceNative(
+            var create = deferred ? (CreateOutputDeviceFunction)CreateManualOutputDeviceDeferred : CreateManualOutputDeviceNative;
+            var intPtr = create(
                 deviceIndex,
                 deviceSelected + finalDeviceSelected,
                 displayMode,
@@ -128,6 +181,7 @@ namespace Unity.Media.Blackmagic
         DeckLinkOutputDevicePlugin(IntPtr plugin, int device)
         {
             m_CurrentDevice = plugin;
+            m_StatusBlock = GetOutputDeviceStatusBlock(plugin);
         }
 
         ~DeckLinkOutputDevicePlugin()
@@ -149,6 +203,10 @@ namespace Unity.Media.Blackmagic
             {
                 SetFrameCompletedCallback(m_CurrentDevice, Marshal.GetFunctionPointerForDelegate(OnFrameCompleted));
             }
+            if (OnFrameReleased != null)
+            {
+                SetFrameReleasedCallback(m_CurrentDevice, Marshal.GetFunctionPointerForDelegate(OnFrameReleased));
+            }
         }
 
         /// <summary>
@@ -157,6 +215,29 @@ namespace Unity.Media.Blackmagic
         /// <returns>True if the device is initialized correctly, false otherwise.</returns>
         public bool IsInitialized() => IsOutputDeviceInitialized(m_CurrentDevice);
 
+        /// <summary>
+        /// Whether the device is still opening, ready to use, or failed to open.
+        /// </summary>
+        /// <remarks>
+        /// A deferred device must not be used before it is <see cref="DeviceReadiness.Ready"/>.
+        /// </remarks>
+        public DeviceReadiness Readiness => (DeviceReadiness)GetOutputDeviceReadiness(m_CurrentDevice);
+
+        /// <summary>
+        /// Waits until the device is done opening.
+        /// </summary>
+        /// <param name="timeoutMs">The maximum time to wait, in milliseconds; a negative value waits until done.</param>
+        /// <returns>The readiness of the device when the wait ended.</returns>
+        public DeviceReadiness WaitReady(int timeoutMs)
+        {
+            return (DeviceReadiness)WaitOutputDeviceReady(m_CurrentDevice, timeoutMs);
+        }
+
+        /// <summary>
+        /// Describes why the device failed to open; empty otherwise.
+        /// </summary>
+        public string OpenError => BlackmagicUtilities.FromUTF8(GetOutputDeviceOpenError(m_CurrentDevice));
+
         /// <summary>
         /// Defines a recovery time for the current output device in use.
         /// </summary>
@@ -181,6 +262,7 @@ namespace Unity.Media.Blackmagic
         /// </summary>
         public void Dispose()
         {
+            m_StatusBlock = IntPtr.Zero;
             DestroyOutputDevice(m_CurrentDevice);
             m_CurrentDevice = IntPtr.Zero;
         }
@@ -221,17 +303,52 @@ namespace Unity.Media.Blackmagic
         /// <summary>
         /// Determines if the Output Device is locked or not (GenLock input status)
         /// </summary>
-        public bool IsReferenceLocked => IsOutputDeviceReferenceLocked(m_CurrentDevice) != 0;
+        public bool IsReferenceLocked => Status.referenceLocked != 0;
 
         /// <summary>
         /// The number of frames dropped.
         /// </summary>
-        public uint DroppedFrameCount => CountDroppedOutputDeviceFrames(m_CurrentDevice);
+        public uint DroppedFrameCount => Status.droppedFrames;
 
         /// <summary>
         /// The number of frames displayed late.
         /// </summary>
-        public uint LateFrameCount => CountLateOutputDeviceFrames(m_CurrentDevice);
+        public uint LateFrameCount => Status.lateFrames;
+
+        /// <summary>
+        /// The time left before the last fed frame was due on the card, in flicks.
+        /// </summary>
+        /// <remarks>
+        /// A slack shrinking towards zero announces late frames before they happen.
+        /// </remarks>
+        public long DeadlineSlack => Status.deadlineSlack;
+
+        /// <summary>
+        /// The status of the device, read from the block mapped from the plugin without calling into it.
+        /// </summary>
+        public DeviceStatus Status => DeckLinkDeviceStatusPlugin.Read(m_StatusBlock);
+
+        /// <summary>
+        /// Retrieves the last status sampled from the card by its background poller.
+        /// </summary>
+        /// <param name="health">The last sampled status.</param>
+        /// <returns>True if the card is polled; false otherwise.</returns>
+        public bool TryGetHealth(out DeckLinkHealth health)
+        {
+            return GetOutputDeviceHealth(m_CurrentDevice, out health);
+        }
+
+        /// <summary>
+        /// Retrieves the recorded changes of reference lock, reference phase and input signal lock of the card.
+        /// </summary>
+        /// <param name="capacity">The maximum number of events to retrieve.</param>
+        /// <returns>The recorded events, oldest first.</returns>
+        public DeckLinkHealthEvent[] GetHealthHistory(int capacity = 256)
+        {
+            var events = new DeckLinkHealthEvent[capacity];
+            var count = GetOutputDeviceHealthHistory(m_CurrentDevice, events, capacity);
+            return DeckLinkDeviceStatusPlugin.TrimHistory(events, count);
+        }
 
         /// <summary>
         /// Queries the initialized plugin and validates its configuration.
@@ -277,6 +394,37 @@ namespace Unity.Media.Blackmagic
         /// <returns>True if succeeded, false otherwise.</returns>
         public bool SetLinkMode(int mode) => SetOutputLinkMode(m_CurrentDevice, mode);
 
+        /// <summary>
+        /// Applies a new configuration to the running device, without recreating it.
+        /// </summary>
+        /// <remarks>
+        /// Only the changed settings are applied. A new display mode, pixel format or HDR state restarts the playback
+        /// at the next frame boundary, from the last fed frame, and keeps the allocated frames if their size still fits.
+        /// </remarks>
+        /// <param name="displayMode">A BMDDisplayMode enum value.</param>
+        /// <param name="pixelFormat">The pixel format of the frames.</param>
+        /// <param name="colorSpace">The color space of the frames.</param>
+        /// <param name="transferFunction">The transfer function of the frames.</param>
+        /// <param name="keyingMode">The keying mode.</param>
+        /// <param name="linkMode">The Link mode.</param>
+        /// <returns>True if succeeded, false otherwise.</returns>
+        public bool Reconfigure(int displayMode,
+            BMDPixelFormat pixelFormat,
+            BMDColorSpace colorSpace,
+            BMDTransferFunction transferFunction,
+            int keyingMode,
+            int linkMode)
+        {
+            return ReconfigureOutputDevice(
+                m_CurrentDevice,
+                displayMode,
+                (int)pixelFormat,
+                (int)colorSpace,
+                (int)transferFunction,
+                keyingMode,
+                linkMode);
+        }
+
         /// <summary>
         /// Feeds a frame to the output device plugin.
         /// </summary>
@@ -288,6 +436,58 @@ namespace Unity.Media.Blackmagic
             FeedFrameToOutputDevice(m_CurrentDevice, (IntPtr)data.GetUnsafeReadOnlyPtr(), timecode.ToBCD());
         }
 
+        /// <summary>
+        /// Sets the trace flow ID of the next fed frame, when the native tracer is recording.
+        /// </summary>
+        /// <param name="flow">The flow ID of the input frame the fed frame is made of.</param>
+        public void SetTraceFlow(ulong flow)
+        {
+            SetOutputDeviceTraceFlow(m_CurrentDevice, flow);
+        }
+
+        /// <summary>
+        /// Starts a native worker which copies, packs and schedules the submitted frames off the calling thread.
+        /// </summary>
+        /// <param name="capacity">The maximum number of frames waiting for the worker.</param>
+        /// <param name="policy">The behavior when the queue is full.</param>
+        /// <returns>True if the worker was started, false otherwise.</returns>
+        public bool EnableAsyncSubmission(int capacity, SubmissionBackpressure policy)
+        {
+            return EnableOutputDeviceAsyncSubmission(m_CurrentDevice, capacity, (int)policy);
+        }
+
+        /// <summary>
+        /// Stops the submission worker; the frames still queued are released as dropped.
+        /// </summary>
+        public void DisableAsyncSubmission()
+        {
+            DisableOutputDeviceAsyncSubmission(m_CurrentDevice);
+        }
+
+        /// <summary>
+        /// Hands a frame over to the submission worker and returns immediately.
+        /// </summary>
+        /// <remarks>
+        /// The buffer must stay valid until <see cref="OnFrameReleased"/> is invoked for it.
+        /// </remarks>
+        /// <param name="data">The frame to submit.</param>
+        /// <param name="timecode">The timecode of the frame.</param>
+        /// <returns>True if the frame was queued; false if it was rejected, in which case the buffer is not retained.</returns>
+        public unsafe bool SubmitFrame<T>(NativeArray<T> data, Timecode timecode) where T : struct
+        {
+            return SubmitFrameToOutputDevice(m_CurrentDevice, (IntPtr)data.GetUnsafeReadOnlyPtr(), timecode.ToBCD());
+        }
+
+        /// <summary>
+        /// Gets the counters and per-stage timings of the submission worker.
+        /// </summary>
+        /// <returns>The submission statistics.</returns>
+        public OutputSubmissionStatistics GetSubmissionStatistics()
+        {
+            GetOutputDeviceSubmissionStatistics(m_CurrentDevice, out var statistics);
+            return statistics;
+        }
+
         /// <summary>
         /// Blocks the thread to wait for Output Device completion every end-of-frame.
         /// </summary>
@@ -303,6 +503,51 @@ namespace Unity.Media.Blackmagic
             }
         }
 
+        /// <summary>
+        /// The number of frames the Output Device has completed so far.
+        /// </summary>
+        public long CompletedFrameCount => GetOutputDeviceCompletedFrames(m_CurrentDevice);
+
+        /// <summary>
+        /// Blocks the thread until one of the Output Devices completes its frame, or until the timeout elapses.
+        /// </summary>
+        /// <param name="devices">The Output Devices to wait on.</param>
+        /// <param name="frameNumbers">The frame number to wait for on each device.</param>
+        /// <param name="timeoutMs">The timeout in milliseconds, or -1 to wait indefinitely.</param>
+        /// <returns>The index of the first device which completed its frame, or -1 on timeout.</returns>
+        public static int WaitAnyCompletion(DeckLinkOutputDevicePlugin[] devices, long[] frameNumbers, int timeoutMs)
+        {
+            if (devices == null || frameNumbers == null || devices.Length != frameNumbers.Length)
+                throw new ArgumentException("Expected one frame number per device.");
+
+            return WaitAnyOutputCompletion(GetDeviceHandles(devices), frameNumbers, devices.Length, timeoutMs);
+        }
+
+        /// <summary>
+        /// Blocks the thread until all the Output Devices complete their frame, or until the timeout elapses.
+        /// </summary>
+        /// <param name="devices">The Output Devices to wait on.</param>
+        /// <param name="frameNumbers">The frame number to wait for on each device.</param>
+        /// <param name="timeoutMs">The timeout in milliseconds, or -1 to wait indefinitely.</param>
+        /// <returns>True if all the devices completed their frame, false on timeout.</returns>
+        public static bool WaitAllCompletion(DeckLinkOutputDevicePlugin[] devices, long[] frameNumbers, int timeoutMs)
+        {
+            if (devices == null || frameNumbers == null || devices.Length != frameNumbers.Length)
+                throw new ArgumentException("Expected one frame number per device.");
+
+            return WaitAllOutputCompletion(GetDeviceHandles(devices), frameNumbers, devices.Length, timeoutMs);
+        }
+
+        internal static IntPtr[] GetDeviceHandles(DeckLinkOutputDevicePlugin[] devices)
+        {
+            var handles = new IntPtr[devices.Length];
+            for (var i = 0; i < devices.Length; ++i)
+            {
+                handles[i] = devices[i] != null ? devices[i].m_CurrentDevice : IntPtr.Zero;
+            }
+            return handles;
+        }
+
         /// <summary>
         /// Feeds audio samples to the plugin.
         /// </summary>
@@ -375,6 +620,59 @@ namespace Unity.Media.Blackmagic
             bool useGPUDirect
         );
 
+        delegate IntPtr CreateOutputDeviceFunction(
+            int deviceIndex,
+            int deviceSelected,
+            int displayMode,
+            int pixelFormat,
+            int colorSpace,
+            int transferFunction,
+            int preroll,
+            bool enableAudio,
+            int audioChannelCount,
+            int audioSampleRate,
+            bool useGPUDirect
+        );
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr CreateAsyncOutputDeviceDeferred(
+            int deviceIndex,
+            int deviceSelected,
+            int displayMode,
+            int pixelFormat,
+            int colorSpace,
+            int transferFunction,
+            int preroll,
+            bool enableAudio,
+            int audioChannelCount,
+            int audioSampleRate,
+            bool useGPUDirect
+        );
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr CreateManualOutputDeviceDeferred(
+            int deviceIndex,
+            int deviceSelected,
+            int displayMode,
+            int pixelFormat,
+            int colorSpace,
+            int transferFunction,
+            int preroll,
+            bool enableAudio,
+            int audioChannelCount,
+            int audioSampleRate,
+            bool useGPUDirect
+        );
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetOutputDeviceReadiness(IntPtr outputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int WaitOutputDeviceReady(IntPtr outputDevice, int timeoutMs);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr GetOutputDeviceOpenError(IntPtr outputDevice);
+
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern void DestroyOutputDevice(IntPtr outputDevice);
 
@@ -402,9 +700,6 @@ namespace Unity.Media.Blackmagic
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern void GetOutputDeviceBackingFrameByteDimensions(IntPtr inputDevice, out uint w, out uint h, out uint d);
 
-        [DllImport(BlackmagicUtilities.k_PluginName)]
-        static extern int IsOutputDeviceReferenceLocked(IntPtr outputDevice);
-
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern void FeedFrameToOutputDevice(IntPtr outputDevice, IntPtr frameData, uint timecode);
 
@@ -412,10 +707,22 @@ namespace Unity.Media.Blackmagic
         static extern void WaitOutputDeviceCompletion(IntPtr outputDevice, long frameNumber);
 
         [DllImport(BlackmagicUtilities.k_PluginName)]
-        static extern uint CountDroppedOutputDeviceFrames(IntPtr outputDevice);
+        static extern long GetOutputDeviceCompletedFrames(IntPtr outputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr GetOutputDeviceStatusBlock(IntPtr outputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool GetOutputDeviceHealth(IntPtr outputDevice, out DeckLinkHealth health);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int GetOutputDeviceHealthHistory(IntPtr outputDevice, [Out] DeckLinkHealthEvent[] events, int capacity);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int WaitAnyOutputCompletion(IntPtr[] outputDevices, long[] frameNumbers, int count, int timeoutMs);
 
         [DllImport(BlackmagicUtilities.k_PluginName)]
-        static extern uint CountLateOutputDeviceFrames(IntPtr outputDevice);
+        static extern bool WaitAllOutputCompletion(IntPtr[] outputDevices, long[] frameNumbers, int count, int timeoutMs);
 
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern unsafe void FeedAudioSampleFramesToOutputDevice(IntPtr outputDevice, float* sampleFrames, int sampleCount);
@@ -441,6 +748,9 @@ namespace Unity.Media.Blackmagic
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern bool ChangeKeyingMode(IntPtr outputDevice, int keying);
 
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool ReconfigureOutputDevice(IntPtr outputDevice, int mode, int pixelFormat, int colorSpace, int transferFunction, int keying, int linkMode);
+
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern bool DisableKeying(IntPtr outputDevice);
 
@@ -452,5 +762,23 @@ namespace Unity.Media.Blackmagic
 
         [DllImport(BlackmagicUtilities.k_PluginName)]
         static extern bool SetOutputLinkMode(IntPtr outputDevice, int mode);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool EnableOutputDeviceAsyncSubmission(IntPtr outputDevice, int capacity, int policy);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void DisableOutputDeviceAsyncSubmission(IntPtr outputDevice);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool SubmitFrameToOutputDevice(IntPtr outputDevice, IntPtr frameData, uint timecode);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void SetOutputDeviceTraceFlow(IntPtr outputDevice, ulong flow);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void SetFrameReleasedCallback(IntPtr outputDevice, IntPtr handler);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void GetOutputDeviceSubmissionStatistics(IntPtr outputDevice, out OutputSubmissionStatistics statistics);
     }
 }
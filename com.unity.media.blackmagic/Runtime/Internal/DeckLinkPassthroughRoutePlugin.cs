@@ -0,0 +1,206 @@
+using System;
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// The way the frames fed to the output device are combined with the routed input frames.
+    /// </summary>
+    enum PassthroughCompositing
+    {
+        /// <summary>
+        /// The input frames are played out untouched.
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// The frames fed to the output device replace the input frames while they keep coming.
+        /// </summary>
+        Fill = 1,
+
+        /// <summary>
+        /// The frames fed to the output device are alpha-blended over the input frames (8-bit RGB formats only).
+        /// </summary>
+        Key = 2,
+    }
+
+    /// <summary>
+    /// The frame synchronizer telemetry of a passthrough route.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    readonly struct FrameSynchronizerStatistics
+    {
+        /// <summary>
+        /// The position of the last input frame within the output frame, in flicks.
+        /// </summary>
+        public readonly long phase;
+
+        /// <summary>
+        /// The duration of an output frame, in flicks.
+        /// </summary>
+        public readonly long outputFrameDuration;
+
+        /// <summary>
+        /// The measured drift of the input clock relative to the output clock, in parts per million.
+        /// </summary>
+        /// <remarks>
+        /// Positive when the input runs slower than the output.
+        /// </remarks>
+        public readonly double driftPpm;
+
+        /// <summary>
+        /// The number of frames waiting to be played out.
+        /// </summary>
+        public readonly int depth;
+
+        /// <summary>
+        /// The number of input frames dropped to follow the output clock.
+        /// </summary>
+        public readonly uint droppedFrames;
+
+        /// <summary>
+        /// The number of frames repeated to follow the output clock.
+        /// </summary>
+        public readonly uint repeatedFrames;
+
+        /// <summary>
+        /// The net number of video frames of audio inserted (positive) or dropped (negative).
+        /// </summary>
+        public readonly long audioSlip;
+    }
+
+    /// <summary>
+    /// Routes the frames captured by an input device to an output device natively, with a programmable delay.
+    /// </summary>
+    sealed class DeckLinkPassthroughRoutePlugin : IDisposable
+    {
+        IntPtr m_Route;
+
+        /// <summary>
+        /// Creates a route between two initialized devices.
+        /// </summary>
+        /// <param name="input">The device capturing the frames.</param>
+        /// <param name="output">The device playing out the frames.</param>
+        /// <param name="delayFrames">The number of frames between capture and play out.</param>
+        /// <param name="compositing">The way the frames fed to the output device are used.</param>
+        /// <param name="synchronize">Whether the frames follow the output clock through a frame synchronizer,
+        /// for inputs which are not locked to the output reference. Requires an output device in async mode.</param>
+        /// <returns>The route, or null if it could not be created; <see cref="GetCreateError"/> tells why.</returns>
+        public static DeckLinkPassthroughRoutePlugin Create(
+            DeckLinkInputDevicePlugin input,
+            DeckLinkOutputDevicePlugin output,
+            int delayFrames,
+            PassthroughCompositing compositing,
+            bool synchronize)
+        {
+            var route = CreatePassthroughRoute(input.Device, output.CurrentDevice, delayFrames, (int)compositing, synchronize);
+
+            if (route == IntPtr.Zero)
+                return null;
+
+            return new DeckLinkPassthroughRoutePlugin
+            {
+                m_Route = route,
+            };
+        }
+
+        ~DeckLinkPassthroughRoutePlugin()
+        {
+            if (m_Route != IntPtr.Zero)
+            {
+                Debug.LogError($"{nameof(DeckLinkPassthroughRoutePlugin)} instance was not disposed before finalization.");
+                Dispose();
+            }
+        }
+
+        /// <summary>
+        /// Detaches the route from its devices and releases its frames.
+        /// </summary>
+        public void Dispose()
+        {
+            if (m_Route != IntPtr.Zero)
+            {
+                DestroyPassthroughRoute(m_Route);
+                m_Route = IntPtr.Zero;
+            }
+        }
+
+        /// <summary>
+        /// Changes the number of frames between capture and play out.
+        /// </summary>
+        /// <remarks>
+        /// Increasing the delay restarts the delay line.
+        /// </remarks>
+        /// <param name="delayFrames">The new delay, in frames.</param>
+        /// <returns>True if the delay was applied; false otherwise.</returns>
+        public bool SetDelay(int delayFrames) => SetPassthroughRouteDelay(m_Route, delayFrames);
+
+        /// <summary>
+        /// Changes the way the frames fed to the output device are used.
+        /// </summary>
+        /// <param name="compositing">The new compositing mode.</param>
+        public void SetCompositing(PassthroughCompositing compositing) => SetPassthroughRouteCompositing(m_Route, (int)compositing);
+
+        /// <summary>
+        /// Gets the number of frames routed to the output device.
+        /// </summary>
+        /// <returns>The number of routed frames.</returns>
+        public uint CountRoutedFrames() => CountRoutedPassthroughFrames(m_Route);
+
+        /// <summary>
+        /// Gets the number of frames which could not be routed to the output device.
+        /// </summary>
+        /// <returns>The number of skipped frames.</returns>
+        public uint CountSkippedFrames() => CountSkippedPassthroughFrames(m_Route);
+
+        /// <summary>
+        /// Gets the phase, drift and slip telemetry of the frame synchronizer.
+        /// </summary>
+        /// <returns>The synchronizer statistics.</returns>
+        public FrameSynchronizerStatistics GetSynchronizerStatistics()
+        {
+            GetPassthroughRouteSynchronizerStatistics(m_Route, out var statistics);
+            return statistics;
+        }
+
+        /// <summary>
+        /// Gets the reason the last call to <see cref="Create"/> on this thread returned null.
+        /// </summary>
+        /// <returns>The error message, or null if the route was created.</returns>
+        public static string GetCreateError() => Marshal.PtrToStringAnsi(GetPassthroughRouteCreateError());
+
+        /// <summary>
+        /// Gets the last error reported by the route.
+        /// </summary>
+        /// <returns>The error message, or null if there is no error.</returns>
+        public string GetError() => Marshal.PtrToStringAnsi(GetPassthroughRouteError(m_Route));
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr CreatePassthroughRoute(IntPtr inputDevice, IntPtr outputDevice, int delayFrames, int compositing, bool synchronize);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr GetPassthroughRouteCreateError();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void DestroyPassthroughRoute(IntPtr route);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool SetPassthroughRouteDelay(IntPtr route, int delayFrames);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void SetPassthroughRouteCompositing(IntPtr route, int compositing);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern uint CountRoutedPassthroughFrames(IntPtr route);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern uint CountSkippedPassthroughFrames(IntPtr route);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void GetPassthroughRouteSynchronizerStatistics(IntPtr route, out FrameSynchronizerStatistics statistics);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern IntPtr GetPassthroughRouteError(IntPtr route);
+    }
+}
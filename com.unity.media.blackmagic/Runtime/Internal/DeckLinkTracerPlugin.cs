@@ -0,0 +1,98 @@
+using System;
+using System.Runtime.InteropServices;
+
+namespace Unity.Media.Blackmagic
+{
+    /// <summary>
+    /// A span of the capture and playout pipeline recorded by the native tracer.
+    /// </summary>
+    enum TraceSpan
+    {
+        InputCallback = 0,
+        ManagedDelivery = 1,
+        TextureUpdate = 2,
+        Readback = 3,
+        FeedFrame = 4,
+        ScheduleFrame = 5,
+        FrameCompleted = 6,
+        PassthroughCopy = 7,
+    }
+
+    /// <summary>
+    /// The native timeline of the capture and playout pipeline.
+    /// </summary>
+    /// <remarks>
+    /// Every captured frame gets a flow ID which follows it through the texture update, the readback
+    /// and the output, so the trace shows where the time of each frame goes from glass to glass.
+    /// </remarks>
+    static class DeckLinkTracerPlugin
+    {
+        /// <summary>
+        /// Starts recording the spans into a ring buffer, the oldest spans being overwritten.
+        /// </summary>
+        /// <param name="capacity">The number of spans kept; only used on the first call.</param>
+        /// <returns>True if the tracer is recording, false otherwise.</returns>
+        public static bool Enable(int capacity = 1 << 16) => EnableDeckLinkTracing(capacity);
+
+        /// <summary>
+        /// Stops recording the spans; the recorded spans can still be written.
+        /// </summary>
+        public static void Disable() => DisableDeckLinkTracing();
+
+        /// <summary>
+        /// Whether the tracer is recording.
+        /// </summary>
+        public static bool IsEnabled => IsDeckLinkTracingEnabled();
+
+        /// <summary>
+        /// Writes the recorded spans as a Chrome JSON trace, which chrome://tracing and the Perfetto UI open.
+        /// </summary>
+        /// <param name="path">The path of the trace file.</param>
+        /// <returns>The number of spans written, or -1 if the file couldn't be written.</returns>
+        public static int Write(string path) => WriteDeckLinkTrace(path);
+
+        /// <summary>
+        /// The current time in the time base of the spans, in nanoseconds.
+        /// </summary>
+        public static long Timestamp => GetDeckLinkTraceTimestamp();
+
+        /// <summary>
+        /// The flow ID of the input frame uploaded last, which the output frames rendered next continue.
+        /// </summary>
+        public static ulong CurrentFlow => GetDeckLinkTraceCurrentFlow();
+
+        /// <summary>
+        /// Records a span measured by the managed code.
+        /// </summary>
+        /// <param name="span">The kind of span.</param>
+        /// <param name="deviceIndex">The index of the device.</param>
+        /// <param name="flow">The flow ID of the frame.</param>
+        /// <param name="begin">The start of the span, from <see cref="Timestamp"/>.</param>
+        /// <param name="end">The end of the span, from <see cref="Timestamp"/>.</param>
+        public static void RecordSpan(TraceSpan span, int deviceIndex, ulong flow, long begin, long end)
+        {
+            RecordDeckLinkTraceSpan((int)span, deviceIndex, flow, begin, end);
+        }
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool EnableDeckLinkTracing(int capacity);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void DisableDeckLinkTracing();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern bool IsDeckLinkTracingEnabled();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern int WriteDeckLinkTrace([MarshalAs(UnmanagedType.LPStr)] string path);
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern long GetDeckLinkTraceTimestamp();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern ulong GetDeckLinkTraceCurrentFlow();
+
+        [DllImport(BlackmagicUtilities.k_PluginName)]
+        static extern void RecordDeckLinkTraceSpan(int span, int deviceIndex, ulong flow, long begin, long end);
+    }
+}